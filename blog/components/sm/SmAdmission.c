@@ -0,0 +1,153 @@
+#include "SmAdmission.h"
+#include "SmOutbox.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief splitmix64 散列
+ */
+static uint64_t SmAdmMix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief 当前是否有令牌(只读, 不消耗令牌也不计入统计)
+ */
+static bool SmAdmitPeek(SmAdmission *admission, uint64_t now)
+{
+    if (admission->interval == 0)
+    {
+        return true;
+    }
+
+    uint64_t tat = atomic_load_explicit(&admission->tat, memory_order_relaxed);
+    uint64_t base = (tat > now) ? tat : now;
+    return (base - now <= admission->tolerance);
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmAdmissionInit(SmAdmission *admission, uint64_t interval, uint32_t burst, uint64_t jitter,
+                          SmEventId retry_event, SmTimerHeap *timers)
+{
+    if (admission == NULL || burst == 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 没有时间源时 SmGetTime 恒为 0, 突发用完后永远拒绝 */
+    if (interval > 0 && SmGetTimeFn() == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(admission, 0, sizeof(SmAdmission));
+    atomic_init(&admission->tat, 0);
+    admission->interval = interval;
+    admission->tolerance = interval * (burst - 1);
+    admission->jitter = jitter;
+    admission->retry_event = retry_event;
+    admission->timers = timers;
+    atomic_init(&admission->stats.admitted, 0);
+    atomic_init(&admission->stats.rejected, 0);
+    atomic_init(&admission->stats.retries, 0);
+    atomic_init(&admission->stats.lost, 0);
+
+    return SM_RET_OK;
+}
+
+bool SmAdmit(SmAdmission *admission, uint64_t now, uint64_t *wait)
+{
+    if (admission->interval == 0)
+    {
+        atomic_fetch_add_explicit(&admission->stats.admitted, 1, memory_order_relaxed);
+        return true;
+    }
+
+    /* GCRA: 理论到达时间不超过 now + 容差即可准入, 准入后后移一个间隔 */
+    uint64_t tat = atomic_load_explicit(&admission->tat, memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t base = (tat > now) ? tat : now;
+        if (base - now > admission->tolerance)
+        {
+            if (wait != NULL)
+            {
+                *wait = base - now - admission->tolerance;
+            }
+            atomic_fetch_add_explicit(&admission->stats.rejected, 1, memory_order_relaxed);
+            return false;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&admission->tat, &tat, base + admission->interval,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        {
+            atomic_fetch_add_explicit(&admission->stats.admitted, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+bool SmAdmitMachine(SmAdmission *admission, SmMachine *machine)
+{
+    uint64_t wait = 0;
+    uint64_t now = SmGetTime();
+
+    if (admission == NULL || machine == NULL)
+    {
+        return true;
+    }
+
+    /* 推演中的克隆(见 SmSpec.h): 只看当前能否准入, 不消耗共享令牌, 不安排重试 */
+    if (machine->spec != NULL)
+    {
+        return SmAdmitPeek(admission, now);
+    }
+
+    if (SmAdmit(admission, now, &wait))
+    {
+        return true;
+    }
+
+    if (admission->retry_event == SM_EVENT_INVALID)
+    {
+        return false;
+    }
+
+    /* 等待时间之后再加抖动, 避免被拒绝的实例在同一时刻再次涌入 */
+    uint64_t seq = atomic_load_explicit(&admission->stats.rejected, memory_order_relaxed);
+    uint64_t delay = wait + ((admission->jitter > 0)
+                                 ? SmAdmMix(((uint64_t)machine->machine_id << 32) ^ seq) % admission->jitter
+                                 : 0);
+
+    SmOutbox *outbox = SmGetOutbox(machine);
+    SmRetCode ret = SM_RET_ERROR;
+    if (outbox != NULL)
+    {
+        ret = SmOutboxTimer(outbox, machine, admission->retry_event, delay);
+    }
+    else if (admission->timers != NULL)
+    {
+        ret = (SmTimerStart(admission->timers, machine, admission->retry_event, now + delay) != SM_TIMER_NONE)
+                  ? SM_RET_OK
+                  : SM_RET_ERROR;
+    }
+
+    atomic_fetch_add_explicit((ret == SM_RET_OK) ? &admission->stats.retries : &admission->stats.lost, 1,
+                              memory_order_relaxed);
+    return false;
+}
+
+bool SmAdmissionGuard(SmHandle handle, void *user_data)
+{
+    return SmAdmitMachine((SmAdmission *)user_data, (SmMachine *)handle);
+}
@@ -0,0 +1,101 @@
+#ifndef __SMADMISSION_H__
+#define __SMADMISSION_H__
+
+#include <stdatomic.h>
+#include "SmMgr.h"
+#include "SmTimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 全局准入控制
+ * ============================================================================ */
+
+/*
+ * 一个类(或一组共享上游的类)共用一个准入控制器, 限制全体实例进入 CONNECTING/
+ * RECONNECTING 等代价高的状态的速率, 防止上游重启后的重连风暴:
+ *   - 令牌桶按 GCRA 实现: 只保存一个"理论到达时间", 每次准入一次 CAS, 无锁
+ *   - 超出速率的请求被拒绝(返回 false), 控制器按需要等待的时间加随机抖动
+ *     安排 retry_event 稍后重发给该实例(优先写入实例的 outbox, 随事件一起
+ *     提交/回滚; 否则直接插入 timers 定时器堆)
+ * 申请令牌有副作用(消耗共享令牌, 安排重试), 应在代价高的状态的进入函数或
+ * 转换动作中调用 SmAdmitMachine, 被拒绝时暂不发起连接, 等 retry_event 再试;
+ * 条件函数按约定是纯函数. SmAdmissionGuard 作为转换条件使用时(action_data
+ * 指向控制器)是显式标记的例外, 只适合没有其他条件的简单类.
+ *
+ * 时间单位与 SmGetTime 一致. 抖动由实例ID和拒绝序号散列得到, 同样的输入
+ * 在虚拟时间仿真中可以精确重现.
+ */
+
+/**
+ * @brief 准入统计
+ */
+typedef struct
+{
+    atomic_ullong admitted; /* 准入次数 */
+    atomic_ullong rejected; /* 拒绝次数 */
+    atomic_ullong retries;  /* 已安排的重试 */
+    atomic_ullong lost;     /* 无法安排重试(无 outbox/定时器或已满) */
+} SmAdmissionStats;
+
+/**
+ * @brief 准入控制器
+ */
+typedef struct
+{
+    atomic_ullong tat;      /* 理论到达时间(GCRA) */
+    uint64_t interval;      /* 每个令牌的时间间隔(1/速率), 0表示不限速 */
+    uint64_t tolerance;     /* 突发容差 = interval * (burst - 1) */
+    uint64_t jitter;        /* 重试抖动上限 */
+    SmEventId retry_event;  /* 拒绝后重发的事件, SM_EVENT_INVALID 表示不重试 */
+    SmTimerHeap *timers;    /* 实例未绑定 outbox 时使用的定时器堆(可选) */
+    SmAdmissionStats stats; /* 统计 */
+} SmAdmission;
+
+/**
+ * @brief 初始化准入控制器
+ * @param admission 控制器
+ * @param interval 令牌间隔(SmGetTime 单位, 例如微秒时钟下 1000 表示每秒 1000 次), 0表示不限速
+ * @param burst 允许的突发数量(至少 1)
+ * @param jitter 重试抖动上限
+ * @param retry_event 拒绝后重发的事件, SM_EVENT_INVALID 表示不重试
+ * @param timers 实例未绑定 outbox 时使用的定时器堆(可选)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效或限速但未设置时间源(SmSetTimeFn)
+ */
+SmRetCode SmAdmissionInit(SmAdmission *admission, uint64_t interval, uint32_t burst, uint64_t jitter,
+                          SmEventId retry_event, SmTimerHeap *timers);
+
+/**
+ * @brief 申请一个令牌(无锁)
+ * @param admission 控制器
+ * @param now 当前时间
+ * @param wait 拒绝时需要等待的时间(输出, 可为NULL)
+ * @return true 准入, false 超出速率
+ */
+bool SmAdmit(SmAdmission *admission, uint64_t now, uint64_t *wait);
+
+/**
+ * @brief 为实例申请准入, 拒绝时安排带抖动的重试
+ * @param admission 控制器
+ * @param machine 状态机实例
+ * @return true 准入, false 拒绝(已安排 retry_event 重发)
+ * @note 推演中的克隆(machine->spec 非NULL)只判断当前能否准入, 不消耗令牌, 不安排重试
+ */
+bool SmAdmitMachine(SmAdmission *admission, SmMachine *machine);
+
+/**
+ * @brief 转换条件: 准入控制(action_data 为 SmAdmission 指针)
+ * @param handle 状态机实例句柄
+ * @param user_data 准入控制器
+ * @return true 准入
+ * @note 有副作用的条件: 每次求值都申请令牌
+ */
+bool SmAdmissionGuard(SmHandle handle, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMADMISSION_H__ */
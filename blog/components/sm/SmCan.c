@@ -0,0 +1,338 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* recvmmsg/struct mmsghdr */
+#endif
+
+#include "SmCan.h"
+
+#ifdef __linux__
+
+#include <endian.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/can/raw.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_CAN_FILTER_MAX 64 /* 规则不超过此数量时设置内核过滤器 */
+
+/**
+ * @brief 规则是否匹配帧ID(含 EFF/RTR 标志)
+ */
+static inline bool SmCanRuleMatch(const SmCanRule *rule, canid_t can_id)
+{
+    uint8_t kind = ((can_id & CAN_EFF_FLAG) ? SM_CAN_RULE_EXT : 0) | ((can_id & CAN_RTR_FLAG) ? SM_CAN_RULE_RTR : 0);
+    canid_t id = can_id & ((can_id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+
+    return rule->flags == kind && ((id ^ rule->id) & rule->mask) == 0;
+}
+
+/**
+ * @brief 查找帧的第一条匹配规则
+ */
+static inline const SmCanRule *SmCanMatch(const SmCanIngest *can, canid_t can_id)
+{
+    /* 标准数据帧: 直接映射 */
+    if ((can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) == 0)
+    {
+        uint16_t r = can->std_map[can_id & CAN_SFF_MASK];
+        return (r != 0) ? &can->rules[r - 1] : NULL;
+    }
+
+    for (uint16_t i = 0; i < can->rule_count; i++)
+    {
+        if (SmCanRuleMatch(&can->rules[i], can_id))
+        {
+            return &can->rules[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 转换并分发一帧
+ */
+static inline void SmCanDispatch(SmCanIngest *can, const struct can_frame *frame)
+{
+    can->stats.frames++;
+    if (frame->can_id & CAN_ERR_FLAG)
+    {
+        can->stats.errors++;
+        return;
+    }
+
+    const SmCanRule *rule = SmCanMatch(can, frame->can_id);
+    if (rule == NULL)
+    {
+        can->stats.unmatched++;
+        return;
+    }
+
+    canid_t id = frame->can_id & ((frame->can_id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+    uint32_t index = rule->machine + ((id >> rule->route_shift) & rule->route_mask);
+    if (index >= can->machine_count || can->machines[index] == NULL)
+    {
+        can->stats.unrouted++;
+        return;
+    }
+
+    SmRetCode ret;
+    if (rule->field_count == 0)
+    {
+        /* 零拷贝: 帧数据即负载 */
+        uint8_t len = (frame->can_dlc <= CAN_MAX_DLEN) ? frame->can_dlc : CAN_MAX_DLEN;
+        ret = SmSendEventEx(can->machines[index], rule->event, frame->data, len);
+    }
+    else
+    {
+        uint64_t payload[SM_CAN_PAYLOAD_MAX / sizeof(uint64_t)];
+        if (SmCanDecode(rule, frame, payload) != SM_RET_OK)
+        {
+            can->stats.short_dlc++;
+            return;
+        }
+        ret = SmSendEventEx(can->machines[index], rule->event, payload, rule->payload_len);
+    }
+
+    if (ret == SM_RET_OK || ret == SM_RET_IGNORE || ret == SM_RET_DEFERRED)
+    {
+        can->stats.dispatched++;
+        can->stats.ignored += (ret == SM_RET_IGNORE);
+    }
+    else
+    {
+        can->stats.rejected++;
+    }
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmCanInit(SmCanIngest *can, const SmCanRule *rules, uint16_t rule_count, SmMachine **machines,
+                    uint32_t machine_count)
+{
+    if (can == NULL || (rules == NULL && rule_count > 0) || rule_count == UINT16_MAX ||
+        (machines == NULL && machine_count > 0))
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 1. 检查字段: 位段在 64 位之内, 成员在负载之内且能容纳位段 */
+    for (uint16_t i = 0; i < rule_count; i++)
+    {
+        const SmCanRule *rule = &rules[i];
+        if (rule->payload_len > SM_CAN_PAYLOAD_MAX || (rule->fields == NULL && rule->field_count > 0))
+        {
+            return SM_RET_ERROR;
+        }
+        for (uint8_t f = 0; f < rule->field_count; f++)
+        {
+            const SmCanField *field = &rule->fields[f];
+            bool width_ok = (field->width == 1 || field->width == 2 || field->width == 4 || field->width == 8);
+            if (field->bit_len == 0 || field->start_bit + field->bit_len > 64 || !width_ok ||
+                field->bit_len > field->width * 8 || field->offset + field->width > rule->payload_len)
+            {
+                return SM_RET_ERROR;
+            }
+        }
+    }
+
+    memset(can, 0, sizeof(SmCanIngest));
+    can->rules = rules;
+    can->rule_count = rule_count;
+    can->machines = machines;
+    can->machine_count = machine_count;
+
+    /* 2. 标准数据帧展开为直接映射(保持规则顺序: 取第一条匹配) */
+    for (uint32_t id = 0; id < SM_CAN_STD_IDS; id++)
+    {
+        for (uint16_t i = 0; i < rule_count; i++)
+        {
+            if (SmCanRuleMatch(&rules[i], id))
+            {
+                can->std_map[id] = (uint16_t)(i + 1);
+                break;
+            }
+        }
+    }
+
+    return SM_RET_OK;
+}
+
+int SmCanOpen(const SmCanIngest *can, const char *ifname)
+{
+    if (ifname == NULL || strlen(ifname) >= IFNAMSIZ)
+    {
+        return -1;
+    }
+
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    struct sockaddr_can addr = { .can_family = AF_CAN };
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    addr.can_ifindex = ifr.ifr_ifindex;
+
+    /* 内核过滤: 只接收规则关心的帧, EFF/RTR 标志同样参与比较 */
+    if (can != NULL && can->rule_count > 0 && can->rule_count <= SM_CAN_FILTER_MAX)
+    {
+        struct can_filter filters[SM_CAN_FILTER_MAX];
+        for (uint16_t i = 0; i < can->rule_count; i++)
+        {
+            const SmCanRule *rule = &can->rules[i];
+            filters[i].can_id = rule->id | ((rule->flags & SM_CAN_RULE_EXT) ? CAN_EFF_FLAG : 0) |
+                                ((rule->flags & SM_CAN_RULE_RTR) ? CAN_RTR_FLAG : 0);
+            filters[i].can_mask = rule->mask | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        }
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, sizeof(struct can_filter) * can->rule_count);
+    }
+
+    int rcvbuf = SM_CAN_RCVBUF;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+SmRetCode SmCanDecode(const SmCanRule *rule, const struct can_frame *frame, void *payload)
+{
+    uint8_t *out = (uint8_t *)payload;
+    uint32_t bits = ((frame->can_dlc <= CAN_MAX_DLEN) ? frame->can_dlc : CAN_MAX_DLEN) * 8u;
+    uint64_t raw;
+
+    /* 8 字节数据一次读入, 两种位序各一次字节序转换 */
+    memcpy(&raw, frame->data, sizeof(raw));
+    uint64_t le = le64toh(raw);
+    uint64_t be = be64toh(raw);
+
+    memset(out, 0, rule->payload_len);
+    for (uint8_t f = 0; f < rule->field_count; f++)
+    {
+        const SmCanField *field = &rule->fields[f];
+        if (field->start_bit + field->bit_len > bits)
+        {
+            return SM_RET_ERROR;
+        }
+
+        uint64_t mask = (field->bit_len < 64) ? ((1ULL << field->bit_len) - 1) : UINT64_MAX;
+        uint64_t value = (field->flags & SM_CAN_FIELD_MOTOROLA)
+                             ? (be >> (64 - field->start_bit - field->bit_len)) & mask
+                             : (le >> field->start_bit) & mask;
+        if ((field->flags & SM_CAN_FIELD_SIGNED) && field->bit_len < 64 && (value >> (field->bit_len - 1)) != 0)
+        {
+            value |= ~mask;
+        }
+
+        switch (field->width)
+        {
+            case 1:
+            {
+                uint8_t v = (uint8_t)value;
+                memcpy(out + field->offset, &v, sizeof(v));
+                break;
+            }
+            case 2:
+            {
+                uint16_t v = (uint16_t)value;
+                memcpy(out + field->offset, &v, sizeof(v));
+                break;
+            }
+            case 4:
+            {
+                uint32_t v = (uint32_t)value;
+                memcpy(out + field->offset, &v, sizeof(v));
+                break;
+            }
+            default:
+                memcpy(out + field->offset, &value, sizeof(value));
+                break;
+        }
+    }
+
+    return SM_RET_OK;
+}
+
+uint32_t SmCanFeed(SmCanIngest *can, const struct can_frame *frames, uint32_t count)
+{
+    if (can == NULL || frames == NULL)
+    {
+        return 0;
+    }
+
+    uint64_t before = can->stats.dispatched;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmCanDispatch(can, &frames[i]);
+    }
+    return (uint32_t)(can->stats.dispatched - before);
+}
+
+int32_t SmCanReceive(SmCanIngest *can, int fd, bool nonblock)
+{
+    if (can == NULL)
+    {
+        return -1;
+    }
+
+    /* 批量接收描述符指向接入结构体内的帧缓冲区 */
+    struct mmsghdr msgs[SM_CAN_BATCH];
+    struct iovec iov[SM_CAN_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (uint32_t i = 0; i < SM_CAN_BATCH; i++)
+    {
+        iov[i].iov_base = &can->frames[i];
+        iov[i].iov_len = sizeof(struct can_frame);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* 阻塞模式: 等到第一帧后取走已到达的其余帧, 不等待凑满一批 */
+    int n;
+    do
+    {
+        n = recvmmsg(fd, msgs, SM_CAN_BATCH, nonblock ? MSG_DONTWAIT : MSG_WAITFORONE, NULL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    can->stats.batches++;
+    for (int i = 0; i < n; i++)
+    {
+        if (msgs[i].msg_len != sizeof(struct can_frame))
+        {
+            can->stats.frames++;
+            can->stats.errors++;
+            continue;
+        }
+        SmCanDispatch(can, &can->frames[i]);
+    }
+
+    return n;
+}
+
+#endif /* __linux__ */
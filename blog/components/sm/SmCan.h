@@ -0,0 +1,184 @@
+#ifndef __SMCAN_H__
+#define __SMCAN_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+
+#ifdef __linux__
+
+#include <linux/can.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CAN 帧接入
+ * ============================================================================ */
+
+/*
+ * 按规则表把 SocketCAN 帧直接转换为事件, 取代逐帧手写解析 + SmSendEvent:
+ *   - 规则 = CAN ID/掩码 -> 事件ID; 规则按顺序匹配, 取第一条. 标准帧(11位)
+ *     数据帧在初始化时展开为 2048 项直接映射表, 查找 O(1); 扩展帧/远程帧按
+ *     顺序比较规则
+ *   - 字段提取(DBC 信号): 帧数据按 Intel(小端)或 Motorola(大端)位序取出
+ *     start_bit/bit_len 指定的位段, 可符号扩展, 写入事件负载结构体的成员;
+ *     没有字段的规则直接以帧数据为负载(零拷贝)
+ *   - 实例路由: 规则的 machine 加上 CAN ID 中的节点号
+ *     ((id >> route_shift) & route_mask), 一条规则即可覆盖一组电机控制器
+ *   - SmCanReceive 用 recvmmsg 每次读取最多 SM_CAN_BATCH 帧到接入结构体内
+ *     预分配的帧缓冲区, 逐帧 SmSendEventEx(负载只在分发期间有效); 批量接收
+ *     描述符在 SmCan.c 内部按次构造, 包含本头文件不需要 _GNU_SOURCE
+ *   - SmCanOpen 按规则表设置内核过滤器(CAN_RAW_FILTER), 无关帧不进入套接字
+ * 整个接入过程不分配内存.
+ *
+ * 约束: 只处理经典 CAN 帧(最多 8 字节数据); 只在一个分发线程中调用.
+ */
+
+#define SM_CAN_BATCH       64     /* recvmmsg 单次最多读取的帧数 */
+#define SM_CAN_STD_IDS     2048   /* 标准帧ID数量 */
+#define SM_CAN_PAYLOAD_MAX 32     /* 事件负载最大字节数 */
+#define SM_CAN_RCVBUF      262144 /* SmCanOpen 设置的套接字接收缓冲区(吸收总线突发) */
+
+#define SM_CAN_RULE_EXT 0x01 /* 规则匹配扩展帧(29位ID) */
+#define SM_CAN_RULE_RTR 0x02 /* 规则匹配远程帧 */
+
+#define SM_CAN_FIELD_MOTOROLA 0x01 /* 大端位序: start_bit 为字段最高位, data[0] 最高位编号为 0 */
+#define SM_CAN_FIELD_SIGNED   0x02 /* 有符号字段(符号扩展到成员宽度) */
+
+/**
+ * @brief 字段(信号)定义
+ * @note Intel 位序: start_bit 为字段最低位, data[0] 最低位编号为 0(与 DBC 一致);
+ *       Motorola 位序: DBC 起始位 s 换算为 (s / 8) * 8 + 7 - s % 8
+ */
+typedef struct
+{
+    uint8_t start_bit; /* 起始位 */
+    uint8_t bit_len;   /* 位数(1..64) */
+    uint8_t offset;    /* 负载中的字节偏移 */
+    uint8_t width;     /* 负载成员宽度(1/2/4/8 字节, 按主机字节序写入) */
+    uint8_t flags;     /* SM_CAN_FIELD_* */
+} SmCanField;
+
+/**
+ * @brief 帧 -> 事件规则
+ */
+typedef struct
+{
+    uint32_t id;               /* CAN ID(不含 EFF/RTR 标志) */
+    uint32_t mask;             /* 比较掩码 */
+    uint8_t flags;             /* SM_CAN_RULE_* */
+    SmEventId event;           /* 事件ID */
+    const SmCanField *fields;  /* 字段数组(NULL 表示以帧数据为负载) */
+    uint8_t field_count;       /* 字段数量 */
+    uint8_t payload_len;       /* 事件负载字节数(有字段时有效) */
+    uint32_t machine;          /* 目标实例下标 */
+    uint8_t route_shift;       /* 节点号在 CAN ID 中的位置 */
+    uint32_t route_mask;       /* 节点号掩码(0 表示固定实例) */
+} SmCanRule;
+
+/**
+ * @brief 接入统计
+ */
+typedef struct
+{
+    uint64_t frames;     /* 收到的帧数 */
+    uint64_t dispatched; /* 送达实例的帧数(含被忽略/延迟的事件) */
+    uint64_t ignored;    /* 其中实例忽略的事件数(没有规则或条件不满足) */
+    uint64_t unmatched;  /* 没有匹配规则的帧数 */
+    uint64_t unrouted;   /* 节点号没有对应实例的帧数 */
+    uint64_t short_dlc;  /* 数据长度不足以提取字段的帧数 */
+    uint64_t rejected;   /* 分发失败的事件数(实例未启动等) */
+    uint64_t errors;     /* 错误帧/长度异常的报文数 */
+    uint64_t batches;    /* recvmmsg 次数 */
+} SmCanStats;
+
+/**
+ * @brief CAN 接入
+ */
+typedef struct
+{
+    const SmCanRule *rules;                 /* 规则表 */
+    uint16_t rule_count;                    /* 规则数量 */
+    SmMachine **machines;                   /* 实例表(可含NULL) */
+    uint32_t machine_count;                 /* 实例表大小 */
+    SmCanStats stats;                       /* 统计 */
+    uint16_t std_map[SM_CAN_STD_IDS];       /* 标准数据帧ID -> 规则下标 + 1, 0 表示无匹配 */
+    struct can_frame frames[SM_CAN_BATCH];  /* 批量接收缓冲区 */
+} SmCanIngest;
+
+/* 定义字段: 取 start/len 位写入负载结构体 type 的成员 member */
+#define SM_CAN_FIELD(start, len, type, member, field_flags) \
+    { .start_bit = (start), .bit_len = (len), .offset = offsetof(type, member), .width = sizeof(((type *)0)->member), .flags = (field_flags) }
+
+/* 定义规则: 按 fields_array 提取到负载结构体 type(可变参数用于追加 SM_CAN_xxx 扩展字段) */
+#define SM_CAN_RULE(can_id, can_mask, evt, fields_array, type, ...) \
+    { .id = (can_id), .mask = (can_mask), .event = (evt), .fields = (fields_array), .field_count = sizeof(fields_array) / sizeof(SmCanField), .payload_len = sizeof(type), __VA_ARGS__ }
+
+/* 定义规则: 以帧数据为负载(零拷贝) */
+#define SM_CAN_RULE_RAW(can_id, can_mask, evt, ...) \
+    { .id = (can_id), .mask = (can_mask), .event = (evt), __VA_ARGS__ }
+
+/* 规则扩展: 固定目标实例 */
+#define SM_CAN_MACHINE(index) .machine = (index)
+
+/* 规则扩展: 目标实例 = base + ((id >> shift) & node_mask) */
+#define SM_CAN_ROUTE(base, shift, node_mask) .machine = (base), .route_shift = (shift), .route_mask = (node_mask)
+
+/* 规则扩展: 扩展帧 */
+#define SM_CAN_EXT() .flags = SM_CAN_RULE_EXT
+
+/**
+ * @brief 初始化接入
+ * @param can 接入结构体
+ * @param rules 规则表(生命周期需不短于 can)
+ * @param rule_count 规则数量
+ * @param machines 实例表
+ * @param machine_count 实例表大小
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效或字段超出范围
+ */
+SmRetCode SmCanInit(SmCanIngest *can, const SmCanRule *rules, uint16_t rule_count, SmMachine **machines,
+                    uint32_t machine_count);
+
+/**
+ * @brief 打开 CAN_RAW 套接字并绑定接口
+ * @param can 接入(可选, 非NULL时按其规则表设置内核过滤器)
+ * @param ifname 接口名("can0", "vcan0")
+ * @return 套接字, -1 表示失败(内核不支持 SocketCAN/接口不存在)
+ */
+int SmCanOpen(const SmCanIngest *can, const char *ifname);
+
+/**
+ * @brief 按规则提取帧中的字段
+ * @param rule 规则
+ * @param frame 帧
+ * @param payload 负载(输出, rule->payload_len 字节)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 数据长度不足
+ */
+SmRetCode SmCanDecode(const SmCanRule *rule, const struct can_frame *frame, void *payload);
+
+/**
+ * @brief 转换并分发一组帧
+ * @param can 接入
+ * @param frames 帧数组
+ * @param count 帧数量
+ * @return 送达实例的帧数
+ */
+uint32_t SmCanFeed(SmCanIngest *can, const struct can_frame *frames, uint32_t count);
+
+/**
+ * @brief 批量读取一次并分发
+ * @param can 接入
+ * @param fd 套接字(CAN_RAW, 或传递 struct can_frame 报文的数据报套接字)
+ * @param nonblock true 没有帧时立即返回, false 阻塞到至少一帧
+ * @return 读取的帧数, 0 没有帧(非阻塞), -1 读取错误
+ */
+int32_t SmCanReceive(SmCanIngest *can, int fd, bool nonblock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __linux__ */
+
+#endif /* __SMCAN_H__ */
@@ -0,0 +1,1308 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "SmExplore.h"
+#include "SmOs.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ============================================================================
+ * 内部定义
+ * ============================================================================ */
+
+#define SM_EXP_EMPTY     UINT64_MAX /* 空槽位/未发布的队列项 */
+#define SM_EXP_NONE      0xFFFF     /* 无状态下标/无条件 */
+#define SM_EXP_UNTRACKED 0xFFFE     /* 条件未跟踪(每次求值两个分支) */
+
+/* 配置编码: 状态下标 | 已知条件掩码 << 16 | 条件值掩码 << 32 */
+#define SM_EXP_KEY(state, known, value) \
+    ((uint64_t)(state) | ((uint64_t)(known) << 16) | ((uint64_t)(value) << 32))
+#define SM_EXP_STATE(key) ((uint16_t)(key))
+#define SM_EXP_KNOWN(key) ((uint16_t)((key) >> 16))
+#define SM_EXP_VALUE(key) ((uint16_t)((key) >> 32))
+
+#define SM_EXP_EDGE_INTERNAL   0x01 /* 内部边: 完成转换/自产生事件 */
+#define SM_EXP_EDGE_GUARD      0x02 /* 条件成立后触发 */
+#define SM_EXP_EDGE_CALLBACK   0x04 /* 执行了回调(条件重置为未知) */
+#define SM_EXP_EDGE_COMPLETION 0x08 /* 完成转换 */
+
+#define SM_EXP_EVAL_FALSE     0 /* 条件已知为假 */
+#define SM_EXP_EVAL_TRUE      1 /* 无条件或已知为真 */
+#define SM_EXP_EVAL_UNKNOWN   2 /* 跟踪的条件未知: 两个分支, 结果记住 */
+#define SM_EXP_EVAL_UNTRACKED 3 /* 未跟踪的条件: 两个分支, 结果不记住 */
+
+#define SM_EXP_REPORT_LIST 20 /* 报告中逐条列出的上限 */
+
+/**
+ * @brief 后继回调
+ * @param arg 回调参数
+ * @param to 后继配置
+ * @param flags SM_EXP_EDGE_*
+ * @param rule 规则编号(条件为假的分支为 UINT32_MAX)
+ */
+typedef void (*SmExpEmitFn)(void *arg, uint64_t to, uint8_t flags, uint32_t rule);
+
+/**
+ * @brief 分析上下文(所有线程共享)
+ */
+typedef struct
+{
+    const SmClass *sm_class;      /* 状态机类 */
+    uint16_t state_count;         /* 状态数量 */
+    uint16_t event_count;         /* auto_event 表大小 */
+    uint16_t *parent;             /* 父状态下标 [state_count], SM_EXP_NONE 表示无 */
+    uint32_t *target_first;       /* 目标叶子列表起点 [state_count + 1] */
+    uint16_t *targets;            /* 转换目标解析出的叶子状态下标 */
+    uint32_t *rule_first;         /* 规则编号起点 [state_count + 1] */
+    uint16_t *rule_target;        /* 规则目标状态下标 [rule_count] */
+    uint16_t *rule_guard;         /* 规则条件编号 [rule_count] */
+    uint8_t *auto_event;          /* 自产生事件标记 [event_count] */
+    atomic_uchar *rule_flags;     /* SM_EXPLORE_RULE_* [rule_count] */
+    atomic_uchar *state_reached;  /* [state_count] */
+    _Atomic uint64_t *table;      /* 访问集合 [mask + 1] */
+    uint32_t *table_index;        /* 槽位中配置的队列下标 [mask + 1] */
+    uint64_t mask;                /* 哈希表容量 - 1 */
+    _Atomic uint64_t *queue;      /* 工作队列(入队顺序即配置编号) [max_configs] */
+    uint32_t *level;              /* 配置的探索深度 [max_configs] */
+    uint32_t max_configs;         /* 配置数上限 */
+    atomic_uint head;             /* 下一个待领取的队列下标 */
+    atomic_uint tail;             /* 已分配的队列下标数 */
+    atomic_ullong pending;        /* 已入队但未处理完的配置数 */
+    atomic_ullong edges;          /* 边数 */
+    atomic_uint depth;            /* 最大深度 */
+    atomic_bool truncated;        /* 达到配置数上限 */
+} SmExpCtx;
+
+/**
+ * @brief 工作线程参数
+ */
+typedef struct
+{
+    SmExpCtx *ctx;   /* 分析上下文 */
+    uint64_t edges;  /* 本线程探索的边数 */
+    uint32_t level;  /* 当前配置的深度 */
+} SmExpWorker;
+
+/**
+ * @brief 内部边(环检测用)
+ */
+typedef struct
+{
+    uint32_t to;   /* 目标配置编号 */
+    uint32_t rule; /* 规则编号 */
+    uint8_t flags; /* SM_EXP_EDGE_* */
+} SmExpEdge;
+
+/**
+ * @brief 内部边收集参数
+ */
+typedef struct
+{
+    SmExpCtx *ctx;     /* 分析上下文 */
+    SmExpEdge *edges;  /* 边数组 */
+    size_t count;      /* 边数 */
+    size_t capacity;   /* 容量 */
+    bool failed;       /* 内存不足 */
+} SmExpGraph;
+
+/* ============================================================================
+ * 内部辅助函数: 类结构
+ * ============================================================================ */
+
+static uint64_t SmExpNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 状态ID转下标
+ */
+static uint16_t SmExpIndex(const SmClass *sm_class, SmStateId state_id)
+{
+    if (state_id >= 0 && state_id < sm_class->state_count && sm_class->states[state_id].state_id == state_id)
+    {
+        return (uint16_t)state_id;
+    }
+
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        if (sm_class->states[i].state_id == state_id)
+        {
+            return i;
+        }
+    }
+
+    return SM_EXP_NONE;
+}
+
+/**
+ * @brief 按下标取规则
+ */
+static const SmTransition *SmExpRule(const SmClass *sm_class, const uint32_t *rule_first, uint32_t rule)
+{
+    uint16_t lo = 0;
+    uint16_t hi = sm_class->state_count;
+
+    if (rule >= rule_first[hi])
+    {
+        return &sm_class->any_transitions[rule - rule_first[hi]];
+    }
+
+    /* 二分查找所属状态 */
+    while (hi - lo > 1)
+    {
+        uint16_t mid = (uint16_t)((lo + hi) / 2);
+        if (rule_first[mid] <= rule)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return &sm_class->states[lo].transitions[rule - rule_first[lo]];
+}
+
+/**
+ * @brief 解析转换目标可能到达的叶子状态
+ * @note 历史伪状态的记录在分析时未知: 取默认目标以及记录可能指向的全部子状态
+ */
+static void SmExpResolve(SmExpCtx *x, uint16_t index, uint8_t *mark, uint16_t *out, uint32_t *count)
+{
+    if (index == SM_EXP_NONE || mark[index])
+    {
+        return;
+    }
+    mark[index] = 1;
+
+    const SmState *state = &x->sm_class->states[index];
+    switch (state->kind)
+    {
+        case SM_STATE_LEAF:
+            out[(*count)++] = index;
+            break;
+
+        case SM_STATE_COMPOSITE:
+            SmExpResolve(x, SmExpIndex(x->sm_class, state->initial), mark, out, count);
+            break;
+
+        default:
+        {
+            uint16_t composite = x->parent[index];
+            SmExpResolve(x, SmExpIndex(x->sm_class, state->initial), mark, out, count);
+            for (uint16_t i = 0; composite != SM_EXP_NONE && i < x->state_count; i++)
+            {
+                const SmState *child = &x->sm_class->states[i];
+                if (child->kind == SM_STATE_HISTORY_SHALLOW || child->kind == SM_STATE_HISTORY_DEEP)
+                {
+                    continue;
+                }
+
+                /* 浅历史: 直接子状态; 深历史: 全部叶子后代 */
+                uint16_t p = x->parent[i];
+                bool below = (p == composite);
+                for (uint16_t d = 0; !below && p != SM_EXP_NONE && d < SM_STATE_MAX_DEPTH; d++)
+                {
+                    p = x->parent[p];
+                    below = (p == composite);
+                }
+                if ((state->kind == SM_STATE_HISTORY_SHALLOW && x->parent[i] == composite) ||
+                    (state->kind == SM_STATE_HISTORY_DEEP && below && child->kind == SM_STATE_LEAF))
+                {
+                    SmExpResolve(x, i, mark, out, count);
+                }
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 转换是否执行退出/进入回调(与 SmPerformTransition 的作用域计算一致)
+ */
+static bool SmExpPathCallbacks(const SmExpCtx *x, uint16_t from, uint16_t to, const SmTransition *trans,
+                               uint16_t declared)
+{
+    uint16_t exit_path[SM_STATE_MAX_DEPTH];
+    uint16_t enter_path[SM_STATE_MAX_DEPTH];
+    uint16_t exit_depth = 0;
+    uint16_t enter_depth = 0;
+
+    for (uint16_t s = from; s != SM_EXP_NONE && exit_depth < SM_STATE_MAX_DEPTH; s = x->parent[s])
+    {
+        exit_path[exit_depth++] = s;
+    }
+    for (uint16_t s = to; s != SM_EXP_NONE && enter_depth < SM_STATE_MAX_DEPTH; s = x->parent[s])
+    {
+        enter_path[enter_depth++] = s;
+    }
+
+    uint16_t first = (trans->kind == SM_TRANS_KIND_LOCAL) ? 0 : 1;
+    uint16_t exit_count = exit_depth;
+    uint16_t enter_count = enter_depth;
+    bool found = false;
+    for (uint16_t i = first; i < exit_depth && !found; i++)
+    {
+        for (uint16_t j = first; j < enter_depth; j++)
+        {
+            if (exit_path[i] == enter_path[j])
+            {
+                exit_count = i;
+                enter_count = j;
+                found = true;
+                break;
+            }
+        }
+    }
+
+    /* 外部转换的目标是源状态所属的组合状态时, 该组合状态同样退出并重新进入 */
+    for (uint16_t i = 1; trans->kind == SM_TRANS_KIND_EXTERNAL && i < exit_depth; i++)
+    {
+        if (exit_path[i] == declared)
+        {
+            for (uint16_t j = 0; j < enter_depth; j++)
+            {
+                if (enter_path[j] == exit_path[i])
+                {
+                    exit_count = i + 1;
+                    enter_count = j + 1;
+                }
+            }
+            break;
+        }
+    }
+
+    for (uint16_t i = 0; i < exit_count; i++)
+    {
+        if (x->sm_class->states[exit_path[i]].on_exit != NULL)
+        {
+            return true;
+        }
+    }
+    for (uint16_t j = 0; j < enter_count; j++)
+    {
+        if (x->sm_class->states[enter_path[j]].on_enter != NULL)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 状态(或所属组合状态)是否延迟该事件
+ */
+static bool SmExpDefers(const SmExpCtx *x, uint16_t index, SmEventId event)
+{
+    for (uint16_t d = 0; index != SM_EXP_NONE && d < SM_STATE_MAX_DEPTH; d++)
+    {
+        for (const SmEventId *evt = x->sm_class->states[index].deferred_events;
+             evt != NULL && *evt != SM_EVENT_INVALID; evt++)
+        {
+            if (*evt == event)
+            {
+                return true;
+            }
+        }
+        index = x->parent[index];
+    }
+
+    return false;
+}
+
+/* ============================================================================
+ * 内部辅助函数: 后继配置
+ * ============================================================================ */
+
+static inline void SmExpMark(atomic_uchar *flags, uint8_t bit)
+{
+    if ((atomic_load_explicit(flags, memory_order_relaxed) & bit) == 0)
+    {
+        atomic_fetch_or_explicit(flags, bit, memory_order_relaxed);
+    }
+}
+
+static inline int SmExpEval(uint16_t guard, uint16_t known, uint16_t value)
+{
+    if (guard == SM_EXP_NONE)
+    {
+        return SM_EXP_EVAL_TRUE;
+    }
+    if (guard == SM_EXP_UNTRACKED)
+    {
+        return SM_EXP_EVAL_UNTRACKED;
+    }
+
+    uint16_t bit = (uint16_t)(1u << guard);
+    if (known & bit)
+    {
+        return (value & bit) ? SM_EXP_EVAL_TRUE : SM_EXP_EVAL_FALSE;
+    }
+    return SM_EXP_EVAL_UNKNOWN;
+}
+
+/**
+ * @brief 触发规则, 生成目标配置
+ */
+static void SmExpFire(SmExpCtx *x, uint16_t state, uint16_t known, uint16_t value, uint32_t rule, uint8_t flags,
+                      bool mark, SmExpEmitFn emit, void *arg)
+{
+    const SmTransition *trans = SmExpRule(x->sm_class, x->rule_first, rule);
+    bool action = (trans->action != NULL);
+
+    if (mark)
+    {
+        SmExpMark(&x->rule_flags[rule], SM_EXPLORE_RULE_FIRED);
+    }
+
+    if (trans->kind == SM_TRANS_KIND_INTERNAL)
+    {
+        flags |= action ? SM_EXP_EDGE_CALLBACK : 0;
+        emit(arg, action ? SM_EXP_KEY(state, 0, 0) : SM_EXP_KEY(state, known, value), flags, rule);
+        return;
+    }
+
+    /* 目标无效时 SmPerformTransition 返回错误, 实例留在原状态 */
+    uint16_t declared = x->rule_target[rule];
+    if (declared == SM_EXP_NONE)
+    {
+        return;
+    }
+
+    for (uint32_t i = x->target_first[declared]; i < x->target_first[declared + 1]; i++)
+    {
+        uint16_t leaf = x->targets[i];
+        bool callbacks = action || SmExpPathCallbacks(x, state, leaf, trans, declared);
+        emit(arg, callbacks ? SM_EXP_KEY(leaf, 0, 0) : SM_EXP_KEY(leaf, known, value),
+             (uint8_t)(flags | (callbacks ? SM_EXP_EDGE_CALLBACK : 0)), rule);
+    }
+}
+
+/**
+ * @brief 对选中的规则求值条件并生成后继
+ */
+static void SmExpSelect(SmExpCtx *x, uint16_t state, uint16_t known, uint16_t value, uint32_t rule, uint8_t flags,
+                        bool mark, SmExpEmitFn emit, void *arg)
+{
+    uint16_t guard = x->rule_guard[rule];
+    int outcome = SmExpEval(guard, known, value);
+    uint8_t guarded = (guard != SM_EXP_NONE) ? SM_EXP_EDGE_GUARD : 0;
+
+    if (mark)
+    {
+        SmExpMark(&x->rule_flags[rule], SM_EXPLORE_RULE_SELECTED);
+    }
+
+    if (outcome == SM_EXP_EVAL_TRUE || outcome == SM_EXP_EVAL_UNTRACKED)
+    {
+        SmExpFire(x, state, known, value, rule, flags | guarded, mark, emit, arg);
+    }
+    else if (outcome == SM_EXP_EVAL_UNKNOWN)
+    {
+        uint16_t bit = (uint16_t)(1u << guard);
+        SmExpFire(x, state, known | bit, value | bit, rule, flags | guarded, mark, emit, arg);
+
+        /* 条件为假: 事件被忽略, 状态不变, 记住条件结果 */
+        emit(arg, SM_EXP_KEY(state, known | bit, value & (uint16_t)~bit), flags & SM_EXP_EDGE_INTERNAL, UINT32_MAX);
+    }
+}
+
+/**
+ * @brief 生成配置的全部后继
+ * @param internal_only 只生成内部边(完成转换/自产生事件)
+ * @param mark 记录规则的选中/触发
+ */
+static void SmExpSuccessors(SmExpCtx *x, uint64_t key, bool internal_only, bool mark, SmExpEmitFn emit, void *arg)
+{
+    const SmClass *sm_class = x->sm_class;
+    uint16_t index = SM_EXP_STATE(key);
+    uint16_t known = SM_EXP_KNOWN(key);
+    uint16_t value = SM_EXP_VALUE(key);
+    const SmState *state = &sm_class->states[index];
+    uint32_t base = x->rule_first[index];
+
+    /* 1. 完成转换: 条件成立时配置只是中间态, 不接受事件 */
+    for (uint16_t i = 0; i < state->trans_count; i++)
+    {
+        if (state->transitions[i].event_id != SM_EVENT_COMPLETION)
+        {
+            continue;
+        }
+
+        int outcome = SmExpEval(x->rule_guard[base + i], known, value);
+        SmExpSelect(x, index, known, value, base + i, SM_EXP_EDGE_INTERNAL | SM_EXP_EDGE_COMPLETION, mark, emit,
+                    arg);
+        if (outcome == SM_EXP_EVAL_TRUE || outcome == SM_EXP_EVAL_UNKNOWN)
+        {
+            return;
+        }
+        break;
+    }
+
+    /* 2. 每个事件取第一条匹配规则 */
+    for (uint16_t i = 0; i < state->trans_count; i++)
+    {
+        SmEventId event = state->transitions[i].event_id;
+        bool is_auto = (event >= 0 && event < x->event_count && x->auto_event[event]);
+        bool first = true;
+        for (uint16_t j = 0; j < i && first; j++)
+        {
+            first = (state->transitions[j].event_id != event);
+        }
+        if (event == SM_EVENT_COMPLETION || event == SM_EVENT_INVALID || !first || (internal_only && !is_auto) ||
+            SmExpDefers(x, index, event))
+        {
+            continue;
+        }
+        SmExpSelect(x, index, known, value, base + i, is_auto ? SM_EXP_EDGE_INTERNAL : 0, mark, emit, arg);
+    }
+
+    /* 3. 状态自身没有规则的事件查找通配转换 */
+    for (uint16_t i = 0; !state->any_opt_out && i < sm_class->any_trans_count; i++)
+    {
+        SmEventId event = sm_class->any_transitions[i].event_id;
+        bool is_auto = (event >= 0 && event < x->event_count && x->auto_event[event]);
+        bool first = true;
+        for (uint16_t j = 0; j < i && first; j++)
+        {
+            first = (sm_class->any_transitions[j].event_id != event);
+        }
+        for (uint16_t j = 0; j < state->trans_count && first; j++)
+        {
+            first = (state->transitions[j].event_id != event);
+        }
+        if (event == SM_EVENT_COMPLETION || event == SM_EVENT_INVALID || !first || (internal_only && !is_auto) ||
+            SmExpDefers(x, index, event))
+        {
+            continue;
+        }
+        SmExpSelect(x, index, known, value, x->rule_first[x->state_count] + i, is_auto ? SM_EXP_EDGE_INTERNAL : 0,
+                    mark, emit, arg);
+    }
+}
+
+/* ============================================================================
+ * 内部辅助函数: 并行广度优先探索
+ * ============================================================================ */
+
+static inline uint64_t SmExpHash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * @brief 查找配置编号
+ * @return 配置编号, UINT32_MAX 表示未访问
+ */
+static uint32_t SmExpLookup(const SmExpCtx *x, uint64_t key)
+{
+    for (uint64_t h = SmExpHash(key) & x->mask;; h = (h + 1) & x->mask)
+    {
+        uint64_t cur = atomic_load_explicit(&x->table[h], memory_order_relaxed);
+        if (cur == key)
+        {
+            return x->table_index[h];
+        }
+        if (cur == SM_EXP_EMPTY)
+        {
+            return UINT32_MAX;
+        }
+    }
+}
+
+/**
+ * @brief 访问配置: 首次访问时插入访问集合并入队
+ */
+static void SmExpVisit(SmExpCtx *x, uint64_t key, uint32_t level)
+{
+    uint64_t h = SmExpHash(key) & x->mask;
+
+    for (;;)
+    {
+        uint64_t cur = atomic_load_explicit(&x->table[h], memory_order_acquire);
+        if (cur == key)
+        {
+            return;
+        }
+        if (cur != SM_EXP_EMPTY)
+        {
+            h = (h + 1) & x->mask;
+            continue;
+        }
+
+        /* 达到上限后不再插入, 保证哈希表不会填满 */
+        if (atomic_load_explicit(&x->truncated, memory_order_relaxed))
+        {
+            return;
+        }
+        if (!atomic_compare_exchange_strong(&x->table[h], &cur, key))
+        {
+            continue; /* 同一槽位被抢先插入, 重新比较 */
+        }
+        break;
+    }
+
+    /* 先计入未完成数, 再分配队列下标 */
+    atomic_fetch_add(&x->pending, 1);
+    uint32_t idx = atomic_load(&x->tail);
+    do
+    {
+        if (idx >= x->max_configs)
+        {
+            atomic_store(&x->truncated, true);
+            x->table_index[h] = UINT32_MAX;
+            atomic_fetch_sub(&x->pending, 1);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak(&x->tail, &idx, idx + 1));
+
+    x->table_index[h] = idx;
+    x->level[idx] = level;
+    atomic_store_explicit(&x->queue[idx], key, memory_order_release);
+}
+
+static void SmExpBfsEmit(void *arg, uint64_t to, uint8_t flags, uint32_t rule)
+{
+    SmExpWorker *worker = (SmExpWorker *)arg;
+    (void)flags; /* 可达性只关心目标配置, 边的种类和规则由诊断遍历使用 */
+    (void)rule;
+    worker->edges++;
+    SmExpVisit(worker->ctx, to, worker->level + 1);
+}
+
+/**
+ * @brief 工作线程: 领取队列中的配置并展开
+ */
+static void SmExpWorkerMain(void *arg)
+{
+    SmExpWorker *worker = (SmExpWorker *)arg;
+    SmExpCtx *x = worker->ctx;
+
+    for (;;)
+    {
+        uint32_t head = atomic_load(&x->head);
+        if (head < atomic_load(&x->tail))
+        {
+            if (!atomic_compare_exchange_weak(&x->head, &head, head + 1))
+            {
+                continue;
+            }
+
+            /* 下标已分配但配置可能尚未写入 */
+            uint64_t key;
+            while ((key = atomic_load_explicit(&x->queue[head], memory_order_acquire)) == SM_EXP_EMPTY)
+            {
+                SmOsYield();
+            }
+
+            uint16_t index = SM_EXP_STATE(key);
+            for (uint16_t d = 0; index != SM_EXP_NONE && d < SM_STATE_MAX_DEPTH; d++)
+            {
+                SmExpMark(&x->state_reached[index], 1);
+                index = x->parent[index];
+            }
+
+            worker->level = x->level[head];
+            uint32_t depth = atomic_load_explicit(&x->depth, memory_order_relaxed);
+            while (worker->level > depth && !atomic_compare_exchange_weak(&x->depth, &depth, worker->level))
+            {
+            }
+
+            SmExpSuccessors(x, key, false, true, SmExpBfsEmit, worker);
+            atomic_fetch_sub(&x->pending, 1);
+            continue;
+        }
+
+        if (atomic_load(&x->pending) == 0)
+        {
+            break;
+        }
+        SmOsYield();
+    }
+}
+
+/* ============================================================================
+ * 内部辅助函数: 环检测
+ * ============================================================================ */
+
+static void SmExpGraphEmit(void *arg, uint64_t to, uint8_t flags, uint32_t rule)
+{
+    SmExpGraph *graph = (SmExpGraph *)arg;
+    uint32_t node = SmExpLookup(graph->ctx, to);
+
+    if ((flags & SM_EXP_EDGE_INTERNAL) == 0 || node == UINT32_MAX || graph->failed)
+    {
+        return;
+    }
+
+    if (graph->count == graph->capacity)
+    {
+        size_t capacity = (graph->capacity == 0) ? 1024 : graph->capacity * 2;
+        SmExpEdge *edges = realloc(graph->edges, sizeof(SmExpEdge) * capacity);
+        if (edges == NULL)
+        {
+            graph->failed = true;
+            return;
+        }
+        graph->edges = edges;
+        graph->capacity = capacity;
+    }
+
+    graph->edges[graph->count++] = (SmExpEdge){ .to = node, .rule = rule, .flags = flags };
+}
+
+/**
+ * @brief 记录一个强连通分量
+ * @note 同一个环在不同的条件抽象值下会形成多个分量, 按(状态集合, 条件规则)合并;
+ *       报告取最小的状态下标/规则编号, 与线程调度无关
+ */
+static void SmExpReportLoop(SmExpCtx *x, SmExploreResult *result, const SmExpEdge *edges, const size_t *first,
+                            const uint32_t *members, uint32_t count, const uint32_t *comp, uint32_t id,
+                            uint32_t *stamp)
+{
+    bool cyclic = (count > 1);
+    bool callbacks = false;
+    bool completion = true;
+    uint32_t guard_rule = UINT32_MAX;
+    uint16_t guard_state = 0;
+
+    for (uint32_t m = 0; m < count; m++)
+    {
+        uint32_t node = members[m];
+        for (size_t e = first[node]; e < first[node + 1]; e++)
+        {
+            if (comp[edges[e].to] != id)
+            {
+                continue;
+            }
+            cyclic = cyclic || (edges[e].to == node);
+            callbacks = callbacks || (edges[e].flags & SM_EXP_EDGE_CALLBACK);
+            completion = completion && (edges[e].flags & SM_EXP_EDGE_COMPLETION);
+            if ((edges[e].flags & SM_EXP_EDGE_GUARD) && edges[e].rule < guard_rule)
+            {
+                guard_rule = edges[e].rule;
+                guard_state = SM_EXP_STATE(atomic_load(&x->queue[node]));
+            }
+        }
+    }
+
+    if (!cyclic || (guard_rule == UINT32_MAX && !completion))
+    {
+        return;
+    }
+
+    /* 统计分量涉及的不同状态 */
+    uint16_t states = 0;
+    uint16_t lowest = SM_EXP_NONE;
+    for (uint32_t m = 0; m < count; m++)
+    {
+        uint16_t s = SM_EXP_STATE(atomic_load(&x->queue[members[m]]));
+        lowest = (s < lowest) ? s : lowest;
+        if (stamp[s] != id + 1)
+        {
+            stamp[s] = id + 1;
+            states++;
+        }
+    }
+
+    SmExploreLoop loop = {
+        .configs = count,
+        .state = lowest,
+        .state_count = states,
+        .guard_rule = (guard_rule != UINT32_MAX) ? SmExpRule(x->sm_class, x->rule_first, guard_rule) : NULL,
+        .guard_state = guard_state,
+        .completion = completion,
+        .held = !callbacks,
+    };
+    for (uint16_t i = 0; i < result->loop_count; i++)
+    {
+        SmExploreLoop *seen = &result->loops[i];
+        if (seen->state == loop.state && seen->state_count == loop.state_count &&
+            seen->guard_rule == loop.guard_rule && seen->completion == loop.completion)
+        {
+            seen->configs += loop.configs;
+            seen->held = seen->held || loop.held;
+            return;
+        }
+    }
+
+    result->loops_total++;
+    if (result->loop_count < SM_EXPLORE_MAX_LOOPS)
+    {
+        result->loops[result->loop_count++] = loop;
+    }
+}
+
+/**
+ * @brief 在内部边上求强连通分量(迭代 Tarjan)
+ */
+static SmRetCode SmExpFindLoops(SmExpCtx *x, SmExploreResult *result, uint32_t nodes)
+{
+    SmExpGraph graph = { .ctx = x };
+    size_t *first = malloc(sizeof(size_t) * ((size_t)nodes + 1));
+
+    if (first == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 1. 按配置编号收集内部边(CSR) */
+    for (uint32_t n = 0; n < nodes && !graph.failed; n++)
+    {
+        first[n] = graph.count;
+        SmExpSuccessors(x, atomic_load(&x->queue[n]), true, false, SmExpGraphEmit, &graph);
+    }
+    first[nodes] = graph.count;
+
+    uint32_t *index = malloc(sizeof(uint32_t) * nodes);
+    uint32_t *low = malloc(sizeof(uint32_t) * nodes);
+    uint32_t *comp = malloc(sizeof(uint32_t) * nodes);
+    uint32_t *stack = malloc(sizeof(uint32_t) * nodes);
+    uint32_t *call = malloc(sizeof(uint32_t) * nodes);
+    size_t *next = malloc(sizeof(size_t) * nodes);
+    uint32_t *stamp = calloc(x->state_count, sizeof(uint32_t));
+    SmRetCode ret = SM_RET_ERROR;
+
+    if (graph.failed || index == NULL || low == NULL || comp == NULL || stack == NULL || call == NULL ||
+        next == NULL || stamp == NULL)
+    {
+        goto out;
+    }
+
+    /* 2. comp 在出栈前标记"在栈中"(UINT32_MAX - 1), 出栈后为分量编号 */
+    memset(index, 0xFF, sizeof(uint32_t) * nodes);
+    memset(comp, 0xFF, sizeof(uint32_t) * nodes);
+    uint32_t counter = 0;
+    uint32_t sp = 0;
+    uint32_t components = 0;
+    for (uint32_t root = 0; root < nodes; root++)
+    {
+        if (index[root] != UINT32_MAX || first[root] == first[root + 1])
+        {
+            continue;
+        }
+
+        uint32_t depth = 0;
+        call[depth++] = root;
+        index[root] = low[root] = counter++;
+        next[root] = first[root];
+        stack[sp++] = root;
+        comp[root] = UINT32_MAX - 1;
+
+        while (depth > 0)
+        {
+            uint32_t v = call[depth - 1];
+            if (next[v] < first[v + 1])
+            {
+                uint32_t w = graph.edges[next[v]++].to;
+                if (index[w] == UINT32_MAX)
+                {
+                    index[w] = low[w] = counter++;
+                    next[w] = first[w];
+                    stack[sp++] = w;
+                    comp[w] = UINT32_MAX - 1;
+                    call[depth++] = w;
+                }
+                else if (comp[w] == UINT32_MAX - 1 && index[w] < low[v])
+                {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            /* v 的边处理完毕 */
+            depth--;
+            if (depth > 0 && low[v] < low[call[depth - 1]])
+            {
+                low[call[depth - 1]] = low[v];
+            }
+            if (low[v] == index[v])
+            {
+                uint32_t top = sp;
+                do
+                {
+                    comp[stack[--sp]] = components;
+                } while (stack[sp] != v);
+                SmExpReportLoop(x, result, graph.edges, first, &stack[sp], top - sp, comp, components, stamp);
+                components++;
+            }
+        }
+    }
+    ret = SM_RET_OK;
+
+out:
+    free(stamp);
+    free(next);
+    free(call);
+    free(stack);
+    free(comp);
+    free(low);
+    free(index);
+    free(graph.edges);
+    free(first);
+    return ret;
+}
+
+/* ============================================================================
+ * 内部辅助函数: 初始化
+ * ============================================================================ */
+
+/**
+ * @brief 建立状态/规则/条件的索引
+ */
+static SmRetCode SmExpPrepare(SmExpCtx *x, const SmExploreConfig *config, SmExploreResult *result)
+{
+    const SmClass *sm_class = config->sm_class;
+    uint16_t n = sm_class->state_count;
+
+    x->sm_class = sm_class;
+    x->state_count = n;
+    x->parent = malloc(sizeof(uint16_t) * (n + 1u));
+    x->target_first = malloc(sizeof(uint32_t) * (n + 1u));
+    x->rule_first = malloc(sizeof(uint32_t) * (n + 1u));
+    uint8_t *mark = malloc(n + 1u);
+    if (x->parent == NULL || x->target_first == NULL || x->rule_first == NULL || mark == NULL)
+    {
+        free(mark);
+        return SM_RET_ERROR;
+    }
+
+    /* 1. 父状态与规则编号 */
+    uint32_t rules = 0;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        const SmState *state = &sm_class->states[i];
+        x->parent[i] = state->has_parent ? SmExpIndex(sm_class, state->parent) : SM_EXP_NONE;
+        x->rule_first[i] = rules;
+        rules += (state->transitions != NULL) ? state->trans_count : 0;
+    }
+    x->rule_first[n] = rules;
+    rules += (sm_class->any_transitions != NULL) ? sm_class->any_trans_count : 0;
+
+    /* 2. 每个状态作为转换目标时可能到达的叶子 */
+    uint32_t total = 0;
+    uint32_t capacity = n + 1u;
+    x->targets = malloc(sizeof(uint16_t) * capacity);
+    x->target_first[n] = UINT32_MAX;
+    for (uint16_t i = 0; i < n && x->targets != NULL; i++)
+    {
+        if (capacity - total < n)
+        {
+            capacity = capacity * 2 + n;
+            uint16_t *grown = realloc(x->targets, sizeof(uint16_t) * capacity);
+            if (grown == NULL)
+            {
+                break;
+            }
+            x->targets = grown;
+        }
+        memset(mark, 0, n);
+        x->target_first[i] = total;
+        SmExpResolve(x, i, mark, x->targets, &total);
+        x->target_first[i + 1] = total;
+    }
+    free(mark);
+
+    /* 3. 规则目标与条件编号(同一 condition + action_data 视为同一个条件) */
+    x->rule_target = malloc(sizeof(uint16_t) * (rules + 1u));
+    x->rule_guard = malloc(sizeof(uint16_t) * (rules + 1u));
+    x->rule_flags = calloc(rules + 1u, sizeof(atomic_uchar));
+    x->state_reached = calloc(n + 1u, sizeof(atomic_uchar));
+    if (x->targets == NULL || x->target_first[n] != total || x->rule_target == NULL || x->rule_guard == NULL ||
+        x->rule_flags == NULL || x->state_reached == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmConditionFn guard_fn[SM_EXPLORE_MAX_GUARDS];
+    void *guard_data[SM_EXPLORE_MAX_GUARDS];
+    for (uint32_t r = 0; r < rules; r++)
+    {
+        const SmTransition *trans = SmExpRule(sm_class, x->rule_first, r);
+        x->rule_target[r] = SmExpIndex(sm_class, trans->next_state);
+        x->rule_guard[r] = SM_EXP_NONE;
+        result->rules_total += (trans->event_id != SM_EVENT_INVALID);
+        if (trans->condition == NULL)
+        {
+            continue;
+        }
+
+        x->rule_guard[r] = SM_EXP_UNTRACKED;
+        for (uint16_t g = 0; g < result->guard_count; g++)
+        {
+            if (guard_fn[g] == trans->condition && guard_data[g] == trans->action_data)
+            {
+                x->rule_guard[r] = g;
+            }
+        }
+        if (x->rule_guard[r] == SM_EXP_UNTRACKED && result->guard_count < SM_EXPLORE_MAX_GUARDS)
+        {
+            guard_fn[result->guard_count] = trans->condition;
+            guard_data[result->guard_count] = trans->action_data;
+            x->rule_guard[r] = result->guard_count++;
+        }
+        result->guards_untracked = result->guards_untracked || (x->rule_guard[r] == SM_EXP_UNTRACKED);
+    }
+
+    /* 4. 自产生事件 */
+    for (uint16_t i = 0; config->auto_events != NULL && i < config->auto_count; i++)
+    {
+        if (config->auto_events[i] >= x->event_count)
+        {
+            x->event_count = (uint16_t)(config->auto_events[i] + 1);
+        }
+    }
+    x->auto_event = calloc(x->event_count + 1u, 1);
+    if (x->auto_event == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    for (uint16_t i = 0; config->auto_events != NULL && i < config->auto_count; i++)
+    {
+        if (config->auto_events[i] >= 0)
+        {
+            x->auto_event[config->auto_events[i]] = 1;
+        }
+    }
+
+    result->rule_count = rules;
+    return SM_RET_OK;
+}
+
+static void SmExpRelease(SmExpCtx *x)
+{
+    free(x->parent);
+    free(x->target_first);
+    free(x->targets);
+    free(x->rule_target);
+    free(x->rule_guard);
+    free(x->auto_event);
+    free(x->rule_flags);
+    free(x->state_reached);
+    free((void *)x->table);
+    free(x->table_index);
+    free((void *)x->queue);
+    free(x->level);
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmExploreRun(const SmExploreConfig *config, SmExploreResult *result)
+{
+    if (result == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    memset(result, 0, sizeof(SmExploreResult));
+    if (config == NULL || config->sm_class == NULL || config->sm_class->states == NULL ||
+        config->sm_class->state_count == 0 || config->max_configs == 0 ||
+        config->thread_count > SM_EXPLORE_MAX_THREADS)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmExpCtx x;
+    memset(&x, 0, sizeof(x));
+    result->sm_class = config->sm_class;
+    if (SmExpPrepare(&x, config, result) != SM_RET_OK)
+    {
+        SmExpRelease(&x);
+        free(x.rule_first);
+        return SM_RET_ERROR;
+    }
+    result->rule_first = x.rule_first;
+
+    /* 访问集合至少为配置数上限的两倍, 开放寻址探测保持较短 */
+    uint64_t capacity = 1024;
+    while (capacity < (uint64_t)config->max_configs * 2)
+    {
+        capacity *= 2;
+    }
+    x.mask = capacity - 1;
+    x.max_configs = config->max_configs;
+    x.table = malloc(sizeof(uint64_t) * capacity);
+    x.table_index = malloc(sizeof(uint32_t) * capacity);
+    x.queue = malloc(sizeof(uint64_t) * config->max_configs);
+    x.level = malloc(sizeof(uint32_t) * config->max_configs);
+    if (x.table == NULL || x.table_index == NULL || x.queue == NULL || x.level == NULL)
+    {
+        SmExpRelease(&x);
+        SmExploreFree(result);
+        return SM_RET_ERROR;
+    }
+    memset((void *)x.table, 0xFF, sizeof(uint64_t) * capacity);
+    memset((void *)x.queue, 0xFF, sizeof(uint64_t) * config->max_configs);
+
+    /* 1. 初始配置: SmStart 解析出的叶子, 条件全部未知 */
+    uint64_t start = SmExpNowNs();
+    uint16_t initial = SmExpIndex(config->sm_class, config->initial_state);
+    for (uint32_t i = (initial != SM_EXP_NONE) ? x.target_first[initial] : 0;
+         initial != SM_EXP_NONE && i < x.target_first[initial + 1]; i++)
+    {
+        SmExpVisit(&x, SM_EXP_KEY(x.targets[i], 0, 0), 0);
+    }
+
+    /* 2. 多线程展开 */
+    uint32_t threads = (config->thread_count == 0) ? 1 : config->thread_count;
+    SmExpWorker workers[SM_EXPLORE_MAX_THREADS];
+    SmOsThread tids[SM_EXPLORE_MAX_THREADS];
+    uint32_t started = 0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers[t] = (SmExpWorker){ .ctx = &x };
+    }
+    for (uint32_t t = 1; t < threads; t++)
+    {
+        if (SmOsThreadCreate(&tids[t], SmExpWorkerMain, &workers[t]) != SM_RET_OK)
+        {
+            break;
+        }
+        started = t;
+    }
+    SmExpWorkerMain(&workers[0]);
+    for (uint32_t t = 1; t <= started; t++)
+    {
+        SmOsThreadJoin(&tids[t]);
+    }
+
+    uint32_t nodes = atomic_load(&x.tail);
+    result->thread_count = started + 1;
+    result->configs = nodes;
+    result->depth = atomic_load(&x.depth);
+    result->truncated = atomic_load(&x.truncated);
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        result->edges += workers[t].edges;
+    }
+
+    /* 3. 环检测 */
+    SmRetCode ret = SmExpFindLoops(&x, result, nodes);
+    result->elapsed_ns = SmExpNowNs() - start;
+
+    /* 4. 汇总覆盖率 */
+    result->state_reached = malloc(x.state_count);
+    result->rule_flags = malloc(result->rule_count + 1u);
+    if (result->state_reached == NULL || result->rule_flags == NULL)
+    {
+        ret = SM_RET_ERROR;
+    }
+    for (uint16_t i = 0; ret == SM_RET_OK && i < x.state_count; i++)
+    {
+        result->state_reached[i] = atomic_load(&x.state_reached[i]);
+        result->states_reached += result->state_reached[i];
+    }
+    for (uint32_t r = 0; ret == SM_RET_OK && r < result->rule_count; r++)
+    {
+        result->rule_flags[r] = atomic_load(&x.rule_flags[r]);
+        result->rules_fired += (result->rule_flags[r] & SM_EXPLORE_RULE_FIRED) != 0;
+    }
+
+    SmExpRelease(&x);
+    if (ret != SM_RET_OK)
+    {
+        SmExploreFree(result);
+    }
+    return ret;
+}
+
+/**
+ * @brief 事件名称(报告用)
+ */
+static const char *SmExpEventName(const SmClass *sm_class, SmEventId event, char *buf, size_t size)
+{
+    if (event == SM_EVENT_COMPLETION)
+    {
+        return "(completion)";
+    }
+
+    const char *name = SmGetEventName(sm_class, event);
+    if (name != NULL)
+    {
+        return name;
+    }
+    snprintf(buf, size, "#%d", event);
+    return buf;
+}
+
+void SmExplorePrint(const SmExploreResult *result, FILE *out)
+{
+    if (result == NULL || out == NULL || result->sm_class == NULL || result->rule_first == NULL)
+    {
+        return;
+    }
+
+    const SmClass *sm_class = result->sm_class;
+    char buf[16];
+
+    fprintf(out, "explore %s: %llu configs, %llu edges, depth %u, %u threads, %.2f ms%s\n",
+            (sm_class->class_name != NULL) ? sm_class->class_name : "?", (unsigned long long)result->configs,
+            (unsigned long long)result->edges, result->depth, result->thread_count, result->elapsed_ns / 1e6,
+            result->truncated ? " (TRUNCATED)" : "");
+
+    /* 1. 状态覆盖 */
+    uint16_t listed = 0;
+    fprintf(out, "  states : %u/%u reached\n", result->states_reached, sm_class->state_count);
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        const SmState *state = &sm_class->states[i];
+        if (result->state_reached[i] || state->kind == SM_STATE_HISTORY_SHALLOW ||
+            state->kind == SM_STATE_HISTORY_DEEP)
+        {
+            continue;
+        }
+        if (listed++ < SM_EXP_REPORT_LIST)
+        {
+            fprintf(out, "    unreachable: %s\n", (state->state_name != NULL) ? state->state_name : "?");
+        }
+    }
+    if (listed > SM_EXP_REPORT_LIST)
+    {
+        fprintf(out, "    ... %u more unreachable\n", listed - SM_EXP_REPORT_LIST);
+    }
+
+    /* 2. 死转换(结束标记不计) */
+    uint32_t dead = 0;
+    fprintf(out, "  rules  : %u/%u fired\n", result->rules_fired, result->rules_total);
+    for (uint32_t r = 0; r < result->rule_count; r++)
+    {
+        const SmTransition *trans = SmExpRule(sm_class, result->rule_first, r);
+        if ((result->rule_flags[r] & SM_EXPLORE_RULE_FIRED) || trans->event_id == SM_EVENT_INVALID)
+        {
+            continue;
+        }
+        if (dead++ >= SM_EXP_REPORT_LIST)
+        {
+            continue;
+        }
+
+        bool any = (r >= result->rule_first[sm_class->state_count]);
+        uint16_t owner = 0;
+        while (!any && result->rule_first[owner + 1] <= r)
+        {
+            owner++;
+        }
+        const char *reason = (!any && !result->state_reached[owner]) ? "state unreachable"
+                             : (result->rule_flags[r] & SM_EXPLORE_RULE_SELECTED) ? "guard never true"
+                                                                                  : "shadowed";
+        uint16_t target = SmExpIndex(sm_class, trans->next_state);
+        fprintf(out, "    dead: %s --%s--> %s (%s)\n",
+                any ? "*" : sm_class->states[owner].state_name,
+                SmExpEventName(sm_class, trans->event_id, buf, sizeof(buf)),
+                (trans->kind == SM_TRANS_KIND_INTERNAL) ? "(internal)"
+                : (target != SM_EXP_NONE)               ? sm_class->states[target].state_name
+                                                        : "?",
+                reason);
+    }
+    if (dead > SM_EXP_REPORT_LIST)
+    {
+        fprintf(out, "    ... %u more dead\n", dead - SM_EXP_REPORT_LIST);
+    }
+
+    /* 3. 环 */
+    fprintf(out, "  guards : %u tracked%s\n", result->guard_count, result->guards_untracked ? " (+ untracked)" : "");
+    fprintf(out, "  loops  : %u\n", result->loops_total);
+    for (uint16_t i = 0; i < result->loop_count; i++)
+    {
+        const SmExploreLoop *loop = &result->loops[i];
+        fprintf(out, "    loop: %u configs over %u states from %s, ", loop->configs, loop->state_count,
+                sm_class->states[loop->state].state_name);
+        if (loop->completion)
+        {
+            fprintf(out, "completion transitions only%s\n", loop->held ? ", no callbacks (always fails)" : "");
+        }
+        else
+        {
+            fprintf(out, "exits only when %s --%s--> guard turns false%s\n",
+                    sm_class->states[loop->guard_state].state_name,
+                    SmExpEventName(sm_class, loop->guard_rule->event_id, buf, sizeof(buf)),
+                    loop->held ? "; no callback on the loop can change it (livelock)" : "");
+        }
+    }
+}
+
+SmRetCode SmExplorePrune(const SmExploreResult *result, SmState *states, SmTransition *transitions,
+                         SmClass *pruned)
+{
+    if (result == NULL || result->sm_class == NULL || result->rule_flags == NULL || result->truncated ||
+        states == NULL || transitions == NULL || pruned == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const SmClass *sm_class = result->sm_class;
+    uint32_t any_first = result->rule_first[sm_class->state_count];
+    uint32_t used = 0;
+
+    /* 保留被选中且触发过的规则; 不可达状态的规则从未被选中, 随之删除 */
+    *pruned = *sm_class;
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        states[i] = sm_class->states[i];
+        states[i].transitions = &transitions[used];
+        states[i].trans_count = 0;
+        for (uint32_t r = result->rule_first[i]; r < result->rule_first[i + 1]; r++)
+        {
+            const SmTransition *trans = &sm_class->states[i].transitions[r - result->rule_first[i]];
+            uint8_t flags = result->rule_flags[r];
+            if (!(flags & SM_EXPLORE_RULE_SELECTED))
+            {
+                continue;
+            }
+
+            /* 条件从不成立的规则: 删除后同事件的通配转换会顶替它, 这种情况保留 */
+            bool keep = (flags & SM_EXPLORE_RULE_FIRED) != 0;
+            for (uint16_t a = 0; !keep && !sm_class->states[i].any_opt_out && a < sm_class->any_trans_count; a++)
+            {
+                keep = (sm_class->any_transitions[a].event_id == trans->event_id);
+            }
+            if (keep)
+            {
+                transitions[used++] = *trans;
+                states[i].trans_count++;
+            }
+        }
+    }
+
+    /* 通配转换的同事件后续规则从未被选中, 删除条件从不成立的通配转换后不会被顶替 */
+    pruned->any_transitions = &transitions[used];
+    pruned->any_trans_count = 0;
+    for (uint32_t r = any_first; r < result->rule_count; r++)
+    {
+        if ((result->rule_flags[r] & SM_EXPLORE_RULE_SELECTED) && (result->rule_flags[r] & SM_EXPLORE_RULE_FIRED))
+        {
+            transitions[used++] = sm_class->any_transitions[r - any_first];
+            pruned->any_trans_count++;
+        }
+    }
+
+    /* 编译产物需按裁剪后的规则重新生成 */
+    pruned->states = states;
+    pruned->table = NULL;
+    return SM_RET_OK;
+}
+
+void SmExploreFree(SmExploreResult *result)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+
+    free(result->state_reached);
+    free(result->rule_first);
+    free(result->rule_flags);
+    result->state_reached = NULL;
+    result->rule_first = NULL;
+    result->rule_flags = NULL;
+}
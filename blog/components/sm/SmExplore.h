@@ -0,0 +1,138 @@
+#ifndef __SMEXPLORE_H__
+#define __SMEXPLORE_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 可达性分析
+ * ============================================================================ */
+
+/*
+ * 部署新类之前, 在不运行回调的前提下穷举类的可达配置, 回答:
+ *   - 哪些状态永远到达不了
+ *   - 哪些转换规则永远不会触发(状态不可达/被同事件的前一条规则遮蔽/条件从不成立)
+ *   - 哪些环只靠条件函数退出(例如 CanRetryConnect 一直返回 true 时的重连环)
+ *
+ * 配置 = (叶子状态, 条件抽象值). 条件函数按 (condition, action_data) 区分, 视为
+ * 用户数据上的谓词, 每个取 未知/真/假 三值:
+ *   - 求值未知条件时两个分支都探索, 结果记住(条件无副作用, 数据未变)
+ *   - 转换执行了回调(动作, 退出/进入函数)后数据可能改变, 全部条件重置为未知
+ *   - 超过 SM_EXPLORE_MAX_GUARDS 个条件时, 其余条件每次求值都两个分支都探索
+ * 分发语义与 SmMgr 一致: 只取状态的第一条匹配规则(无匹配时取通配转换), 条件
+ * 不成立即忽略事件; 完成转换在进入状态后立即执行; 延迟的事件在当前状态无效果;
+ * on_handle 不改变状态, 不参与分析.
+ *
+ * 多线程按广度优先探索: 访问集合为开放寻址哈希表(CAS 插入, 无锁), 工作队列为
+ * 只追加数组, 各线程以原子计数领取; 所有入队配置处理完毕时结束.
+ *
+ * 环检测: 在"内部边"(完成转换及 auto_events 中由定时器/驱动自行产生的事件)
+ * 构成的子图上求强连通分量. 包含条件成立的边或只由完成转换组成的分量即报告;
+ * 分量内没有任何回调时条件结果无法改变, 一旦进入就永远循环(held).
+ */
+
+#define SM_EXPLORE_MAX_GUARDS  16 /* 跟踪三值的条件数量上限 */
+#define SM_EXPLORE_MAX_THREADS 64 /* 最大线程数 */
+#define SM_EXPLORE_MAX_LOOPS   32 /* 报告的环数量上限 */
+
+#define SM_EXPLORE_RULE_SELECTED 0x01 /* 规则在某个可达配置中被选中(不论条件) */
+#define SM_EXPLORE_RULE_FIRED    0x02 /* 规则在某个可达配置中触发 */
+
+/**
+ * @brief 分析配置
+ */
+typedef struct
+{
+    const SmClass *sm_class;       /* 状态机类 */
+    SmStateId initial_state;       /* 初始状态(同 SmStart) */
+    const SmEventId *auto_events;  /* 由定时器/驱动自行产生的事件(可选, 用于环检测) */
+    uint16_t auto_count;           /* auto_events 数量 */
+    uint32_t thread_count;         /* 线程数量(1..SM_EXPLORE_MAX_THREADS) */
+    uint32_t max_configs;          /* 最多探索的配置数, 超出时结果标记为不完整 */
+} SmExploreConfig;
+
+/**
+ * @brief 只靠条件退出的环(内部边上的强连通分量)
+ */
+typedef struct
+{
+    uint32_t configs;               /* 环上的配置数(合并后的总数) */
+    uint16_t state;                 /* 环上最小的状态下标 */
+    uint16_t state_count;           /* 分量涉及的不同状态数 */
+    const SmTransition *guard_rule; /* 分量内条件成立的一条规则(只有完成转换时可为NULL) */
+    uint16_t guard_state;           /* guard_rule 所属的状态下标(通配转换为触发时的状态) */
+    bool completion;                /* 只由完成转换组成(SmRunCompletions 将报错) */
+    bool held;                      /* 分量内没有回调, 条件结果不会改变 */
+} SmExploreLoop;
+
+/**
+ * @brief 分析结果
+ */
+typedef struct
+{
+    const SmClass *sm_class;                  /* 状态机类 */
+    uint64_t configs;                         /* 可达配置数 */
+    uint64_t edges;                           /* 探索的边数 */
+    uint32_t depth;                           /* 最大探索深度 */
+    bool truncated;                           /* 配置数达到 max_configs, 结果不完整 */
+    uint64_t elapsed_ns;                      /* 探索耗时 */
+    uint32_t thread_count;                    /* 使用的线程数 */
+    uint16_t states_reached;                  /* 到达过的状态数(叶子及其所属组合状态) */
+    uint8_t *state_reached;                   /* 状态是否到达过 [state_count] */
+    uint32_t rule_count;                      /* 规则编号数(状态转换 + 通配转换, 含结束标记) */
+    uint32_t rules_total;                     /* 有效规则数(不含 SM_TRANS_END 结束标记) */
+    uint32_t rules_fired;                     /* 触发过的规则数 */
+    uint32_t *rule_first;                     /* 规则编号起点 [state_count + 1], 通配转换从 rule_first[state_count] 开始 */
+    uint8_t *rule_flags;                      /* SM_EXPLORE_RULE_* [rule_count] */
+    uint16_t guard_count;                     /* 跟踪三值的条件数 */
+    bool guards_untracked;                    /* 存在超出上限、未跟踪的条件 */
+    uint16_t loop_count;                      /* 报告的环数 */
+    uint32_t loops_total;                     /* 发现的不同环总数(可能超过上限) */
+    SmExploreLoop loops[SM_EXPLORE_MAX_LOOPS]; /* 环 */
+} SmExploreResult;
+
+/**
+ * @brief 探索类的可达配置
+ * @param config 分析配置
+ * @param result 分析结果(输出, 用完后调用 SmExploreFree)
+ * @return SM_RET_OK 成功, 其他 参数无效或内存不足
+ */
+SmRetCode SmExploreRun(const SmExploreConfig *config, SmExploreResult *result);
+
+/**
+ * @brief 打印覆盖率/死转换/环报告
+ * @param result 分析结果
+ * @param out 输出文件
+ */
+void SmExplorePrint(const SmExploreResult *result, FILE *out);
+
+/**
+ * @brief 生成裁剪后的类: 删除从未被选中的规则(不可达状态的规则, 被遮蔽的规则, 结束标记)
+ *        和条件从不成立的规则(状态自身规则有同事件通配转换可顶替时保留)
+ * @param result 分析结果(不能是不完整的结果)
+ * @param states 状态存储 [state_count]
+ * @param transitions 转换存储 [rule_count]
+ * @param pruned 裁剪后的类(输出, 可再用 SmTableBuild 编译)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效或结果不完整
+ * @note 只删除不影响分发结果的规则; 假定实例只通过 SmStart/SmSendEvent 改变状态,
+ *       条件只取决于回调修改的用户数据(与探索的假定相同)
+ */
+SmRetCode SmExplorePrune(const SmExploreResult *result, SmState *states, SmTransition *transitions,
+                         SmClass *pruned);
+
+/**
+ * @brief 释放分析结果
+ * @param result 分析结果
+ */
+void SmExploreFree(SmExploreResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMEXPLORE_H__ */
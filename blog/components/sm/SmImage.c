@@ -0,0 +1,1708 @@
+#define _POSIX_C_SOURCE 200809L /* O_CLOEXEC/strdup */
+
+#include "SmImage.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * 描述文本格式(每行一条, '#' 之后为注释, 状态/事件可用名称或数字引用):
+ *   class <名称> [init=<符号>] [deinit=<符号>]
+ *   event <ID> <名称> [lane=<通道>]
+ *   state <ID> <名称> [enter=<符号>] [exit=<符号>] [handle=<符号>] [handles=<事件>,<事件>]
+ *                     [defers=<事件>,<事件>] [dwell=<时间>] [parent=<状态>] [no_any]
+ *   composite <ID> <名称> initial=<状态> [enter=<符号>] [exit=<符号>] [parent=<状态>]
+ *   history <ID> <名称> parent=<状态> default=<状态> [deep]
+ *   trans <状态> <事件> <目标状态> [cond=<符号>] [action=<符号>] [data=<符号>] [kind=internal|local]
+ *         (事件写作 completion 表示完成转换)
+ *   any <事件> <目标状态> [cond=<符号>] [action=<符号>] [data=<符号>]
+ */
+
+/* ============================================================================
+ * 内部定义
+ * ============================================================================ */
+
+#define SM_IMG_ALIGN      8         /* 段对齐 */
+#define SM_IMG_ANY_STATE  INT32_MIN /* 通配转换的源状态 */
+#define SM_IMG_MAX_TOKENS 16        /* 描述行最多字段数 */
+
+/**
+ * @brief 动态字节缓冲区
+ */
+typedef struct
+{
+    uint8_t *data; /* 数据 */
+    size_t size;   /* 已用大小 */
+    size_t cap;    /* 容量 */
+    bool failed;   /* 内存不足 */
+} SmImgBuf;
+
+/**
+ * @brief 构建中的状态
+ */
+typedef struct
+{
+    int32_t state_id;    /* 状态ID */
+    uint32_t name;       /* 状态名(字符串偏移) */
+    uint8_t kind;        /* 状态种类 */
+    uint8_t flags;       /* SM_IMAGE_STATE_xxx */
+    int32_t parent;      /* 所属组合状态ID */
+    int32_t initial;     /* 初始子状态/历史默认目标 */
+    uint16_t enter_sym;  /* 进入回调符号 */
+    uint16_t exit_sym;   /* 退出回调符号 */
+    uint16_t handle_sym; /* 处理回调符号 */
+    SmEventId *handles;  /* on_handle 事件列表(malloc, 以 SM_EVENT_INVALID 结尾) */
+    SmEventId *defers;   /* 延迟事件列表(malloc, 以 SM_EVENT_INVALID 结尾) */
+    uint32_t dwell;      /* 最长停留时间 */
+} SmImgState;
+
+/**
+ * @brief 构建中的转换
+ */
+typedef struct
+{
+    int32_t from;        /* 源状态ID, SM_IMG_ANY_STATE 表示通配转换 */
+    int32_t event_id;    /* 事件ID */
+    int32_t next_state;  /* 目标状态ID */
+    uint16_t cond_sym;   /* 条件回调符号 */
+    uint16_t action_sym; /* 动作回调符号 */
+    uint16_t data_sym;   /* 动作数据符号 */
+    uint8_t kind;        /* 转换种类 */
+} SmImgTrans;
+
+/**
+ * @brief 镜像构建器
+ */
+typedef struct
+{
+    SmImgBuf strings;      /* 字符串段 */
+    uint32_t class_name;   /* 类名 */
+    uint16_t init_sym;     /* 类初始化回调符号 */
+    uint16_t deinit_sym;   /* 类反初始化回调符号 */
+    uint16_t event_count;  /* 事件数量 */
+    uint32_t *event_names; /* 事件名 [event_count], 可为NULL */
+    uint8_t *lanes;        /* 通道表 [event_count], 可为NULL */
+    SmImgState *states;    /* 状态 */
+    uint16_t state_count;  /* 状态数量 */
+    SmImgTrans *trans;     /* 转换 */
+    uint32_t trans_count;  /* 转换数量 */
+    uint32_t *symbols;     /* 符号名 [symbol_count](字符串偏移) */
+    uint16_t symbol_count; /* 符号数量 */
+    char *error;           /* 错误信息输出 */
+    size_t error_size;     /* 错误信息缓冲区大小 */
+} SmImgBuilder;
+
+/* ============================================================================
+ * 内部辅助函数: 通用
+ * ============================================================================ */
+
+static void SmImgError(char *error, size_t size, const char *fmt, ...)
+{
+    va_list args;
+
+    if (error == NULL || size == 0)
+    {
+        return;
+    }
+    va_start(args, fmt);
+    vsnprintf(error, size, fmt, args);
+    va_end(args);
+}
+
+/**
+ * @brief FNV-1a 校验和
+ */
+static uint32_t SmImgChecksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void *SmImgGrow(void *ptr, size_t count, size_t elem)
+{
+    /* 容量按 2 的幂增长, count 为增长后的元素个数 */
+    if (count == 0 || (count & (count - 1)) != 0)
+    {
+        return ptr;
+    }
+    return realloc(ptr, count * 2 * elem);
+}
+
+static void SmImgBufAppend(SmImgBuf *buf, const void *data, size_t size)
+{
+    if (buf->failed)
+    {
+        return;
+    }
+
+    if (buf->size + size > buf->cap)
+    {
+        size_t cap = (buf->cap == 0) ? 256 : buf->cap;
+        while (cap < buf->size + size)
+        {
+            cap *= 2;
+        }
+        uint8_t *grown = realloc(buf->data, cap);
+        if (grown == NULL)
+        {
+            buf->failed = true;
+            return;
+        }
+        buf->data = grown;
+        buf->cap = cap;
+    }
+
+    if (data != NULL)
+    {
+        memcpy(buf->data + buf->size, data, size);
+    }
+    else
+    {
+        memset(buf->data + buf->size, 0, size);
+    }
+    buf->size += size;
+}
+
+/**
+ * @brief 对齐缓冲区并返回当前偏移
+ */
+static uint32_t SmImgBufAlign(SmImgBuf *buf)
+{
+    size_t pad = (SM_IMG_ALIGN - (buf->size % SM_IMG_ALIGN)) % SM_IMG_ALIGN;
+    SmImgBufAppend(buf, NULL, pad);
+    return (uint32_t)buf->size;
+}
+
+/**
+ * @brief 追加事件列表(含结束标记), 返回偏移, NULL 返回 SM_IMAGE_NONE
+ */
+static uint32_t SmImgAppendEvents(SmImgBuf *buf, const SmEventId *events)
+{
+    if (events == NULL)
+    {
+        return SM_IMAGE_NONE;
+    }
+
+    uint32_t count = 0;
+    while (events[count] != SM_EVENT_INVALID)
+    {
+        count++;
+    }
+    uint32_t offset = SmImgBufAlign(buf);
+    SmImgBufAppend(buf, events, sizeof(SmEventId) * (count + 1));
+    return offset;
+}
+
+/* ============================================================================
+ * 内部辅助函数: 构建器
+ * ============================================================================ */
+
+static uint32_t SmImgAddString(SmImgBuilder *b, const char *str)
+{
+    uint32_t offset = (uint32_t)b->strings.size;
+    SmImgBufAppend(&b->strings, str, strlen(str) + 1);
+    return offset;
+}
+
+static const char *SmImgString(const SmImgBuilder *b, uint32_t offset)
+{
+    return (const char *)b->strings.data + offset;
+}
+
+/**
+ * @brief 登记符号名, 返回符号ID(从1开始)
+ */
+static uint16_t SmImgIntern(SmImgBuilder *b, const char *name)
+{
+    if (name == NULL || name[0] == '\0')
+    {
+        return SM_IMAGE_NO_SYM;
+    }
+
+    for (uint16_t i = 0; i < b->symbol_count; i++)
+    {
+        if (strcmp(SmImgString(b, b->symbols[i]), name) == 0)
+        {
+            return (uint16_t)(i + 1);
+        }
+    }
+
+    if (b->symbol_count == UINT16_MAX - 1)
+    {
+        return SM_IMAGE_NO_SYM;
+    }
+    uint32_t *symbols = (b->symbol_count == 0) ? malloc(sizeof(uint32_t))
+                                               : SmImgGrow(b->symbols, b->symbol_count, sizeof(uint32_t));
+    if (symbols == NULL)
+    {
+        b->strings.failed = true;
+        return SM_IMAGE_NO_SYM;
+    }
+
+    b->symbols = symbols;
+    b->symbols[b->symbol_count++] = SmImgAddString(b, name);
+    return b->symbol_count;
+}
+
+static SmImgState *SmImgAddState(SmImgBuilder *b)
+{
+    SmImgState *states = (b->state_count == 0) ? malloc(sizeof(SmImgState))
+                                               : SmImgGrow(b->states, b->state_count, sizeof(SmImgState));
+    if (states == NULL || b->state_count == UINT16_MAX)
+    {
+        b->strings.failed = true;
+        return NULL;
+    }
+
+    b->states = states;
+    SmImgState *state = &b->states[b->state_count++];
+    memset(state, 0, sizeof(SmImgState));
+    state->parent = SM_STATE_INVALID;
+    state->initial = SM_STATE_INVALID;
+    return state;
+}
+
+static SmImgTrans *SmImgAddTrans(SmImgBuilder *b)
+{
+    SmImgTrans *trans = (b->trans_count == 0) ? malloc(sizeof(SmImgTrans))
+                                              : SmImgGrow(b->trans, b->trans_count, sizeof(SmImgTrans));
+    if (trans == NULL)
+    {
+        b->strings.failed = true;
+        return NULL;
+    }
+
+    b->trans = trans;
+    SmImgTrans *t = &b->trans[b->trans_count++];
+    memset(t, 0, sizeof(SmImgTrans));
+    return t;
+}
+
+static void SmImgBuilderFree(SmImgBuilder *b)
+{
+    for (uint16_t i = 0; i < b->state_count; i++)
+    {
+        free(b->states[i].handles);
+        free(b->states[i].defers);
+    }
+    free(b->states);
+    free(b->trans);
+    free(b->symbols);
+    free(b->event_names);
+    free(b->lanes);
+    free(b->strings.data);
+    memset(b, 0, sizeof(SmImgBuilder));
+}
+
+static int SmImgCompareState(const void *a, const void *b)
+{
+    const SmImgState *sa = (const SmImgState *)a;
+    const SmImgState *sb = (const SmImgState *)b;
+    return (sa->state_id > sb->state_id) - (sa->state_id < sb->state_id);
+}
+
+static SmRetCode SmImgDummyHandle(SmHandle handle, SmEventId event)
+{
+    (void)handle;
+    (void)event;
+    return SM_RET_IGNORE;
+}
+
+/**
+ * @brief 生成压缩转换表(借助临时 SmClass 调用 SmTableBuild)
+ */
+static void *SmImgBuildTable(const SmImgBuilder *b, const uint32_t *first, SmTable *table)
+{
+    SmState *states = calloc(b->state_count, sizeof(SmState));
+    SmTransition *trans = calloc(b->trans_count + 1, sizeof(SmTransition));
+    void *buf = NULL;
+
+    if (states == NULL || trans == NULL)
+    {
+        goto out;
+    }
+
+    /* 转换按源状态排列, 与镜像的转换段一致 */
+    uint32_t n = 0;
+    for (uint16_t s = 0; s < b->state_count; s++)
+    {
+        states[s].state_id = b->states[s].state_id;
+        states[s].transitions = &trans[first[s]];
+        states[s].on_handle = (b->states[s].handle_sym != SM_IMAGE_NO_SYM) ? SmImgDummyHandle : NULL;
+        states[s].handle_events = b->states[s].handles;
+        states[s].deferred_events = b->states[s].defers;
+        states[s].parent = b->states[s].parent;
+        states[s].has_parent = (b->states[s].flags & SM_IMAGE_STATE_HAS_PARENT) != 0;
+        states[s].any_opt_out = (b->states[s].flags & SM_IMAGE_STATE_NO_ANY) != 0;
+        states[s].kind = b->states[s].kind;
+        for (uint32_t t = 0; t < b->trans_count; t++)
+        {
+            if (b->trans[t].from == b->states[s].state_id)
+            {
+                trans[n].event_id = b->trans[t].event_id;
+                trans[n].next_state = b->trans[t].next_state;
+                states[s].trans_count++;
+                n++;
+            }
+        }
+    }
+    uint32_t any_first = n;
+    for (uint32_t t = 0; t < b->trans_count; t++)
+    {
+        if (b->trans[t].from == SM_IMG_ANY_STATE)
+        {
+            trans[n].event_id = b->trans[t].event_id;
+            trans[n].next_state = b->trans[t].next_state;
+            n++;
+        }
+    }
+
+    SmClass sm_class = {
+        .class_name = "image",
+        .states = states,
+        .state_count = b->state_count,
+        .event_count = b->event_count,
+        .any_transitions = &trans[any_first],
+        .any_trans_count = (uint16_t)(n - any_first),
+    };
+
+    /* 不满足约束(状态ID与下标不一致等)时镜像不含转换表, 加载后线性查找 */
+    size_t size = SmTableCalcSize(&sm_class);
+    if (size == 0 || (buf = malloc(size)) == NULL)
+    {
+        goto out;
+    }
+    if (SmTableBuild(table, &sm_class, buf, size) != SM_RET_OK)
+    {
+        free(buf);
+        buf = NULL;
+    }
+
+out:
+    free(trans);
+    free(states);
+    return buf;
+}
+
+/**
+ * @brief 序列化为镜像
+ */
+static SmRetCode SmImgFinish(SmImgBuilder *b, SmImageBlob *blob)
+{
+    SmImgBuf out = { 0 };
+    SmImageHeader header;
+    SmTable table;
+    uint32_t *first = NULL;
+    void *table_buf = NULL;
+    uint16_t any_count = 0;
+
+    if (b->strings.failed)
+    {
+        SmImgError(b->error, b->error_size, "out of memory");
+        return SM_RET_ERROR;
+    }
+    if (b->state_count == 0)
+    {
+        SmImgError(b->error, b->error_size, "class has no states");
+        return SM_RET_ERROR;
+    }
+
+    /* 每个状态的第一个转换下标 */
+    first = calloc(b->state_count, sizeof(uint32_t));
+    if (first == NULL)
+    {
+        SmImgError(b->error, b->error_size, "out of memory");
+        return SM_RET_ERROR;
+    }
+    uint32_t state_trans = 0;
+    for (uint16_t s = 0; s < b->state_count; s++)
+    {
+        first[s] = state_trans;
+        uint32_t count = 0;
+        for (uint32_t t = 0; t < b->trans_count; t++)
+        {
+            count += (b->trans[t].from == b->states[s].state_id);
+        }
+        if (count > UINT16_MAX)
+        {
+            SmImgError(b->error, b->error_size, "state %s has too many transitions",
+                       SmImgString(b, b->states[s].name));
+            free(first);
+            return SM_RET_ERROR;
+        }
+        state_trans += count;
+    }
+    for (uint32_t t = 0; t < b->trans_count; t++)
+    {
+        any_count += (b->trans[t].from == SM_IMG_ANY_STATE);
+    }
+    if (state_trans + any_count != b->trans_count)
+    {
+        SmImgError(b->error, b->error_size, "transition from undefined state");
+        free(first);
+        return SM_RET_ERROR;
+    }
+
+    table_buf = SmImgBuildTable(b, first, &table);
+
+    memset(&header, 0, sizeof(header));
+    SmImgBufAppend(&out, NULL, sizeof(header));
+
+    /* 状态 */
+    header.states = SmImgBufAlign(&out);
+    SmImgBufAppend(&out, NULL, sizeof(SmImageState) * b->state_count);
+
+    /* 转换: 各状态连续排列, 通配转换在最后 */
+    header.transitions = SmImgBufAlign(&out);
+    for (uint16_t s = 0; s < b->state_count; s++)
+    {
+        for (uint32_t t = 0; t < b->trans_count; t++)
+        {
+            if (b->trans[t].from == b->states[s].state_id)
+            {
+                SmImageTrans it = {
+                    .event_id = b->trans[t].event_id,
+                    .next_state = b->trans[t].next_state,
+                    .cond_sym = b->trans[t].cond_sym,
+                    .action_sym = b->trans[t].action_sym,
+                    .data_sym = b->trans[t].data_sym,
+                    .kind = b->trans[t].kind,
+                };
+                SmImgBufAppend(&out, &it, sizeof(it));
+            }
+        }
+    }
+    for (uint32_t t = 0; t < b->trans_count; t++)
+    {
+        if (b->trans[t].from == SM_IMG_ANY_STATE)
+        {
+            SmImageTrans it = {
+                .event_id = b->trans[t].event_id,
+                .next_state = b->trans[t].next_state,
+                .cond_sym = b->trans[t].cond_sym,
+                .action_sym = b->trans[t].action_sym,
+                .data_sym = b->trans[t].data_sym,
+                .kind = b->trans[t].kind,
+            };
+            SmImgBufAppend(&out, &it, sizeof(it));
+        }
+    }
+
+    /* on_handle 事件列表, 同时填写状态段 */
+    for (uint16_t s = 0; s < b->state_count; s++)
+    {
+        const SmImgState *state = &b->states[s];
+        SmImageState is = {
+            .state_id = state->state_id,
+            .name = state->name,
+            .trans_first = first[s],
+            .trans_count = (uint16_t)(((s + 1 < b->state_count) ? first[s + 1] : state_trans) - first[s]),
+            .kind = state->kind,
+            .flags = state->flags,
+            .parent = state->parent,
+            .initial = state->initial,
+            .enter_sym = state->enter_sym,
+            .exit_sym = state->exit_sym,
+            .handle_sym = state->handle_sym,
+            .handle_events = SmImgAppendEvents(&out, state->handles),
+            .dwell_budget = state->dwell,
+            .defer_events = SmImgAppendEvents(&out, state->defers),
+        };
+        if (!out.failed)
+        {
+            memcpy(out.data + header.states + sizeof(SmImageState) * s, &is, sizeof(is));
+        }
+    }
+
+    /* 通道表与事件名 */
+    header.lanes = SM_IMAGE_NONE;
+    if (b->lanes != NULL)
+    {
+        header.lanes = SmImgBufAlign(&out);
+        SmImgBufAppend(&out, b->lanes, b->event_count);
+    }
+    header.event_names = SM_IMAGE_NONE;
+    if (b->event_names != NULL)
+    {
+        header.event_names = SmImgBufAlign(&out);
+        SmImgBufAppend(&out, b->event_names, sizeof(uint32_t) * b->event_count);
+    }
+
+    /* 符号表 */
+    header.symbols = SmImgBufAlign(&out);
+    SmImgBufAppend(&out, b->symbols, sizeof(uint32_t) * b->symbol_count);
+
+    /* 压缩转换表 */
+    header.table_base = SM_IMAGE_NONE;
+    header.table_interest = SM_IMAGE_NONE;
+    header.table_slots = SM_IMAGE_NONE;
+    if (table_buf != NULL)
+    {
+        header.table_base = SmImgBufAlign(&out);
+        SmImgBufAppend(&out, table.base, sizeof(uint32_t) * table.state_count);
+        header.table_interest = SmImgBufAlign(&out);
+        SmImgBufAppend(&out, table.interest, sizeof(uint32_t) * table.interest_words * table.state_count);
+        header.table_slots = SmImgBufAlign(&out);
+        SmImgBufAppend(&out, table.slots, sizeof(SmTableSlot) * table.slot_count);
+        header.slot_count = table.slot_count;
+        header.table_trans = table.trans_count;
+        header.interest_words = table.interest_words;
+        header.table_events = table.event_count;
+        free(table_buf);
+    }
+
+    /* 字符串 */
+    header.strings = SmImgBufAlign(&out);
+    header.strings_size = (uint32_t)b->strings.size;
+    SmImgBufAppend(&out, b->strings.data, b->strings.size);
+    SmImgBufAlign(&out);
+    free(first);
+
+    if (out.failed || out.size > UINT32_MAX)
+    {
+        free(out.data);
+        SmImgError(b->error, b->error_size, "out of memory");
+        return SM_RET_ERROR;
+    }
+
+    header.magic = SM_IMAGE_MAGIC;
+    header.version = SM_IMAGE_VERSION;
+    header.header_size = sizeof(SmImageHeader);
+    header.image_size = (uint32_t)out.size;
+    header.class_name = b->class_name;
+    header.state_count = b->state_count;
+    header.event_count = b->event_count;
+    header.any_count = any_count;
+    header.symbol_count = b->symbol_count;
+    header.trans_count = state_trans;
+    header.init_sym = b->init_sym;
+    header.deinit_sym = b->deinit_sym;
+    header.checksum = SmImgChecksum(out.data + sizeof(header), out.size - sizeof(header));
+    memcpy(out.data, &header, sizeof(header));
+
+    blob->data = out.data;
+    blob->size = out.size;
+    return SM_RET_OK;
+}
+
+/* ============================================================================
+ * 内部辅助函数: C 类 -> 构建器
+ * ============================================================================ */
+
+/**
+ * @brief 按地址查找符号名
+ */
+static const char *SmImgSymbolName(const SmImageSymbol *symbols, uint32_t count, SmImageFn fn, const void *data)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ((fn != NULL && symbols[i].fn == fn) || (data != NULL && symbols[i].data == data))
+        {
+            return symbols[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 复制事件列表(含结束标记)
+ */
+static bool SmImgCopyEvents(const SmEventId *src, SmEventId **out)
+{
+    if (src == NULL)
+    {
+        return true;
+    }
+
+    uint32_t n = 0;
+    while (src[n] != SM_EVENT_INVALID)
+    {
+        n++;
+    }
+    *out = malloc(sizeof(SmEventId) * (n + 1));
+    if (*out == NULL)
+    {
+        return false;
+    }
+    memcpy(*out, src, sizeof(SmEventId) * (n + 1));
+    return true;
+}
+
+/**
+ * @brief 登记回调函数符号, 找不到名称时报错
+ */
+static bool SmImgInternFn(SmImgBuilder *b, const SmImageSymbol *symbols, uint32_t count, SmImageFn fn,
+                          const char *owner, const char *slot, uint16_t *sym)
+{
+    *sym = SM_IMAGE_NO_SYM;
+    if (fn == NULL)
+    {
+        return true;
+    }
+
+    const char *name = SmImgSymbolName(symbols, count, fn, NULL);
+    if (name == NULL)
+    {
+        SmImgError(b->error, b->error_size, "%s: %s callback has no symbol", owner, slot);
+        return false;
+    }
+    *sym = SmImgIntern(b, name);
+    return true;
+}
+
+static bool SmImgAddClassTrans(SmImgBuilder *b, const SmImageSymbol *symbols, uint32_t count,
+                               const SmTransition *trans, int32_t from, const char *owner)
+{
+    SmImgTrans *t = SmImgAddTrans(b);
+    if (t == NULL)
+    {
+        return false;
+    }
+
+    t->from = from;
+    t->event_id = trans->event_id;
+    t->next_state = trans->next_state;
+    t->kind = trans->kind;
+    if (!SmImgInternFn(b, symbols, count, (SmImageFn)trans->condition, owner, "condition", &t->cond_sym) ||
+        !SmImgInternFn(b, symbols, count, (SmImageFn)trans->action, owner, "action", &t->action_sym))
+    {
+        return false;
+    }
+
+    if (trans->action_data != NULL)
+    {
+        const char *name = SmImgSymbolName(symbols, count, NULL, trans->action_data);
+        if (name == NULL)
+        {
+            SmImgError(b->error, b->error_size, "%s: action data has no symbol", owner);
+            return false;
+        }
+        t->data_sym = SmImgIntern(b, name);
+    }
+    return true;
+}
+
+/* ============================================================================
+ * 内部辅助函数: 描述文本 -> 构建器
+ * ============================================================================ */
+
+/**
+ * @brief 描述文本解析上下文
+ */
+typedef struct
+{
+    SmImgBuilder *b;    /* 构建器 */
+    uint32_t line;      /* 当前行号 */
+    uint32_t *events;   /* 事件名(字符串偏移) [event_cap] */
+    uint16_t event_cap; /* 事件名数组容量 */
+} SmImgParser;
+
+static int32_t SmImgLookupState(const SmImgParser *p, const char *ref)
+{
+    char *end;
+    long id = strtol(ref, &end, 10);
+    if (*end == '\0' && end != ref)
+    {
+        return (int32_t)id;
+    }
+
+    for (uint16_t i = 0; i < p->b->state_count; i++)
+    {
+        if (strcmp(SmImgString(p->b, p->b->states[i].name), ref) == 0)
+        {
+            return p->b->states[i].state_id;
+        }
+    }
+    return SM_STATE_INVALID;
+}
+
+static int32_t SmImgLookupEvent(const SmImgParser *p, const char *ref)
+{
+    char *end;
+    long id = strtol(ref, &end, 10);
+    if (*end == '\0' && end != ref)
+    {
+        return (int32_t)id;
+    }
+
+    for (uint16_t i = 0; i < p->event_cap; i++)
+    {
+        if (strcmp(SmImgString(p->b, p->events[i]), ref) == 0)
+        {
+            return i;
+        }
+    }
+    return SM_EVENT_INVALID;
+}
+
+/**
+ * @brief 查找 key=value 参数
+ */
+static const char *SmImgArg(char **tokens, int count, int start, const char *key)
+{
+    size_t len = strlen(key);
+
+    for (int i = start; i < count; i++)
+    {
+        if (strncmp(tokens[i], key, len) == 0 && (tokens[i][len] == '=' || tokens[i][len] == '\0'))
+        {
+            return (tokens[i][len] == '=') ? tokens[i] + len + 1 : "";
+        }
+    }
+    return NULL;
+}
+
+static bool SmImgParseFail(SmImgParser *p, const char *fmt, const char *what)
+{
+    char msg[64];
+    snprintf(msg, sizeof(msg), fmt, what);
+    SmImgError(p->b->error, p->b->error_size, "line %u: %s", p->line, msg);
+    return false;
+}
+
+static bool SmImgParseStateRef(SmImgParser *p, const char *ref, int32_t *state)
+{
+    *state = SmImgLookupState(p, ref);
+    return (*state != SM_STATE_INVALID) || SmImgParseFail(p, "unknown state '%s'", ref);
+}
+
+/**
+ * @brief 解析以逗号分隔的事件列表, 结果以 SM_EVENT_INVALID 结尾
+ */
+static bool SmImgParseEventList(SmImgParser *p, const char *arg, SmEventId **out)
+{
+    if (arg == NULL)
+    {
+        return true;
+    }
+
+    uint32_t n = 1;
+    for (const char *c = arg; *c != '\0'; c++)
+    {
+        n += (*c == ',');
+    }
+    *out = malloc(sizeof(SmEventId) * (n + 1));
+    if (*out == NULL)
+    {
+        return SmImgParseFail(p, "%s", "out of memory");
+    }
+    char list[256];
+    snprintf(list, sizeof(list), "%s", arg);
+    n = 0;
+    for (char *ev = strtok(list, ","); ev != NULL; ev = strtok(NULL, ","))
+    {
+        (*out)[n] = SmImgLookupEvent(p, ev);
+        if ((*out)[n] == SM_EVENT_INVALID)
+        {
+            return SmImgParseFail(p, "unknown event '%s'", ev);
+        }
+        n++;
+    }
+    (*out)[n] = SM_EVENT_INVALID;
+    return true;
+}
+
+/**
+ * @brief 第一遍: 登记类名/事件/状态的 ID 与名称
+ */
+static bool SmImgParseDecl(SmImgParser *p, char **tokens, int count)
+{
+    SmImgBuilder *b = p->b;
+
+    if (strcmp(tokens[0], "class") == 0 && count >= 2)
+    {
+        b->class_name = SmImgAddString(b, tokens[1]);
+        return true;
+    }
+
+    if (strcmp(tokens[0], "event") == 0)
+    {
+        long id = (count >= 3) ? strtol(tokens[1], NULL, 10) : -1;
+        if (id < 0 || id >= INT16_MAX)
+        {
+            return SmImgParseFail(p, "bad event '%s'", (count >= 2) ? tokens[1] : "");
+        }
+        if (id >= p->event_cap)
+        {
+            uint16_t cap = (uint16_t)(id + 1);
+            uint32_t *events = realloc(p->events, sizeof(uint32_t) * cap);
+            if (events == NULL)
+            {
+                return SmImgParseFail(p, "%s", "out of memory");
+            }
+            /* 偏移 0 是构建开始时登记的空字符串, 未命名的事件名为空 */
+            memset(events + p->event_cap, 0, sizeof(uint32_t) * (cap - p->event_cap));
+            p->events = events;
+            p->event_cap = cap;
+        }
+        p->events[id] = SmImgAddString(b, tokens[2]);
+        return true;
+    }
+
+    if (strcmp(tokens[0], "state") == 0 || strcmp(tokens[0], "composite") == 0 || strcmp(tokens[0], "history") == 0)
+    {
+        char *end;
+        long id = (count >= 3) ? strtol(tokens[1], &end, 10) : -1;
+        if (id < 0 || id > INT16_MAX || *end != '\0')
+        {
+            return SmImgParseFail(p, "bad state '%s'", (count >= 2) ? tokens[1] : "");
+        }
+        for (uint16_t i = 0; i < b->state_count; i++)
+        {
+            if (b->states[i].state_id == id)
+            {
+                return SmImgParseFail(p, "duplicate state '%s'", tokens[1]);
+            }
+        }
+        SmImgState *state = SmImgAddState(b);
+        if (state == NULL)
+        {
+            return SmImgParseFail(p, "%s", "out of memory");
+        }
+        state->state_id = (int32_t)id;
+        state->name = SmImgAddString(b, tokens[2]);
+        return true;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 第二遍: 解析回调/层次/转换
+ */
+static bool SmImgParseBody(SmImgParser *p, char **tokens, int count)
+{
+    SmImgBuilder *b = p->b;
+    const char *arg;
+
+    if (strcmp(tokens[0], "class") == 0)
+    {
+        b->init_sym = SmImgIntern(b, SmImgArg(tokens, count, 2, "init"));
+        b->deinit_sym = SmImgIntern(b, SmImgArg(tokens, count, 2, "deinit"));
+        return true;
+    }
+
+    if (strcmp(tokens[0], "event") == 0)
+    {
+        arg = SmImgArg(tokens, count, 3, "lane");
+        if (arg != NULL)
+        {
+            if (b->lanes == NULL && (b->lanes = calloc(b->event_count, 1)) == NULL)
+            {
+                return SmImgParseFail(p, "%s", "out of memory");
+            }
+            int32_t event = SmImgLookupEvent(p, tokens[1]);
+            b->lanes[event] = (uint8_t)strtol(arg, NULL, 10);
+            if (b->lanes[event] >= SM_LANE_COUNT)
+            {
+                return SmImgParseFail(p, "bad lane '%s'", arg);
+            }
+        }
+        return true;
+    }
+
+    if (strcmp(tokens[0], "state") == 0 || strcmp(tokens[0], "composite") == 0 || strcmp(tokens[0], "history") == 0)
+    {
+        int32_t id = SmImgLookupState(p, tokens[1]);
+        SmImgState *state = NULL;
+        for (uint16_t i = 0; i < b->state_count; i++)
+        {
+            if (b->states[i].state_id == id)
+            {
+                state = &b->states[i];
+            }
+        }
+
+        state->enter_sym = SmImgIntern(b, SmImgArg(tokens, count, 3, "enter"));
+        state->exit_sym = SmImgIntern(b, SmImgArg(tokens, count, 3, "exit"));
+        state->handle_sym = SmImgIntern(b, SmImgArg(tokens, count, 3, "handle"));
+        if (SmImgArg(tokens, count, 3, "no_any") != NULL)
+        {
+            state->flags |= SM_IMAGE_STATE_NO_ANY;
+        }
+        if ((arg = SmImgArg(tokens, count, 3, "parent")) != NULL)
+        {
+            if (!SmImgParseStateRef(p, arg, &state->parent))
+            {
+                return false;
+            }
+            state->flags |= SM_IMAGE_STATE_HAS_PARENT;
+        }
+
+        if (tokens[0][0] == 'c')
+        {
+            state->kind = SM_STATE_COMPOSITE;
+            arg = SmImgArg(tokens, count, 3, "initial");
+            if (arg == NULL || !SmImgParseStateRef(p, arg, &state->initial))
+            {
+                return (arg == NULL) ? SmImgParseFail(p, "composite '%s' needs initial=", tokens[2]) : false;
+            }
+        }
+        else if (tokens[0][0] == 'h')
+        {
+            state->kind = (SmImgArg(tokens, count, 3, "deep") != NULL) ? SM_STATE_HISTORY_DEEP
+                                                                       : SM_STATE_HISTORY_SHALLOW;
+            arg = SmImgArg(tokens, count, 3, "default");
+            if (!(state->flags & SM_IMAGE_STATE_HAS_PARENT) || arg == NULL ||
+                !SmImgParseStateRef(p, arg, &state->initial))
+            {
+                return (arg == NULL || !(state->flags & SM_IMAGE_STATE_HAS_PARENT))
+                           ? SmImgParseFail(p, "history '%s' needs parent= and default=", tokens[2])
+                           : false;
+            }
+        }
+
+        if ((arg = SmImgArg(tokens, count, 3, "dwell")) != NULL)
+        {
+            state->dwell = (uint32_t)strtoul(arg, NULL, 0);
+        }
+        return SmImgParseEventList(p, SmImgArg(tokens, count, 3, "handles"), &state->handles) &&
+               SmImgParseEventList(p, SmImgArg(tokens, count, 3, "defers"), &state->defers);
+    }
+
+    if (strcmp(tokens[0], "trans") == 0 || strcmp(tokens[0], "any") == 0)
+    {
+        bool any = (tokens[0][0] == 'a');
+        int base = any ? 1 : 2;
+        if (count < base + 2)
+        {
+            return SmImgParseFail(p, "incomplete %s", tokens[0]);
+        }
+
+        SmImgTrans *t = SmImgAddTrans(b);
+        if (t == NULL)
+        {
+            return SmImgParseFail(p, "%s", "out of memory");
+        }
+        t->from = SM_IMG_ANY_STATE;
+        if (!any && !SmImgParseStateRef(p, tokens[1], &t->from))
+        {
+            return false;
+        }
+        t->event_id = (strcmp(tokens[base], "completion") == 0) ? SM_EVENT_COMPLETION
+                                                                : SmImgLookupEvent(p, tokens[base]);
+        if (t->event_id == SM_EVENT_INVALID)
+        {
+            return SmImgParseFail(p, "unknown event '%s'", tokens[base]);
+        }
+        if (!SmImgParseStateRef(p, tokens[base + 1], &t->next_state))
+        {
+            return false;
+        }
+        t->cond_sym = SmImgIntern(b, SmImgArg(tokens, count, base + 2, "cond"));
+        t->action_sym = SmImgIntern(b, SmImgArg(tokens, count, base + 2, "action"));
+        t->data_sym = SmImgIntern(b, SmImgArg(tokens, count, base + 2, "data"));
+        const char *kind = SmImgArg(tokens, count, base + 2, "kind");
+        if (kind != NULL)
+        {
+            if (strcmp(kind, "internal") == 0)
+            {
+                t->kind = SM_TRANS_KIND_INTERNAL;
+            }
+            else if (strcmp(kind, "local") == 0)
+            {
+                t->kind = SM_TRANS_KIND_LOCAL;
+            }
+            else if (strcmp(kind, "external") != 0)
+            {
+                return SmImgParseFail(p, "unknown transition kind '%s'", kind);
+            }
+        }
+        return true;
+    }
+
+    return SmImgParseFail(p, "unknown directive '%s'", tokens[0]);
+}
+
+/**
+ * @brief 逐行切分并调用解析函数
+ */
+static bool SmImgParseLines(SmImgParser *p, char *text, bool (*fn)(SmImgParser *, char **, int))
+{
+    char *line = text;
+
+    p->line = 0;
+    while (line != NULL)
+    {
+        char *next = strchr(line, '\n');
+        if (next != NULL)
+        {
+            *next++ = '\0';
+        }
+        p->line++;
+
+        char *hash = strchr(line, '#');
+        if (hash != NULL)
+        {
+            *hash = '\0';
+        }
+
+        /* 切分前先复制一份, 第二遍仍需原始行 */
+        char buf[512];
+        char *tokens[SM_IMG_MAX_TOKENS];
+        int count = 0;
+        snprintf(buf, sizeof(buf), "%s", line);
+        for (char *tok = strtok(buf, " \t\r"); tok != NULL && count < SM_IMG_MAX_TOKENS; tok = strtok(NULL, " \t\r"))
+        {
+            tokens[count++] = tok;
+        }
+        if (count > 0 && !fn(p, tokens, count))
+        {
+            return false;
+        }
+
+        if (next != NULL)
+        {
+            next[-1] = '\n';
+        }
+        if (hash != NULL)
+        {
+            *hash = '#';
+        }
+        line = next;
+    }
+    return true;
+}
+
+/* ============================================================================
+ * 内部辅助函数: 加载
+ * ============================================================================ */
+
+/**
+ * @brief 检查段范围
+ */
+static bool SmImgInRange(const SmImageHeader *h, uint32_t offset, uint64_t bytes)
+{
+    return offset != SM_IMAGE_NONE && (offset % 4) == 0 && (uint64_t)offset + bytes <= h->image_size;
+}
+
+/**
+ * @brief 检查事件列表(以 SM_EVENT_INVALID 结尾)整体在镜像内
+ */
+static bool SmImgListInRange(const SmImageHeader *h, uint32_t offset)
+{
+    if (offset == SM_IMAGE_NONE)
+    {
+        return true;
+    }
+    if (!SmImgInRange(h, offset, sizeof(SmEventId)))
+    {
+        return false;
+    }
+
+    const SmEventId *list = (const SmEventId *)((const uint8_t *)h + offset);
+    uint64_t count = (h->image_size - offset) / sizeof(SmEventId);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (list[i] == SM_EVENT_INVALID)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int SmImgCompareId(const void *a, const void *b)
+{
+    int32_t ia = *(const int32_t *)a;
+    int32_t ib = *(const int32_t *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+/**
+ * @brief 状态ID是否存在(ids 已排序)
+ */
+static bool SmImgHasState(const int32_t *ids, uint16_t count, int32_t id)
+{
+    return bsearch(&id, ids, count, sizeof(int32_t), SmImgCompareId) != NULL;
+}
+
+/**
+ * @brief 逐元素检查状态/转换/转换表的引用(不依赖校验和, 截断或篡改的镜像不会越界访问)
+ * @note O(状态数 * log(状态数) + 转换数 + 槽位数)
+ */
+static bool SmImgValidate(SmImage *image)
+{
+    const SmImageHeader *h = image->header;
+    const SmImageState *is = (const SmImageState *)(image->base + h->states);
+    const SmImageTrans *it = (const SmImageTrans *)(image->base + h->transitions);
+    uint32_t total_trans = h->trans_count + h->any_count;
+
+    int32_t *ids = malloc(sizeof(int32_t) * (h->state_count + 1u));
+    if (ids == NULL)
+    {
+        SmImgError(image->error, sizeof(image->error), "out of memory");
+        return false;
+    }
+    for (uint16_t i = 0; i < h->state_count; i++)
+    {
+        ids[i] = is[i].state_id;
+    }
+    qsort(ids, h->state_count, sizeof(int32_t), SmImgCompareId);
+
+    bool ok = true;
+    for (uint16_t i = 1; ok && i < h->state_count; i++)
+    {
+        if (ids[i] == ids[i - 1])
+        {
+            SmImgError(image->error, sizeof(image->error), "duplicate state id %d", ids[i]);
+            ok = false;
+        }
+    }
+
+    /* 1. 状态: 转换范围, 名称, 事件列表(含结束标记), 所属组合状态, 初始/默认目标 */
+    for (uint16_t i = 0; ok && i < h->state_count; i++)
+    {
+        bool has_parent = (is[i].flags & SM_IMAGE_STATE_HAS_PARENT) != 0;
+        if ((uint64_t)is[i].trans_first + is[i].trans_count > h->trans_count || is[i].name >= h->strings_size ||
+            is[i].kind > SM_STATE_HISTORY_DEEP || !SmImgListInRange(h, is[i].handle_events) ||
+            !SmImgListInRange(h, is[i].defer_events) ||
+            (has_parent && !SmImgHasState(ids, h->state_count, is[i].parent)) ||
+            (is[i].kind != SM_STATE_LEAF && is[i].initial != SM_STATE_INVALID &&
+             !SmImgHasState(ids, h->state_count, is[i].initial)))
+        {
+            SmImgError(image->error, sizeof(image->error), "state %u out of range", i);
+            ok = false;
+        }
+    }
+
+    /* 2. 转换: 目标状态存在(内部转换为 SM_STATE_INVALID) */
+    for (uint32_t i = 0; ok && i < total_trans; i++)
+    {
+        if (it[i].kind > SM_TRANS_KIND_LOCAL ||
+            (it[i].next_state != SM_STATE_INVALID && !SmImgHasState(ids, h->state_count, it[i].next_state)))
+        {
+            SmImgError(image->error, sizeof(image->error), "transition %u targets unknown state %d", i,
+                       it[i].next_state);
+            ok = false;
+        }
+    }
+
+    /* 3. 转换表: 槽位引用的状态下标和转换下标 */
+    if (ok && h->table_base != SM_IMAGE_NONE)
+    {
+        const SmTableSlot *slots = (const SmTableSlot *)(image->base + h->table_slots);
+        for (uint32_t i = 0; ok && i < h->slot_count; i++)
+        {
+            uint16_t check = slots[i].check;
+            uint16_t trans = slots[i].trans;
+            if (check == SM_TABLE_EMPTY)
+            {
+                continue;
+            }
+            bool any = (trans & SM_TABLE_ANY_BIT) != 0;
+            uint16_t index = trans & (uint16_t)~SM_TABLE_ANY_BIT;
+            if (check >= h->state_count || (any ? index >= h->any_count : index >= is[check].trans_count))
+            {
+                SmImgError(image->error, sizeof(image->error), "table slot %u out of range", i);
+                ok = false;
+            }
+        }
+    }
+
+    free(ids);
+    return ok;
+}
+
+/**
+ * @brief 解析符号ID
+ */
+static bool SmImgResolve(SmImage *image, const SmImageSymbol **resolved, uint16_t sym, bool want_fn, void **out)
+{
+    *out = NULL;
+    if (sym == SM_IMAGE_NO_SYM)
+    {
+        return true;
+    }
+    if (sym > image->header->symbol_count)
+    {
+        SmImgError(image->error, sizeof(image->error), "bad symbol id %u", sym);
+        return false;
+    }
+
+    const SmImageSymbol *symbol = resolved[sym - 1];
+    if (want_fn ? (symbol->fn == NULL) : (symbol->data == NULL))
+    {
+        SmImgError(image->error, sizeof(image->error), "symbol '%s' is not a %s", symbol->name,
+                   want_fn ? "function" : "data symbol");
+        return false;
+    }
+    *out = want_fn ? (void *)(uintptr_t)symbol->fn : symbol->data;
+    return true;
+}
+
+#define SM_IMG_FN(type, ptr) ((type)(uintptr_t)(ptr))
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmImageLoad(SmImage *image, const void *data, size_t size, const SmImageSymbol *symbols,
+                      uint32_t symbol_count, uint32_t flags)
+{
+    if (image == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(image, 0, sizeof(SmImage));
+    if (data == NULL || ((uintptr_t)data % SM_IMG_ALIGN) != 0 || size < sizeof(SmImageHeader))
+    {
+        SmImgError(image->error, sizeof(image->error), "image too small or misaligned");
+        return SM_RET_ERROR;
+    }
+
+    const SmImageHeader *h = (const SmImageHeader *)data;
+    if (h->magic != SM_IMAGE_MAGIC || h->version != SM_IMAGE_VERSION || h->header_size != sizeof(SmImageHeader) ||
+        h->image_size > size || h->image_size < sizeof(SmImageHeader))
+    {
+        SmImgError(image->error, sizeof(image->error), "bad image header (version %u)", h->version);
+        return SM_RET_ERROR;
+    }
+    if ((flags & SM_IMAGE_VERIFY) &&
+        SmImgChecksum((const uint8_t *)data + h->header_size, h->image_size - h->header_size) != h->checksum)
+    {
+        SmImgError(image->error, sizeof(image->error), "checksum mismatch");
+        return SM_RET_ERROR;
+    }
+
+    /* 段范围检查(段内元素由 SmImgValidate 逐个检查) */
+    uint32_t total_trans = h->trans_count + h->any_count;
+    if (!SmImgInRange(h, h->states, (uint64_t)sizeof(SmImageState) * h->state_count) ||
+        !SmImgInRange(h, h->transitions, (uint64_t)sizeof(SmImageTrans) * total_trans) ||
+        !SmImgInRange(h, h->symbols, (uint64_t)sizeof(uint32_t) * h->symbol_count) ||
+        !SmImgInRange(h, h->strings, h->strings_size) || h->strings_size == 0 ||
+        ((const char *)data)[h->strings + h->strings_size - 1] != '\0' || h->class_name >= h->strings_size ||
+        (h->lanes != SM_IMAGE_NONE && !SmImgInRange(h, h->lanes, h->event_count)) ||
+        (h->event_names != SM_IMAGE_NONE &&
+         !SmImgInRange(h, h->event_names, (uint64_t)sizeof(uint32_t) * h->event_count)) ||
+        (h->table_base != SM_IMAGE_NONE &&
+         (!SmImgInRange(h, h->table_base, (uint64_t)sizeof(uint32_t) * h->state_count) ||
+          !SmImgInRange(h, h->table_interest, (uint64_t)sizeof(uint32_t) * h->interest_words * h->state_count) ||
+          !SmImgInRange(h, h->table_slots, (uint64_t)sizeof(SmTableSlot) * h->slot_count) ||
+          (uint32_t)h->interest_words * 32u <= h->table_events)))
+    {
+        SmImgError(image->error, sizeof(image->error), "section out of range");
+        return SM_RET_ERROR;
+    }
+
+    image->base = (const uint8_t *)data;
+    image->size = size;
+    image->header = h;
+    const char *strings = (const char *)data + h->strings;
+    if (!SmImgValidate(image))
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 按名称解析符号(每个符号一次) */
+    const SmImageSymbol **resolved = calloc(h->symbol_count + 1, sizeof(SmImageSymbol *));
+    if (resolved == NULL)
+    {
+        SmImgError(image->error, sizeof(image->error), "out of memory");
+        return SM_RET_ERROR;
+    }
+    const uint32_t *sym_names = (const uint32_t *)(image->base + h->symbols);
+    for (uint16_t i = 0; i < h->symbol_count; i++)
+    {
+        const char *name = (sym_names[i] < h->strings_size) ? strings + sym_names[i] : "";
+        for (uint32_t j = 0; j < symbol_count && resolved[i] == NULL; j++)
+        {
+            if (symbols[j].name != NULL && strcmp(symbols[j].name, name) == 0)
+            {
+                resolved[i] = &symbols[j];
+            }
+        }
+        if (resolved[i] == NULL)
+        {
+            SmImgError(image->error, sizeof(image->error), "unresolved symbol '%s'", name);
+            free(resolved);
+            return SM_RET_ERROR;
+        }
+    }
+
+    /* 状态、转换与事件名称指针一次性分配 */
+    uint16_t name_count = (h->event_names != SM_IMAGE_NONE) ? h->event_count : 0;
+    size_t block_size = sizeof(SmState) * h->state_count + sizeof(SmTransition) * (total_trans + 1) +
+                        sizeof(const char *) * name_count;
+    image->block = malloc(block_size);
+    if (image->block == NULL)
+    {
+        free(resolved);
+        SmImgError(image->error, sizeof(image->error), "out of memory");
+        return SM_RET_ERROR;
+    }
+    SmState *states = (SmState *)image->block;
+    SmTransition *trans = (SmTransition *)(states + h->state_count);
+    const char **names = (const char **)(trans + total_trans + 1);
+    memset(image->block, 0, block_size);
+
+    /* 空名称(生成镜像时缺失的事件名)不进入名称表 */
+    const uint32_t *name_offsets = (const uint32_t *)(image->base + h->event_names);
+    for (uint16_t e = 0; e < name_count; e++)
+    {
+        if (name_offsets[e] < h->strings_size && strings[name_offsets[e]] != '\0')
+        {
+            names[e] = strings + name_offsets[e];
+        }
+    }
+
+    bool ok = true;
+    const SmImageTrans *it = (const SmImageTrans *)(image->base + h->transitions);
+    for (uint32_t i = 0; i < total_trans && ok; i++)
+    {
+        void *cond, *action, *data_ptr;
+        ok = SmImgResolve(image, resolved, it[i].cond_sym, true, &cond) &&
+             SmImgResolve(image, resolved, it[i].action_sym, true, &action) &&
+             SmImgResolve(image, resolved, it[i].data_sym, false, &data_ptr);
+        trans[i].event_id = it[i].event_id;
+        trans[i].next_state = it[i].next_state;
+        trans[i].condition = SM_IMG_FN(SmConditionFn, cond);
+        trans[i].action = SM_IMG_FN(SmActionFn, action);
+        trans[i].action_data = data_ptr;
+        trans[i].kind = it[i].kind;
+    }
+
+    const SmImageState *is = (const SmImageState *)(image->base + h->states);
+    for (uint16_t i = 0; i < h->state_count && ok; i++)
+    {
+        void *enter, *exit_fn, *handle;
+        ok = SmImgResolve(image, resolved, is[i].enter_sym, true, &enter) &&
+             SmImgResolve(image, resolved, is[i].exit_sym, true, &exit_fn) &&
+             SmImgResolve(image, resolved, is[i].handle_sym, true, &handle);
+
+        states[i].state_id = is[i].state_id;
+        states[i].state_name = strings + is[i].name;
+        states[i].on_enter = SM_IMG_FN(SmStateEnterFn, enter);
+        states[i].on_exit = SM_IMG_FN(SmStateExitFn, exit_fn);
+        states[i].on_handle = SM_IMG_FN(SmStateHandleFn, handle);
+        states[i].transitions = &trans[is[i].trans_first];
+        states[i].trans_count = is[i].trans_count;
+        states[i].any_opt_out = (is[i].flags & SM_IMAGE_STATE_NO_ANY) != 0;
+        states[i].handle_events = (is[i].handle_events != SM_IMAGE_NONE)
+                                      ? (const SmEventId *)(image->base + is[i].handle_events)
+                                      : NULL;
+        states[i].deferred_events = (is[i].defer_events != SM_IMAGE_NONE)
+                                        ? (const SmEventId *)(image->base + is[i].defer_events)
+                                        : NULL;
+        states[i].dwell_budget = is[i].dwell_budget;
+        states[i].parent = is[i].parent;
+        states[i].has_parent = (is[i].flags & SM_IMAGE_STATE_HAS_PARENT) != 0;
+        states[i].kind = is[i].kind;
+        states[i].initial = is[i].initial;
+    }
+
+    void *init = NULL, *deinit = NULL;
+    ok = ok && SmImgResolve(image, resolved, h->init_sym, true, &init) &&
+         SmImgResolve(image, resolved, h->deinit_sym, true, &deinit);
+    free(resolved);
+    if (!ok)
+    {
+        free(image->block);
+        image->block = NULL;
+        return SM_RET_ERROR;
+    }
+
+    /* 压缩转换表直接引用镜像中的数组 */
+    if (h->table_base != SM_IMAGE_NONE)
+    {
+        image->table.state_count = h->state_count;
+        image->table.event_count = h->table_events;
+        image->table.slot_count = h->slot_count;
+        image->table.trans_count = h->table_trans;
+        image->table.interest_words = h->interest_words;
+        image->table.base = (const uint32_t *)(image->base + h->table_base);
+        image->table.interest = (const uint32_t *)(image->base + h->table_interest);
+        image->table.slots = (const SmTableSlot *)(image->base + h->table_slots);
+    }
+
+    image->sm_class.class_name = strings + h->class_name;
+    image->sm_class.states = states;
+    image->sm_class.state_count = h->state_count;
+    image->sm_class.on_init = SM_IMG_FN(SmInitFn, init);
+    image->sm_class.on_deinit = SM_IMG_FN(SmDeinitFn, deinit);
+    image->sm_class.event_lanes = (h->lanes != SM_IMAGE_NONE) ? image->base + h->lanes : NULL;
+    image->sm_class.event_count = h->event_count;
+    image->sm_class.any_transitions = (h->any_count > 0) ? &trans[h->trans_count] : NULL;
+    image->sm_class.any_trans_count = h->any_count;
+    image->sm_class.table = (h->table_base != SM_IMAGE_NONE) ? &image->table : NULL;
+    image->sm_class.event_names = (name_count > 0) ? names : NULL;
+    image->sm_class.event_name_count = name_count;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmImageOpen(SmImage *image, const char *path, const SmImageSymbol *symbols, uint32_t symbol_count,
+                      uint32_t flags)
+{
+    struct stat st;
+
+    if (image == NULL || path == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(image, 0, sizeof(SmImage));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SmImageHeader))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        SmImgError(image->error, sizeof(image->error), "cannot open %s", path);
+        return SM_RET_ERROR;
+    }
+
+    /* 只读共享映射: 多个进程加载同一镜像时共用页缓存 */
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        SmImgError(image->error, sizeof(image->error), "cannot map %s", path);
+        return SM_RET_ERROR;
+    }
+
+    if (SmImageLoad(image, base, (size_t)st.st_size, symbols, symbol_count, flags) != SM_RET_OK)
+    {
+        munmap(base, (size_t)st.st_size);
+        image->base = NULL;
+        return SM_RET_ERROR;
+    }
+
+    image->mapped = true;
+    return SM_RET_OK;
+}
+
+void SmImageClose(SmImage *image)
+{
+    if (image == NULL)
+    {
+        return;
+    }
+
+    free(image->block);
+    if (image->mapped && image->base != NULL)
+    {
+        munmap((void *)image->base, image->size);
+    }
+    memset(image, 0, sizeof(SmImage));
+}
+
+const char *SmImageEventName(const SmImage *image, SmEventId event)
+{
+    if (image == NULL || image->header == NULL || image->header->event_names == SM_IMAGE_NONE ||
+        event < 0 || event >= image->header->event_count)
+    {
+        return NULL;
+    }
+
+    uint32_t name = ((const uint32_t *)(image->base + image->header->event_names))[event];
+    if (name >= image->header->strings_size)
+    {
+        return NULL;
+    }
+    return (const char *)image->base + image->header->strings + name;
+}
+
+SmRetCode SmImageBuildFromClass(const SmClass *sm_class, const SmImageSymbol *symbols, uint32_t symbol_count,
+                                const char *const *event_names, SmImageBlob *blob)
+{
+    SmImgBuilder b;
+
+    if (blob == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    memset(blob, 0, sizeof(SmImageBlob));
+    if (sm_class == NULL || sm_class->states == NULL)
+    {
+        SmImgError(blob->error, sizeof(blob->error), "invalid class");
+        return SM_RET_ERROR;
+    }
+
+    memset(&b, 0, sizeof(b));
+    b.error = blob->error;
+    b.error_size = sizeof(blob->error);
+    b.class_name = SmImgAddString(&b, (sm_class->class_name != NULL) ? sm_class->class_name : "");
+    b.event_count = sm_class->event_count;
+
+    bool ok = SmImgInternFn(&b, symbols, symbol_count, (SmImageFn)sm_class->on_init, "class", "init", &b.init_sym) &&
+              SmImgInternFn(&b, symbols, symbol_count, (SmImageFn)sm_class->on_deinit, "class", "deinit",
+                            &b.deinit_sym);
+
+    /* 事件数量取声明值与实际使用的最大事件ID中较大者 */
+    for (uint16_t s = 0; ok && s < sm_class->state_count; s++)
+    {
+        for (uint16_t t = 0; t < sm_class->states[s].trans_count; t++)
+        {
+            if (sm_class->states[s].transitions[t].event_id >= b.event_count)
+            {
+                b.event_count = (uint16_t)(sm_class->states[s].transitions[t].event_id + 1);
+            }
+        }
+    }
+    if (ok && sm_class->event_lanes != NULL)
+    {
+        b.lanes = calloc(b.event_count, 1);
+        ok = (b.lanes != NULL);
+        if (ok)
+        {
+            memcpy(b.lanes, sm_class->event_lanes, sm_class->event_count);
+        }
+    }
+    /* 未指定事件名称时使用类自带的名称表 */
+    uint16_t name_count = sm_class->event_count;
+    if (event_names == NULL)
+    {
+        event_names = sm_class->event_names;
+        name_count = sm_class->event_name_count;
+    }
+    if (ok && event_names != NULL)
+    {
+        b.event_names = malloc(sizeof(uint32_t) * b.event_count);
+        ok = (b.event_names != NULL);
+        for (uint16_t e = 0; ok && e < b.event_count; e++)
+        {
+            b.event_names[e] = SmImgAddString(&b, (e < name_count && event_names[e] != NULL) ? event_names[e] : "");
+        }
+    }
+
+    for (uint16_t s = 0; ok && s < sm_class->state_count; s++)
+    {
+        const SmState *src = &sm_class->states[s];
+        const char *owner = (src->state_name != NULL) ? src->state_name : "state";
+        SmImgState *state = SmImgAddState(&b);
+        if (state == NULL)
+        {
+            ok = false;
+            break;
+        }
+
+        state->state_id = src->state_id;
+        state->name = SmImgAddString(&b, owner);
+        state->kind = src->kind;
+        state->flags = (src->has_parent ? SM_IMAGE_STATE_HAS_PARENT : 0) | (src->any_opt_out ? SM_IMAGE_STATE_NO_ANY : 0);
+        state->parent = src->has_parent ? src->parent : SM_STATE_INVALID;
+        state->initial = (src->kind != SM_STATE_LEAF) ? src->initial : SM_STATE_INVALID;
+        ok = SmImgInternFn(&b, symbols, symbol_count, (SmImageFn)src->on_enter, owner, "enter", &state->enter_sym) &&
+             SmImgInternFn(&b, symbols, symbol_count, (SmImageFn)src->on_exit, owner, "exit", &state->exit_sym) &&
+             SmImgInternFn(&b, symbols, symbol_count, (SmImageFn)src->on_handle, owner, "handle", &state->handle_sym);
+
+        state->dwell = src->dwell_budget;
+        ok = ok && SmImgCopyEvents(src->handle_events, &state->handles) &&
+             SmImgCopyEvents(src->deferred_events, &state->defers);
+
+        for (uint16_t t = 0; ok && t < src->trans_count; t++)
+        {
+            ok = SmImgAddClassTrans(&b, symbols, symbol_count, &src->transitions[t], src->state_id, owner);
+        }
+    }
+
+    for (uint16_t t = 0; ok && t < sm_class->any_trans_count; t++)
+    {
+        ok = SmImgAddClassTrans(&b, symbols, symbol_count, &sm_class->any_transitions[t], SM_IMG_ANY_STATE, "any");
+    }
+
+    if (!ok && blob->error[0] == '\0')
+    {
+        SmImgError(blob->error, sizeof(blob->error), "out of memory");
+    }
+    SmRetCode ret = ok ? SmImgFinish(&b, blob) : SM_RET_ERROR;
+    SmImgBuilderFree(&b);
+    return ret;
+}
+
+SmRetCode SmImageBuildFromText(const char *text, SmImageBlob *blob)
+{
+    SmImgBuilder b;
+    SmImgParser p;
+
+    if (blob == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    memset(blob, 0, sizeof(SmImageBlob));
+    if (text == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    char *copy = strdup(text);
+    if (copy == NULL)
+    {
+        SmImgError(blob->error, sizeof(blob->error), "out of memory");
+        return SM_RET_ERROR;
+    }
+
+    memset(&b, 0, sizeof(b));
+    memset(&p, 0, sizeof(p));
+    b.error = blob->error;
+    b.error_size = sizeof(blob->error);
+    b.class_name = SmImgAddString(&b, "");
+    p.b = &b;
+
+    /* 第一遍登记名称, 第二遍解析引用(允许向后引用) */
+    bool ok = SmImgParseLines(&p, copy, SmImgParseDecl);
+    if (ok)
+    {
+        b.event_count = p.event_cap;
+        b.event_names = p.events;
+        if (b.state_count > 0)
+        {
+            qsort(b.states, b.state_count, sizeof(SmImgState), SmImgCompareState);
+        }
+    }
+    ok = ok && SmImgParseLines(&p, copy, SmImgParseBody);
+
+    SmRetCode ret = ok ? SmImgFinish(&b, blob) : SM_RET_ERROR;
+    if (b.event_names == NULL)
+    {
+        free(p.events);
+    }
+    SmImgBuilderFree(&b);
+    free(copy);
+    return ret;
+}
+
+SmRetCode SmImageBlobSave(const SmImageBlob *blob, const char *path)
+{
+    if (blob == NULL || blob->data == NULL || path == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    size_t written = fwrite(blob->data, 1, blob->size, fp);
+    if (fclose(fp) != 0 || written != blob->size)
+    {
+        return SM_RET_ERROR;
+    }
+    return SM_RET_OK;
+}
+
+void SmImageBlobFree(SmImageBlob *blob)
+{
+    if (blob != NULL)
+    {
+        free(blob->data);
+        blob->data = NULL;
+        blob->size = 0;
+    }
+}
@@ -0,0 +1,236 @@
+#ifndef __SMIMAGE_H__
+#define __SMIMAGE_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+#include "SmTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 预编译类镜像
+ * ============================================================================ */
+
+/*
+ * 一个类编译后的二进制镜像, 全部使用相对镜像起始处的偏移, 与加载地址无关:
+ *   头 | 状态 | 转换(各状态连续, 通配转换在最后) | on_handle/延迟事件列表 |
+ *   通道表 | 事件名 | 符号表 | 压缩转换表(base/interest/slots) | 字符串
+ * 各段按 8 字节对齐. 回调函数/动作数据以符号ID引用, 加载时按名称解析一次.
+ *
+ * 加载(SmImageOpen)只做一次只读 mmap(MAP_SHARED, 多进程共享同一份物理页):
+ *   - 压缩转换表, 通道表, on_handle/延迟事件列表, 状态名/类名直接使用镜像中的数据
+ *   - SmState/SmTransition 含函数指针, 无法与地址无关, 因此在一块内存中按顺序
+ *     逐个重建(一次分配, 无链接)
+ * 因此加载耗时为 O(状态数 + 转换数): 先逐元素检查引用(事件列表结束标记, 转换目标,
+ * 转换表槽位), 再填充上述内存块; 不随转换表大小和实例数增长. 实测见 SmMgr_bench 的 image check.
+ *
+ * 约束: 镜像按本机字节序生成, 只在相同字节序的平台间通用.
+ */
+
+#define SM_IMAGE_MAGIC   0x4D49534DU /* "SMIM" */
+#define SM_IMAGE_VERSION 3           /* 格式版本(不兼容修改时递增) */
+#define SM_IMAGE_NONE    0xFFFFFFFFU /* 空偏移 */
+#define SM_IMAGE_NO_SYM  0           /* 无符号 */
+
+#define SM_IMAGE_VERIFY 0x01 /* 加载时校验整个镜像的校验和 */
+
+#define SM_IMAGE_STATE_HAS_PARENT 0x01 /* 属于组合状态 */
+#define SM_IMAGE_STATE_NO_ANY     0x02 /* 不使用类级通配转换 */
+
+/**
+ * @brief 通用函数指针(符号解析用)
+ */
+typedef void (*SmImageFn)(void);
+
+/**
+ * @brief 符号(名称 -> 回调函数或动作数据)
+ */
+typedef struct
+{
+    const char *name; /* 符号名 */
+    SmImageFn fn;     /* 回调函数(函数符号) */
+    void *data;       /* 动作数据(数据符号) */
+} SmImageSymbol;
+
+/* 定义函数符号 */
+#define SM_IMAGE_FN(func) { .name = #func, .fn = (SmImageFn)(func), .data = NULL }
+
+/* 定义数据符号(obj 为动作数据对象, 符号名为对象名) */
+#define SM_IMAGE_DATA(obj) { .name = #obj, .fn = NULL, .data = (void *)&(obj) }
+
+/**
+ * @brief 镜像头
+ */
+typedef struct
+{
+    uint32_t magic;          /* SM_IMAGE_MAGIC */
+    uint16_t version;        /* SM_IMAGE_VERSION */
+    uint16_t header_size;    /* 头大小 */
+    uint32_t image_size;     /* 镜像总大小 */
+    uint32_t checksum;       /* 头之后全部字节的 FNV-1a 校验和 */
+    uint32_t class_name;     /* 类名(字符串偏移) */
+    uint16_t state_count;    /* 状态数量 */
+    uint16_t event_count;    /* 事件数量 */
+    uint16_t any_count;      /* 通配转换数量 */
+    uint16_t symbol_count;   /* 符号数量 */
+    uint32_t trans_count;    /* 状态转换总数(不含通配转换) */
+    uint16_t init_sym;       /* 类初始化回调符号 */
+    uint16_t deinit_sym;     /* 类反初始化回调符号 */
+    uint32_t states;         /* 状态段偏移 */
+    uint32_t transitions;    /* 转换段偏移 */
+    uint32_t lanes;          /* 通道表偏移 [event_count], 或 SM_IMAGE_NONE */
+    uint32_t event_names;    /* 事件名偏移 [event_count](字符串偏移), 或 SM_IMAGE_NONE */
+    uint32_t symbols;        /* 符号表偏移 [symbol_count](字符串偏移) */
+    uint32_t table_base;     /* 转换表行偏移 [state_count], 或 SM_IMAGE_NONE */
+    uint32_t table_interest; /* 转换表兴趣位图 [state_count][interest_words] */
+    uint32_t table_slots;    /* 转换表槽位 [slot_count] */
+    uint32_t slot_count;     /* 槽位数量 */
+    uint32_t table_trans;    /* 转换表有效转换数量 */
+    uint16_t interest_words; /* 每个状态的兴趣位图字数 */
+    uint16_t table_events;   /* 转换表事件域(可大于 event_count, 见 SmTable.h) */
+    uint32_t strings;        /* 字符串段偏移 */
+    uint32_t strings_size;   /* 字符串段大小 */
+} SmImageHeader;
+
+/**
+ * @brief 镜像中的状态
+ */
+typedef struct
+{
+    int32_t state_id;       /* 状态ID */
+    uint32_t name;          /* 状态名(字符串偏移) */
+    uint32_t trans_first;   /* 第一个转换在转换段中的下标 */
+    uint16_t trans_count;   /* 转换数量 */
+    uint8_t kind;           /* 状态种类 SM_STATE_xxx */
+    uint8_t flags;          /* SM_IMAGE_STATE_xxx */
+    int32_t parent;         /* 所属组合状态ID */
+    int32_t initial;        /* 初始子状态/历史默认目标 */
+    uint16_t enter_sym;     /* 进入回调符号 */
+    uint16_t exit_sym;      /* 退出回调符号 */
+    uint16_t handle_sym;    /* 处理回调符号 */
+    uint16_t reserved;      /* 保留 */
+    uint32_t handle_events; /* on_handle 事件列表偏移(以 SM_EVENT_INVALID 结尾), 或 SM_IMAGE_NONE */
+    uint32_t dwell_budget;  /* 最长停留时间 */
+    uint32_t defer_events;  /* 延迟事件列表偏移(以 SM_EVENT_INVALID 结尾), 或 SM_IMAGE_NONE */
+} SmImageState;
+
+/**
+ * @brief 镜像中的转换
+ */
+typedef struct
+{
+    int32_t event_id;    /* 事件ID */
+    int32_t next_state;  /* 目标状态ID */
+    uint16_t cond_sym;   /* 条件回调符号 */
+    uint16_t action_sym; /* 动作回调符号 */
+    uint16_t data_sym;   /* 动作数据符号 */
+    uint8_t kind;        /* 转换种类 SM_TRANS_KIND_xxx */
+    uint8_t reserved;    /* 保留 */
+} SmImageTrans;
+
+/**
+ * @brief 已加载的镜像
+ */
+typedef struct
+{
+    const uint8_t *base;         /* 镜像数据 */
+    size_t size;                 /* 镜像大小 */
+    bool mapped;                 /* 是否由 SmImageOpen 映射 */
+    const SmImageHeader *header; /* 镜像头 */
+    SmClass sm_class;            /* 类(状态/转换指向 block, 其余指向镜像) */
+    SmTable table;               /* 压缩转换表(数组直接指向镜像) */
+    void *block;                 /* 状态/转换/事件名称指针的存储 */
+    char error[96];              /* 最近一次失败的原因 */
+} SmImage;
+
+/**
+ * @brief 生成的镜像数据
+ */
+typedef struct
+{
+    uint8_t *data;  /* 镜像数据(malloc) */
+    size_t size;    /* 镜像大小 */
+    char error[96]; /* 失败原因 */
+} SmImageBlob;
+
+/**
+ * @brief 映射并加载镜像文件
+ * @param image 镜像(输出)
+ * @param path 文件路径
+ * @param symbols 符号表(程序中的回调函数和动作数据)
+ * @param symbol_count 符号数量
+ * @param flags SM_IMAGE_VERIFY 等
+ * @return SM_RET_OK 成功, SM_RET_ERROR 失败(原因见 image->error)
+ */
+SmRetCode SmImageOpen(SmImage *image, const char *path, const SmImageSymbol *symbols, uint32_t symbol_count,
+                      uint32_t flags);
+
+/**
+ * @brief 从内存加载镜像(例如链接进 Flash 的镜像)
+ * @param image 镜像(输出)
+ * @param data 镜像数据(8字节对齐, 生命周期不短于 image)
+ * @param size 镜像大小
+ * @param symbols 符号表
+ * @param symbol_count 符号数量
+ * @param flags SM_IMAGE_VERIFY 等
+ * @return SM_RET_OK 成功, SM_RET_ERROR 失败(原因见 image->error)
+ */
+SmRetCode SmImageLoad(SmImage *image, const void *data, size_t size, const SmImageSymbol *symbols,
+                      uint32_t symbol_count, uint32_t flags);
+
+/**
+ * @brief 卸载镜像
+ * @param image 镜像
+ * @note 使用该类的实例应已销毁
+ */
+void SmImageClose(SmImage *image);
+
+/**
+ * @brief 获取镜像中的事件名称
+ * @param image 镜像
+ * @param event 事件ID
+ * @return 事件名称, 镜像未包含事件名或越界时返回NULL
+ */
+const char *SmImageEventName(const SmImage *image, SmEventId event);
+
+/**
+ * @brief 由 C 定义的类生成镜像
+ * @param sm_class 状态机类
+ * @param symbols 符号表, 类中的每个回调函数/动作数据都必须能在其中找到
+ * @param symbol_count 符号数量
+ * @param event_names 事件名称 [event_count](可选)
+ * @param blob 生成结果(输出)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 失败(原因见 blob->error)
+ */
+SmRetCode SmImageBuildFromClass(const SmClass *sm_class, const SmImageSymbol *symbols, uint32_t symbol_count,
+                                const char *const *event_names, SmImageBlob *blob);
+
+/**
+ * @brief 由描述文本生成镜像
+ * @param text 描述文本(格式见 SmImage.c)
+ * @param blob 生成结果(输出)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 失败(原因及行号见 blob->error)
+ */
+SmRetCode SmImageBuildFromText(const char *text, SmImageBlob *blob);
+
+/**
+ * @brief 保存镜像到文件
+ * @param blob 镜像数据
+ * @param path 文件路径
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmImageBlobSave(const SmImageBlob *blob, const char *path);
+
+/**
+ * @brief 释放生成的镜像数据
+ * @param blob 镜像数据
+ */
+void SmImageBlobFree(SmImageBlob *blob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMIMAGE_H__ */
@@ -0,0 +1,210 @@
+/**
+ * @file SmImage_tool.c
+ * @brief 类镜像生成/查看工具
+ *
+ * 用法:
+ *   image_tool build <描述文件> <镜像文件>   由描述文本生成镜像
+ *   image_tool dump <镜像文件>               打印镜像内容(不解析符号)
+ */
+
+#include "SmImage.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+static char *ToolReadFile(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *text = (size >= 0) ? malloc((size_t)size + 1) : NULL;
+    if (text != NULL)
+    {
+        size_t n = fread(text, 1, (size_t)size, fp);
+        text[n] = '\0';
+    }
+    fclose(fp);
+    return text;
+}
+
+static const char *ToolString(const uint8_t *base, const SmImageHeader *h, uint32_t offset)
+{
+    return (offset < h->strings_size) ? (const char *)base + h->strings + offset : "?";
+}
+
+static const char *ToolSymbol(const uint8_t *base, const SmImageHeader *h, uint16_t sym)
+{
+    if (sym == SM_IMAGE_NO_SYM || sym > h->symbol_count)
+    {
+        return "-";
+    }
+    return ToolString(base, h, ((const uint32_t *)(base + h->symbols))[sym - 1]);
+}
+
+static const char *ToolEvent(const uint8_t *base, const SmImageHeader *h, int32_t event, char *buf, size_t size)
+{
+    if (h->event_names != SM_IMAGE_NONE && event >= 0 && event < h->event_count)
+    {
+        const char *name = ToolString(base, h, ((const uint32_t *)(base + h->event_names))[event]);
+        if (name[0] != '\0')
+        {
+            return name;
+        }
+    }
+    snprintf(buf, size, "%d", event);
+    return buf;
+}
+
+static void ToolDumpTrans(const uint8_t *base, const SmImageHeader *h, const SmImageTrans *t)
+{
+    char buf[16];
+
+    static const char *const kinds[] = { "", " kind=internal", " kind=local" };
+
+    printf("    %-16s -> %-4d cond=%s action=%s data=%s%s\n",
+           (t->event_id == SM_EVENT_COMPLETION) ? "completion" : ToolEvent(base, h, t->event_id, buf, sizeof(buf)),
+           t->next_state, ToolSymbol(base, h, t->cond_sym), ToolSymbol(base, h, t->action_sym),
+           ToolSymbol(base, h, t->data_sym), (t->kind < 3) ? kinds[t->kind] : " kind=?");
+}
+
+static int ToolBuild(const char *desc, const char *out)
+{
+    SmImageBlob blob;
+
+    char *text = ToolReadFile(desc);
+    if (text == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", desc);
+        return 1;
+    }
+
+    SmRetCode ret = SmImageBuildFromText(text, &blob);
+    free(text);
+    if (ret != SM_RET_OK)
+    {
+        fprintf(stderr, "%s: %s\n", desc, blob.error);
+        return 1;
+    }
+
+    ret = SmImageBlobSave(&blob, out);
+    printf("%s: %zu bytes\n", out, blob.size);
+    SmImageBlobFree(&blob);
+    return (ret == SM_RET_OK) ? 0 : 1;
+}
+
+static int ToolDump(const char *path)
+{
+    struct stat st;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SmImageHeader))
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+    const uint8_t *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    /* 只检查头, 段内容按生成器的布局直接打印 */
+    const SmImageHeader *h = (const SmImageHeader *)base;
+    if (h->magic != SM_IMAGE_MAGIC || h->version != SM_IMAGE_VERSION || h->image_size > (uint64_t)st.st_size)
+    {
+        fprintf(stderr, "%s: not a version %d class image\n", path, SM_IMAGE_VERSION);
+        munmap((void *)base, (size_t)st.st_size);
+        return 1;
+    }
+
+    printf("class %s: %u bytes, %u states, %u events, %u+%u transitions, %u symbols, table %s\n",
+           ToolString(base, h, h->class_name), h->image_size, h->state_count, h->event_count, h->trans_count,
+           h->any_count, h->symbol_count, (h->table_base != SM_IMAGE_NONE) ? "yes" : "no");
+
+    const SmImageState *states = (const SmImageState *)(base + h->states);
+    const SmImageTrans *trans = (const SmImageTrans *)(base + h->transitions);
+    for (uint16_t i = 0; i < h->state_count; i++)
+    {
+        const SmImageState *s = &states[i];
+        printf("  [%d] %s kind=%u enter=%s exit=%s handle=%s", s->state_id, ToolString(base, h, s->name), s->kind,
+               ToolSymbol(base, h, s->enter_sym), ToolSymbol(base, h, s->exit_sym), ToolSymbol(base, h, s->handle_sym));
+        if (s->flags & SM_IMAGE_STATE_HAS_PARENT)
+        {
+            printf(" parent=%d", s->parent);
+        }
+        if (s->kind != SM_STATE_LEAF)
+        {
+            printf(" initial=%d", s->initial);
+        }
+        if (s->dwell_budget != 0)
+        {
+            printf(" dwell=%u", s->dwell_budget);
+        }
+        if (s->defer_events != SM_IMAGE_NONE)
+        {
+            const SmEventId *ev = (const SmEventId *)(base + s->defer_events);
+            printf(" defers=");
+            for (uint32_t n = 0; ev[n] != SM_EVENT_INVALID; n++)
+            {
+                printf("%s%d", (n > 0) ? "," : "", ev[n]);
+            }
+        }
+        printf("\n");
+        for (uint16_t t = 0; t < s->trans_count; t++)
+        {
+            ToolDumpTrans(base, h, &trans[s->trans_first + t]);
+        }
+    }
+
+    if (h->any_count > 0)
+    {
+        printf("  [any]\n");
+        for (uint16_t t = 0; t < h->any_count; t++)
+        {
+            ToolDumpTrans(base, h, &trans[h->trans_count + t]);
+        }
+    }
+
+    munmap((void *)base, (size_t)st.st_size);
+    return 0;
+}
+
+/* ============================================================================
+ * 工具主函数
+ * ============================================================================ */
+
+int image_tool(int argc, char *argv[])
+{
+    if (argc == 4 && strcmp(argv[1], "build") == 0)
+    {
+        return ToolBuild(argv[2], argv[3]);
+    }
+    if (argc == 3 && strcmp(argv[1], "dump") == 0)
+    {
+        return ToolDump(argv[2]);
+    }
+
+    fprintf(stderr, "usage: %s build <desc> <image>\n"
+                    "       %s dump <image>\n", argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,231 @@
+#include "SmLoop.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_LOOP_BATCH 64 /* 每次加锁最多取出的事件数量 */
+
+/**
+ * @brief 分发一个事件(绑定了队列的实例经过队列, 保持通道优先级)
+ */
+static void SmLoopDeliver(SmMachine *machine, SmEventId event)
+{
+    if (machine->queue != NULL)
+    {
+        SmPostEvent(machine, event);
+        SmDispatch(machine, 0);
+    }
+    else
+    {
+        SmSendEvent(machine, event);
+    }
+}
+
+/**
+ * @brief 取出一批投递的事件
+ */
+static uint32_t SmLoopTake(SmLoop *loop, SmLoopItem *batch)
+{
+    uint32_t n = 0;
+
+    SmOsMutexLock(&loop->lock);
+    while (n < SM_LOOP_BATCH && loop->count > 0)
+    {
+        batch[n++] = loop->items[loop->head];
+        loop->head = (loop->head + 1 == loop->capacity) ? 0 : loop->head + 1;
+        loop->count--;
+    }
+    SmOsMutexUnlock(&loop->lock);
+
+    return n;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmLoopInit(SmLoop *loop, SmLoopItem *items, uint32_t capacity, SmTimerHeap *timers, SmOutbox *outbox)
+{
+    if (loop == NULL || items == NULL || capacity == 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(loop, 0, sizeof(SmLoop));
+    if (SmOsMutexInit(&loop->lock) != SM_RET_OK)
+    {
+        return SM_RET_ERROR;
+    }
+    if (SmOsSemInit(&loop->wake, 0) != SM_RET_OK)
+    {
+        SmOsMutexDeinit(&loop->lock);
+        return SM_RET_ERROR;
+    }
+
+    loop->items = items;
+    loop->capacity = capacity;
+    loop->timers = timers;
+    loop->outbox = outbox;
+    atomic_init(&loop->stop, false);
+
+    if (SmGetTimeFn() == NULL)
+    {
+        SmSetTimeFn(SmOsTimeUs);
+    }
+
+    return SM_RET_OK;
+}
+
+void SmLoopDeinit(SmLoop *loop)
+{
+    if (loop == NULL)
+    {
+        return;
+    }
+
+    SmOsSemDeinit(&loop->wake);
+    SmOsMutexDeinit(&loop->lock);
+}
+
+SmRetCode SmLoopPost(SmLoop *loop, SmMachine *machine, SmEventId event)
+{
+    if (loop == NULL || machine == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    bool wake = false;
+
+    SmOsMutexLock(&loop->lock);
+    if (loop->count >= loop->capacity)
+    {
+        loop->stats.dropped++;
+        SmOsMutexUnlock(&loop->lock);
+        return SM_RET_ERROR;
+    }
+
+    uint32_t tail = loop->head + loop->count;
+    if (tail >= loop->capacity)
+    {
+        tail -= loop->capacity;
+    }
+    loop->items[tail].machine = machine;
+    loop->items[tail].event = event;
+    loop->count++;
+
+    /* 只在循环准备阻塞时唤醒, 每次阻塞最多唤醒一次 */
+    if (loop->waiting)
+    {
+        loop->waiting = false;
+        wake = true;
+    }
+    SmOsMutexUnlock(&loop->lock);
+
+    if (wake)
+    {
+        SmOsSemPost(&loop->wake);
+    }
+
+    return SM_RET_OK;
+}
+
+uint32_t SmLoopRunOnce(SmLoop *loop, uint64_t max_wait_us)
+{
+    SmLoopItem batch[SM_LOOP_BATCH];
+    uint32_t dispatched = 0;
+
+    if (loop == NULL)
+    {
+        return 0;
+    }
+
+    /* 1. 投递的事件 */
+    uint32_t n;
+    while ((n = SmLoopTake(loop, batch)) > 0)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            SmLoopDeliver(batch[i].machine, batch[i].event);
+        }
+        dispatched += n;
+    }
+
+    /* 2. 到期的定时器 */
+    SmMachine *machine;
+    SmEventId event;
+    uint64_t now = SmGetTime();
+    while (loop->timers != NULL && SmTimerPop(loop->timers, now, &machine, &event))
+    {
+        SmLoopDeliver(machine, event);
+        loop->stats.fired++;
+        dispatched++;
+    }
+
+    /* 3. 本轮的副作用 */
+    SmOutboxFlush(loop->outbox);
+    loop->stats.dispatched += dispatched;
+
+    if (dispatched > 0 || atomic_load_explicit(&loop->stop, memory_order_acquire))
+    {
+        return dispatched;
+    }
+
+    /* 4. 空闲: 阻塞到下一个截止时间或新事件 */
+    uint64_t wait_us = max_wait_us;
+    uint64_t deadline;
+    if (loop->timers != NULL && SmTimerPeek(loop->timers, &deadline))
+    {
+        now = SmGetTime();
+        uint64_t until = (deadline > now) ? deadline - now : 0;
+        if (until < wait_us)
+        {
+            wait_us = until;
+        }
+    }
+
+    SmOsMutexLock(&loop->lock);
+    bool idle = (loop->count == 0);
+    loop->waiting = idle;
+    SmOsMutexUnlock(&loop->lock);
+
+    if (idle && wait_us > 0)
+    {
+        loop->stats.sleeps++;
+        if (SmOsSemWait(&loop->wake, wait_us) == SM_RET_OK)
+        {
+            loop->stats.wakeups++;
+        }
+    }
+
+    SmOsMutexLock(&loop->lock);
+    loop->waiting = false;
+    SmOsMutexUnlock(&loop->lock);
+
+    return 0;
+}
+
+void SmLoopRun(SmLoop *loop)
+{
+    if (loop == NULL)
+    {
+        return;
+    }
+
+    while (!atomic_load_explicit(&loop->stop, memory_order_acquire))
+    {
+        SmLoopRunOnce(loop, SM_OS_WAIT_FOREVER);
+    }
+}
+
+void SmLoopStop(SmLoop *loop)
+{
+    if (loop == NULL)
+    {
+        return;
+    }
+
+    atomic_store_explicit(&loop->stop, true, memory_order_release);
+    SmOsSemPost(&loop->wake);
+}
@@ -0,0 +1,121 @@
+#ifndef __SMLOOP_H__
+#define __SMLOOP_H__
+
+#include <stdatomic.h>
+#include "SmMgr.h"
+#include "SmOs.h"
+#include "SmTimer.h"
+#include "SmOutbox.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 阻塞式分发循环
+ * ============================================================================ */
+
+/*
+ * 一个分发线程的事件循环, 取代轮询:
+ *   1. 取出其他线程投递的事件并分发
+ *   2. 触发已到期的定时器
+ *   3. 刷新 outbox(可选)
+ *   4. 没有待处理事件时在信号量上阻塞, 超时时间为最近的定时器截止时间
+ * 投递方只在循环即将阻塞或已阻塞时释放信号量, 繁忙时投递不产生唤醒开销.
+ * 定时器截止时间按 SmGetTime 计算, 单位为微秒(SmLoopInit 在未设置时间源时
+ * 安装 SmOsTimeUs).
+ *
+ * 约束: 实例只在循环线程中分发; 定时器只在循环线程(回调函数)中启动/取消;
+ *       SmLoopPost/SmLoopStop 可在任意线程调用.
+ */
+
+/**
+ * @brief 投递的事件
+ */
+typedef struct
+{
+    SmMachine *machine; /* 目标实例 */
+    SmEventId event;    /* 事件ID */
+} SmLoopItem;
+
+/**
+ * @brief 分发循环统计
+ */
+typedef struct
+{
+    uint64_t dispatched; /* 分发的事件数量(含定时器) */
+    uint64_t fired;      /* 触发的定时器数量 */
+    uint64_t dropped;    /* 收件箱满丢弃的事件数量 */
+    uint64_t sleeps;     /* 阻塞等待次数 */
+    uint64_t wakeups;    /* 被投递唤醒的次数 */
+} SmLoopStats;
+
+/**
+ * @brief 分发循环
+ */
+typedef struct
+{
+    SmOsMutex lock;      /* 保护收件箱和 waiting */
+    SmOsSem wake;        /* 唤醒信号量 */
+    SmLoopItem *items;   /* 收件箱 [capacity] */
+    uint32_t capacity;   /* 收件箱容量 */
+    uint32_t head;       /* 收件箱头 */
+    uint32_t count;      /* 收件箱中的事件数量 */
+    bool waiting;        /* 循环是否即将/正在阻塞 */
+    atomic_bool stop;    /* 停止请求 */
+    SmTimerHeap *timers; /* 定时器堆(可选) */
+    SmOutbox *outbox;    /* 每轮结束时刷新的输出缓冲区(可选) */
+    SmLoopStats stats;   /* 统计(dropped 在锁内更新, 其余只由循环线程写) */
+} SmLoop;
+
+/**
+ * @brief 初始化分发循环
+ * @param loop 分发循环
+ * @param items 收件箱存储 [capacity]
+ * @param capacity 收件箱容量
+ * @param timers 定时器堆(可选)
+ * @param outbox 输出缓冲区(可选)
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmLoopInit(SmLoop *loop, SmLoopItem *items, uint32_t capacity, SmTimerHeap *timers, SmOutbox *outbox);
+
+/**
+ * @brief 销毁分发循环
+ * @param loop 分发循环
+ */
+void SmLoopDeinit(SmLoop *loop);
+
+/**
+ * @brief 投递事件(线程安全)
+ * @param loop 分发循环
+ * @param machine 目标实例
+ * @param event 事件ID
+ * @return SM_RET_OK 成功, SM_RET_ERROR 收件箱已满
+ */
+SmRetCode SmLoopPost(SmLoop *loop, SmMachine *machine, SmEventId event);
+
+/**
+ * @brief 执行一轮: 分发事件, 触发定时器, 刷新输出, 必要时阻塞等待
+ * @param loop 分发循环
+ * @param max_wait_us 最长阻塞时间(微秒), SM_OS_WAIT_FOREVER 表示直到有事件或定时器到期
+ * @return 本轮分发的事件数量
+ */
+uint32_t SmLoopRunOnce(SmLoop *loop, uint64_t max_wait_us);
+
+/**
+ * @brief 运行直到 SmLoopStop
+ * @param loop 分发循环
+ */
+void SmLoopRun(SmLoop *loop);
+
+/**
+ * @brief 请求停止(线程安全)
+ * @param loop 分发循环
+ */
+void SmLoopStop(SmLoop *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMLOOP_H__ */
@@ -1,6 +1,20 @@
 #include "SmMgr.h"
+#include "SmTable.h"
+#include "SmObserver.h"
+#include "SmOutbox.h"
+#include "SmWatchdog.h"
+#include "SmPopIndex.h"
+#include "SmRepl.h"
+#include "SmSpec.h"
+#include "SmNames.h"
 #include <string.h>
 
+/* ============================================================================
+ * 内部变量
+ * ============================================================================ */
+
+static SmTimeFn s_time_fn = NULL; /* 全局时间源 */
+
 /* ============================================================================
  * 内部辅助函数
  * ============================================================================ */
@@ -8,13 +22,20 @@
 /**
  * @brief 查找状态定义
  */
-static SmState *SmFindState(SmMachine *machine, SmStateId state_id)
+static const SmState *SmFindState(SmMachine *machine, SmStateId state_id)
 {
     if (machine == NULL || machine->sm_class == NULL)
     {
         return NULL;
     }
 
+    /* 状态ID与下标一致时直接索引 */
+    if (state_id >= 0 && state_id < machine->sm_class->state_count &&
+        machine->sm_class->states[state_id].state_id == state_id)
+    {
+        return &machine->sm_class->states[state_id];
+    }
+
     for (uint16_t i = 0; i < machine->sm_class->state_count; i++)
     {
         if (machine->sm_class->states[i].state_id == state_id)
@@ -26,36 +47,320 @@ static SmState *SmFindState(SmMachine *machine, SmStateId state_id)
     return NULL;
 }
 
+/**
+ * @brief 在转换数组中查找事件对应的规则
+ */
+static const SmTransition *SmFindInTransitions(const SmTransition *transitions, uint16_t count, SmEventId event)
+{
+    if (transitions == NULL)
+    {
+        return NULL;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (transitions[i].event_id == event)
+        {
+            return &transitions[i];
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * @brief 查找状态转换规则
+ * @note 状态自身规则优先, 无匹配时查找类级通配转换(状态可选择退出);
+ *       类带有压缩转换表时直接 O(1) 查表(通配转换已在构建时展开)
  */
-static SmTransition *SmFindTransition(SmState *state, SmEventId event)
+static const SmTransition *SmFindTransition(const SmClass *sm_class, const SmState *state, SmEventId event)
 {
-    if (state == NULL || state->transitions == NULL)
+    if (state == NULL)
     {
         return NULL;
     }
 
-    for (uint16_t i = 0; i < state->trans_count; i++)
+    if (sm_class->table != NULL)
+    {
+        return SmTableLookup(sm_class->table, sm_class, (uint16_t)(state - sm_class->states), event);
+    }
+
+    const SmTransition *trans = SmFindInTransitions(state->transitions, state->trans_count, event);
+    if (trans == NULL && !state->any_opt_out)
+    {
+        trans = SmFindInTransitions(sm_class->any_transitions, sm_class->any_trans_count, event);
+    }
+
+    return trans;
+}
+
+/**
+ * @brief 判断 on_handle 是否关心事件
+ */
+static bool SmStateHandles(const SmState *state, SmEventId event)
+{
+    if (state->handle_events == NULL)
+    {
+        return true;
+    }
+
+    for (const SmEventId *evt = state->handle_events; *evt != SM_EVENT_INVALID; evt++)
+    {
+        if (*evt == event)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 获取所属组合状态
+ */
+static const SmState *SmParentState(SmMachine *machine, const SmState *state)
+{
+    return state->has_parent ? SmFindState(machine, state->parent) : NULL;
+}
+
+/**
+ * @brief 解析转换目标为叶子状态
+ * @note 组合状态沿 initial 下降; 历史伪状态取所属组合状态最近的活动叶子,
+ *       浅历史只恢复到其直接子状态, 无记录时使用默认目标
+ */
+static const SmState *SmResolveTarget(SmMachine *machine, SmStateId target)
+{
+    const SmState *state = SmFindState(machine, target);
+
+    for (uint16_t n = 0; state != NULL && n <= machine->sm_class->state_count; n++)
     {
-        if (state->transitions[i].event_id == event)
+        if (state->kind == SM_STATE_LEAF)
+        {
+            return state;
+        }
+
+        if (state->kind == SM_STATE_COMPOSITE)
+        {
+            state = SmFindState(machine, state->initial);
+            continue;
+        }
+
+        /* 历史伪状态 */
+        const SmState *composite = SmParentState(machine, state);
+        SmStateId last = SM_STATE_INVALID;
+        if (composite != NULL && machine->history != NULL)
+        {
+            last = machine->history[composite - machine->sm_class->states];
+        }
+
+        if (last == SM_STATE_INVALID)
+        {
+            state = SmFindState(machine, state->initial);
+        }
+        else if (state->kind == SM_STATE_HISTORY_DEEP)
         {
-            return &state->transitions[i];
+            state = SmFindState(machine, last);
+        }
+        else
+        {
+            const SmState *child = SmFindState(machine, last);
+            while (child != NULL && SmParentState(machine, child) != composite)
+            {
+                child = SmParentState(machine, child);
+            }
+            state = child;
         }
     }
 
     return NULL;
 }
 
+/**
+ * @brief 获取状态到根的路径
+ * @return 路径长度(path[0] 为状态自身)
+ */
+static uint16_t SmStatePath(SmMachine *machine, const SmState *state, const SmState **path)
+{
+    uint16_t depth = 0;
+
+    while (state != NULL && depth < SM_STATE_MAX_DEPTH)
+    {
+        path[depth++] = state;
+        state = SmParentState(machine, state);
+    }
+
+    return depth;
+}
+
+/**
+ * @brief 计算转换需要退出/进入的状态数量
+ * @param first 从路径的第几层开始查找公共祖先: 1 表示源状态自身总是退出并重新进入
+ *              (外部转换), 0 表示保留共同所在的全部状态(本地转换)
+ * @note 退出到最近公共祖先(不含)为止
+ */
+static void SmTransitionScope(const SmState **exit_path, uint16_t exit_depth,
+                              const SmState **enter_path, uint16_t enter_depth, uint16_t first,
+                              uint16_t *exit_count, uint16_t *enter_count)
+{
+    *exit_count = exit_depth;
+    *enter_count = enter_depth;
+
+    for (uint16_t i = first; i < exit_depth; i++)
+    {
+        for (uint16_t j = first; j < enter_depth; j++)
+        {
+            if (exit_path[i] == enter_path[j])
+            {
+                *exit_count = i;
+                *enter_count = j;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 依次调用退出函数(从叶子向上)
+ */
+static SmRetCode SmExitStates(SmMachine *machine, const SmState **path, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        /* 推演中先记录, 替换为桩函数时不实际调用 */
+        if (path[i]->on_exit != NULL &&
+            (machine->spec == NULL || SmSpecRecord(machine->spec, SM_SPEC_STEP_EXIT, path[i]->state_id, NULL)))
+        {
+            SmRetCode ret = path[i]->on_exit((SmHandle)machine);
+            if (ret != SM_RET_OK)
+            {
+                return ret;
+            }
+        }
+    }
+
+    return SM_RET_OK;
+}
+
+/**
+ * @brief 依次调用进入函数(从外层向叶子)
+ */
+static SmRetCode SmEnterStates(SmMachine *machine, const SmState **path, uint16_t count)
+{
+    for (uint16_t i = count; i > 0; i--)
+    {
+        if (path[i - 1]->on_enter != NULL &&
+            (machine->spec == NULL || SmSpecRecord(machine->spec, SM_SPEC_STEP_ENTER, path[i - 1]->state_id, NULL)))
+        {
+            SmRetCode ret = path[i - 1]->on_enter((SmHandle)machine);
+            if (ret != SM_RET_OK)
+            {
+                return ret;
+            }
+        }
+    }
+
+    return SM_RET_OK;
+}
+
+/**
+ * @brief 提交状态变更
+ * @param keep_clock 保留进入时间(热更新只换状态ID, 实例并未重新进入)
+ * @note 所有改变 current_state 的路径(转换/强制切换/启动/停止/迁移)都经过这里
+ */
+static void SmCommitStateEx(SmMachine *machine, SmStateId previous_state, SmStateId new_state, bool keep_clock)
+{
+    /* 自转换不算重新进入, 停留时间继续累计 */
+    SmStateId old_state = machine->current_state;
+    bool entered = (new_state != old_state);
+
+    machine->previous_state = previous_state;
+    machine->current_state = new_state;
+    if (entered && !keep_clock)
+    {
+        machine->enter_time = SmGetTime();
+    }
+
+    /* 记录各级组合状态最近的活动叶子 */
+    if (machine->history != NULL && new_state != SM_STATE_INVALID)
+    {
+        const SmState *state = SmFindState(machine, new_state);
+        for (uint16_t depth = 0; state != NULL && state->has_parent && depth < SM_STATE_MAX_DEPTH; depth++)
+        {
+            state = SmFindState(machine, state->parent);
+            if (state != NULL)
+            {
+                machine->history[state - machine->sm_class->states] = new_state;
+            }
+        }
+    }
+
+    /* 导出到共享内存观察槽位 */
+    if (machine->obs_slot != NULL)
+    {
+        SmObsSlotWrite(machine->obs_slot, new_state, previous_state, SmGetTime());
+    }
+
+    /* 更新状态成员索引 */
+    if (machine->pop_index != NULL)
+    {
+        SmPopIndexMove(machine, old_state, new_state);
+    }
+
+    /* 按新状态的停留预算重新登记 */
+    if (machine->dwell.watchdog != NULL)
+    {
+        SmWatchdogTrack(machine, SmFindState(machine, new_state), entered);
+    }
+
+    /* 进入新状态后重新分发延迟的事件 */
+    if (entered && machine->defer.count > 0)
+    {
+        machine->defer.recall = true;
+    }
+
+    /* 记录推演中的状态提交 */
+    if (machine->spec != NULL)
+    {
+        SmSpecRecord(machine->spec, SM_SPEC_STEP_STATE, new_state, NULL);
+    }
+
+    /* 标记待复制, 最外层调用结束时连同进入函数对用户数据的修改一起发布 */
+    if (machine->repl != NULL)
+    {
+        machine->repl_pending = true;
+    }
+}
+
+/**
+ * @brief 提交状态变更(进入新状态时重新开始计时)
+ */
+static inline void SmCommitState(SmMachine *machine, SmStateId previous_state, SmStateId new_state)
+{
+    SmCommitStateEx(machine, previous_state, new_state, false);
+}
+
+/**
+ * @brief 发布待复制的状态变更(嵌套调用中推迟到最外层)
+ */
+static void SmReplFlush(SmMachine *machine)
+{
+    if (machine->repl_pending && machine->dispatch_depth == 0)
+    {
+        machine->repl_pending = false;
+        SmReplPublish(machine);
+    }
+}
+
 /**
  * @brief 执行状态转换
  */
-static SmRetCode SmPerformTransition(SmMachine *machine, SmState *current_state, SmTransition *trans)
+static SmRetCode SmPerformTransition(SmMachine *machine, const SmState *current_state, const SmTransition *trans)
 {
     SmRetCode ret = SM_RET_OK;
 
     /* 执行转换前动作(如果有) */
-    if (trans->action != NULL)
+    if (trans->action != NULL &&
+        (machine->spec == NULL || SmSpecRecord(machine->spec, SM_SPEC_STEP_ACTION, machine->current_state, trans)))
     {
         ret = trans->action((SmHandle)machine, trans->action_data);
         if (ret != SM_RET_OK)
@@ -64,26 +369,65 @@ static SmRetCode SmPerformTransition(SmMachine *machine, SmState *current_state,
         }
     }
 
-    /* 查找目标状态 */
-    SmState *next_state = SmFindState(machine, trans->next_state);
+    /* 内部转换: 只执行动作 */
+    if (trans->kind == SM_TRANS_KIND_INTERNAL)
+    {
+        return SM_RET_OK;
+    }
+
+    /* 查找目标状态(组合状态/历史伪状态解析为叶子状态) */
+    const SmState *next_state = SmResolveTarget(machine, trans->next_state);
     if (next_state == NULL)
     {
         return SM_RET_ERROR;
     }
 
-    /* 退出当前状态 */
-    if (current_state->on_exit != NULL)
+    /* 跳过构建时已融合的直通状态, 直接到达完成转换链的终点 */
+    const SmTable *table = machine->sm_class->table;
+    if (table != NULL && table->chain != NULL)
     {
-        ret = current_state->on_exit((SmHandle)machine);
-        if (ret != SM_RET_OK)
+        uint16_t end = table->chain[next_state - machine->sm_class->states];
+        if (end < table->state_count)
         {
-            return ret;
+            next_state = &machine->sm_class->states[end];
+        }
+    }
+
+    /* 退出当前状态及不包含目标状态的各级组合状态 */
+    const SmState *exit_path[SM_STATE_MAX_DEPTH];
+    const SmState *enter_path[SM_STATE_MAX_DEPTH];
+    uint16_t exit_count;
+    uint16_t enter_count;
+    uint16_t exit_depth = SmStatePath(machine, current_state, exit_path);
+    uint16_t enter_depth = SmStatePath(machine, next_state, enter_path);
+    SmTransitionScope(exit_path, exit_depth, enter_path, enter_depth,
+                      (trans->kind == SM_TRANS_KIND_LOCAL) ? 0 : 1, &exit_count, &enter_count);
+
+    /* 外部转换的目标是源状态所属的组合状态时, 该组合状态同样退出并重新进入 */
+    for (uint16_t i = 1; trans->kind == SM_TRANS_KIND_EXTERNAL && i < exit_depth; i++)
+    {
+        if (exit_path[i]->state_id == trans->next_state)
+        {
+            for (uint16_t j = 0; j < enter_depth; j++)
+            {
+                if (enter_path[j] == exit_path[i])
+                {
+                    exit_count = i + 1;
+                    enter_count = j + 1;
+                }
+            }
+            break;
         }
     }
 
+    ret = SmExitStates(machine, exit_path, exit_count);
+    if (ret != SM_RET_OK)
+    {
+        return ret;
+    }
+
     /* 更新状态 */
-    machine->previous_state = machine->current_state;
-    machine->current_state = trans->next_state;
+    SmCommitState(machine, machine->current_state, next_state->state_id);
 
     /* 输出转换日志 */
     if (machine->trans_log_fn != NULL)
@@ -93,6 +437,10 @@ static SmRetCode SmPerformTransition(SmMachine *machine, SmState *current_state,
         {
             event_name = machine->get_event_name_fn(trans->event_id);
         }
+        else
+        {
+            event_name = SmGetEventName(machine->sm_class, trans->event_id);
+        }
         machine->trans_log_fn(
             machine->sm_class->class_name,
             current_state->state_name,
@@ -101,17 +449,47 @@ static SmRetCode SmPerformTransition(SmMachine *machine, SmState *current_state,
             event_name);
     }
 
-    /* 进入新状态 */
-    if (next_state->on_enter != NULL)
+    /* 进入目标状态所在的各级组合状态及目标状态 */
+    return SmEnterStates(machine, enter_path, enter_count);
+}
+
+/**
+ * @brief 执行完成转换(进入新状态后调用)
+ * @note 逐步执行直到状态没有完成转换或条件不满足; 步数超过状态数量视为成环
+ */
+static SmRetCode SmRunCompletions(SmMachine *machine)
+{
+    const SmClass *sm_class = machine->sm_class;
+
+    for (uint16_t n = 0; n <= sm_class->state_count; n++)
     {
-        ret = next_state->on_enter((SmHandle)machine);
-        if (ret != SM_RET_OK)
+        const SmState *state = SmFindState(machine, machine->current_state);
+        if (state == NULL)
+        {
+            return SM_RET_OK;
+        }
+
+        /* 有压缩表时按构建结果直接判断, 没有完成转换的状态不扫描转换数组 */
+        if (sm_class->table != NULL && sm_class->table->chain != NULL &&
+            sm_class->table->chain[state - sm_class->states] == SM_TABLE_EMPTY)
+        {
+            return SM_RET_OK;
+        }
+
+        const SmTransition *trans = SmFindInTransitions(state->transitions, state->trans_count, SM_EVENT_COMPLETION);
+        if (trans == NULL || (trans->condition != NULL && !trans->condition((SmHandle)machine, trans->action_data)))
+        {
+            return SM_RET_OK;
+        }
+
+        SmRetCode ret = SmPerformTransition(machine, state, trans);
+        if (ret != SM_RET_OK || trans->kind == SM_TRANS_KIND_INTERNAL)
         {
             return ret;
         }
     }
 
-    return SM_RET_OK;
+    return SM_RET_ERROR; /* 完成转换成环 */
 }
 
 /* ============================================================================
@@ -136,6 +514,18 @@ SmRetCode SmCreate(SmMachine *machine, const SmClass *sm_class, void *user_data)
     machine->is_initialized = false;
     machine->trans_log_fn = NULL;
     machine->get_event_name_fn = NULL;
+    machine->queue = NULL;
+    machine->machine_id = 0;
+    machine->obs_slot = NULL;
+    machine->hooks = NULL;
+    machine->outbox = NULL;
+    machine->history = NULL;
+    machine->history_count = 0;
+    machine->enter_time = 0;
+    machine->dwell.watchdog = NULL;
+    machine->pop_index = NULL;
+    machine->defer.buf = NULL;
+    machine->defer.size = 0;
 
     /* 调用类初始化函数 */
     if (sm_class->on_init != NULL)
@@ -167,13 +557,15 @@ SmRetCode SmDestroy(SmMachine *machine)
     /* 停止状态机(如果正在运行) */
     if (machine->current_state != SM_STATE_INVALID)
     {
-        SmState *state = SmFindState(machine, machine->current_state);
-        if (state != NULL && state->on_exit != NULL)
-        {
-            state->on_exit((SmHandle)machine);
-        }
+        const SmState *path[SM_STATE_MAX_DEPTH];
+        SmExitStates(machine, path, SmStatePath(machine, SmFindState(machine, machine->current_state), path));
     }
 
+    /* 退出停留时间监视, 状态成员索引和复制流 */
+    SmWatchdogDetach(machine);
+    SmPopIndexDetach(machine);
+    SmReplDetach(machine);
+
     /* 清零 */
     memset(machine, 0, sizeof(SmMachine));
     return SM_RET_OK;
@@ -186,28 +578,34 @@ SmRetCode SmStart(SmMachine *machine, SmStateId initial_state)
         return SM_RET_ERROR;
     }
 
-    /* 查找初始状态 */
-    SmState *state = SmFindState(machine, initial_state);
+    /* 查找初始状态(组合状态/历史伪状态解析为叶子状态) */
+    const SmState *state = SmResolveTarget(machine, initial_state);
     if (state == NULL)
     {
         return SM_RET_ERROR;
     }
 
+    /* 重新启动时清空历史记录和延迟事件 */
+    for (uint16_t i = 0; machine->history != NULL && i < machine->sm_class->state_count; i++)
+    {
+        machine->history[i] = SM_STATE_INVALID;
+    }
+    machine->defer.head = 0;
+    machine->defer.count = 0;
+
     /* 设置当前状态 */
-    machine->current_state = initial_state;
-    machine->previous_state = SM_STATE_INVALID;
+    SmCommitState(machine, SM_STATE_INVALID, state->state_id);
 
-    /* 调用进入函数 */
-    if (state->on_enter != NULL)
+    /* 从最外层组合状态开始调用进入函数 */
+    const SmState *path[SM_STATE_MAX_DEPTH];
+    SmRetCode ret = SmEnterStates(machine, path, SmStatePath(machine, state, path));
+    if (ret == SM_RET_OK)
     {
-        SmRetCode ret = state->on_enter((SmHandle)machine);
-        if (ret != SM_RET_OK)
-        {
-            return ret;
-        }
+        ret = SmRunCompletions(machine);
     }
 
-    return SM_RET_OK;
+    SmReplFlush(machine);
+    return ret;
 }
 
 SmRetCode SmStop(SmMachine *machine)
@@ -222,38 +620,39 @@ SmRetCode SmStop(SmMachine *machine)
         return SM_RET_OK; /* 已停止 */
     }
 
-    /* 退出当前状态 */
-    SmState *state = SmFindState(machine, machine->current_state);
-    if (state != NULL && state->on_exit != NULL)
-    {
-        state->on_exit((SmHandle)machine);
-    }
+    /* 退出当前状态及各级组合状态 */
+    const SmState *path[SM_STATE_MAX_DEPTH];
+    SmExitStates(machine, path, SmStatePath(machine, SmFindState(machine, machine->current_state), path));
 
-    machine->current_state = SM_STATE_INVALID;
+    SmCommitState(machine, machine->previous_state, SM_STATE_INVALID);
+    machine->defer.head = 0;
+    machine->defer.count = 0;
+    machine->defer.recall = false;
+    SmReplFlush(machine);
     return SM_RET_OK;
 }
 
-SmRetCode SmSendEvent(SmMachine *machine, SmEventId event)
+/**
+ * @brief 分发单个事件
+ */
+static SmRetCode SmDispatchEvent(SmMachine *machine, SmEventId event)
 {
-    if (machine == NULL || !machine->is_initialized)
-    {
-        return SM_RET_ERROR;
-    }
-
-    if (machine->current_state == SM_STATE_INVALID)
+    /* 查找当前状态 */
+    const SmState *state = SmFindState(machine, machine->current_state);
+    if (state == NULL)
     {
         return SM_RET_ERROR;
     }
 
-    /* 查找当前状态 */
-    SmState *state = SmFindState(machine, machine->current_state);
-    if (state == NULL)
+    /* 0. 快速拒绝: 状态既无转换也不处理该事件 */
+    const SmTable *table = machine->sm_class->table;
+    if (table != NULL && !SmTableIsInterested(table, (uint16_t)(state - machine->sm_class->states), event))
     {
-        return SM_RET_ERROR;
+        return SM_RET_IGNORE;
     }
 
     /* 1. 先调用状态处理函数 */
-    if (state->on_handle != NULL)
+    if (state->on_handle != NULL && SmStateHandles(state, event))
     {
         SmRetCode ret = state->on_handle((SmHandle)machine, event);
         if (ret == SM_RET_TRANSITION)
@@ -269,7 +668,7 @@ SmRetCode SmSendEvent(SmMachine *machine, SmEventId event)
     }
 
     /* 2. 查找转换规则 */
-    SmTransition *trans = SmFindTransition(state, event);
+    const SmTransition *trans = SmFindTransition(machine->sm_class, state, event);
     if (trans == NULL)
     {
         return SM_RET_IGNORE; /* 无转换规则,忽略事件 */
@@ -285,58 +684,255 @@ SmRetCode SmSendEvent(SmMachine *machine, SmEventId event)
         }
     }
 
-    /* 4. 执行转换 */
-    return SmPerformTransition(machine, state, trans);
+    /* 4. 执行转换, 然后执行新状态的完成转换 */
+    SmRetCode ret = SmPerformTransition(machine, state, trans);
+    if (ret != SM_RET_OK || trans->kind == SM_TRANS_KIND_INTERNAL)
+    {
+        return ret;
+    }
+    return SmRunCompletions(machine);
 }
 
-SmStateId SmGetCurrentState(SmMachine *machine)
+/**
+ * @brief 检查当前状态(或所属组合状态)是否延迟该事件
+ */
+static bool SmStateDefers(SmMachine *machine, SmEventId event)
 {
-    if (machine == NULL || !machine->is_initialized)
+    const SmState *state = SmFindState(machine, machine->current_state);
+    for (uint16_t depth = 0; state != NULL && depth < SM_STATE_MAX_DEPTH; depth++)
     {
-        return SM_STATE_INVALID;
+        for (const SmEventId *evt = state->deferred_events; evt != NULL && *evt != SM_EVENT_INVALID; evt++)
+        {
+            if (*evt == event)
+            {
+                return true;
+            }
+        }
+        state = SmParentState(machine, state);
     }
 
-    return machine->current_state;
+    return false;
 }
 
-SmRetCode SmForceTransition(SmMachine *machine, SmStateId new_state)
+/**
+ * @brief 分发一个事件, 未处理且被延迟时放入延迟队列
+ */
+static SmRetCode SmDispatchOrDefer(SmMachine *machine, SmEventId event)
 {
-    if (machine == NULL || !machine->is_initialized)
+    /* 事件处理失败时丢弃本事件产生的输出记录 */
+    SmOutMark out_mark = SmOutboxMark(machine->outbox);
+    SmRetCode ret = SmDispatchEvent(machine, event);
+
+    if (ret == SM_RET_IGNORE && machine->defer.size > 0 && SmStateDefers(machine, event))
     {
-        return SM_RET_ERROR;
+        SmDeferQueue *defer = &machine->defer;
+        if (defer->count < defer->size)
+        {
+            defer->buf[(defer->head + defer->count) % defer->size] = event;
+            defer->count++;
+            ret = SM_RET_DEFERRED;
+        }
+        else
+        {
+            ret = SM_RET_ERROR; /* 延迟队列已满 */
+        }
     }
 
-    if (machine->current_state == new_state)
+    if (ret != SM_RET_OK && ret != SM_RET_IGNORE && ret != SM_RET_DEFERRED)
     {
-        return SM_RET_OK; /* 已是目标状态 */
+        SmOutboxRollback(machine->outbox, out_mark);
     }
 
-    SmState *current_state = SmFindState(machine, machine->current_state);
-    SmState *next_state = SmFindState(machine, new_state);
+    return ret;
+}
 
-    if (next_state == NULL)
-    {
-        return SM_RET_ERROR;
-    }
+/**
+ * @brief 重新分发延迟的事件(外层事件处理完成后调用)
+ * @note 每轮只处理本轮开始时已在队列中的事件, 仍被延迟的事件重新排到队尾;
+ *       本轮中再次进入新状态时继续下一轮
+ */
+static void SmRecallDeferred(SmMachine *machine)
+{
+    SmDeferQueue *defer = &machine->defer;
 
-    /* 退出当前状态 */
-    if (current_state != NULL && current_state->on_exit != NULL)
+    machine->event_data = NULL;
+    machine->event_len = 0;
+
+    while (defer->recall)
     {
-        SmRetCode ret = current_state->on_exit((SmHandle)machine);
-        if (ret != SM_RET_OK)
+        defer->recall = false;
+        for (uint16_t n = defer->count; n > 0 && defer->count > 0; n--)
         {
-            return ret;
+            SmEventId event = defer->buf[defer->head];
+            defer->head = (uint16_t)((defer->head + 1) % defer->size);
+            defer->count--;
+
+            if (machine->current_state == SM_STATE_INVALID)
+            {
+                break; /* 处理过程中实例已停止 */
+            }
+            SmDispatchOrDefer(machine, event);
         }
     }
+}
 
-    /* 更新状态 */
-    machine->previous_state = machine->current_state;
-    machine->current_state = new_state;
+SmRetCode SmSendEvent(SmMachine *machine, SmEventId event)
+{
+    return SmSendEventEx(machine, event, NULL, 0);
+}
+
+SmRetCode SmSendEventEx(SmMachine *machine, SmEventId event, const void *data, uint16_t len)
+{
+    if (machine == NULL || !machine->is_initialized)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (machine->current_state == SM_STATE_INVALID)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 保存外层事件负载, 支持回调函数中嵌套发送 */
+    const void *outer_data = machine->event_data;
+    uint16_t outer_len = machine->event_len;
+
+    machine->event_data = data;
+    machine->event_len = len;
+    machine->dispatch_depth++;
+
+    SmRetCode ret = SmDispatchOrDefer(machine, event);
+
+    /* 运行到完成: 外层事件处理完成后才重新分发延迟的事件 */
+    if (machine->dispatch_depth == 1 && machine->defer.recall)
+    {
+        SmRecallDeferred(machine);
+    }
+
+    machine->dispatch_depth--;
+    machine->event_data = outer_data;
+    machine->event_len = outer_len;
+    SmReplFlush(machine);
+
+    /* 通知钩子(嵌套事件由外层事件的回调产生, 不单独通知) */
+    if (machine->hooks != NULL && machine->hooks->on_event != NULL && machine->dispatch_depth == 0)
+    {
+        machine->hooks->on_event(machine->hooks->ctx, machine, event, data, len, ret);
+    }
+
+    return ret;
+}
+
+const void *SmGetEventData(SmMachine *machine, uint16_t *len)
+{
+    if (machine == NULL || machine->dispatch_depth == 0)
+    {
+        if (len != NULL)
+        {
+            *len = 0;
+        }
+        return NULL;
+    }
+
+    if (len != NULL)
+    {
+        *len = machine->event_len;
+    }
+    return machine->event_data;
+}
+
+uint32_t SmBroadcast(const SmFleet *fleet, SmEventId event)
+{
+    uint32_t delivered = 0;
+
+    if (fleet == NULL || fleet->machines == NULL)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < fleet->count; i++)
+    {
+        SmMachine *machine = fleet->machines[i];
+        if (machine == NULL || machine->current_state == SM_STATE_INVALID)
+        {
+            continue;
+        }
+
+        /* 有压缩表时状态ID即下标, 一次位测试过滤不关心的实例 */
+        const SmTable *table = machine->sm_class->table;
+        if (table != NULL && !SmTableIsInterested(table, (uint16_t)machine->current_state, event))
+        {
+            continue;
+        }
+
+        SmSendEvent(machine, event);
+        delivered++;
+    }
+
+    return delivered;
+}
+
+SmStateId SmGetCurrentState(SmMachine *machine)
+{
+    if (machine == NULL || !machine->is_initialized)
+    {
+        return SM_STATE_INVALID;
+    }
+
+    return machine->current_state;
+}
+
+uint64_t SmGetEnterTime(SmMachine *machine)
+{
+    if (machine == NULL || !machine->is_initialized)
+    {
+        return 0;
+    }
+
+    return machine->enter_time;
+}
+
+SmRetCode SmForceTransition(SmMachine *machine, SmStateId new_state)
+{
+    if (machine == NULL || !machine->is_initialized)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const SmState *current_state = SmFindState(machine, machine->current_state);
+    const SmState *next_state = SmResolveTarget(machine, new_state);
+
+    if (next_state == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (machine->current_state == next_state->state_id)
+    {
+        return SM_RET_OK; /* 已是目标状态 */
+    }
+
+    /* 退出当前状态及不包含目标状态的各级组合状态 */
+    const SmState *exit_path[SM_STATE_MAX_DEPTH];
+    const SmState *enter_path[SM_STATE_MAX_DEPTH];
+    uint16_t exit_count;
+    uint16_t enter_count;
+    SmTransitionScope(exit_path, SmStatePath(machine, current_state, exit_path),
+                      enter_path, SmStatePath(machine, next_state, enter_path), 1, &exit_count, &enter_count);
+
+    SmRetCode ret = SmExitStates(machine, exit_path, exit_count);
+    if (ret != SM_RET_OK)
+    {
+        return ret;
+    }
+
+    /* 更新状态 */
+    SmCommitState(machine, machine->current_state, next_state->state_id);
 
     /* 输出转换日志(强制切换) */
     if (machine->trans_log_fn != NULL)
     {
-        SmState *current_state = SmFindState(machine, machine->previous_state);
+        const SmState *current_state = SmFindState(machine, machine->previous_state);
         if (current_state != NULL)
         {
             machine->trans_log_fn(
@@ -348,17 +944,23 @@ SmRetCode SmForceTransition(SmMachine *machine, SmStateId new_state)
         }
     }
 
-    /* 进入新状态 */
-    if (next_state->on_enter != NULL)
+    /* 进入目标状态所在的各级组合状态及目标状态 */
+    ret = SmEnterStates(machine, enter_path, enter_count);
+    if (ret == SM_RET_OK)
     {
-        SmRetCode ret = next_state->on_enter((SmHandle)machine);
-        if (ret != SM_RET_OK)
-        {
-            return ret;
-        }
+        ret = SmRunCompletions(machine);
     }
 
-    return SM_RET_OK;
+    /* 不在事件处理中时立即重新分发延迟的事件, 否则由外层事件完成后处理 */
+    if (machine->dispatch_depth == 0 && machine->defer.recall)
+    {
+        machine->dispatch_depth++;
+        SmRecallDeferred(machine);
+        machine->dispatch_depth--;
+    }
+
+    SmReplFlush(machine);
+    return ret;
 }
 
 void *SmGetUserData(SmMachine *machine)
@@ -387,6 +989,26 @@ void SmSetGetEventNameFn(SmMachine *machine, SmGetEventNameFn get_event_name_fn)
     }
 }
 
+bool SmIsInState(SmMachine *machine, SmStateId state_id)
+{
+    if (machine == NULL || !machine->is_initialized || machine->current_state == SM_STATE_INVALID)
+    {
+        return false;
+    }
+
+    const SmState *path[SM_STATE_MAX_DEPTH];
+    uint16_t depth = SmStatePath(machine, SmFindState(machine, machine->current_state), path);
+    for (uint16_t i = 0; i < depth; i++)
+    {
+        if (path[i]->state_id == state_id)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 const char *SmGetCurrentStateName(SmMachine *machine)
 {
     if (machine == NULL)
@@ -407,3 +1029,443 @@ const char *SmGetCurrentStateName(SmMachine *machine)
 
     return sm_class->states[machine->current_state].state_name;
 }
+
+/**
+ * @brief 比较名称(name 不要求以'\0'结尾)
+ */
+static bool SmNameEquals(const char *candidate, const char *name, size_t len)
+{
+    return candidate != NULL && memchr(name, '\0', len) == NULL && strncmp(candidate, name, len) == 0 &&
+           candidate[len] == '\0';
+}
+
+const char *SmGetEventName(const SmClass *sm_class, SmEventId event_id)
+{
+    if (sm_class == NULL || sm_class->event_names == NULL || event_id < 0 || event_id >= sm_class->event_name_count)
+    {
+        return NULL;
+    }
+
+    return sm_class->event_names[event_id];
+}
+
+SmEventId SmFindEventId(const SmClass *sm_class, const char *name, size_t len)
+{
+    if (sm_class == NULL || sm_class->event_names == NULL || name == NULL)
+    {
+        return SM_EVENT_INVALID;
+    }
+
+    if (sm_class->names != NULL)
+    {
+        int32_t id = SmNamesProbe(&sm_class->names->events, SmNamesHash(name, len));
+        return (id >= 0 && SmNameEquals(sm_class->event_names[id], name, len)) ? (SmEventId)id : SM_EVENT_INVALID;
+    }
+
+    for (uint16_t i = 0; i < sm_class->event_name_count; i++)
+    {
+        if (SmNameEquals(sm_class->event_names[i], name, len))
+        {
+            return (SmEventId)i;
+        }
+    }
+
+    return SM_EVENT_INVALID;
+}
+
+SmStateId SmFindStateId(const SmClass *sm_class, const char *name, size_t len)
+{
+    if (sm_class == NULL || sm_class->states == NULL || name == NULL)
+    {
+        return SM_STATE_INVALID;
+    }
+
+    if (sm_class->names != NULL)
+    {
+        int32_t index = SmNamesProbe(&sm_class->names->states, SmNamesHash(name, len));
+        return (index >= 0 && SmNameEquals(sm_class->states[index].state_name, name, len))
+                   ? sm_class->states[index].state_id
+                   : SM_STATE_INVALID;
+    }
+
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        if (SmNameEquals(sm_class->states[i].state_name, name, len))
+        {
+            return sm_class->states[i].state_id;
+        }
+    }
+
+    return SM_STATE_INVALID;
+}
+
+void SmSetMachineId(SmMachine *machine, uint32_t machine_id)
+{
+    if (machine != NULL)
+    {
+        machine->machine_id = machine_id;
+    }
+}
+
+uint32_t SmGetMachineId(const SmMachine *machine)
+{
+    return (machine != NULL) ? machine->machine_id : 0;
+}
+
+void SmSetObsSlot(SmMachine *machine, SmObsSlot *slot)
+{
+    if (machine != NULL)
+    {
+        machine->obs_slot = slot;
+    }
+}
+
+void SmSetHooks(SmMachine *machine, const SmHooks *hooks)
+{
+    if (machine != NULL)
+    {
+        machine->hooks = hooks;
+    }
+}
+
+void SmSetOutbox(SmMachine *machine, SmOutbox *outbox)
+{
+    if (machine != NULL)
+    {
+        machine->outbox = outbox;
+    }
+}
+
+SmOutbox *SmGetOutbox(SmMachine *machine)
+{
+    return (machine != NULL) ? machine->outbox : NULL;
+}
+
+SmRetCode SmSetHistoryStorage(SmMachine *machine, SmStateId *storage, uint16_t count)
+{
+    if (machine == NULL || machine->sm_class == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (storage != NULL && count < machine->sm_class->state_count)
+    {
+        return SM_RET_ERROR;
+    }
+
+    for (uint16_t i = 0; storage != NULL && i < count; i++)
+    {
+        storage[i] = SM_STATE_INVALID;
+    }
+    machine->history = storage;
+    machine->history_count = (storage != NULL) ? count : 0;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmSetDeferStorage(SmMachine *machine, SmEventId *storage, uint16_t count)
+{
+    if (machine == NULL || (storage != NULL && count == 0))
+    {
+        return SM_RET_ERROR;
+    }
+
+    machine->defer.buf = storage;
+    machine->defer.size = (storage != NULL) ? count : 0;
+    machine->defer.head = 0;
+    machine->defer.count = 0;
+    machine->defer.recall = false;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmMigrate(SmMachine *machine, const SmClass *new_class, SmStateId new_state)
+{
+    if (machine == NULL || !machine->is_initialized || new_class == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const SmClass *old_class = machine->sm_class;
+    machine->sm_class = new_class;
+
+    if (machine->current_state != SM_STATE_INVALID)
+    {
+        const SmState *state = SmFindState(machine, new_state);
+        if (state == NULL || state->kind != SM_STATE_LEAF)
+        {
+            machine->sm_class = old_class;
+            return SM_RET_ERROR;
+        }
+    }
+
+    /* 历史记录按状态下标保存, 换类后失效 */
+    if (machine->history != NULL && machine->history_count < new_class->state_count)
+    {
+        machine->history = NULL;
+        machine->history_count = 0;
+    }
+    for (uint16_t i = 0; machine->history != NULL && i < machine->history_count; i++)
+    {
+        machine->history[i] = SM_STATE_INVALID;
+    }
+
+    /* 状态ID可能变化但实例没有重新进入, 停留时间继续累计 */
+    if (machine->current_state != SM_STATE_INVALID)
+    {
+        SmCommitStateEx(machine, SM_STATE_INVALID, new_state, true);
+        SmReplFlush(machine);
+    }
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmRestoreState(SmMachine *machine, SmStateId state_id, SmStateId previous_state)
+{
+    if (machine == NULL || !machine->is_initialized)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (state_id != SM_STATE_INVALID)
+    {
+        const SmState *state = SmFindState(machine, state_id);
+        if (state == NULL || state->kind != SM_STATE_LEAF)
+        {
+            return SM_RET_ERROR;
+        }
+    }
+    else
+    {
+        machine->defer.head = 0;
+        machine->defer.count = 0;
+        machine->defer.recall = false;
+    }
+
+    SmCommitState(machine, previous_state, state_id);
+    SmReplFlush(machine);
+    return SM_RET_OK;
+}
+
+void SmSetTimeFn(SmTimeFn time_fn)
+{
+    s_time_fn = time_fn;
+}
+
+SmTimeFn SmGetTimeFn(void)
+{
+    return s_time_fn;
+}
+
+uint64_t SmGetTime(void)
+{
+    return (s_time_fn != NULL) ? s_time_fn() : 0;
+}
+
+/* ============================================================================
+ * 事件队列实现
+ * ============================================================================ */
+
+/**
+ * @brief 选择下一个分发的通道
+ * @note 先检查被抢占次数达到阈值的通道(从高到低), 否则选择最高优先级的非空通道
+ */
+static int SmQueuePickLane(SmEventQueue *queue)
+{
+    int lane = -1;
+
+    if (queue->starve_limit > 0)
+    {
+        for (int i = SM_LANE_COUNT - 1; i >= 0; i--)
+        {
+            if (queue->lanes[i].count > 0 && queue->lanes[i].skipped >= queue->starve_limit)
+            {
+                lane = i;
+                break;
+            }
+        }
+    }
+
+    if (lane < 0)
+    {
+        for (int i = SM_LANE_COUNT - 1; i >= 0; i--)
+        {
+            if (queue->lanes[i].count > 0)
+            {
+                lane = i;
+                break;
+            }
+        }
+    }
+
+    if (lane < 0)
+    {
+        return -1;
+    }
+
+    /* 更新其他非空通道的抢占计数 */
+    for (int i = 0; i < SM_LANE_COUNT; i++)
+    {
+        if (i == lane)
+        {
+            queue->lanes[i].skipped = 0;
+        }
+        else if (queue->lanes[i].count > 0 && queue->lanes[i].skipped < UINT16_MAX)
+        {
+            queue->lanes[i].skipped++;
+        }
+    }
+
+    return lane;
+}
+
+/**
+ * @brief 记录排队延迟
+ */
+static void SmLaneRecordDelay(SmLaneStats *stats, uint64_t delay)
+{
+    uint32_t bucket = 0;
+
+    while (bucket < SM_LANE_DELAY_BUCKETS - 1 && (delay >> bucket) != 0)
+    {
+        bucket++;
+    }
+
+    stats->dispatched++;
+    stats->delay_total += delay;
+    if (delay > stats->delay_max)
+    {
+        stats->delay_max = delay;
+    }
+    stats->delay_hist[bucket]++;
+}
+
+SmRetCode SmQueueInit(SmEventQueue *queue, SmQueuedEvent *storage, uint16_t lane_depth, uint16_t starve_limit)
+{
+    if (queue == NULL || storage == NULL || lane_depth == 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(queue, 0, sizeof(SmEventQueue));
+
+    for (int i = 0; i < SM_LANE_COUNT; i++)
+    {
+        queue->lanes[i].buf = &storage[i * lane_depth];
+        queue->lanes[i].depth = lane_depth;
+    }
+    queue->starve_limit = starve_limit;
+
+    return SM_RET_OK;
+}
+
+void SmSetEventQueue(SmMachine *machine, SmEventQueue *queue)
+{
+    if (machine != NULL)
+    {
+        machine->queue = queue;
+    }
+}
+
+SmRetCode SmPostEvent(SmMachine *machine, SmEventId event)
+{
+    if (machine == NULL || !machine->is_initialized || machine->queue == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 按类配置选择通道 */
+    uint8_t lane_id = SM_LANE_LOW;
+    const SmClass *sm_class = machine->sm_class;
+    if (sm_class->event_lanes != NULL && event >= 0 && event < sm_class->event_count)
+    {
+        lane_id = sm_class->event_lanes[event];
+        if (lane_id >= SM_LANE_COUNT)
+        {
+            lane_id = SM_LANE_COUNT - 1;
+        }
+    }
+
+    SmLane *lane = &machine->queue->lanes[lane_id];
+    SmLaneStats *stats = &machine->queue->stats[lane_id];
+    if (lane->count >= lane->depth)
+    {
+        stats->dropped++;
+        return SM_RET_ERROR;
+    }
+
+    uint16_t tail = (uint16_t)((lane->head + lane->count) % lane->depth);
+    lane->buf[tail].event_id = event;
+    lane->buf[tail].post_time = SmGetTime();
+    lane->count++;
+    stats->posted++;
+
+    return SM_RET_OK;
+}
+
+uint32_t SmDispatch(SmMachine *machine, uint32_t max_events)
+{
+    uint32_t dispatched = 0;
+
+    if (machine == NULL || machine->queue == NULL)
+    {
+        return 0;
+    }
+
+    SmEventQueue *queue = machine->queue;
+    while (max_events == 0 || dispatched < max_events)
+    {
+        int lane_id = SmQueuePickLane(queue);
+        if (lane_id < 0)
+        {
+            break; /* 队列为空 */
+        }
+
+        /* 先出队再分发, 处理函数中可以继续投递事件 */
+        SmLane *lane = &queue->lanes[lane_id];
+        SmQueuedEvent item = lane->buf[lane->head];
+        lane->head = (uint16_t)((lane->head + 1) % lane->depth);
+        lane->count--;
+
+        uint64_t now = SmGetTime();
+        SmLaneRecordDelay(&queue->stats[lane_id], (now > item.post_time) ? (now - item.post_time) : 0);
+
+        SmSendEvent(machine, item.event_id);
+        dispatched++;
+    }
+
+    return dispatched;
+}
+
+const SmLaneStats *SmGetLaneStats(const SmEventQueue *queue, uint8_t lane)
+{
+    if (queue == NULL || lane >= SM_LANE_COUNT)
+    {
+        return NULL;
+    }
+
+    return &queue->stats[lane];
+}
+
+uint64_t SmGetLaneDelayPercentile(const SmLaneStats *stats, uint16_t permille)
+{
+    if (stats == NULL || stats->dispatched == 0)
+    {
+        return 0;
+    }
+
+    /* 目标样本序号(向上取整) */
+    uint64_t target = ((uint64_t)stats->dispatched * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SM_LANE_DELAY_BUCKETS; i++)
+    {
+        seen += stats->delay_hist[i];
+        if (seen >= target && seen > 0)
+        {
+            uint64_t upper = (i == 0) ? 0 : ((1ULL << i) - 1);
+            return (upper < stats->delay_max) ? upper : stats->delay_max;
+        }
+    }
+
+    return stats->delay_max;
+}
@@ -1,6 +1,7 @@
 #ifndef __SMMGR_H__
 #define __SMMGR_H__
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -42,16 +43,49 @@ typedef void (*SmTransLogFn)(const char *class_name,
  */
 typedef const char *(*SmGetEventNameFn)(SmEventId event_id);
 
+/**
+ * @brief 时间源回调函数
+ * @return 当前单调时间(单位由时间源决定,建议微秒)
+ */
+typedef uint64_t (*SmTimeFn)(void);
+
 /* 返回码定义 */
 #define SM_RET_OK         0  /* 成功 */
 #define SM_RET_ERROR      -1 /* 错误 */
 #define SM_RET_IGNORE     -2 /* 忽略事件 */
 #define SM_RET_TRANSITION -3 /* 触发状态转换 */
+#define SM_RET_DEFERRED   -4 /* 事件已延迟(当前状态暂不处理, 转换后重新分发) */
 
 /* 状态/事件ID无效值 */
 #define SM_STATE_INVALID -1 /* 无效状态ID */
 #define SM_EVENT_INVALID -1 /* 无效事件ID */
 
+/* 完成事件: 以它为事件的转换不需要事件触发, 进入源状态后立即尝试 */
+#define SM_EVENT_COMPLETION -2
+
+/* 事件优先级通道(数值越大优先级越高) */
+#define SM_LANE_COUNT         4  /* 通道数量 */
+#define SM_LANE_LOW           0  /* 低优先级(默认) */
+#define SM_LANE_NORMAL        1  /* 普通优先级 */
+#define SM_LANE_HIGH          2  /* 高优先级 */
+#define SM_LANE_CTRL          3  /* 控制事件(断开/故障切换等) */
+#define SM_LANE_DELAY_BUCKETS 32 /* 排队延迟直方图桶数(按log2分桶) */
+
+/* 状态种类 */
+#define SM_STATE_LEAF            0 /* 普通(叶子)状态 */
+#define SM_STATE_COMPOSITE       1 /* 组合状态(子状态的容器) */
+#define SM_STATE_HISTORY_SHALLOW 2 /* 浅历史伪状态: 恢复组合状态最近的直接子状态 */
+#define SM_STATE_HISTORY_DEEP    3 /* 深历史伪状态: 恢复组合状态最近的叶子状态 */
+#define SM_STATE_MAX_DEPTH       8 /* 状态嵌套最大深度 */
+
+/* 转换种类 */
+#define SM_TRANS_KIND_EXTERNAL 0 /* 外部转换(默认): 退出源状态, 目标为源状态或其所属组合状态时也退出并重新进入 */
+#define SM_TRANS_KIND_INTERNAL 1 /* 内部转换: 只执行动作, 不退出/进入, 状态不变, 不输出转换日志 */
+#define SM_TRANS_KIND_LOCAL    2 /* 本地转换: 源状态与目标共同所在的状态(包括源状态自身)不退出/重新进入 */
+
+/* 停留时间监视 */
+#define SM_DWELL_UNLINKED 0xFFFF /* 不在任何停留链表中 */
+
 /* ============================================================================
  * 前向声明
  * ============================================================================ */
@@ -60,6 +94,41 @@ typedef struct SmStateTag SmState;
 typedef struct SmTransitionTag SmTransition;
 typedef struct SmMachineTag SmMachine;
 typedef struct SmClassTag SmClass;
+typedef struct SmEventQueueTag SmEventQueue;
+typedef struct SmTableTag SmTable;
+typedef struct SmObsSlotTag SmObsSlot;
+typedef struct SmOutboxTag SmOutbox;
+typedef struct SmWatchdogTag SmWatchdog;
+typedef struct SmPopIndexTag SmPopIndex;
+typedef struct SmReplSenderTag SmReplSender;
+typedef struct SmSpecTraceTag SmSpecTrace;
+typedef struct SmNamesTag SmNames;
+
+/* ============================================================================
+ * 扩展钩子
+ * ============================================================================ */
+
+/**
+ * @brief 事件分发完成钩子
+ * @param ctx 钩子上下文
+ * @param machine 状态机实例
+ * @param event 事件ID
+ * @param data 事件负载(可为NULL)
+ * @param len 负载长度
+ * @param ret 分发结果
+ * @note 只对外部发送的事件调用, 回调函数内部对同一实例发送的嵌套事件不再通知
+ */
+typedef void (*SmEventHookFn)(void *ctx, SmMachine *machine, SmEventId event,
+                              const void *data, uint16_t len, SmRetCode ret);
+
+/**
+ * @brief 实例扩展钩子(记录/回放等模块通过它接入分发路径)
+ */
+typedef struct
+{
+    SmEventHookFn on_event; /* 事件分发完成 */
+    void *ctx;              /* 钩子上下文 */
+} SmHooks;
 
 /* ============================================================================
  * 状态转换条件
@@ -91,6 +160,7 @@ struct SmTransitionTag
     SmConditionFn condition; /* 转换条件判断(可选) */
     SmActionFn action;       /* 转换前动作(可选) */
     void *action_data;       /* 动作数据 */
+    uint8_t kind;            /* 转换种类 SM_TRANS_KIND_xxx */
 };
 
 /* ============================================================================
@@ -129,8 +199,16 @@ struct SmStateTag
     SmStateEnterFn on_enter;   /* 进入状态时的回调 */
     SmStateExitFn on_exit;     /* 退出状态时的回调 */
     SmStateHandleFn on_handle; /* 状态内事件处理回调 */
-    SmTransition *transitions; /* 转换规则数组 */
-    uint16_t trans_count;      /* 转换规则数量 */
+    const SmTransition *transitions; /* 转换规则数组 */
+    uint16_t trans_count;            /* 转换规则数量 */
+    bool any_opt_out;                /* 不使用类级通配转换 */
+    const SmEventId *handle_events;  /* on_handle 关心的事件(以SM_EVENT_INVALID结尾), NULL表示全部 */
+    SmStateId parent;                /* 所属组合状态ID(has_parent 为 true 时有效) */
+    bool has_parent;                 /* 是否属于组合状态 */
+    uint8_t kind;                    /* 状态种类 SM_STATE_LEAF/COMPOSITE/HISTORY_xxx */
+    SmStateId initial;               /* 组合状态的初始子状态 / 历史伪状态无记录时的默认目标 */
+    uint32_t dwell_budget;           /* 最长停留时间(SmGetTime 单位, 0表示不限, 见 SmWatchdog.h) */
+    const SmEventId *deferred_events; /* 延迟处理的事件(以SM_EVENT_INVALID结尾), 见 SmSetDeferStorage */
 };
 
 /* ============================================================================
@@ -153,20 +231,102 @@ typedef SmRetCode (*SmDeinitFn)(SmHandle handle);
 
 /**
  * @brief 状态机类定义(模板)
+ * @note 类描述(状态表/转换表/类本身)全部只读, 可定义为 static const 放入
+ *       Flash/.rodata, 多个进程间共享; 实例的可变数据只保存在 SmMachine 中
  */
 struct SmClassTag
 {
-    const char *class_name; /* 类名 */
-    SmState *states;        /* 状态数组 */
-    uint16_t state_count;   /* 状态数量 */
-    SmInitFn on_init;       /* 初始化回调 */
-    SmDeinitFn on_deinit;   /* 反初始化回调 */
+    const char *class_name;              /* 类名 */
+    const SmState *states;               /* 状态数组 */
+    uint16_t state_count;                /* 状态数量 */
+    SmInitFn on_init;                    /* 初始化回调 */
+    SmDeinitFn on_deinit;                /* 反初始化回调 */
+    const uint8_t *event_lanes;          /* 事件优先级通道表(按事件ID索引,可选) */
+    uint16_t event_count;                /* 事件数量(通道表长度; 转换表事件域另按最大事件ID计算) */
+    const SmTransition *any_transitions; /* 通配转换数组(任意状态下均生效,可选) */
+    uint16_t any_trans_count;            /* 通配转换数量 */
+    const SmTable *table;                /* 压缩转换表(可选, 见 SmTable.h) */
+    const char *const *event_names;      /* 事件名称表(按事件ID索引,可选) */
+    uint16_t event_name_count;           /* 事件名称数量 */
+    const SmNames *names;                /* 名称 -> ID 完美哈希(可选, 见 SmNames.h) */
+};
+
+/* ============================================================================
+ * 事件队列定义
+ * ============================================================================ */
+
+/**
+ * @brief 队列中的事件
+ */
+typedef struct
+{
+    SmEventId event_id; /* 事件ID */
+    uint64_t post_time; /* 投递时间 */
+} SmQueuedEvent;
+
+/**
+ * @brief 单个通道的排队统计
+ */
+typedef struct
+{
+    uint32_t posted;                            /* 投递数量 */
+    uint32_t dispatched;                        /* 分发数量 */
+    uint32_t dropped;                           /* 队列满丢弃数量 */
+    uint64_t delay_total;                       /* 累计排队延迟 */
+    uint64_t delay_max;                         /* 最大排队延迟 */
+    uint32_t delay_hist[SM_LANE_DELAY_BUCKETS]; /* 延迟直方图,第i桶为[2^(i-1), 2^i) */
+} SmLaneStats;
+
+/**
+ * @brief 单个优先级通道(环形缓冲区)
+ */
+typedef struct
+{
+    SmQueuedEvent *buf; /* 缓冲区 */
+    uint16_t depth;     /* 缓冲区深度 */
+    uint16_t head;      /* 队首位置 */
+    uint16_t count;     /* 当前事件数量 */
+    uint16_t skipped;   /* 有事件时被高优先级通道抢占的连续次数 */
+} SmLane;
+
+/**
+ * @brief 状态机事件队列(多优先级通道)
+ */
+struct SmEventQueueTag
+{
+    SmLane lanes[SM_LANE_COUNT];      /* 优先级通道 */
+    SmLaneStats stats[SM_LANE_COUNT]; /* 通道统计 */
+    uint16_t starve_limit;            /* 饥饿保护阈值(被抢占次数达到后强制调度,0表示关闭) */
 };
 
 /* ============================================================================
  * 状态机实例定义
  * ============================================================================ */
 
+/**
+ * @brief 停留时间监视链接(由 SmWatchdog 维护)
+ */
+typedef struct
+{
+    SmWatchdog *watchdog; /* 所属监视器, NULL表示未监视 */
+    SmMachine *prev;      /* 同状态链表前驱 */
+    SmMachine *next;      /* 同状态链表后继 */
+    uint64_t deadline;    /* 停留预算到期时间 */
+    uint16_t list;        /* 所在链表(状态下标), SM_DWELL_UNLINKED 表示不在链表中 */
+} SmDwellLink;
+
+/**
+ * @brief 延迟事件队列(环形缓冲区, 存储由调用者提供)
+ */
+typedef struct
+{
+    SmEventId *buf; /* 存储区 */
+    uint16_t size;  /* 容量 */
+    uint16_t head;  /* 队首位置 */
+    uint16_t count; /* 事件数量 */
+    bool recall;    /* 状态已变化, 外层事件处理完成后重新分发 */
+} SmDeferQueue;
+
 /**
  * @brief 状态机实例结构体
  */
@@ -179,8 +339,34 @@ struct SmMachineTag
     void *user_data;                    /* 用户数据指针 */
     SmTransLogFn trans_log_fn;          /* 状态转换日志回调 */
     SmGetEventNameFn get_event_name_fn; /* 获取事件名称回调 */
+    SmEventQueue *queue;                /* 事件队列(可选) */
+    uint32_t machine_id;                /* 实例ID(观察/记录/复制等按此索引) */
+    SmObsSlot *obs_slot;                /* 共享内存观察槽位(可选, 见 SmObserver.h) */
+    const SmHooks *hooks;               /* 扩展钩子(可选) */
+    SmOutbox *outbox;                   /* 副作用输出缓冲区(可选, 见 SmOutbox.h) */
+    const void *event_data;             /* 当前事件负载(仅分发期间有效) */
+    uint16_t event_len;                 /* 当前事件负载长度 */
+    uint16_t dispatch_depth;            /* 分发嵌套深度 */
+    SmStateId *history;                 /* 各组合状态最近的活动叶子状态(按状态下标, 可选) */
+    uint16_t history_count;             /* 历史记录存储元素个数 */
+    uint64_t enter_time;                /* 进入当前状态的时间(SmGetTime) */
+    SmDwellLink dwell;                  /* 停留时间监视(可选, 见 SmWatchdog.h) */
+    SmPopIndex *pop_index;              /* 状态成员索引(可选, 见 SmPopIndex.h) */
+    SmDeferQueue defer;                 /* 延迟事件队列(可选, 见 SmSetDeferStorage) */
+    SmReplSender *repl;                 /* 热备复制发送端(可选, 见 SmRepl.h) */
+    bool repl_pending;                  /* 有尚未发布到复制流的状态变更 */
+    SmSpecTrace *spec;                  /* 推演轨迹(只在克隆推演期间设置, 见 SmSpec.h) */
 };
 
+/**
+ * @brief 状态机实例集合(用于广播)
+ */
+typedef struct
+{
+    SmMachine **machines; /* 实例指针数组 */
+    uint32_t count;       /* 实例数量 */
+} SmFleet;
+
 /* ============================================================================
  * 宏定义 - 辅助创建状态和转换
  * ============================================================================ */
@@ -204,13 +390,70 @@ struct SmMachineTag
 #define SM_TRANS_FULL(evt, next, cond, act, act_data) \
     { .event_id = (evt), .next_state = (next), .condition = (cond), .action = (act), .action_data = (act_data) }
 
-/* 定义状态 */
-#define SM_STATE(id, name, enter, exit, handle, trans_array) \
-    { .state_id = (id), .state_name = (name), .on_enter = (enter), .on_exit = (exit), .on_handle = (handle), .transitions = (trans_array), .trans_count = sizeof(trans_array) / sizeof(SmTransition) }
+/* 定义内部转换(只执行动作, 不退出/进入状态) */
+#define SM_TRANS_INTERNAL(evt, cond, act, act_data) \
+    { .event_id = (evt), .next_state = SM_STATE_INVALID, .condition = (cond), .action = (act), .action_data = (act_data), .kind = SM_TRANS_KIND_INTERNAL }
+
+/* 定义本地转换(不退出/重新进入源状态与目标共同所在的状态) */
+#define SM_TRANS_LOCAL(evt, next, cond, act, act_data) \
+    { .event_id = (evt), .next_state = (next), .condition = (cond), .action = (act), .action_data = (act_data), .kind = SM_TRANS_KIND_LOCAL }
+
+/* 定义完成转换(进入源状态后立即尝试; 无条件无动作且经过的状态没有回调时, SmTableBuild 将链路融合为一步) */
+#define SM_TRANS_COMPLETION(next, cond, act, act_data) \
+    { .event_id = SM_EVENT_COMPLETION, .next_state = (next), .condition = (cond), .action = (act), .action_data = (act_data) }
+
+/* 定义状态(可变参数用于追加 SM_STATE_xxx 扩展字段) */
+#define SM_STATE(id, name, enter, exit, handle, trans_array, ...) \
+    { .state_id = (id), .state_name = (name), .on_enter = (enter), .on_exit = (exit), .on_handle = (handle), .transitions = (trans_array), .trans_count = sizeof(trans_array) / sizeof(SmTransition), __VA_ARGS__ }
+
+/* 状态扩展: 不使用类级通配转换 */
+#define SM_STATE_NO_ANY() .any_opt_out = true
+
+/* 状态扩展: on_handle 关心的事件列表(用于快速拒绝无关事件) */
+#define SM_STATE_HANDLES(events_array) .handle_events = (events_array)
+
+/* 状态扩展: 最长停留时间(超过后由 SmWatchdog 报告) */
+#define SM_STATE_DWELL(budget) .dwell_budget = (budget)
+
+/* 状态扩展: 延迟处理的事件列表(本状态不处理时暂存, 进入其他状态后按原顺序重新分发) */
+#define SM_STATE_DEFER(events_array) .deferred_events = (events_array)
+
+/* 状态扩展: 所属组合状态 */
+#define SM_STATE_PARENT(composite) .parent = (composite), .has_parent = true
+
+/* 定义组合状态(当前状态始终为叶子状态, 进入组合状态时沿 initial 下降) */
+#define SM_COMPOSITE(id, name, enter, exit, initial_state, ...) \
+    { .state_id = (id), .state_name = (name), .on_enter = (enter), .on_exit = (exit), .kind = SM_STATE_COMPOSITE, .initial = (initial_state), __VA_ARGS__ }
+
+/* 定义浅历史伪状态(转换以它为目标时恢复组合状态最近的直接子状态) */
+#define SM_HISTORY(id, name, composite, default_state) \
+    { .state_id = (id), .state_name = (name), .kind = SM_STATE_HISTORY_SHALLOW, .parent = (composite), .has_parent = true, .initial = (default_state) }
+
+/* 定义深历史伪状态(转换以它为目标时恢复组合状态最近的叶子状态) */
+#define SM_DEEP_HISTORY(id, name, composite, default_state) \
+    { .state_id = (id), .state_name = (name), .kind = SM_STATE_HISTORY_DEEP, .parent = (composite), .has_parent = true, .initial = (default_state) }
+
+/* 定义状态机类(可变参数用于追加 SM_CLASS_xxx 扩展字段) */
+#define SM_CLASS_DEF(name, states_array, init_fn, deinit_fn, ...) \
+    { .class_name = (name), .states = (states_array), .state_count = sizeof(states_array) / sizeof(SmState), .on_init = (init_fn), .on_deinit = (deinit_fn), __VA_ARGS__ }
+
+/* 类扩展: 事件优先级通道表 */
+#define SM_CLASS_LANES(lanes_array) \
+    .event_lanes = (lanes_array), .event_count = sizeof(lanes_array) / sizeof(uint8_t)
+
+/* 类扩展: 通配转换表(状态自身无匹配规则时查找) */
+#define SM_CLASS_ANY(trans_array) \
+    .any_transitions = (trans_array), .any_trans_count = sizeof(trans_array) / sizeof(SmTransition)
+
+/* 类扩展: 预生成的压缩转换表 */
+#define SM_CLASS_TABLE(table_ptr) .table = (table_ptr)
 
-/* 定义状态机类 */
-#define SM_CLASS_DEF(name, states_array, init_fn, deinit_fn) \
-    { .class_name = (name), .states = (states_array), .state_count = sizeof(states_array) / sizeof(SmState), .on_init = (init_fn), .on_deinit = (deinit_fn) }
+/* 类扩展: 事件名称表 */
+#define SM_CLASS_EVENT_NAMES(names_array) \
+    .event_names = (names_array), .event_name_count = sizeof(names_array) / sizeof(const char *)
+
+/* 类扩展: 预生成的名称索引 */
+#define SM_CLASS_NAMES(names_ptr) .names = (names_ptr)
 
 /* ============================================================================
  * API 接口
@@ -255,6 +498,33 @@ SmRetCode SmStop(SmMachine *machine);
  */
 SmRetCode SmSendEvent(SmMachine *machine, SmEventId event);
 
+/**
+ * @brief 发送带负载的事件到状态机
+ * @param machine 状态机实例指针
+ * @param event 事件ID
+ * @param data 事件负载(可为NULL), 分发期间通过 SmGetEventData 获取
+ * @param len 负载长度
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmSendEventEx(SmMachine *machine, SmEventId event, const void *data, uint16_t len);
+
+/**
+ * @brief 获取当前正在分发的事件负载
+ * @param machine 状态机实例指针
+ * @param len 负载长度(输出, 可为NULL)
+ * @return 负载指针, NULL表示无负载或不在分发过程中
+ */
+const void *SmGetEventData(SmMachine *machine, uint16_t *len);
+
+/**
+ * @brief 广播事件到实例集合
+ * @param fleet 实例集合
+ * @param event 事件ID
+ * @return 实际分发到的实例数量
+ * @note 类带有压缩转换表时, 对事件不感兴趣的实例只需一次位测试即被跳过
+ */
+uint32_t SmBroadcast(const SmFleet *fleet, SmEventId event);
+
 /**
  * @brief 获取当前状态ID
  * @param machine 状态机实例指针
@@ -262,6 +532,21 @@ SmRetCode SmSendEvent(SmMachine *machine, SmEventId event);
  */
 SmStateId SmGetCurrentState(SmMachine *machine);
 
+/**
+ * @brief 判断是否处于指定状态(含组合状态)
+ * @param machine 状态机实例指针
+ * @param state_id 状态ID
+ * @return true 当前叶子状态或其任一祖先为 state_id
+ */
+bool SmIsInState(SmMachine *machine, SmStateId state_id);
+
+/**
+ * @brief 获取进入当前状态的时间
+ * @param machine 状态机实例指针
+ * @return 进入时间(SmGetTime), 自转换不更新
+ */
+uint64_t SmGetEnterTime(SmMachine *machine);
+
 /**
  * @brief 获取当前状态名称
  * @param machine 状态机实例指针
@@ -269,6 +554,34 @@ SmStateId SmGetCurrentState(SmMachine *machine);
  */
 const char *SmGetCurrentStateName(SmMachine *machine);
 
+/**
+ * @brief 获取事件名称
+ * @param sm_class 状态机类
+ * @param event_id 事件ID
+ * @return 事件名称, NULL表示类没有事件名称表或越界
+ */
+const char *SmGetEventName(const SmClass *sm_class, SmEventId event_id);
+
+/**
+ * @brief 按名称查找事件ID
+ * @param sm_class 状态机类
+ * @param name 事件名称(不要求以'\0'结尾, 可直接指向报文中的字段)
+ * @param len 名称长度
+ * @return 事件ID, SM_EVENT_INVALID表示未知名称
+ * @note 类设置了 names 时为 O(1) 查找, 否则逐个比较事件名称表
+ */
+SmEventId SmFindEventId(const SmClass *sm_class, const char *name, size_t len);
+
+/**
+ * @brief 按名称查找状态ID
+ * @param sm_class 状态机类
+ * @param name 状态名称(不要求以'\0'结尾)
+ * @param len 名称长度
+ * @return 状态ID, SM_STATE_INVALID表示未知名称
+ * @note 类设置了 names 时为 O(1) 查找, 否则逐个比较状态名称
+ */
+SmStateId SmFindStateId(const SmClass *sm_class, const char *name, size_t len);
+
 /**
  * @brief 强制切换状态
  * @param machine 状态机实例指针
@@ -296,9 +609,168 @@ void SmSetTransLogFn(SmMachine *machine, SmTransLogFn trans_log_fn);
  * @brief 设置获取事件名称回调
  * @param machine 状态机实例指针
  * @param get_event_name_fn 事件名称获取回调
+ * @note 类已提供事件名称表(SM_CLASS_EVENT_NAMES)时无需设置, 设置后优先使用回调
  */
 void SmSetGetEventNameFn(SmMachine *machine, SmGetEventNameFn get_event_name_fn);
 
+/**
+ * @brief 设置实例ID
+ * @param machine 状态机实例指针
+ * @param machine_id 实例ID
+ */
+void SmSetMachineId(SmMachine *machine, uint32_t machine_id);
+
+/**
+ * @brief 获取实例ID
+ * @param machine 状态机实例指针
+ * @return 实例ID
+ */
+uint32_t SmGetMachineId(const SmMachine *machine);
+
+/**
+ * @brief 设置共享内存观察槽位
+ * @param machine 状态机实例指针
+ * @param slot 观察槽位, NULL表示关闭导出
+ * @note 每次状态变更时以 seqlock 方式写入 (状态, 上一状态, 变更次数, 时间戳)
+ */
+void SmSetObsSlot(SmMachine *machine, SmObsSlot *slot);
+
+/**
+ * @brief 设置扩展钩子
+ * @param machine 状态机实例指针
+ * @param hooks 钩子, NULL表示解除
+ */
+void SmSetHooks(SmMachine *machine, const SmHooks *hooks);
+
+/**
+ * @brief 绑定副作用输出缓冲区
+ * @param machine 状态机实例指针
+ * @param outbox 输出缓冲区(通常同一分发线程的实例共用一个), NULL表示解除绑定
+ * @note 事件处理返回错误时, 该事件产生的输出记录被丢弃
+ */
+void SmSetOutbox(SmMachine *machine, SmOutbox *outbox);
+
+/**
+ * @brief 获取副作用输出缓冲区(供动作/进入/退出函数产生输出记录)
+ * @param machine 状态机实例指针
+ * @return 输出缓冲区, 未绑定时返回NULL
+ */
+SmOutbox *SmGetOutbox(SmMachine *machine);
+
+/**
+ * @brief 设置历史记录存储
+ * @param machine 状态机实例指针
+ * @param storage 存储区, 按状态下标索引, NULL表示不记录(历史伪状态总是走默认目标)
+ * @param count 存储区元素个数, 不少于类的状态数量
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmSetHistoryStorage(SmMachine *machine, SmStateId *storage, uint16_t count);
+
+/**
+ * @brief 设置延迟事件队列存储
+ * @param machine 状态机实例指针
+ * @param storage 存储区, NULL表示不延迟(声明为延迟的事件按忽略处理)
+ * @param count 存储区元素个数(队列容量)
+ * @return SM_RET_OK 成功, 其他 失败
+ * @note 当前状态(或所属组合状态)声明为延迟、且没有转换处理的事件进入队列,
+ *       SmSendEvent 返回 SM_RET_DEFERRED; 队列已满时返回 SM_RET_ERROR.
+ *       每次进入新状态后, 在外层事件处理完成时按原顺序逐个重新分发一次,
+ *       新状态仍延迟的事件重新排队. 只保存事件ID, 重新分发时没有负载;
+ *       重新设置存储或 SmStart/SmStop 时清空队列
+ */
+SmRetCode SmSetDeferStorage(SmMachine *machine, SmEventId *storage, uint16_t count);
+
+/**
+ * @brief 将实例迁移到另一个版本的类(热更新)
+ * @param machine 状态机实例指针
+ * @param new_class 新版本的类
+ * @param new_state 实例在新类中的状态ID(已停止的实例忽略)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数错误或新类中不存在该状态
+ * @note 不调用进入/退出函数, 实例的逻辑状态保持不变, 进入时间(停留计时)保留;
+ *       历史记录清空, 存储不足以容纳新类时解除绑定
+ */
+SmRetCode SmMigrate(SmMachine *machine, const SmClass *new_class, SmStateId new_state);
+
+/**
+ * @brief 直接设置实例状态(热备镜像/快照恢复)
+ * @param machine 状态机实例指针
+ * @param state_id 状态ID(叶子状态), SM_STATE_INVALID 表示停止
+ * @param previous_state 上一个状态ID
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数错误或状态不存在
+ * @note 不调用进入/退出函数和完成转换; 未启动的实例设置后即处于运行状态.
+ *       观察槽位/成员索引/停留监视/历史记录照常更新
+ */
+SmRetCode SmRestoreState(SmMachine *machine, SmStateId state_id, SmStateId previous_state);
+
+/**
+ * @brief 设置全局时间源
+ * @param time_fn 时间源回调, NULL表示不记录时间
+ */
+void SmSetTimeFn(SmTimeFn time_fn);
+
+/**
+ * @brief 获取全局时间源
+ * @return 时间源回调, NULL表示未设置
+ */
+SmTimeFn SmGetTimeFn(void);
+
+/**
+ * @brief 获取当前时间
+ * @return 当前时间, 未设置时间源时返回0
+ */
+uint64_t SmGetTime(void);
+
+/**
+ * @brief 初始化事件队列
+ * @param queue 事件队列指针
+ * @param storage 事件缓冲区, 至少 SM_LANE_COUNT * lane_depth 个元素
+ * @param lane_depth 每个通道的深度
+ * @param starve_limit 饥饿保护阈值, 低优先级通道被连续抢占该次数后优先调度一次
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmQueueInit(SmEventQueue *queue, SmQueuedEvent *storage, uint16_t lane_depth, uint16_t starve_limit);
+
+/**
+ * @brief 绑定事件队列到状态机
+ * @param machine 状态机实例指针
+ * @param queue 事件队列指针, NULL表示解除绑定
+ */
+void SmSetEventQueue(SmMachine *machine, SmEventQueue *queue);
+
+/**
+ * @brief 投递事件到状态机队列
+ * @param machine 状态机实例指针
+ * @param event 事件ID
+ * @return SM_RET_OK 成功, SM_RET_ERROR 未绑定队列或通道已满
+ * @note 通道由类的 event_lanes 表决定, 未配置时使用 SM_LANE_LOW
+ */
+SmRetCode SmPostEvent(SmMachine *machine, SmEventId event);
+
+/**
+ * @brief 从队列中分发事件
+ * @param machine 状态机实例指针
+ * @param max_events 本次最多分发的事件数量, 0表示直到队列为空
+ * @return 实际分发的事件数量
+ * @note 优先分发高优先级通道, 被抢占达到 starve_limit 次的低优先级通道优先分发一次
+ */
+uint32_t SmDispatch(SmMachine *machine, uint32_t max_events);
+
+/**
+ * @brief 获取通道排队统计
+ * @param queue 事件队列指针
+ * @param lane 通道号
+ * @return 统计信息指针, NULL表示参数无效
+ */
+const SmLaneStats *SmGetLaneStats(const SmEventQueue *queue, uint8_t lane);
+
+/**
+ * @brief 按直方图估算通道排队延迟分位数
+ * @param stats 通道统计
+ * @param permille 千分位(如 990 表示 P99, 999 表示 P99.9)
+ * @return 延迟上界, 无数据时返回0
+ */
+uint64_t SmGetLaneDelayPercentile(const SmLaneStats *stats, uint16_t permille);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,2798 @@
+/**
+ * @file SmMgr_bench.c
+ * @brief SmMgr 分发性能基准
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sendmmsg/struct mmsghdr(CAN 套接字接入的发送线程) */
+#endif
+
+#include "SmMgr.h"
+#include "SmTable.h"
+#include "SmRecord.h"
+#include "SmWorkload.h"
+#include "SmSim.h"
+#include "SmWatchdog.h"
+#include "SmPopIndex.h"
+#include "SmAdmission.h"
+#include "SmRepl.h"
+#include "SmSpec.h"
+#include "SmOutbox.h"
+#include "SmNames.h"
+#include "SmExplore.h"
+#include "SmCan.h"
+#include "SmObserver.h"
+#include "SmReload.h"
+#include "SmLoop.h"
+#include "SmImage.h"
+#include "SmOs.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* ============================================================================
+ * 基准参数
+ * ============================================================================ */
+#define BENCH_STATE_COUNT 4000    /* 状态数量 */
+#define BENCH_EVENT_COUNT 300     /* 事件数量 */
+#define BENCH_TRANS_MIN   3       /* 每个状态最少转换数 */
+#define BENCH_TRANS_MAX   12      /* 每个状态最多转换数 */
+#define BENCH_ANY_COUNT   3       /* 通配转换数量 */
+#define BENCH_EVENTS      2000000 /* 分发事件数量 */
+#define BENCH_FLEET       1000000 /* 广播实例数量 */
+#define BENCH_REPLAY_POOL 1000    /* 记录/回放实例数量 */
+#define BENCH_REPLAY_FILE "/tmp/sm_bench.rec"
+#define BENCH_WL_MACHINES 200000  /* 负载实例数量 */
+#define BENCH_WL_EVENTS   1000000 /* 负载每线程事件数量 */
+#define BENCH_SIM_POOL    100000  /* 仿真实例数量 */
+#define BENCH_SIM_DAYS    1       /* 仿真天数 */
+#define BENCH_SIM_RETRY   5       /* 连接失败后最多退避重试次数 */
+#define BENCH_WD_FLEET    1000000 /* 停留监视实例数量 */
+#define BENCH_WD_BUDGET   30000   /* 认证停留预算(毫秒) */
+#define BENCH_POP_POOL    100000  /* 成员索引实例数量 */
+#define BENCH_STORM_POOL  100000  /* 重连风暴实例数量 */
+#define BENCH_STORM_RATE  10      /* 准入速率(每毫秒连接数), 突发为 10 ms 的量 */
+#define BENCH_KIND_EVENTS 2000000 /* 转换种类对比的事件数量 */
+#define BENCH_REPL_RING   131072  /* 复制环容量(记录数) */
+#define BENCH_REPL_FLUSH  1000    /* 复制攒批时间(微秒) */
+#define BENCH_SPEC_PLANS  1000000 /* 推演候选数量(每个候选 2 个事件) */
+#define BENCH_NAME_FINDS  1000000 /* 名称查找次数 */
+#define BENCH_EXP_GUARDS  4       /* 可达性分析: 条件数量 */
+#define BENCH_EXP_CONFIGS 2000000 /* 可达性分析: 配置数上限 */
+#define BENCH_EXP_DEAD    1000    /* 可达性分析: 没有入边(不可达)的状态数 */
+#define BENCH_CAN_NODES   64      /* CAN 电机控制器数量 */
+#define BENCH_CAN_FRAMES  2000000 /* CAN 内存接入帧数 */
+#define BENCH_CAN_SOCKET  200000  /* CAN 套接字接入帧数 */
+#define BENCH_OBS_POOL    1000    /* 共享内存观察实例数量 */
+#define BENCH_OBS_RING    8       /* 共享内存观察: 环形类的状态数 */
+#define BENCH_OBS_EVENTS  2000000 /* 共享内存观察: 写者分发的事件数量 */
+#define BENCH_OBS_SHM     "/sm_bench_obs"
+#define BENCH_RELOAD_POOL 5000    /* 热更新: 每个分发线程的实例数量 */
+#define BENCH_RELOAD_BATCH 20000  /* 热更新: 两个静止点之间的事件数量 */
+#define BENCH_RELOAD_ROUNDS 40    /* 热更新: 每个分发线程的批数 */
+#define BENCH_LOOP_POSTS  200     /* 阻塞循环: 空闲时投递的事件数量 */
+#define BENCH_LOOP_TIMER  50000   /* 阻塞循环: 空闲时到期的定时器(微秒) */
+#define BENCH_LOOP_SLACK  50000   /* 阻塞循环: 唤醒/到期允许的最大延迟(微秒) */
+#define BENCH_IMAGE_LOADS 20      /* 镜像: 计时的加载次数 */
+#define BENCH_CAN_BUS_FPS 8772    /* 1 Mbit/s 满载的帧率(8 字节标准帧约 114 位, 不计位填充) */
+
+/* ============================================================================
+ * 辅助函数
+ * ============================================================================ */
+
+static uint64_t BenchNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t BenchNowUs(void)
+{
+    return BenchNowNs() / 1000;
+}
+
+static uint32_t BenchRand(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/**
+ * @brief 生成大规模随机状态机类(协议一致性机风格)
+ */
+static SmClass *BenchGenClass(uint32_t seed)
+{
+    SmClass *sm_class = calloc(1, sizeof(SmClass));
+    SmState *states = calloc(BENCH_STATE_COUNT, sizeof(SmState));
+    SmTransition *any = calloc(BENCH_ANY_COUNT, sizeof(SmTransition));
+
+    for (uint16_t s = 0; s < BENCH_STATE_COUNT; s++)
+    {
+        uint16_t count = BENCH_TRANS_MIN + BenchRand(&seed) % (BENCH_TRANS_MAX - BENCH_TRANS_MIN + 1);
+        SmTransition *trans = calloc(count, sizeof(SmTransition));
+        for (uint16_t i = 0; i < count; i++)
+        {
+            trans[i].event_id = (SmEventId)(BenchRand(&seed) % BENCH_EVENT_COUNT);
+            trans[i].next_state = (SmStateId)(BenchRand(&seed) % BENCH_STATE_COUNT);
+        }
+        states[s].state_id = s;
+        states[s].state_name = "S";
+        states[s].transitions = trans;
+        states[s].trans_count = count;
+    }
+
+    for (uint16_t i = 0; i < BENCH_ANY_COUNT; i++)
+    {
+        any[i].event_id = (SmEventId)(BenchRand(&seed) % BENCH_EVENT_COUNT);
+        any[i].next_state = 0;
+    }
+
+    sm_class->class_name = "BenchSm";
+    sm_class->states = states;
+    sm_class->state_count = BENCH_STATE_COUNT;
+    sm_class->event_count = BENCH_EVENT_COUNT;
+    sm_class->any_transitions = any;
+    sm_class->any_trans_count = BENCH_ANY_COUNT;
+    return sm_class;
+}
+
+/**
+ * @brief 分发事件序列并返回每事件耗时(ns)
+ */
+static double BenchDispatch(const SmClass *sm_class, const SmEventId *events, uint32_t count, SmStateId *final_state)
+{
+    SmMachine machine;
+
+    SmCreate(&machine, sm_class, NULL);
+    SmStart(&machine, 0);
+
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmSendEvent(&machine, events[i]);
+    }
+    uint64_t elapsed = BenchNowNs() - start;
+
+    *final_state = SmGetCurrentState(&machine);
+    SmDestroy(&machine);
+    return (double)elapsed / count;
+}
+
+/**
+ * @brief 广播事件到实例集合并返回每实例耗时(ns)
+ */
+static double BenchBroadcast(const SmClass *sm_class, SmMachine *pool, SmFleet *fleet, SmEventId event,
+                             uint32_t *delivered)
+{
+    uint32_t seed = 0xC0FFEE;
+
+    /* 实例分布在随机状态上 */
+    for (uint32_t i = 0; i < fleet->count; i++)
+    {
+        SmCreate(&pool[i], sm_class, NULL);
+        SmStart(&pool[i], (SmStateId)(BenchRand(&seed) % BENCH_STATE_COUNT));
+        fleet->machines[i] = &pool[i];
+    }
+
+    uint64_t start = BenchNowNs();
+    *delivered = SmBroadcast(fleet, event);
+    uint64_t elapsed = BenchNowNs() - start;
+
+    return (double)elapsed / fleet->count;
+}
+
+/* 兴趣位图检查: 未声明 event_count 的类, on_handle 不过滤/按列表过滤 */
+static uint32_t g_interest_calls;
+
+static SmRetCode BenchInterestHandle(SmHandle handle, SmEventId event)
+{
+    g_interest_calls++;
+    return SM_RET_IGNORE;
+}
+
+static const SmEventId bench_interest_handles[] = { 9, SM_EVENT_INVALID };
+static SmTransition bench_interest_trans0[] = { SM_TRANS(1, 1), SM_TRANS_END() };
+static SmTransition bench_interest_trans1[] = { SM_TRANS(2, 0), SM_TRANS_END() };
+static SmState bench_interest_states[] = {
+    SM_STATE(0, "ANY", NULL, NULL, BenchInterestHandle, bench_interest_trans0),
+    SM_STATE(1, "FILTERED", NULL, NULL, BenchInterestHandle, bench_interest_trans1,
+             SM_STATE_HANDLES(bench_interest_handles)),
+};
+static SmClass bench_interest_class = SM_CLASS_DEF("Interest", bench_interest_states, NULL, NULL);
+
+/**
+ * @brief 超出转换事件范围的事件在有无转换表时都送到 on_handle, 返回 on_handle 调用次数
+ */
+static uint32_t BenchInterestRun(void)
+{
+    static const SmEventId events[] = { 40, 9, 1, 40, 9, 2, 1000 };
+    SmMachine machine;
+
+    g_interest_calls = 0;
+    SmCreate(&machine, &bench_interest_class, NULL);
+    SmStart(&machine, 0);
+    for (size_t i = 0; i < sizeof(events) / sizeof(events[0]); i++)
+    {
+        SmSendEvent(&machine, events[i]);
+    }
+    SmDestroy(&machine);
+    return g_interest_calls;
+}
+
+/**
+ * @brief 挂上转换表后运行, 返回 on_handle 调用次数(构建失败返回 UINT32_MAX)
+ */
+static uint32_t BenchInterestRunTable(void)
+{
+    SmTable table;
+    size_t buf_size = SmTableCalcSize(&bench_interest_class);
+    void *buf = malloc(buf_size);
+    uint32_t calls = UINT32_MAX;
+    if (SmTableBuild(&table, &bench_interest_class, buf, buf_size) == SM_RET_OK)
+    {
+        bench_interest_class.table = &table;
+        calls = BenchInterestRun();
+        bench_interest_class.table = NULL;
+    }
+    free(buf);
+    return calls;
+}
+
+/**
+ * @brief 对比有无转换表时 on_handle 收到的事件数
+ * @note 通道表比最大事件ID短时, 转换表的事件域不能按通道表长度截断
+ */
+static int BenchInterest(void)
+{
+    static const uint8_t short_lanes[2] = { SM_LANE_LOW, SM_LANE_LOW };
+
+    uint32_t plain = BenchInterestRun();
+    uint32_t tabled = BenchInterestRunTable();
+
+    bench_interest_class.event_lanes = short_lanes;
+    bench_interest_class.event_count = sizeof(short_lanes);
+    uint32_t laned = BenchInterestRunTable();
+    bench_interest_class.event_lanes = NULL;
+    bench_interest_class.event_count = 0;
+
+    bool ok = (plain == tabled && plain == laned && plain == 5);
+    printf("  interest check: on_handle %u calls without table, %u with, %u with short lanes (%s)\n", plain,
+           tabled, laned, ok ? "OK" : "MISMATCH");
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief 创建并启动实例池(相同种子得到相同的初始状态)
+ */
+static void BenchStartPool(const SmClass *sm_class, SmMachine *pool, uint32_t count)
+{
+    uint32_t seed = 0xBADC0DE;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmCreate(&pool[i], sm_class, NULL);
+        SmSetMachineId(&pool[i], i);
+        SmStart(&pool[i], (SmStateId)(BenchRand(&seed) % BENCH_STATE_COUNT));
+    }
+}
+
+/**
+ * @brief 记录事件流后全速回放到新实例, 返回 0 表示回放结果一致
+ */
+static int BenchRecordReplay(const SmClass *sm_class, const SmEventId *events, uint32_t count)
+{
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_REPLAY_POOL);
+    SmRecorder rec;
+    uint32_t seed = 0x51ED270B;
+
+    /* 1. 录制 */
+    SmSetTimeFn(BenchNowUs);
+    if (SmRecorderCreate(&rec, BENCH_REPLAY_FILE, sm_class, 1000) != SM_RET_OK)
+    {
+        printf("  record        : cannot create %s\n", BENCH_REPLAY_FILE);
+        free(pool);
+        return -1;
+    }
+    BenchStartPool(sm_class, pool, BENCH_REPLAY_POOL);
+    for (uint32_t i = 0; i < BENCH_REPLAY_POOL; i++)
+    {
+        SmRecorderAttach(&rec, &pool[i]);
+    }
+
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmSendEvent(&pool[BenchRand(&seed) % BENCH_REPLAY_POOL], events[i]);
+    }
+    uint64_t record_ns = BenchNowNs() - start;
+    SmRecorderClose(&rec);
+    SmSetTimeFn(NULL);
+
+    /* 2. 回放到新实例 */
+    SmRecLog log;
+    SmReplayResult result;
+    if (SmRecLogOpen(&log, BENCH_REPLAY_FILE) != SM_RET_OK)
+    {
+        free(pool);
+        return -1;
+    }
+    BenchStartPool(sm_class, pool, BENCH_REPLAY_POOL);
+    SmReplay(&log, pool, BENCH_REPLAY_POOL, 0, &result);
+
+    printf("  record        : %7.2f ns/event, %.1f bytes/event\n",
+           (double)record_ns / count, (double)log.data_size / count);
+    printf("  replay        : %7.2f ns/event, %llu events, %llu mismatches\n",
+           (double)result.elapsed_ns / result.events, (unsigned long long)result.events,
+           (unsigned long long)result.mismatches);
+
+    SmRecLogClose(&log);
+    unlink(BENCH_REPLAY_FILE);
+    free(pool);
+    return (result.mismatches == 0 && result.events == count) ? 0 : -1;
+}
+
+/**
+ * @brief 空日志回调(只衡量日志路径本身的开销)
+ */
+static void BenchLogSink(const char *class_name, const char *from_state, const char *to_state,
+                         SmEventId event_id, const char *event_name)
+{
+}
+
+/**
+ * @brief 在几种负载模型下运行并打印吞吐/延迟/内存
+ */
+static void BenchWorkload(const SmClass *sm_class)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = (cpus > 4) ? 4 : (cpus > 0 ? (uint32_t)cpus : 1);
+    const struct
+    {
+        const char *name;
+        double zipf_s;
+        uint32_t burst_len;
+        uint32_t storm_every;
+        uint16_t queue_depth;
+        SmTransLogFn log_fn;
+    } models[] = {
+        { "uniform", 0, 0, 0, 0, NULL },
+        { "zipf 1.1", 1.1, 0, 0, 0, NULL },
+        { "bursty", 0, 10000, 0, 0, NULL },
+        { "storm", 0, 0, 250000, 0, NULL },
+        { "queued", 0, 0, 0, 8, NULL },
+        { "logging", 0, 0, 0, 0, BenchLogSink },
+    };
+
+    printf("  workload      : %u instances, %u threads, %u events/thread\n",
+           BENCH_WL_MACHINES, threads, BENCH_WL_EVENTS);
+    for (size_t i = 0; i < sizeof(models) / sizeof(models[0]); i++)
+    {
+        SmWorkloadConfig config = {
+            .sm_class = sm_class,
+            .machine_count = BENCH_WL_MACHINES,
+            .thread_count = threads,
+            .events_per_thread = BENCH_WL_EVENTS,
+            .initial_state = 0,
+            .zipf_s = models[i].zipf_s,
+            .burst_len = models[i].burst_len,
+            .idle_us = 200,
+            .storm_every = models[i].storm_every,
+            .storm_event = 7,
+            .queue_depth = models[i].queue_depth,
+            .dispatch_batch = 256,
+            .trans_log_fn = models[i].log_fn,
+            .seed = 42,
+        };
+        SmWorkloadResult result;
+        if (SmWorkloadRun(&config, &result) != SM_RET_OK)
+        {
+            printf("    %-10s: failed\n", models[i].name);
+            continue;
+        }
+        printf("    %-10s: %6.2f M events/s, p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns, "
+               "storm %llu us, %zu B/instance, rss +%zu KB\n",
+               models[i].name, result.events_per_sec / 1e6, (unsigned long long)result.latency_p50,
+               (unsigned long long)result.latency_p99, (unsigned long long)result.latency_p999,
+               (unsigned long long)result.latency_max, (unsigned long long)(result.storm_max_ns / 1000),
+               result.bytes_per_instance,
+               (result.rss_after > result.rss_before) ? (result.rss_after - result.rss_before) / 1024 : 0);
+    }
+}
+
+/* ============================================================================
+ * 虚拟时间仿真: 会话抖动
+ * ============================================================================ */
+
+/*
+ * 会话状态机(时间单位: 毫秒):
+ *   IDLE --CONNECT--> CONNECTING --CONNECT_OK--> ONLINE --DROP--> IDLE
+ *   CONNECTING --TIMEOUT--> BACKOFF --RETRY--> CONNECTING (最多 BENCH_SIM_RETRY 次)
+ *   CONNECTING --TIMEOUT--> FAILED --RESET--> IDLE
+ * 进入函数通过定时器安排环境的响应, 连接成功时取消超时定时器.
+ */
+enum
+{
+    SIM_IDLE,
+    SIM_CONNECTING,
+    SIM_ONLINE,
+    SIM_BACKOFF,
+    SIM_FAILED,
+    SIM_STATE_MAX
+};
+
+enum
+{
+    SIM_EV_CONNECT,
+    SIM_EV_CONNECT_OK,
+    SIM_EV_TIMEOUT,
+    SIM_EV_RETRY,
+    SIM_EV_DROP,
+    SIM_EV_RESET,
+    SIM_EV_MAX
+};
+
+/**
+ * @brief 仿真会话实例
+ */
+typedef struct
+{
+    SmMachine machine;    /* 状态机实例(必须位于起始处) */
+    SmTimerId timeout;    /* 连接超时定时器 */
+    uint8_t retries;      /* 本轮已重试次数 */
+    uint8_t attempts;     /* 本轮连接尝试次数 */
+    uint8_t max_attempts; /* 观测到的单轮最多连接尝试次数 */
+} BenchSession;
+
+static SmSim g_sim;
+
+static SmRetCode SimIdleEnter(SmHandle handle)
+{
+    BenchSession *s = (BenchSession *)handle;
+    s->retries = 0;
+    s->attempts = 0;
+    SmSimAfter(&g_sim, &s->machine, SIM_EV_CONNECT, SmSimRandomRange(&g_sim, 10 * 60 * 1000));
+    return SM_RET_OK;
+}
+
+static SmRetCode SimConnectingEnter(SmHandle handle)
+{
+    BenchSession *s = (BenchSession *)handle;
+    s->attempts++;
+    if (s->attempts > s->max_attempts)
+    {
+        s->max_attempts = s->attempts;
+    }
+    s->timeout = SmSimAfter(&g_sim, &s->machine, SIM_EV_TIMEOUT, 5000);
+    if (SmSimRandomRange(&g_sim, 100) < 70)
+    {
+        SmSimAfter(&g_sim, &s->machine, SIM_EV_CONNECT_OK, 10 + SmSimRandomRange(&g_sim, 490));
+    }
+    return SM_RET_OK;
+}
+
+static SmRetCode SimOnlineEnter(SmHandle handle)
+{
+    BenchSession *s = (BenchSession *)handle;
+    SmTimerCancel(g_sim.timers, s->timeout);
+    SmSimAfter(&g_sim, &s->machine, SIM_EV_DROP, 60 * 1000 + SmSimRandomRange(&g_sim, 4 * 3600 * 1000));
+    return SM_RET_OK;
+}
+
+static SmRetCode SimBackoffEnter(SmHandle handle)
+{
+    BenchSession *s = (BenchSession *)handle;
+    SmSimAfter(&g_sim, &s->machine, SIM_EV_RETRY, 1000ULL << s->retries);
+    s->retries++;
+    return SM_RET_OK;
+}
+
+static SmRetCode SimFailedEnter(SmHandle handle)
+{
+    BenchSession *s = (BenchSession *)handle;
+    SmSimAfter(&g_sim, &s->machine, SIM_EV_RESET, 30 * 60 * 1000);
+    return SM_RET_OK;
+}
+
+static bool SimCanRetry(SmHandle handle, void *user_data)
+{
+    return ((BenchSession *)handle)->retries < BENCH_SIM_RETRY;
+}
+
+static const SmTransition sim_idle_trans[] = {
+    SM_TRANS(SIM_EV_CONNECT, SIM_CONNECTING),
+};
+static const SmTransition sim_connecting_trans[] = {
+    SM_TRANS(SIM_EV_CONNECT_OK, SIM_ONLINE),
+    SM_TRANS_COND(SIM_EV_TIMEOUT, SIM_BACKOFF, SimCanRetry),
+    SM_TRANS(SIM_EV_TIMEOUT, SIM_FAILED),
+};
+static const SmTransition sim_online_trans[] = {
+    SM_TRANS(SIM_EV_DROP, SIM_IDLE),
+};
+static const SmTransition sim_backoff_trans[] = {
+    SM_TRANS(SIM_EV_RETRY, SIM_CONNECTING),
+};
+static const SmTransition sim_failed_trans[] = {
+    SM_TRANS(SIM_EV_RESET, SIM_IDLE),
+};
+
+static const SmState sim_states[] = {
+    SM_STATE(SIM_IDLE, "IDLE", SimIdleEnter, NULL, NULL, sim_idle_trans),
+    SM_STATE(SIM_CONNECTING, "CONNECTING", SimConnectingEnter, NULL, NULL, sim_connecting_trans),
+    SM_STATE(SIM_ONLINE, "ONLINE", SimOnlineEnter, NULL, NULL, sim_online_trans),
+    SM_STATE(SIM_BACKOFF, "BACKOFF", SimBackoffEnter, NULL, NULL, sim_backoff_trans),
+    SM_STATE(SIM_FAILED, "FAILED", SimFailedEnter, NULL, NULL, sim_failed_trans),
+};
+
+static const SmClass sim_class = SM_CLASS_DEF("SessionSim", sim_states, NULL, NULL);
+
+/**
+ * @brief 运行一次会话抖动仿真, 返回最终状态的校验和
+ */
+static uint64_t BenchSimRun(uint64_t seed, uint64_t *events, uint64_t *elapsed_ns, uint8_t *max_attempts)
+{
+    BenchSession *sessions = calloc(BENCH_SIM_POOL, sizeof(BenchSession));
+    SmTimer *timers = malloc(sizeof(SmTimer) * BENCH_SIM_POOL * 2);
+    uint32_t *heap_buf = malloc(sizeof(uint32_t) * BENCH_SIM_POOL * 2);
+    SmSimItem *items = malloc(sizeof(SmSimItem) * BENCH_SIM_POOL);
+    SmTimerHeap heap;
+    uint64_t checksum = 0;
+
+    SmTimerHeapInit(&heap, timers, heap_buf, BENCH_SIM_POOL * 2);
+    SmSimInit(&g_sim, &heap, items, BENCH_SIM_POOL, 0, seed);
+
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_SIM_POOL; i++)
+    {
+        SmCreate(&sessions[i].machine, &sim_class, NULL);
+        SmSetMachineId(&sessions[i].machine, i);
+        SmStart(&sessions[i].machine, SIM_IDLE);
+    }
+    *events = SmSimRun(&g_sim, (uint64_t)BENCH_SIM_DAYS * 24 * 3600 * 1000);
+    *elapsed_ns = BenchNowNs() - start;
+
+    *max_attempts = 0;
+    for (uint32_t i = 0; i < BENCH_SIM_POOL; i++)
+    {
+        checksum = checksum * 31 + (uint64_t)SmGetCurrentState(&sessions[i].machine) * 7 + sessions[i].retries;
+        if (sessions[i].max_attempts > *max_attempts)
+        {
+            *max_attempts = sessions[i].max_attempts;
+        }
+        SmDestroy(&sessions[i].machine);
+    }
+    checksum ^= *events;
+
+    SmSimDeinit(&g_sim);
+    free(items);
+    free(heap_buf);
+    free(timers);
+    free(sessions);
+    return checksum;
+}
+
+/**
+ * @brief 仿真会话抖动: 验证重试上限并检查同一种子的可重现性
+ */
+static int BenchSimulate(void)
+{
+    uint64_t events[2], elapsed[2], checksum[2];
+    uint8_t max_attempts;
+
+    for (int i = 0; i < 2; i++)
+    {
+        checksum[i] = BenchSimRun(0x5EED, &events[i], &elapsed[i], &max_attempts);
+    }
+
+    double virtual_s = (double)BENCH_SIM_DAYS * 24 * 3600;
+    printf("  simulation    : %u sessions x %d day, %llu events in %.2f s (%.0fx real time)\n",
+           BENCH_SIM_POOL, BENCH_SIM_DAYS, (unsigned long long)events[0], elapsed[0] / 1e9,
+           virtual_s / (elapsed[0] / 1e9));
+    printf("  sim check     : max %u connect attempts per cycle (limit %d), rerun %s\n",
+           max_attempts, BENCH_SIM_RETRY + 1, (checksum[0] == checksum[1]) ? "identical" : "DIVERGED");
+
+    return (checksum[0] == checksum[1] && max_attempts <= BENCH_SIM_RETRY + 1) ? 0 : -1;
+}
+
+/* ============================================================================
+ * 状态成员索引
+ * ============================================================================ */
+
+/**
+ * @brief 实例池轮流分发事件, 返回 ns/event
+ */
+static double BenchPoolDispatch(SmMachine *pool, const SmEventId *events, uint32_t count)
+{
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmSendEvent(&pool[i % BENCH_POP_POOL], events[i]);
+    }
+    return (double)(BenchNowNs() - start) / count;
+}
+
+static bool BenchPopVisit(void *ctx, SmMachine *machine)
+{
+    (*(uint32_t *)ctx)++;
+    return true;
+}
+
+/**
+ * @brief 成员索引: 转换路径上的维护开销, 计数/枚举与全量扫描对比
+ */
+static int BenchPopIndex(const SmClass *sm_class, const SmEventId *events, uint32_t count)
+{
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_POP_POOL);
+    size_t size = SmPopIndexCalcSize(BENCH_STATE_COUNT, BENCH_POP_POOL);
+    void *buf = malloc(size);
+    SmPopIndex index;
+
+    /* 1. 不带索引 */
+    BenchStartPool(sm_class, pool, BENCH_POP_POOL);
+    double plain_ns = BenchPoolDispatch(pool, events, count);
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+    }
+
+    /* 2. 带索引(相同初始状态和事件流), 多写者和单写者两种方式 */
+    double index_ns[2];
+    bool ok = true;
+    for (int mode = 0; mode < 2; mode++)
+    {
+        SmPopIndexInit(&index, BENCH_STATE_COUNT, BENCH_POP_POOL, buf, size, mode ? SM_POP_SINGLE_WRITER : 0);
+        BenchStartPool(sm_class, pool, BENCH_POP_POOL);
+        for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+        {
+            SmPopIndexAttach(&index, &pool[i]);
+        }
+        index_ns[mode] = BenchPoolDispatch(pool, events, count);
+
+        /* 3. 与全量扫描对比 */
+        SmStateId state = SmGetCurrentState(&pool[0]);
+        uint64_t start = BenchNowNs();
+        uint32_t scanned = 0;
+        for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+        {
+            scanned += (SmGetCurrentState(&pool[i]) == state);
+        }
+        uint64_t scan_ns = BenchNowNs() - start;
+
+        start = BenchNowNs();
+        uint32_t visited = 0;
+        SmPopForEach(&index, state, BenchPopVisit, &visited);
+        uint64_t enum_ns = BenchNowNs() - start;
+
+        uint64_t total = 0;
+        for (SmStateId s = 0; s < BENCH_STATE_COUNT; s++)
+        {
+            total += SmPopCount(&index, s);
+        }
+
+        if (mode == 1)
+        {
+            printf("  pop index     : %7.2f ns/event shared, %.2f single writer (%.2f without), "
+                   "state %d has %u of %u, enumerate %.1f us (scan %.1f us)\n",
+                   index_ns[0], index_ns[1], plain_ns, state, SmPopCount(&index, state), BENCH_POP_POOL,
+                   enum_ns / 1e3, scan_ns / 1e3);
+            printf("  pop memory    : %zu bytes for %d states x %d ids\n", size, BENCH_STATE_COUNT, BENCH_POP_POOL);
+        }
+
+        ok = ok && (scanned == SmPopCount(&index, state) && visited == scanned && total == BENCH_POP_POOL);
+        for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+        {
+            SmDestroy(&pool[i]);
+        }
+        ok = ok && (SmPopCount(&index, state) == 0);
+    }
+    printf("  pop check     : counts %s\n", ok ? "OK" : "MISMATCH");
+
+    free(buf);
+    free(pool);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 准入控制: 重连风暴
+ * ============================================================================ */
+
+/*
+ * 上游重启: 全部 ONLINE 会话同时收到 DROP (时间单位: 微秒)
+ *   ONLINE --DROP--> RECONNECTING --START [准入]--> CONNECTING --CONNECT_OK--> ONLINE
+ * 被拒绝的 START 由准入控制器加抖动后重发. 按 100 ms 统计进入 CONNECTING 的次数.
+ */
+enum
+{
+    STORM_ONLINE,
+    STORM_RECONNECTING,
+    STORM_CONNECTING,
+    STORM_STATE_MAX
+};
+
+enum
+{
+    STORM_EV_DROP,
+    STORM_EV_START,
+    STORM_EV_CONNECT_OK,
+};
+
+#define STORM_BUCKET  100000 /* 统计桶宽度(100 ms) */
+#define STORM_BUCKETS 1000   /* 统计桶数量 */
+
+static SmAdmission g_storm_admission;
+static uint32_t g_storm_connects[STORM_BUCKETS];
+
+static SmRetCode StormReconnectingEnter(SmHandle handle)
+{
+    SmSimAfter(&g_sim, (SmMachine *)handle, STORM_EV_START, 0);
+    return SM_RET_OK;
+}
+
+static SmRetCode StormConnectingEnter(SmHandle handle)
+{
+    uint64_t bucket = SmSimNow(&g_sim) / STORM_BUCKET;
+    g_storm_connects[(bucket < STORM_BUCKETS) ? bucket : STORM_BUCKETS - 1]++;
+    SmSimAfter(&g_sim, (SmMachine *)handle, STORM_EV_CONNECT_OK, 20000 + SmSimRandomRange(&g_sim, 80000));
+    return SM_RET_OK;
+}
+
+static const SmTransition storm_online_trans[] = {
+    SM_TRANS(STORM_EV_DROP, STORM_RECONNECTING),
+};
+static const SmTransition storm_reconnecting_trans[] = {
+    SM_TRANS_FULL(STORM_EV_START, STORM_CONNECTING, SmAdmissionGuard, NULL, &g_storm_admission),
+};
+static const SmTransition storm_connecting_trans[] = {
+    SM_TRANS(STORM_EV_CONNECT_OK, STORM_ONLINE),
+};
+
+static const SmState storm_states[] = {
+    SM_STATE(STORM_ONLINE, "ONLINE", NULL, NULL, NULL, storm_online_trans),
+    SM_STATE(STORM_RECONNECTING, "RECONNECTING", StormReconnectingEnter, NULL, NULL, storm_reconnecting_trans),
+    SM_STATE(STORM_CONNECTING, "CONNECTING", StormConnectingEnter, NULL, NULL, storm_connecting_trans),
+};
+
+static const SmClass storm_class = SM_CLASS_DEF("ReconnectStorm", storm_states, NULL, NULL);
+
+/**
+ * @brief 运行一次重连风暴, 返回 100 ms 内最多的连接次数
+ */
+static uint32_t BenchStormRun(uint64_t interval, uint32_t burst, uint64_t *recovered_ms, uint32_t *online)
+{
+    SmMachine *pool = calloc(BENCH_STORM_POOL, sizeof(SmMachine));
+    SmTimer *timers = malloc(sizeof(SmTimer) * BENCH_STORM_POOL * 2);
+    uint32_t *heap_buf = malloc(sizeof(uint32_t) * BENCH_STORM_POOL * 2);
+    SmSimItem *items = malloc(sizeof(SmSimItem) * BENCH_STORM_POOL);
+    SmTimerHeap heap;
+    uint32_t peak = 0;
+
+    memset(g_storm_connects, 0, sizeof(g_storm_connects));
+    SmTimerHeapInit(&heap, timers, heap_buf, BENCH_STORM_POOL * 2);
+    SmSimInit(&g_sim, &heap, items, BENCH_STORM_POOL, 0, 0x570F);
+    SmAdmissionInit(&g_storm_admission, interval, burst, 200000, STORM_EV_START, &heap);
+
+    for (uint32_t i = 0; i < BENCH_STORM_POOL; i++)
+    {
+        SmCreate(&pool[i], &storm_class, NULL);
+        SmSetMachineId(&pool[i], i);
+        SmStart(&pool[i], STORM_ONLINE);
+        SmSimAfter(&g_sim, &pool[i], STORM_EV_DROP, 0);
+    }
+
+    /* 逐 100 ms 推进, 记录全部恢复在线的时间 */
+    *recovered_ms = 0;
+    for (uint64_t t = STORM_BUCKET; t <= (uint64_t)STORM_BUCKETS * STORM_BUCKET && *recovered_ms == 0;
+         t += STORM_BUCKET)
+    {
+        SmSimRun(&g_sim, t);
+        *online = 0;
+        for (uint32_t i = 0; i < BENCH_STORM_POOL; i++)
+        {
+            *online += (SmGetCurrentState(&pool[i]) == STORM_ONLINE);
+        }
+        if (*online == BENCH_STORM_POOL)
+        {
+            *recovered_ms = t / 1000;
+        }
+    }
+
+    for (uint32_t i = 0; i < STORM_BUCKETS; i++)
+    {
+        peak = (g_storm_connects[i] > peak) ? g_storm_connects[i] : peak;
+    }
+    for (uint32_t i = 0; i < BENCH_STORM_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+    }
+
+    SmSimDeinit(&g_sim);
+    free(items);
+    free(heap_buf);
+    free(timers);
+    free(pool);
+    return peak;
+}
+
+/**
+ * @brief 准入控制: 对比不限速和全局限速时的连接峰值
+ */
+static int BenchStorm(void)
+{
+    uint64_t recovered[2];
+    uint32_t online[2];
+
+    uint32_t unpaced = BenchStormRun(0, 1, &recovered[0], &online[0]);
+    uint32_t paced = BenchStormRun(1000 / BENCH_STORM_RATE, BENCH_STORM_RATE * 10, &recovered[1], &online[1]);
+    uint64_t lost = atomic_load(&g_storm_admission.stats.lost);
+
+    /* 每 100 ms 最多 100 ms 的速率加一次突发 */
+    uint32_t limit = BENCH_STORM_RATE * 100 + BENCH_STORM_RATE * 10;
+
+    printf("  storm         : %u sessions, peak %u connects/100ms unpaced, %u paced (limit %d), "
+           "online after %llu / %llu ms\n",
+           BENCH_STORM_POOL, unpaced, paced, limit,
+           (unsigned long long)recovered[0], (unsigned long long)recovered[1]);
+
+    return (online[0] == BENCH_STORM_POOL && online[1] == BENCH_STORM_POOL && paced <= limit &&
+            lost == 0) ? 0 : -1;
+}
+
+/* ============================================================================
+ * 停留时间监视: 丢失的认证结果
+ * ============================================================================ */
+
+/*
+ * IDLE --START--> AUTH --OK--> ONLINE, AUTH 有停留预算, 到期后监视器发送 STUCK 进入 RECOVER.
+ * 1% 的认证结果丢失, 检查监视器只处理这些实例, 并与全量扫描对比.
+ */
+enum
+{
+    WD_IDLE,
+    WD_AUTH,
+    WD_ONLINE,
+    WD_RECOVER,
+    WD_STATE_MAX
+};
+
+enum
+{
+    WD_EV_START,
+    WD_EV_OK,
+    WD_EV_STUCK,
+};
+
+static const SmTransition wd_idle_trans[] = {
+    SM_TRANS(WD_EV_START, WD_AUTH),
+};
+static const SmTransition wd_auth_trans[] = {
+    SM_TRANS(WD_EV_OK, WD_ONLINE),
+    SM_TRANS(WD_EV_STUCK, WD_RECOVER),
+};
+static const SmTransition wd_online_trans[] = {
+    SM_TRANS(WD_EV_START, WD_AUTH),
+};
+static const SmTransition wd_recover_trans[] = {
+    SM_TRANS(WD_EV_START, WD_AUTH),
+};
+
+static const SmState wd_states[] = {
+    SM_STATE(WD_IDLE, "IDLE", NULL, NULL, NULL, wd_idle_trans),
+    SM_STATE(WD_AUTH, "AUTH", NULL, NULL, NULL, wd_auth_trans, SM_STATE_DWELL(BENCH_WD_BUDGET)),
+    SM_STATE(WD_ONLINE, "ONLINE", NULL, NULL, NULL, wd_online_trans),
+    SM_STATE(WD_RECOVER, "RECOVER", NULL, NULL, NULL, wd_recover_trans),
+};
+
+static const SmClass wd_class = SM_CLASS_DEF("DwellWatch", wd_states, NULL, NULL);
+
+static uint64_t g_wd_now;
+
+static uint64_t BenchWdTime(void)
+{
+    return g_wd_now;
+}
+
+/**
+ * @brief 停留时间监视: 到期处理开销只与到期数量相关
+ */
+static int BenchWatchdog(void)
+{
+    SmMachine *fleet = calloc(BENCH_WD_FLEET, sizeof(SmMachine));
+    SmDwellList lists[WD_STATE_MAX];
+    SmWatchdog watchdog;
+    SmTimeFn saved_time_fn = SmGetTimeFn();
+    uint32_t seed = 0xD00D;
+    uint32_t lost = 0;
+
+    SmSetTimeFn(BenchWdTime);
+    SmWatchdogInit(&watchdog, lists, WD_STATE_MAX);
+    SmWatchdogSetAction(&watchdog, WD_EV_STUCK, NULL, NULL);
+
+    /* 认证在 10 秒内陆续开始, 1% 的结果丢失 */
+    g_wd_now = 0;
+    for (uint32_t i = 0; i < BENCH_WD_FLEET; i++)
+    {
+        g_wd_now = (uint64_t)i * 10000 / BENCH_WD_FLEET;
+        SmCreate(&fleet[i], &wd_class, NULL);
+        SmWatchdogAttach(&watchdog, &fleet[i]);
+        SmStart(&fleet[i], WD_IDLE);
+        SmSendEvent(&fleet[i], WD_EV_START);
+        if (BenchRand(&seed) % 100 != 0)
+        {
+            SmSendEvent(&fleet[i], WD_EV_OK);
+        }
+        else
+        {
+            lost++;
+        }
+    }
+    g_wd_now = 10000 + BENCH_WD_BUDGET;
+
+    /* 对比: 扫描全部实例 */
+    uint64_t start = BenchNowNs();
+    uint32_t scanned = 0;
+    for (uint32_t i = 0; i < BENCH_WD_FLEET; i++)
+    {
+        const SmState *state = &wd_states[fleet[i].current_state];
+        scanned += (state->dwell_budget != 0 && g_wd_now - fleet[i].enter_time >= state->dwell_budget);
+    }
+    uint64_t scan_ns = BenchNowNs() - start;
+
+    start = BenchNowNs();
+    uint32_t found = SmWatchdogCheck(&watchdog, g_wd_now);
+    uint64_t check_ns = BenchNowNs() - start;
+
+    uint32_t recovered = 0;
+    for (uint32_t i = 0; i < BENCH_WD_FLEET; i++)
+    {
+        recovered += (fleet[i].current_state == WD_RECOVER);
+        SmDestroy(&fleet[i]);
+    }
+
+    printf("  watchdog      : %u of %u stuck found in %.1f us (fleet scan %.1f us), %u recovered, %u still watched\n",
+           found, BENCH_WD_FLEET, check_ns / 1e3, scan_ns / 1e3, recovered, watchdog.watched);
+
+    SmSetTimeFn(saved_time_fn);
+    free(fleet);
+    return (found == lost && scanned == lost && recovered == lost && watchdog.watched == 0) ? 0 : -1;
+}
+
+/* ============================================================================
+ * 转换种类: 内部转换与完成转换融合
+ * ============================================================================ */
+
+/*
+ * 重试行: 外部自转换每次执行退出/进入回调和转换日志, 内部转换只执行动作.
+ * 直通链: IDLE -GO-> P0 -> P1 -> P2 -> P3 -> DONE -RESET-> IDLE, P0..P3 只有
+ * 无条件完成转换, 压缩表构建时融合为一步, 与逐步执行对比.
+ */
+
+enum
+{
+    KIND_EXTERNAL,
+    KIND_INTERNAL,
+    KIND_IDLE,
+    KIND_P0,
+    KIND_P1,
+    KIND_P2,
+    KIND_P3,
+    KIND_DONE,
+    KIND_STATE_MAX
+};
+
+enum
+{
+    KIND_EV_FAIL,
+    KIND_EV_GO,
+    KIND_EV_RESET,
+    KIND_EV_MAX
+};
+
+static uint32_t g_kind_calls;
+
+static SmRetCode KindCallback(SmHandle handle)
+{
+    g_kind_calls++;
+    return SM_RET_OK;
+}
+
+static SmRetCode KindRetryAction(SmHandle handle, void *user_data)
+{
+    g_kind_calls++;
+    return SM_RET_OK;
+}
+
+static const SmTransition kind_external_trans[] = {
+    SM_TRANS_ACTION(KIND_EV_FAIL, KIND_EXTERNAL, KindRetryAction, NULL),
+};
+static const SmTransition kind_internal_trans[] = {
+    SM_TRANS_INTERNAL(KIND_EV_FAIL, NULL, KindRetryAction, NULL),
+};
+static const SmTransition kind_idle_trans[] = {
+    SM_TRANS(KIND_EV_GO, KIND_P0),
+};
+static const SmTransition kind_p0_trans[] = {
+    SM_TRANS_COMPLETION(KIND_P1, NULL, NULL, NULL),
+};
+static const SmTransition kind_p1_trans[] = {
+    SM_TRANS_COMPLETION(KIND_P2, NULL, NULL, NULL),
+};
+static const SmTransition kind_p2_trans[] = {
+    SM_TRANS_COMPLETION(KIND_P3, NULL, NULL, NULL),
+};
+static const SmTransition kind_p3_trans[] = {
+    SM_TRANS_COMPLETION(KIND_DONE, NULL, NULL, NULL),
+};
+static const SmTransition kind_done_trans[] = {
+    SM_TRANS(KIND_EV_RESET, KIND_IDLE),
+};
+
+static const SmState kind_states[] = {
+    SM_STATE(KIND_EXTERNAL, "EXTERNAL", KindCallback, KindCallback, NULL, kind_external_trans),
+    SM_STATE(KIND_INTERNAL, "INTERNAL", KindCallback, KindCallback, NULL, kind_internal_trans),
+    SM_STATE(KIND_IDLE, "IDLE", KindCallback, NULL, NULL, kind_idle_trans),
+    SM_STATE(KIND_P0, "P0", NULL, NULL, NULL, kind_p0_trans),
+    SM_STATE(KIND_P1, "P1", NULL, NULL, NULL, kind_p1_trans),
+    SM_STATE(KIND_P2, "P2", NULL, NULL, NULL, kind_p2_trans),
+    SM_STATE(KIND_P3, "P3", NULL, NULL, NULL, kind_p3_trans),
+    SM_STATE(KIND_DONE, "DONE", KindCallback, NULL, NULL, kind_done_trans),
+};
+
+/**
+ * @brief 单个实例循环发送事件序列, 返回 ns/event
+ */
+static double BenchKindRun(const SmClass *sm_class, SmStateId start, const SmEventId *seq, uint32_t seq_len,
+                           SmStateId *final_state, uint32_t *calls)
+{
+    SmMachine machine;
+    SmCreate(&machine, sm_class, NULL);
+    SmSetTransLogFn(&machine, BenchLogSink);
+    SmStart(&machine, start);
+
+    g_kind_calls = 0;
+    uint64_t begin = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_KIND_EVENTS; i++)
+    {
+        SmSendEvent(&machine, seq[i % seq_len]);
+    }
+    uint64_t elapsed = BenchNowNs() - begin;
+
+    *final_state = SmGetCurrentState(&machine);
+    *calls = g_kind_calls;
+    SmDestroy(&machine);
+    return (double)elapsed / BENCH_KIND_EVENTS;
+}
+
+/**
+ * @brief 转换种类: 外部/内部重试行, 直通链逐步执行/融合
+ */
+static int BenchKinds(void)
+{
+    SmClass kind_class = SM_CLASS_DEF("TransKinds", kind_states, NULL, NULL, .event_count = KIND_EV_MAX);
+    static const SmEventId retry_seq[] = { KIND_EV_FAIL };
+    static const SmEventId chain_seq[] = { KIND_EV_GO, KIND_EV_RESET };
+    SmStateId ext_state, int_state, step_state, fused_state;
+    uint32_t ext_calls, int_calls, step_calls, fused_calls;
+
+    double ext_ns = BenchKindRun(&kind_class, KIND_EXTERNAL, retry_seq, 1, &ext_state, &ext_calls);
+    double int_ns = BenchKindRun(&kind_class, KIND_INTERNAL, retry_seq, 1, &int_state, &int_calls);
+    double step_ns = BenchKindRun(&kind_class, KIND_IDLE, chain_seq, 2, &step_state, &step_calls);
+
+    SmTable table;
+    size_t size = SmTableCalcSize(&kind_class);
+    void *buf = malloc(size);
+    if (buf == NULL || SmTableBuild(&table, &kind_class, buf, size) != SM_RET_OK)
+    {
+        free(buf);
+        return -1;
+    }
+    kind_class.table = &table;
+    double fused_ns = BenchKindRun(&kind_class, KIND_IDLE, chain_seq, 2, &fused_state, &fused_calls);
+
+    printf("  retry row     : %7.2f ns/event external self, %.2f internal (%u vs %u callbacks)\n",
+           ext_ns, int_ns, ext_calls, int_calls);
+    printf("  pass-through  : %7.2f ns/event stepwise, %.2f fused (4 states, chain P0 -> %d)\n",
+           step_ns, fused_ns, table.chain[KIND_P0]);
+
+    bool ok = (ext_state == KIND_EXTERNAL && int_state == KIND_INTERNAL && int_calls == BENCH_KIND_EVENTS &&
+               ext_calls == 3 * BENCH_KIND_EVENTS && step_state == fused_state && step_calls == fused_calls &&
+               table.chain[KIND_P0] == KIND_DONE);
+    printf("  kinds check   : %s\n", ok ? "OK" : "MISMATCH");
+
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 热备复制
+ * ============================================================================ */
+
+static uint32_t *g_repl_primary; /* 主实例用户数据(按实例ID) */
+static uint32_t *g_repl_mirror;  /* 镜像用户数据(按实例ID) */
+
+static uint16_t BenchReplDelta(void *ctx, SmMachine *machine, void *buf, uint16_t cap)
+{
+    memcpy(buf, &g_repl_primary[SmGetMachineId(machine)], sizeof(uint32_t));
+    return sizeof(uint32_t);
+}
+
+static void BenchReplApply(void *ctx, SmMachine *mirror, const void *delta, uint16_t len)
+{
+    memcpy(&g_repl_mirror[SmGetMachineId(mirror)], delta, sizeof(uint32_t));
+}
+
+/**
+ * @brief 备用端
+ */
+typedef struct
+{
+    SmReplReceiver *receiver; /* 接收端 */
+    int fd;                   /* 套接字 */
+} BenchStandby;
+
+/**
+ * @brief 备用端线程: 读到连接关闭为止
+ */
+static void BenchReplStandby(void *arg)
+{
+    BenchStandby *standby = (BenchStandby *)arg;
+    while (SmReplReceive(standby->receiver, standby->fd) >= 0)
+    {
+    }
+}
+
+/**
+ * @brief 等待发送线程取走环中的全部记录
+ */
+static void BenchReplWait(SmReplSender *sender)
+{
+    while (atomic_load(&sender->tail) != atomic_load(&sender->head))
+    {
+        usleep(100);
+    }
+}
+
+/**
+ * @brief 热备复制: 分发路径上的开销, 备用进程镜像与主实例一致
+ */
+static int BenchRepl(const SmClass *sm_class, const SmEventId *events, uint32_t count)
+{
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_POP_POOL);
+    SmMachine *mirrors = malloc(sizeof(SmMachine) * BENCH_POP_POOL);
+    SmMachine **mirror_ptrs = malloc(sizeof(SmMachine *) * BENCH_POP_POOL);
+    SmReplRecord *ring = malloc(sizeof(SmReplRecord) * BENCH_REPL_RING);
+    SmReplReceiver *receiver = malloc(sizeof(SmReplReceiver));
+    g_repl_primary = malloc(sizeof(uint32_t) * BENCH_POP_POOL);
+    g_repl_mirror = calloc(BENCH_POP_POOL, sizeof(uint32_t));
+    SmReplSender sender;
+    SmOsThread thread;
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        printf("  repl          : socketpair failed\n");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        g_repl_primary[i] = i * 7;
+        SmCreate(&mirrors[i], sm_class, NULL);
+        SmSetMachineId(&mirrors[i], i);
+        mirror_ptrs[i] = &mirrors[i];
+    }
+
+    /* 1. 不复制 */
+    BenchStartPool(sm_class, pool, BENCH_POP_POOL);
+    double plain_ns = BenchPoolDispatch(pool, events, count);
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+    }
+
+    /* 2. 复制到另一个线程中的备用端(相同初始状态和事件流) */
+    BenchStandby standby = { .receiver = receiver, .fd = fds[1] };
+    SmReplReceiverInit(receiver, mirror_ptrs, BENCH_POP_POOL, BenchReplApply, NULL);
+    SmReplSenderInit(&sender, ring, BENCH_REPL_RING, fds[0], BENCH_REPL_FLUSH, BenchReplDelta, NULL);
+    SmOsThreadCreate(&thread, BenchReplStandby, &standby);
+
+    BenchStartPool(sm_class, pool, BENCH_POP_POOL);
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmReplAttach(&sender, &pool[i]);
+    }
+    BenchReplWait(&sender);
+    double repl_ns = BenchPoolDispatch(pool, events, count);
+    uint64_t dropped = atomic_load(&sender.stats.dropped);
+
+    /* 3. 有丢弃时按半个环分批重新同步 */
+    for (uint32_t i = 0; dropped > 0 && i < BENCH_POP_POOL; i++)
+    {
+        if (i % (BENCH_REPL_RING / 2) == 0)
+        {
+            BenchReplWait(&sender);
+        }
+        SmReplSync(&pool[i]);
+    }
+    BenchReplWait(&sender);
+    uint64_t sent = atomic_load(&sender.stats.sent);
+    uint64_t batches = atomic_load(&sender.stats.batches);
+
+    /* 4. 备用端退出: 连接断开后的变更全部丢弃 */
+    shutdown(fds[0], SHUT_WR);
+    SmOsThreadJoin(&thread);
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        mismatch += (SmGetCurrentState(&mirrors[i]) != SmGetCurrentState(&pool[i]) ||
+                     g_repl_mirror[i] != g_repl_primary[i]);
+    }
+    uint64_t applied = receiver->stats.applied;
+    uint64_t gaps = receiver->stats.gaps;
+
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        g_repl_primary[i] = i * 11;
+    }
+    BenchPoolDispatch(pool, events, count / 10);
+    BenchReplWait(&sender);
+    bool broken = atomic_load(&sender.broken);
+    uint64_t lost = atomic_load(&sender.stats.lost) + atomic_load(&sender.stats.dropped) - dropped;
+
+    /* 5. 新的备用端(镜像用户数据清零)连上后重连, 全量同步并继续分发 */
+    int fds2[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds2) != 0)
+    {
+        printf("  repl          : socketpair failed\n");
+        return -1;
+    }
+    memset(g_repl_mirror, 0, sizeof(uint32_t) * BENCH_POP_POOL);
+    SmReplReceiverInit(receiver, mirror_ptrs, BENCH_POP_POOL, BenchReplApply, NULL);
+    standby.fd = fds2[1];
+    SmOsThreadCreate(&thread, BenchReplStandby, &standby);
+    bool reconnected = (SmReplReconnect(&sender, fds2[0]) == SM_RET_OK);
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        if (i % (BENCH_REPL_RING / 2) == 0)
+        {
+            BenchReplWait(&sender);
+        }
+        SmReplSync(&pool[i]);
+    }
+    BenchReplWait(&sender);
+    BenchPoolDispatch(pool, events, count / 10);
+
+    SmReplSenderDeinit(&sender);
+    shutdown(fds2[0], SHUT_WR);
+    SmOsThreadJoin(&thread);
+
+    uint32_t reseed_mismatch = 0;
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        reseed_mismatch += (SmGetCurrentState(&mirrors[i]) != SmGetCurrentState(&pool[i]) ||
+                            g_repl_mirror[i] != g_repl_primary[i]);
+    }
+
+    printf("  replication   : %7.2f ns/event (%.2f without), %llu records in %llu writes, %llu dropped\n",
+           repl_ns, plain_ns, (unsigned long long)sent, (unsigned long long)batches, (unsigned long long)dropped);
+    printf("  repl reconnect: standby gone -> %s, %llu records discarded; reconnect %s, %u of %u mirrors differ "
+           "after re-seed\n",
+           broken ? "broken" : "NOT BROKEN", (unsigned long long)lost, reconnected ? "OK" : "FAILED", reseed_mismatch,
+           BENCH_POP_POOL);
+
+    bool ok = (mismatch == 0 && broken && reconnected && reseed_mismatch == 0 && receiver->stats.gaps == 0);
+    printf("  repl check    : %u of %u mirrors differ, %llu applied, %llu gap -> %s\n", mismatch, BENCH_POP_POOL,
+           (unsigned long long)applied, (unsigned long long)gaps, ok ? "OK" : "MISMATCH");
+
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+        SmDestroy(&mirrors[i]);
+    }
+    close(fds[0]);
+    close(fds[1]);
+    close(fds2[0]);
+    close(fds2[1]);
+    free(g_repl_primary);
+    free(g_repl_mirror);
+    free(receiver);
+    free(ring);
+    free(mirror_ptrs);
+    free(mirrors);
+    free(pool);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 克隆与推演
+ * ============================================================================ */
+
+/**
+ * @brief 克隆推演: 每秒可评估的候选数, 推演结果与真实分发一致且不影响原实例
+ */
+static int BenchSpeculate(const SmClass *sm_class, const SmEventId *events, uint32_t count)
+{
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_POP_POOL);
+    static uint64_t arena_buf[64];
+    static SmOutRecord scratch_records[16];
+    SmOutbox scratch;
+    SmSpecStep steps[16];
+    SmSpecTrace trace = { .steps = steps, .capacity = 16 };
+    SmSpecArena arena;
+    uint32_t plans = (count / 2 < BENCH_SPEC_PLANS) ? count / 2 : BENCH_SPEC_PLANS;
+    uint64_t checksum = 0;
+
+    BenchStartPool(sm_class, pool, BENCH_POP_POOL);
+    SmOutboxInit(&scratch, scratch_records, 16, NULL, 0, NULL);
+    SmSpecArenaInit(&arena, arena_buf, sizeof(arena_buf), &scratch);
+
+    /* 1. 吞吐: 每个候选一次克隆 + 两个事件 */
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < plans; i++)
+    {
+        SmSpecArenaReset(&arena);
+        SmMachine *clone = SmClone(&arena, &pool[i % BENCH_POP_POOL], sizeof(SmMachine), 0);
+        SmSpeculate(clone, &events[2 * i], 2, SM_SPEC_STUB_ALL, &trace);
+        checksum += (uint64_t)trace.final_state + trace.count;
+    }
+    double plan_ns = (double)(BenchNowNs() - start) / plans;
+
+    /* 2. 与真实分发对比: 推演后原实例不变, 再真实发送同样的事件 */
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmStateId before = SmGetCurrentState(&pool[i]);
+        SmSpecArenaReset(&arena);
+        SmSpeculate(SmClone(&arena, &pool[i], sizeof(SmMachine), 0), &events[2 * i], 2, 0, &trace);
+        bool unchanged = (SmGetCurrentState(&pool[i]) == before);
+
+        SmSendEvent(&pool[i], events[2 * i]);
+        SmSendEvent(&pool[i], events[2 * i + 1]);
+        mismatch += (!unchanged || SmGetCurrentState(&pool[i]) != trace.final_state);
+    }
+
+    printf("  speculate     : %7.2f ns/plan (clone + 2 events), %.1f M plans/s, checksum %llu\n",
+           plan_ns, 1e3 / plan_ns, (unsigned long long)checksum);
+    printf("  spec check    : %u of %u plans differ from real dispatch -> %s\n", mismatch, BENCH_POP_POOL,
+           (mismatch == 0) ? "OK" : "MISMATCH");
+
+    for (uint32_t i = 0; i < BENCH_POP_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+    }
+    free(pool);
+    return (mismatch == 0) ? 0 : -1;
+}
+
+/**
+ * @brief 准入快照: 统计, 理论到达时间, 定时器堆
+ */
+static void BenchAdmSnapshot(SmAdmission *admission, const SmTimerHeap *heap, uint64_t snap[6])
+{
+    snap[0] = atomic_load(&admission->stats.admitted);
+    snap[1] = atomic_load(&admission->stats.rejected);
+    snap[2] = atomic_load(&admission->stats.retries);
+    snap[3] = atomic_load(&admission->stats.lost);
+    snap[4] = atomic_load(&admission->tat);
+    snap[5] = heap->count;
+}
+
+/**
+ * @brief 在带准入守卫的重连类上推演: 共享令牌和定时器堆不受影响
+ * @note 令牌用完时克隆停在 RECONNECTING, 有令牌时进入 CONNECTING, 两种情况均不消耗令牌
+ */
+static int BenchSpecAdmission(void)
+{
+    static uint64_t arena_buf[64];
+    static SmOutRecord scratch_records[16];
+    static SmTimer timers[16];
+    static uint32_t heap_buf[16];
+    static const SmEventId plan[] = { STORM_EV_START, STORM_EV_START };
+    SmOutbox scratch;
+    SmTimerHeap heap;
+    SmSpecStep steps[16];
+    SmSpecTrace trace = { .steps = steps, .capacity = 16 };
+    SmSpecArena arena;
+    SmMachine machine;
+    uint64_t before[6], after[6];
+    uint32_t plans = 0, changed = 0;
+    bool states_ok = true;
+
+    SmTimerHeapInit(&heap, timers, heap_buf, 16);
+    SmOutboxInit(&scratch, scratch_records, 16, NULL, 0, NULL);
+    bool no_outbox = (SmSpecArenaInit(&arena, arena_buf, sizeof(arena_buf), NULL) != SM_RET_OK);
+    SmSpecArenaInit(&arena, arena_buf, sizeof(arena_buf), &scratch);
+
+    SmSetTimeFn(BenchNowUs);
+    SmCreate(&machine, &storm_class, NULL);
+    SmRestoreState(&machine, STORM_RECONNECTING, STORM_ONLINE);
+
+    /* burst = 1 且令牌已用完 / burst = 4 的新桶 */
+    for (uint32_t round = 0; round < 2; round++)
+    {
+        SmAdmissionInit(&g_storm_admission, 1000000, (round == 0) ? 1 : 4, 1000, STORM_EV_START, &heap);
+        if (round == 0)
+        {
+            SmAdmit(&g_storm_admission, SmGetTime(), NULL);
+        }
+        SmStateId expect = (round == 0) ? STORM_RECONNECTING : STORM_CONNECTING;
+
+        BenchAdmSnapshot(&g_storm_admission, &heap, before);
+        for (uint32_t i = 0; i < 1000; i++, plans++)
+        {
+            SmSpecArenaReset(&arena);
+            SmSpeculate(SmClone(&arena, &machine, sizeof(SmMachine), 0), plan, 2, SM_SPEC_STUB_ALL, &trace);
+            states_ok = states_ok && (trace.final_state == expect);
+        }
+        BenchAdmSnapshot(&g_storm_admission, &heap, after);
+        changed += (memcmp(before, after, sizeof(before)) != 0);
+    }
+
+    SmDestroy(&machine);
+    SmSetTimeFn(NULL);
+
+    bool ok = (no_outbox && states_ok && changed == 0);
+    printf("  spec admission: %u plans on a guarded class, admission stats/tat and timer heap %s -> %s\n", plans,
+           (changed == 0) ? "unchanged" : "CHANGED", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 名称索引
+ * ============================================================================ */
+
+/**
+ * @brief 按名称查找: 完美哈希与逐个比较(strcmp 链)对比, 结果需一致
+ */
+static int BenchNames(const SmClass *sm_class)
+{
+    SmClass named = *sm_class;
+    char (*event_text)[16] = malloc(sizeof(*event_text) * BENCH_EVENT_COUNT);
+    char (*state_text)[16] = malloc(sizeof(*state_text) * BENCH_STATE_COUNT);
+    const char **event_names = malloc(sizeof(const char *) * BENCH_EVENT_COUNT);
+    SmState *states = malloc(sizeof(SmState) * BENCH_STATE_COUNT);
+    uint16_t *picks = malloc(sizeof(uint16_t) * BENCH_NAME_FINDS);
+    uint32_t seed = 0x2545F491;
+    SmNames names;
+
+    /* 生成的类状态名都是 "S", 这里换成唯一名称 */
+    for (uint16_t e = 0; e < BENCH_EVENT_COUNT; e++)
+    {
+        snprintf(event_text[e], sizeof(event_text[e]), "EVT_%03u", e);
+        event_names[e] = event_text[e];
+    }
+    for (uint16_t i = 0; i < BENCH_STATE_COUNT; i++)
+    {
+        states[i] = sm_class->states[i];
+        snprintf(state_text[i], sizeof(state_text[i]), "STATE_%04u", i);
+        states[i].state_name = state_text[i];
+    }
+    for (uint32_t i = 0; i < BENCH_NAME_FINDS; i++)
+    {
+        picks[i] = (uint16_t)(BenchRand(&seed) % BENCH_EVENT_COUNT);
+    }
+    named.states = states;
+    named.event_names = event_names;
+    named.event_name_count = BENCH_EVENT_COUNT;
+    named.names = NULL;
+
+    size_t size = SmNamesCalcSize(&named);
+    void *buf = malloc(size);
+    uint64_t build_start = BenchNowNs();
+    SmRetCode built = SmNamesBuild(&names, &named, buf, size);
+    uint64_t build_ns = BenchNowNs() - build_start;
+
+    /* 1. 逐个比较 */
+    uint32_t mismatch = 0;
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_NAME_FINDS; i++)
+    {
+        mismatch += (SmFindEventId(&named, event_names[picks[i]], 7) != picks[i]);
+    }
+    double linear_ns = (double)(BenchNowNs() - start) / BENCH_NAME_FINDS;
+
+    /* 2. 完美哈希 */
+    named.names = (built == SM_RET_OK) ? &names : NULL;
+    start = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_NAME_FINDS; i++)
+    {
+        mismatch += (SmFindEventId(&named, event_names[picks[i]], 7) != picks[i]);
+    }
+    double hash_ns = (double)(BenchNowNs() - start) / BENCH_NAME_FINDS;
+
+    for (uint16_t i = 0; i < BENCH_STATE_COUNT; i++)
+    {
+        mismatch += (SmFindStateId(&named, state_text[i], 10) != states[i].state_id);
+    }
+    mismatch += (SmFindEventId(&named, "EVT_XYZ", 7) != SM_EVENT_INVALID);
+    mismatch += (built != SM_RET_OK);
+
+    printf("  event by name : %7.2f ns/lookup (strcmp chain over %d names)\n", linear_ns, BENCH_EVENT_COUNT);
+    printf("  event by name : %7.2f ns/lookup (perfect hash, build %.2f ms, %zu bytes)\n", hash_ns,
+           build_ns / 1e6, SmNamesGetBytes(&names));
+    printf("  names check   : %s\n", (mismatch == 0) ? "OK" : "MISMATCH");
+
+    free(buf);
+    free(picks);
+    free(states);
+    free(event_names);
+    free(state_text);
+    free(event_text);
+    return (mismatch == 0) ? 0 : -1;
+}
+
+/* ============================================================================
+ * 可达性分析
+ * ============================================================================ */
+
+static bool BenchExpGuard(SmHandle handle, void *user_data)
+{
+    return ((uintptr_t)user_data & 1) != 0;
+}
+
+static SmRetCode BenchExpAction(SmHandle handle, void *user_data)
+{
+    return SM_RET_OK;
+}
+
+/**
+ * @brief 生成的类加上条件和动作: 约 30% 的规则带条件(BENCH_EXP_GUARDS 个之一), 约 20% 带动作;
+ *        指向最后 BENCH_EXP_DEAD 个状态的转换改指其他状态, 这些状态不可达
+ */
+static SmClass BenchExpGuarded(const SmClass *sm_class, SmState *states)
+{
+    SmClass guarded = *sm_class;
+    uint32_t seed = 0x6A09E667;
+
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        SmTransition *trans = malloc(sizeof(SmTransition) * sm_class->states[s].trans_count);
+        states[s] = sm_class->states[s];
+        for (uint16_t i = 0; i < states[s].trans_count; i++)
+        {
+            uint32_t r = BenchRand(&seed) % 100;
+            trans[i] = sm_class->states[s].transitions[i];
+            trans[i].next_state %= (SmStateId)(sm_class->state_count - BENCH_EXP_DEAD);
+            if (r < 30)
+            {
+                trans[i].condition = BenchExpGuard;
+                trans[i].action_data = (void *)(uintptr_t)(1 + BenchRand(&seed) % BENCH_EXP_GUARDS);
+            }
+            if (r >= 20 && r < 40)
+            {
+                trans[i].action = BenchExpAction;
+            }
+        }
+        states[s].transitions = trans;
+    }
+
+    guarded.class_name = "BenchGuarded";
+    guarded.states = states;
+    guarded.table = NULL;
+    return guarded;
+}
+
+/*
+ * 条件从不成立: T 的完成转换在 G 为假时留在 T, B 不经回调把"G 为假"带到 S,
+ * S 上以 G 为条件的 C 规则永远不会触发
+ */
+enum
+{
+    DEAD_T,
+    DEAD_X,
+    DEAD_S,
+};
+
+static const SmTransition bench_dead_t[] = {
+    SM_TRANS_COMPLETION(DEAD_X, BenchExpGuard, NULL, (void *)2),
+    SM_TRANS(1, DEAD_S),
+    SM_TRANS_END()
+};
+static const SmTransition bench_dead_x[] = {
+    SM_TRANS(1, DEAD_T),
+    SM_TRANS_END()
+};
+static const SmTransition bench_dead_s[] = {
+    SM_TRANS_FULL(2, DEAD_T, BenchExpGuard, NULL, (void *)2),
+    SM_TRANS(3, DEAD_T),
+    SM_TRANS_END()
+};
+static const SmState bench_dead_states[] = {
+    SM_STATE(DEAD_T, "T", NULL, NULL, NULL, bench_dead_t),
+    SM_STATE(DEAD_X, "X", NULL, NULL, NULL, bench_dead_x),
+    SM_STATE(DEAD_S, "S", NULL, NULL, NULL, bench_dead_s),
+};
+static const SmClass bench_dead_class = SM_CLASS_DEF("DeadGuard", bench_dead_states, NULL, NULL);
+
+/**
+ * @brief 裁剪删除条件从不成立的规则
+ */
+static bool BenchExpDeadGuard(void)
+{
+    SmExploreConfig config = {
+        .sm_class = &bench_dead_class,
+        .initial_state = DEAD_T,
+        .thread_count = 1,
+        .max_configs = 1000,
+    };
+    SmExploreResult result;
+    SmState states[3];
+    SmTransition trans[16];
+    SmClass pruned;
+
+    if (SmExploreRun(&config, &result) != SM_RET_OK)
+    {
+        return false;
+    }
+    bool ok = (SmExplorePrune(&result, states, trans, &pruned) == SM_RET_OK && pruned.states[DEAD_S].trans_count == 1 &&
+               pruned.states[DEAD_S].transitions[0].event_id == 3 && pruned.states[DEAD_T].trans_count == 2);
+    SmExploreFree(&result);
+    return ok;
+}
+
+/**
+ * @brief 探索带条件的生成类, 裁剪后重新编译, 并验证转换表变小且分发结果不变
+ */
+static int BenchExplore(const SmClass *sm_class, const SmEventId *events, uint32_t count)
+{
+    SmState *states = malloc(sizeof(SmState) * sm_class->state_count);
+    SmClass guarded = BenchExpGuarded(sm_class, states);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = (cpus < 1) ? 1 : (cpus > SM_EXPLORE_MAX_THREADS) ? SM_EXPLORE_MAX_THREADS : (uint32_t)cpus;
+    SmExploreConfig config = {
+        .sm_class = &guarded,
+        .initial_state = 0,
+        .thread_count = 1,
+        .max_configs = BENCH_EXP_CONFIGS,
+    };
+    SmExploreResult serial;
+    SmExploreResult parallel;
+    bool ok = true;
+
+    /* 1. 单线程与多线程(至少 4 个线程, 验证并发插入)结果一致 */
+    ok = ok && SmExploreRun(&config, &serial) == SM_RET_OK;
+    config.thread_count = (threads < 4) ? 4 : threads;
+    ok = ok && SmExploreRun(&config, &parallel) == SM_RET_OK;
+    ok = ok && serial.configs == parallel.configs && serial.edges == parallel.edges &&
+         serial.depth == parallel.depth && serial.rules_fired == parallel.rules_fired && !serial.truncated;
+    for (uint32_t r = 0; ok && r < serial.rule_count; r++)
+    {
+        ok = (serial.rule_flags[r] == parallel.rule_flags[r]);
+    }
+
+    printf("  explore       : %llu configs, %llu edges, depth %u, %u guards\n",
+           (unsigned long long)serial.configs, (unsigned long long)serial.edges, serial.depth, serial.guard_count);
+    printf("  explore       : %7.1f ms, %.2f M configs/s (1 thread)\n", serial.elapsed_ns / 1e6,
+           serial.configs * 1e3 / (serial.elapsed_ns ? serial.elapsed_ns : 1));
+    printf("  explore       : %7.1f ms, %.2f M configs/s (%u threads, %u cpus)\n", parallel.elapsed_ns / 1e6,
+           parallel.configs * 1e3 / (parallel.elapsed_ns ? parallel.elapsed_ns : 1), parallel.thread_count,
+           (unsigned)((cpus < 1) ? 1 : cpus));
+    printf("  coverage      : %u/%u states, %u/%u rules fired\n", serial.states_reached, guarded.state_count,
+           serial.rules_fired, serial.rules_total);
+
+    /* 2. 裁剪后重新编译, 比较转换表大小 */
+    SmState *pruned_states = malloc(sizeof(SmState) * guarded.state_count);
+    SmTransition *pruned_trans = malloc(sizeof(SmTransition) * (serial.rule_count + 1));
+    SmClass pruned;
+    SmTable full_table;
+    SmTable pruned_table;
+    ok = ok && SmExplorePrune(&serial, pruned_states, pruned_trans, &pruned) == SM_RET_OK;
+
+    size_t full_size = SmTableCalcSize(&guarded);
+    size_t pruned_size = ok ? SmTableCalcSize(&pruned) : 0;
+    void *full_buf = malloc(full_size);
+    void *pruned_buf = malloc(pruned_size ? pruned_size : 1);
+    ok = ok && SmTableBuild(&full_table, &guarded, full_buf, full_size) == SM_RET_OK &&
+         SmTableBuild(&pruned_table, &pruned, pruned_buf, pruned_size) == SM_RET_OK;
+    if (ok)
+    {
+        uint32_t kept = pruned.any_trans_count;
+        for (uint16_t s = 0; s < pruned.state_count; s++)
+        {
+            kept += pruned.states[s].trans_count;
+        }
+        printf("  pruned        : %u -> %u rules, table %u -> %u slots, %zu -> %zu bytes\n",
+               serial.rules_total, kept, full_table.slot_count, pruned_table.slot_count, SmTableGetBytes(&full_table),
+               SmTableGetBytes(&pruned_table));
+        ok = (pruned_table.slot_count < full_table.slot_count &&
+              SmTableGetBytes(&pruned_table) < SmTableGetBytes(&full_table));
+
+        /* 3. 裁剪不改变分发结果 */
+        SmStateId full_state;
+        SmStateId pruned_state;
+        guarded.table = &full_table;
+        pruned.table = &pruned_table;
+        BenchDispatch(&guarded, events, count, &full_state);
+        BenchDispatch(&pruned, events, count, &pruned_state);
+        ok = ok && (full_state == pruned_state);
+    }
+    bool dead_ok = BenchExpDeadGuard();
+    ok = ok && dead_ok;
+    printf("  explore check : table shrinks and dispatch unchanged, guard-never-true rule %s -> %s\n",
+           dead_ok ? "pruned" : "KEPT", ok ? "OK" : "MISMATCH");
+
+    free(pruned_buf);
+    free(full_buf);
+    free(pruned_trans);
+    free(pruned_states);
+    SmExploreFree(&parallel);
+    SmExploreFree(&serial);
+    for (uint16_t s = 0; s < guarded.state_count; s++)
+    {
+        free((void *)states[s].transitions);
+    }
+    free(states);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * CAN 帧接入
+ * ============================================================================ */
+
+enum
+{
+    MOTOR_IDLE,
+    MOTOR_RUN,
+    MOTOR_FAULT,
+};
+
+enum
+{
+    MOTOR_EVT_STATUS,
+    MOTOR_EVT_HEARTBEAT,
+    MOTOR_EVT_RESET,
+};
+
+/**
+ * @brief 电机状态帧解码后的负载
+ */
+typedef struct
+{
+    int16_t rpm;      /* 转速 */
+    uint8_t temp;     /* 温度 */
+    uint8_t fault;    /* 故障位 */
+    uint16_t current; /* 电流(12 位, 大端) */
+} BenchMotorStatus;
+
+/**
+ * @brief 电机控制器
+ */
+typedef struct
+{
+    SmMachine sm;        /* 状态机实例(必须在开头) */
+    int64_t rpm_sum;     /* 运行中收到的转速累计 */
+    uint32_t heartbeats; /* 心跳次数 */
+} BenchMotor;
+
+static const BenchMotorStatus *BenchMotorPayload(SmHandle handle)
+{
+    uint16_t len;
+    const void *data = SmGetEventData((SmMachine *)handle, &len);
+    return (len == sizeof(BenchMotorStatus)) ? (const BenchMotorStatus *)data : NULL;
+}
+
+static bool MotorSpinning(SmHandle handle, void *user_data)
+{
+    const BenchMotorStatus *status = BenchMotorPayload(handle);
+    return status != NULL && status->rpm != 0;
+}
+
+static bool MotorFaulted(SmHandle handle, void *user_data)
+{
+    const BenchMotorStatus *status = BenchMotorPayload(handle);
+    return status != NULL && status->fault != 0;
+}
+
+static SmRetCode MotorHeartbeat(SmHandle handle, void *user_data)
+{
+    ((BenchMotor *)handle)->heartbeats++;
+    return SM_RET_OK;
+}
+
+static SmRetCode MotorRunHandle(SmHandle handle, SmEventId event)
+{
+    const BenchMotorStatus *status = BenchMotorPayload(handle);
+    if (event == MOTOR_EVT_STATUS && status != NULL)
+    {
+        ((BenchMotor *)handle)->rpm_sum += status->rpm + status->current;
+    }
+    return SM_RET_OK;
+}
+
+static const SmEventId motor_run_handles[] = { MOTOR_EVT_STATUS, SM_EVENT_INVALID };
+
+static const SmTransition motor_idle_trans[] = {
+    SM_TRANS_COND(MOTOR_EVT_STATUS, MOTOR_RUN, MotorSpinning),
+    SM_TRANS_INTERNAL(MOTOR_EVT_HEARTBEAT, NULL, MotorHeartbeat, NULL),
+};
+static const SmTransition motor_run_trans[] = {
+    SM_TRANS_COND(MOTOR_EVT_STATUS, MOTOR_FAULT, MotorFaulted),
+    SM_TRANS_INTERNAL(MOTOR_EVT_HEARTBEAT, NULL, MotorHeartbeat, NULL),
+};
+static const SmTransition motor_fault_trans[] = {
+    SM_TRANS(MOTOR_EVT_RESET, MOTOR_IDLE),
+};
+
+static const SmState motor_states[] = {
+    SM_STATE(MOTOR_IDLE, "IDLE", NULL, NULL, NULL, motor_idle_trans),
+    SM_STATE(MOTOR_RUN, "RUN", NULL, NULL, MotorRunHandle, motor_run_trans, SM_STATE_HANDLES(motor_run_handles)),
+    SM_STATE(MOTOR_FAULT, "FAULT", NULL, NULL, NULL, motor_fault_trans),
+};
+
+static const SmClass motor_class = SM_CLASS_DEF("MotorCtrl", motor_states, NULL, NULL);
+
+/* 状态帧 0x180 + 节点号: 转速(有符号, Intel), 温度, 电流(Motorola 12 位), 故障位(data[7] 最高位) */
+static const SmCanField motor_status_fields[] = {
+    SM_CAN_FIELD(0, 16, BenchMotorStatus, rpm, SM_CAN_FIELD_SIGNED),
+    SM_CAN_FIELD(16, 8, BenchMotorStatus, temp, 0),
+    SM_CAN_FIELD(24, 12, BenchMotorStatus, current, SM_CAN_FIELD_MOTOROLA),
+    SM_CAN_FIELD(56, 1, BenchMotorStatus, fault, SM_CAN_FIELD_MOTOROLA),
+};
+
+static const SmCanRule motor_can_rules[] = {
+    SM_CAN_RULE(0x180, 0x7C0, MOTOR_EVT_STATUS, motor_status_fields, BenchMotorStatus, SM_CAN_ROUTE(0, 0, 0x3F)),
+    SM_CAN_RULE_RAW(0x700, 0x7C0, MOTOR_EVT_HEARTBEAT, SM_CAN_ROUTE(0, 0, 0x3F)),
+    SM_CAN_RULE_RAW(0x18FF5000, 0x1FFFFF00, MOTOR_EVT_RESET, SM_CAN_EXT(), SM_CAN_ROUTE(0, 0, 0x3F)),
+};
+
+/**
+ * @brief 生成总线流量: 状态帧为主, 心跳, 扩展帧复位, 少量无关帧
+ */
+static void BenchCanGenFrames(struct can_frame *frames, BenchMotorStatus *expect, uint32_t count)
+{
+    uint32_t seed = 0x510E527F;
+
+    memset(frames, 0, sizeof(struct can_frame) * count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t node = BenchRand(&seed) % BENCH_CAN_NODES;
+        uint32_t kind = BenchRand(&seed) % 100;
+        struct can_frame *frame = &frames[i];
+
+        memset(&expect[i], 0, sizeof(BenchMotorStatus));
+        if (kind < 80)
+        {
+            BenchMotorStatus *status = &expect[i];
+            status->rpm = (int16_t)(BenchRand(&seed) % 6000) - 1000;
+            status->temp = (uint8_t)(BenchRand(&seed) % 120);
+            status->current = (uint16_t)(BenchRand(&seed) & 0xFFF);
+            status->fault = (BenchRand(&seed) % 2000 == 0);
+            frame->can_id = 0x180 + node;
+            frame->can_dlc = 8;
+            frame->data[0] = (uint8_t)status->rpm;
+            frame->data[1] = (uint8_t)((uint16_t)status->rpm >> 8);
+            frame->data[2] = status->temp;
+            frame->data[3] = (uint8_t)(status->current >> 4);
+            frame->data[4] = (uint8_t)((status->current & 0xF) << 4);
+            frame->data[7] = status->fault ? 0x80 : 0;
+        }
+        else if (kind < 95)
+        {
+            frame->can_id = 0x700 + node;
+            frame->can_dlc = 1;
+            frame->data[0] = 0x05;
+        }
+        else if (kind < 99)
+        {
+            frame->can_id = CAN_EFF_FLAG | 0x18FF5000 | node;
+            frame->can_dlc = 0;
+        }
+        else
+        {
+            frame->can_id = 0x555;
+            frame->can_dlc = 2;
+        }
+    }
+}
+
+static void BenchCanResetMotors(BenchMotor *motors, SmMachine **machines)
+{
+    for (uint32_t i = 0; i < BENCH_CAN_NODES; i++)
+    {
+        memset(&motors[i], 0, sizeof(BenchMotor));
+        SmCreate(&motors[i].sm, &motor_class, NULL);
+        SmStart(&motors[i].sm, MOTOR_IDLE);
+        machines[i] = &motors[i].sm;
+    }
+}
+
+static uint64_t BenchCanChecksum(BenchMotor *motors)
+{
+    uint64_t checksum = 0;
+    for (uint32_t i = 0; i < BENCH_CAN_NODES; i++)
+    {
+        checksum = checksum * 31 + (uint64_t)SmGetCurrentState(&motors[i].sm);
+        checksum = checksum * 31 + (uint64_t)motors[i].rpm_sum + motors[i].heartbeats;
+        SmDestroy(&motors[i].sm);
+    }
+    return checksum;
+}
+
+/**
+ * @brief 总线发送端
+ */
+typedef struct
+{
+    int fd;                         /* 发送套接字 */
+    const struct can_frame *frames; /* 帧 */
+    uint32_t count;                 /* 帧数 */
+    atomic_bool done;               /* 发送完成 */
+} BenchCanWriter;
+
+static void BenchCanWriterThread(void *arg)
+{
+    BenchCanWriter *writer = (BenchCanWriter *)arg;
+    struct mmsghdr msgs[SM_CAN_BATCH];
+    struct iovec iov[SM_CAN_BATCH];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (uint32_t sent = 0; sent < writer->count;)
+    {
+        uint32_t n = (writer->count - sent < SM_CAN_BATCH) ? writer->count - sent : SM_CAN_BATCH;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            iov[i].iov_base = (void *)&writer->frames[sent + i];
+            iov[i].iov_len = sizeof(struct can_frame);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int ret = sendmmsg(writer->fd, msgs, n, 0);
+        if (ret <= 0)
+        {
+            if (ret < 0 && errno != EINTR && errno != ENOBUFS && errno != EAGAIN)
+            {
+                break;
+            }
+            SmOsYield();
+            continue;
+        }
+        sent += (uint32_t)ret;
+    }
+    atomic_store(&writer->done, true);
+}
+
+/**
+ * @brief CAN 接入: 解码正确性, 内存接入吞吐, recvmmsg 套接字接入(vcan0, 不可用时用数据报套接字对)
+ */
+static int BenchCan(void)
+{
+    struct can_frame *frames = malloc(sizeof(struct can_frame) * BENCH_CAN_FRAMES);
+    BenchMotorStatus *expect = malloc(sizeof(BenchMotorStatus) * BENCH_CAN_FRAMES);
+    BenchMotor motors[BENCH_CAN_NODES];
+    SmMachine *machines[BENCH_CAN_NODES];
+    static SmCanIngest can;
+    uint32_t mismatch = 0;
+
+    BenchCanGenFrames(frames, expect, BENCH_CAN_FRAMES);
+    if (SmCanInit(&can, motor_can_rules, sizeof(motor_can_rules) / sizeof(SmCanRule), machines,
+                  BENCH_CAN_NODES) != SM_RET_OK)
+    {
+        printf("  can init failed\n");
+        return -1;
+    }
+
+    /* 1. 解码结果与编码值一致 */
+    for (uint32_t i = 0; i < BENCH_CAN_FRAMES; i++)
+    {
+        BenchMotorStatus status;
+        if ((frames[i].can_id & ~0x3Fu) == 0x180 &&
+            (SmCanDecode(&motor_can_rules[0], &frames[i], &status) != SM_RET_OK ||
+             memcmp(&status, &expect[i], sizeof(status)) != 0))
+        {
+            mismatch++;
+        }
+    }
+
+    /* 2. 内存接入: 按批分发 */
+    BenchCanResetMotors(motors, machines);
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_CAN_FRAMES; i += SM_CAN_BATCH)
+    {
+        uint32_t n = (BENCH_CAN_FRAMES - i < SM_CAN_BATCH) ? BENCH_CAN_FRAMES - i : SM_CAN_BATCH;
+        SmCanFeed(&can, &frames[i], n);
+    }
+    double feed_ns = (double)(BenchNowNs() - start) / BENCH_CAN_FRAMES;
+    SmCanStats stats = can.stats;
+    BenchCanResetMotors(motors, machines);
+
+    /* 同样的帧逐帧只分发前 BENCH_CAN_SOCKET 帧, 作为套接字接入的参照 */
+    SmCanFeed(&can, frames, BENCH_CAN_SOCKET);
+    uint64_t reference = BenchCanChecksum(motors);
+
+    printf("  can feed      : %7.2f ns/frame, %.1f M frames/s (%.0fx a saturated 1 Mbit/s bus)\n", feed_ns,
+           1e3 / feed_ns, 1e9 / feed_ns / BENCH_CAN_BUS_FPS);
+    printf("  can frames    : %llu dispatched (%llu ignored), %llu unmatched, %llu unrouted, %llu short, "
+           "%llu rejected\n",
+           (unsigned long long)stats.dispatched, (unsigned long long)stats.ignored, (unsigned long long)stats.unmatched,
+           (unsigned long long)stats.unrouted, (unsigned long long)stats.short_dlc,
+           (unsigned long long)stats.rejected);
+
+    /* 3. 套接字接入: 发送线程 sendmmsg, 接入端 recvmmsg */
+    int fds[2] = { -1, -1 };
+    const char *transport = "vcan0";
+    fds[0] = SmCanOpen(&can, "vcan0");
+    fds[1] = (fds[0] >= 0) ? SmCanOpen(NULL, "vcan0") : -1;
+    if (fds[1] < 0)
+    {
+        if (fds[0] >= 0)
+        {
+            close(fds[0]);
+        }
+        transport = "AF_UNIX datagram pair, no vcan0";
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) != 0)
+        {
+            printf("  can socket    : socketpair failed\n");
+            free(expect);
+            free(frames);
+            return -1;
+        }
+    }
+
+    BenchCanResetMotors(motors, machines);
+    SmCanInit(&can, motor_can_rules, sizeof(motor_can_rules) / sizeof(SmCanRule), machines, BENCH_CAN_NODES);
+    BenchCanWriter writer = { .fd = fds[1], .frames = frames, .count = BENCH_CAN_SOCKET };
+    SmOsThread thread;
+    uint64_t received = 0;
+    start = BenchNowNs();
+    SmOsThreadCreate(&thread, BenchCanWriterThread, &writer);
+    while (received < BENCH_CAN_SOCKET)
+    {
+        bool done = atomic_load(&writer.done);
+        int32_t n = SmCanReceive(&can, fds[0], true);
+        if (n < 0 || (n == 0 && done))
+        {
+            break;
+        }
+        if (n == 0)
+        {
+            SmOsYield();
+        }
+        received += (uint64_t)((n > 0) ? n : 0);
+    }
+    uint64_t elapsed = BenchNowNs() - start;
+    SmOsThreadJoin(&thread);
+    close(fds[0]);
+    close(fds[1]);
+    uint64_t socket_sum = BenchCanChecksum(motors);
+
+    /* vcan 接收缓冲区溢出时会丢帧, 此时不比较结果 */
+    bool socket_ok = (received == BENCH_CAN_SOCKET) ? (socket_sum == reference) : (strcmp(transport, "vcan0") == 0);
+    printf("  can socket    : %7.2f ns/frame over %s, %llu frames in %llu recvmmsg (%.1f per call)\n",
+           (double)elapsed / (received ? received : 1), transport, (unsigned long long)received,
+           (unsigned long long)can.stats.batches, (double)received / (can.stats.batches ? can.stats.batches : 1));
+    printf("  can check     : %u decode mismatches, socket ingest %s\n", mismatch,
+           (received == BENCH_CAN_SOCKET) ? (socket_ok ? "matches feed" : "MISMATCH") : "lost frames");
+
+    free(expect);
+    free(frames);
+    return (mismatch == 0 && socket_ok && stats.short_dlc == 0 && stats.rejected == 0) ? 0 : -1;
+}
+
+/* ============================================================================
+ * 共享内存观察
+ * ============================================================================ */
+
+/* 环形类: 每个事件前进一个状态, 快照满足 state == trans_count % BENCH_OBS_RING */
+static const SmTransition obs_ring_trans[BENCH_OBS_RING][2] = {
+    { SM_TRANS(0, 1), SM_TRANS_END() }, { SM_TRANS(0, 2), SM_TRANS_END() }, { SM_TRANS(0, 3), SM_TRANS_END() },
+    { SM_TRANS(0, 4), SM_TRANS_END() }, { SM_TRANS(0, 5), SM_TRANS_END() }, { SM_TRANS(0, 6), SM_TRANS_END() },
+    { SM_TRANS(0, 7), SM_TRANS_END() }, { SM_TRANS(0, 0), SM_TRANS_END() },
+};
+static const SmState obs_ring_states[BENCH_OBS_RING] = {
+    SM_STATE(0, "R0", NULL, NULL, NULL, obs_ring_trans[0]), SM_STATE(1, "R1", NULL, NULL, NULL, obs_ring_trans[1]),
+    SM_STATE(2, "R2", NULL, NULL, NULL, obs_ring_trans[2]), SM_STATE(3, "R3", NULL, NULL, NULL, obs_ring_trans[3]),
+    SM_STATE(4, "R4", NULL, NULL, NULL, obs_ring_trans[4]), SM_STATE(5, "R5", NULL, NULL, NULL, obs_ring_trans[5]),
+    SM_STATE(6, "R6", NULL, NULL, NULL, obs_ring_trans[6]), SM_STATE(7, "R7", NULL, NULL, NULL, obs_ring_trans[7]),
+};
+static const SmClass obs_ring_class = SM_CLASS_DEF("ObsRing", obs_ring_states, NULL, NULL);
+
+/**
+ * @brief 观察读者(独立只读映射, 与其他进程中的读者相同)
+ */
+typedef struct
+{
+    atomic_bool stop;  /* 写者已结束 */
+    atomic_bool ready; /* 读者已打开段 */
+    uint64_t reads;    /* 一致快照数 */
+    uint64_t busy;     /* 重试耗尽次数 */
+    uint64_t torn;     /* 不满足环形不变量的快照数 */
+} BenchObsReader;
+
+/**
+ * @brief 快照是否满足环形类的不变量
+ */
+static bool BenchObsConsistent(const SmObsSnapshot *snap)
+{
+    if (snap->state != (SmStateId)(snap->trans_count % BENCH_OBS_RING))
+    {
+        return false;
+    }
+    return snap->trans_count == 0 || snap->previous_state == (snap->state + BENCH_OBS_RING - 1) % BENCH_OBS_RING;
+}
+
+/**
+ * @brief 读者线程: 写者分发期间不停读取快照并检查不变量
+ */
+static void BenchObsReaderThread(void *arg)
+{
+    BenchObsReader *reader = (BenchObsReader *)arg;
+    SmObserver obs;
+    uint32_t seed = 0x0B5E4;
+
+    if (SmObserverOpen(&obs, BENCH_OBS_SHM) != SM_RET_OK)
+    {
+        atomic_store(&reader->ready, true);
+        return;
+    }
+    atomic_store(&reader->ready, true);
+
+    while (!atomic_load_explicit(&reader->stop, memory_order_relaxed))
+    {
+        SmObsSnapshot snap;
+        if (SmObserverRead(&obs, BenchRand(&seed) % BENCH_OBS_POOL, &snap) != SM_RET_OK)
+        {
+            reader->busy++;
+            continue;
+        }
+        reader->reads++;
+        reader->torn += !BenchObsConsistent(&snap);
+    }
+    SmObserverClose(&obs);
+}
+
+/**
+ * @brief 写者分发时另一个线程读取一致快照, 结束后计数与实例一致
+ */
+static int BenchObserver(void)
+{
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_OBS_POOL);
+    uint32_t *sent = calloc(BENCH_OBS_POOL, sizeof(uint32_t));
+    BenchObsReader reader = { .reads = 0, .busy = 0, .torn = 0 };
+    SmObserver obs;
+    SmOsThread thread;
+    uint32_t seed = 0x0B5E5;
+
+    atomic_init(&reader.stop, false);
+    atomic_init(&reader.ready, false);
+    SmObserverUnlink(BENCH_OBS_SHM);
+    if (SmObserverCreate(&obs, BENCH_OBS_SHM, BENCH_OBS_POOL, &obs_ring_class) != SM_RET_OK)
+    {
+        printf("  observer      : cannot create %s\n", BENCH_OBS_SHM);
+        free(sent);
+        free(pool);
+        return -1;
+    }
+
+    /* 1. 绑定只发布当前状态, 不计入变更次数 */
+    SmSetTimeFn(BenchNowUs);
+    for (uint32_t i = 0; i < BENCH_OBS_POOL; i++)
+    {
+        SmCreate(&pool[i], &obs_ring_class, NULL);
+        SmSetMachineId(&pool[i], i);
+        SmStart(&pool[i], 0);
+        SmObserverAttach(&obs, &pool[i]);
+    }
+
+    /* 2. 读者在另一个线程中独立映射同一个段 */
+    SmOsThreadCreate(&thread, BenchObsReaderThread, &reader);
+    while (!atomic_load(&reader.ready))
+    {
+        SmOsYield();
+    }
+
+    uint64_t start = BenchNowNs();
+    for (uint32_t i = 0; i < BENCH_OBS_EVENTS; i++)
+    {
+        uint32_t id = BenchRand(&seed) % BENCH_OBS_POOL;
+        SmSendEvent(&pool[id], 0);
+        sent[id]++;
+        if ((i & 1023u) == 0)
+        {
+            SmOsYield(); /* 单核时也让读者与写者交错 */
+        }
+    }
+    uint64_t elapsed = BenchNowNs() - start;
+    atomic_store(&reader.stop, true);
+    SmOsThreadJoin(&thread);
+
+    /* 3. 结束后每个槽位的变更次数等于发送的事件数, 按状态统计与实例一致 */
+    uint32_t wrong = 0;
+    uint32_t expect[BENCH_OBS_RING] = { 0 };
+    uint32_t counts[BENCH_OBS_RING];
+    for (uint32_t i = 0; i < BENCH_OBS_POOL; i++)
+    {
+        SmObsSnapshot snap;
+        wrong += (SmObserverRead(&obs, i, &snap) != SM_RET_OK || snap.trans_count != sent[i] ||
+                  snap.state != SmGetCurrentState(&pool[i]));
+        expect[SmGetCurrentState(&pool[i])]++;
+    }
+    uint32_t invalid = SmObserverCountStates(&obs, counts, BENCH_OBS_RING);
+    bool counts_ok = (invalid == 0 && memcmp(counts, expect, sizeof(counts)) == 0);
+
+    bool ok = (reader.reads > 0 && reader.torn == 0 && wrong == 0 && counts_ok);
+    printf("  observer      : %u events in %.1f ms, %llu snapshots read concurrently (%llu busy)\n",
+           BENCH_OBS_EVENTS, elapsed / 1e6, (unsigned long long)reader.reads, (unsigned long long)reader.busy);
+    printf("  obs check     : %llu torn, %u slots differ, state counts %s -> %s\n", (unsigned long long)reader.torn,
+           wrong, counts_ok ? "match" : "MISMATCH", ok ? "OK" : "FAIL");
+
+    for (uint32_t i = 0; i < BENCH_OBS_POOL; i++)
+    {
+        SmDestroy(&pool[i]);
+    }
+    SmSetTimeFn(NULL);
+    SmObserverClose(&obs);
+    SmObserverUnlink(BENCH_OBS_SHM);
+    free(sent);
+    free(pool);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 类热更新
+ * ============================================================================ */
+
+/* 版本 1: 六个状态的环; 版本 2: 状态ID倒排并删除 R5, R4 直接回到 R0 */
+static const SmTransition reload_v1_trans[6][2] = {
+    { SM_TRANS(0, 1), SM_TRANS_END() }, { SM_TRANS(0, 2), SM_TRANS_END() }, { SM_TRANS(0, 3), SM_TRANS_END() },
+    { SM_TRANS(0, 4), SM_TRANS_END() }, { SM_TRANS(0, 5), SM_TRANS_END() }, { SM_TRANS(0, 0), SM_TRANS_END() },
+};
+static const SmState reload_v1_states[] = {
+    SM_STATE(0, "R0", NULL, NULL, NULL, reload_v1_trans[0]), SM_STATE(1, "R1", NULL, NULL, NULL, reload_v1_trans[1]),
+    SM_STATE(2, "R2", NULL, NULL, NULL, reload_v1_trans[2]), SM_STATE(3, "R3", NULL, NULL, NULL, reload_v1_trans[3]),
+    SM_STATE(4, "R4", NULL, NULL, NULL, reload_v1_trans[4]), SM_STATE(5, "R5", NULL, NULL, NULL, reload_v1_trans[5]),
+};
+static const SmClass reload_v1_class = SM_CLASS_DEF("ReloadRing", reload_v1_states, NULL, NULL);
+
+static const SmTransition reload_v2_trans[5][2] = {
+    { SM_TRANS(0, 4), SM_TRANS_END() }, { SM_TRANS(0, 0), SM_TRANS_END() }, { SM_TRANS(0, 1), SM_TRANS_END() },
+    { SM_TRANS(0, 2), SM_TRANS_END() }, { SM_TRANS(0, 3), SM_TRANS_END() },
+};
+static const SmState reload_v2_states[] = {
+    SM_STATE(0, "R4", NULL, NULL, NULL, reload_v2_trans[0]), SM_STATE(1, "R3", NULL, NULL, NULL, reload_v2_trans[1]),
+    SM_STATE(2, "R2", NULL, NULL, NULL, reload_v2_trans[2]), SM_STATE(3, "R1", NULL, NULL, NULL, reload_v2_trans[3]),
+    SM_STATE(4, "R0", NULL, NULL, NULL, reload_v2_trans[4]),
+};
+static const SmClass reload_v2_class = SM_CLASS_DEF("ReloadRing", reload_v2_states, NULL, NULL);
+
+/* 版本 1 状态下标 -> 版本 2 状态ID, R5 被删除, 迁移到 R0 */
+static const SmStateId reload_v2_map[] = { 4, 3, 2, 1, 0, SM_STATE_INVALID };
+#define RELOAD_V2_FALLBACK 4
+
+/**
+ * @brief 一个分发线程
+ */
+typedef struct
+{
+    SmReloadDomain *domain;  /* 热更新域 */
+    SmReloadReader reader;   /* 本线程的读者 */
+    SmMachine *machines;     /* 本线程负责的实例 */
+    SmMachine **ptrs;        /* 实例指针(静止点迁移用) */
+    SmStateId *before;       /* 静止点之前的状态 */
+    uint64_t *entered;       /* 静止点之前的进入时间 */
+    atomic_uint *rounds;     /* 全部线程已完成的批数 */
+    uint32_t seed;           /* 事件随机种子 */
+    uint32_t migrated;       /* 迁移的实例数量 */
+    uint32_t fallback;       /* 迁移到删除状态回退目标的实例数量 */
+    uint32_t wrong;          /* 迁移后状态/进入时间不符的实例数量 */
+    SmRetCode registered;    /* 注册结果 */
+} BenchReloadWorker;
+
+/* 回收回调: 只统计(类为静态定义) */
+static const SmClass *g_reload_freed;
+static uint32_t g_reload_free_calls;
+
+static void BenchReloadFree(void *ctx, const SmClass *sm_class, const SmStateId *state_map)
+{
+    g_reload_freed = sm_class;
+    g_reload_free_calls++;
+}
+
+/**
+ * @brief 分发线程: 每批事件之后进入静止点, 迁移时逐个核对状态映射和进入时间
+ */
+static void BenchReloadThread(void *arg)
+{
+    BenchReloadWorker *worker = (BenchReloadWorker *)arg;
+    SmFleet fleet = { .machines = worker->ptrs, .count = BENCH_RELOAD_POOL };
+
+    /* 各线程同时注册, 然后用注册时的最新版本创建实例 */
+    worker->registered = SmReloadRegister(worker->domain, &worker->reader);
+    if (worker->registered != SM_RET_OK)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < BENCH_RELOAD_POOL; i++)
+    {
+        SmCreate(&worker->machines[i], worker->reader.version->sm_class, NULL);
+        SmStart(&worker->machines[i], (SmStateId)(i % 6));
+        worker->ptrs[i] = &worker->machines[i];
+    }
+
+    for (uint32_t round = 0; round < BENCH_RELOAD_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < BENCH_RELOAD_BATCH; i++)
+        {
+            SmSendEvent(&worker->machines[BenchRand(&worker->seed) % BENCH_RELOAD_POOL], 0);
+        }
+
+        for (uint32_t i = 0; i < BENCH_RELOAD_POOL; i++)
+        {
+            worker->before[i] = SmGetCurrentState(&worker->machines[i]);
+            worker->entered[i] = SmGetEnterTime(&worker->machines[i]);
+        }
+        uint32_t migrated = SmReloadQuiescent(worker->domain, &worker->reader, &fleet);
+        for (uint32_t i = 0; migrated > 0 && i < BENCH_RELOAD_POOL; i++)
+        {
+            SmStateId expect = reload_v2_map[worker->before[i]];
+            expect = (expect == SM_STATE_INVALID) ? RELOAD_V2_FALLBACK : expect;
+            worker->fallback += (reload_v2_map[worker->before[i]] == SM_STATE_INVALID);
+            worker->wrong += (worker->machines[i].sm_class != &reload_v2_class ||
+                              SmGetCurrentState(&worker->machines[i]) != expect ||
+                              SmGetEnterTime(&worker->machines[i]) != worker->entered[i]);
+        }
+        worker->migrated += migrated;
+        atomic_fetch_add(worker->rounds, 1);
+        SmOsYield();
+    }
+}
+
+/**
+ * @brief 两个分发线程运行中发布重排状态ID的新版本, 在静止点迁移, 回收旧版本
+ */
+static int BenchReload(void)
+{
+    static SmReloadDomain domain;
+    BenchReloadWorker workers[2];
+    SmOsThread threads[2];
+    atomic_uint rounds;
+
+    atomic_init(&rounds, 0);
+    g_reload_freed = NULL;
+    g_reload_free_calls = 0;
+    SmSetTimeFn(BenchNowUs);
+    SmReloadInit(&domain, &reload_v1_class, BenchReloadFree, NULL);
+
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].domain = &domain;
+        workers[t].machines = malloc(sizeof(SmMachine) * BENCH_RELOAD_POOL);
+        workers[t].ptrs = malloc(sizeof(SmMachine *) * BENCH_RELOAD_POOL);
+        workers[t].before = malloc(sizeof(SmStateId) * BENCH_RELOAD_POOL);
+        workers[t].entered = malloc(sizeof(uint64_t) * BENCH_RELOAD_POOL);
+        workers[t].rounds = &rounds;
+        workers[t].seed = 0x5E10AD + t;
+        SmOsThreadCreate(&threads[t], BenchReloadThread, &workers[t]);
+    }
+
+    /* 1. 运行一段时间后发布版本 2, 等两个线程都越过静止点后回收版本 1 */
+    while (atomic_load(&rounds) < BENCH_RELOAD_ROUNDS / 2)
+    {
+        SmOsYield();
+    }
+    uint32_t number = SmReloadPublish(&domain, &reload_v2_class, reload_v2_map,
+                                      sizeof(reload_v2_map) / sizeof(reload_v2_map[0]), RELOAD_V2_FALLBACK);
+    uint32_t reclaimed = 0;
+    while (reclaimed == 0 && atomic_load(&rounds) < 2 * BENCH_RELOAD_ROUNDS)
+    {
+        SmOsYield();
+        reclaimed += SmReloadReclaim(&domain);
+    }
+    SmOsThreadJoin(&threads[0]);
+    SmOsThreadJoin(&threads[1]);
+    reclaimed += SmReloadReclaim(&domain);
+
+    /* 2. 迁移后的实例继续在版本 2 上分发 */
+    uint32_t migrated = 0;
+    uint32_t fallback = 0;
+    uint32_t wrong = 0;
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        migrated += workers[t].migrated;
+        fallback += workers[t].fallback;
+        wrong += workers[t].wrong + (workers[t].registered != SM_RET_OK);
+        for (uint32_t i = 0; workers[t].registered == SM_RET_OK && i < BENCH_RELOAD_POOL; i++)
+        {
+            SmMachine *machine = &workers[t].machines[i];
+            SmStateId state = SmGetCurrentState(machine);
+            wrong += (machine->sm_class != &reload_v2_class || state < 0 || state > RELOAD_V2_FALLBACK);
+        }
+    }
+    bool readers_ok = (atomic_load(&domain.reader_count) == 2 && atomic_load(&domain.readers[0]) != NULL &&
+                       atomic_load(&domain.readers[1]) != NULL &&
+                       atomic_load(&domain.readers[0]) != atomic_load(&domain.readers[1]));
+    bool freed_ok = (reclaimed == 1 && g_reload_free_calls == 1 && g_reload_freed == &reload_v1_class);
+
+    bool ok = (number == 2 && migrated == 2 * BENCH_RELOAD_POOL && wrong == 0 && fallback > 0 &&
+               readers_ok && freed_ok);
+    printf("  reload        : version %u published mid-run, %u of %u migrated at quiescent points (%u to fallback)\n",
+           number, migrated, 2 * BENCH_RELOAD_POOL, fallback);
+    printf("  reload check  : %u wrong state/class/enter time, readers %s, version 1 %s -> %s\n", wrong,
+           readers_ok ? "distinct" : "LOST", freed_ok ? "reclaimed once" : "NOT RECLAIMED", ok ? "OK" : "FAIL");
+
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        for (uint32_t i = 0; workers[t].registered == SM_RET_OK && i < BENCH_RELOAD_POOL; i++)
+        {
+            SmDestroy(&workers[t].machines[i]);
+        }
+        free(workers[t].entered);
+        free(workers[t].before);
+        free(workers[t].ptrs);
+        free(workers[t].machines);
+    }
+    SmReloadDestroy(&domain);
+    SmSetTimeFn(NULL);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 阻塞式分发循环
+ * ============================================================================ */
+
+enum
+{
+    LOOP_EV_POST = 0, /* 其他线程投递的事件 */
+    LOOP_EV_TIMER,    /* 定时器事件 */
+};
+
+static atomic_ullong g_loop_posted_at; /* 最近一次投递的时间 */
+static atomic_uint g_loop_posts;       /* 分发的投递事件数量 */
+static atomic_ullong g_loop_fired_at;  /* 定时器事件分发时间(0 表示未触发) */
+static uint64_t g_loop_max_wake;       /* 投递到分发的最大延迟 */
+
+static SmRetCode LoopPostAction(SmHandle handle, void *user_data)
+{
+    uint64_t wake = SmGetTime() - atomic_load(&g_loop_posted_at);
+    g_loop_max_wake = (wake > g_loop_max_wake) ? wake : g_loop_max_wake;
+    atomic_fetch_add(&g_loop_posts, 1);
+    return SM_RET_OK;
+}
+
+static SmRetCode LoopTimerAction(SmHandle handle, void *user_data)
+{
+    atomic_store(&g_loop_fired_at, SmGetTime());
+    return SM_RET_OK;
+}
+
+static const SmTransition loop_probe_trans[] = {
+    SM_TRANS_ACTION(LOOP_EV_POST, 0, LoopPostAction, NULL),
+    SM_TRANS_ACTION(LOOP_EV_TIMER, 0, LoopTimerAction, NULL),
+    SM_TRANS_END(),
+};
+static const SmState loop_probe_states[] = {
+    SM_STATE(0, "PROBE", NULL, NULL, NULL, loop_probe_trans),
+};
+static const SmClass loop_probe_class = SM_CLASS_DEF("LoopProbe", loop_probe_states, NULL, NULL);
+
+static void BenchLoopThread(void *arg)
+{
+    SmLoopRun((SmLoop *)arg);
+}
+
+/**
+ * @brief 循环空闲阻塞时, 定时器按截止时间触发, 其他线程的投递立即唤醒循环
+ */
+static int BenchLoop(void)
+{
+    static SmLoopItem items[64];
+    SmTimer timers[4];
+    uint32_t heap_buf[4];
+    SmTimerHeap heap;
+    SmLoop loop;
+    SmMachine machine;
+    SmOsThread thread;
+
+    atomic_init(&g_loop_posted_at, 0);
+    atomic_init(&g_loop_posts, 0);
+    atomic_init(&g_loop_fired_at, 0);
+    g_loop_max_wake = 0;
+
+    SmTimerHeapInit(&heap, timers, heap_buf, 4);
+    if (SmLoopInit(&loop, items, 64, &heap, NULL) != SM_RET_OK)
+    {
+        printf("  loop          : init failed\n");
+        return -1;
+    }
+    SmCreate(&machine, &loop_probe_class, NULL);
+    SmStart(&machine, 0);
+
+    /* 1. 循环线程启动前登记定时器, 循环在没有事件时阻塞到截止时间 */
+    uint64_t deadline = SmGetTime() + BENCH_LOOP_TIMER;
+    SmTimerStart(&heap, &machine, LOOP_EV_TIMER, deadline);
+    SmOsThreadCreate(&thread, BenchLoopThread, &loop);
+    while (atomic_load(&g_loop_fired_at) == 0 && SmGetTime() < deadline + BENCH_LOOP_SLACK * 4)
+    {
+        usleep(1000);
+    }
+    uint64_t fired_at = atomic_load(&g_loop_fired_at);
+    uint64_t late = (fired_at >= deadline) ? fired_at - deadline : 0;
+
+    /* 2. 每次投递前让循环回到阻塞, 投递唤醒它 */
+    uint32_t posted = 0;
+    for (uint32_t i = 0; i < BENCH_LOOP_POSTS; i++)
+    {
+        usleep(1000);
+        atomic_store(&g_loop_posted_at, SmGetTime());
+        posted += (SmLoopPost(&loop, &machine, LOOP_EV_POST) == SM_RET_OK);
+        uint64_t wait_start = SmGetTime();
+        while (atomic_load(&g_loop_posts) < posted && SmGetTime() - wait_start < BENCH_LOOP_SLACK * 4)
+        {
+            SmOsYield();
+        }
+    }
+
+    SmLoopStop(&loop);
+    SmOsThreadJoin(&thread);
+
+    uint32_t handled = atomic_load(&g_loop_posts);
+    bool ok = (fired_at != 0 && fired_at >= deadline && late <= BENCH_LOOP_SLACK && handled == BENCH_LOOP_POSTS &&
+               g_loop_max_wake <= BENCH_LOOP_SLACK && loop.stats.wakeups > 0 && loop.stats.fired == 1);
+    printf("  loop          : timer fired %llu us after deadline while idle, %u posts woke the loop "
+           "(max %llu us), %llu sleeps, %llu wakeups\n",
+           (unsigned long long)late, handled, (unsigned long long)g_loop_max_wake,
+           (unsigned long long)loop.stats.sleeps, (unsigned long long)loop.stats.wakeups);
+    printf("  loop check    : %s\n", ok ? "OK" : "FAIL");
+
+    SmDestroy(&machine);
+    SmLoopDeinit(&loop);
+    SmSetTimeFn(NULL);
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 预编译镜像检查
+ * ============================================================================ */
+
+/**
+ * @brief 复制镜像并在末尾追加 8 字节后篡改一处, 返回加载结果
+ * @param mode 0 末尾为合法事件列表(对照), 1 事件列表无结束标记, 2 转换目标不存在, 3 转换表槽位越界
+ */
+static SmRetCode BenchImageTamper(const SmImageBlob *blob, const SmImageSymbol *symbols, uint32_t symbol_count,
+                                  int mode, char *error, size_t error_size)
+{
+    size_t size = blob->size + 8;
+    uint8_t *data = malloc(size);
+    SmImage image;
+
+    memcpy(data, blob->data, blob->size);
+    SmImageHeader *h = (SmImageHeader *)data;
+    SmImageState *is = (SmImageState *)(data + h->states);
+    SmImageTrans *it = (SmImageTrans *)(data + h->transitions);
+    SmEventId *tail = (SmEventId *)(data + blob->size);
+
+    h->image_size = (uint32_t)size;
+    tail[0] = 0;
+    tail[1] = (mode == 1) ? 1 : SM_EVENT_INVALID;
+    is[0].handle_events = (uint32_t)blob->size;
+    if (mode == 2)
+    {
+        it[0].next_state = 12345;
+    }
+    if (mode == 3)
+    {
+        SmTableSlot *slots = (SmTableSlot *)(data + h->table_slots);
+        for (uint32_t i = 0; i < h->slot_count; i++)
+        {
+            if (slots[i].check != SM_TABLE_EMPTY)
+            {
+                slots[i].check = h->state_count;
+                break;
+            }
+        }
+    }
+
+    SmRetCode ret = SmImageLoad(&image, data, size, symbols, symbol_count, 0);
+    snprintf(error, error_size, "%s", (ret == SM_RET_OK) ? "" : image.error);
+    if (ret == SM_RET_OK)
+    {
+        SmImageClose(&image);
+    }
+    free(data);
+    return ret;
+}
+
+/**
+ * @brief 镜像加载耗时(O(状态数 + 转换数)), 往返后分发结果一致, 篡改的镜像被拒绝
+ */
+static int BenchImage(const SmClass *sm_class, const SmEventId *events, uint32_t count, SmStateId expect)
+{
+    SmImageBlob blob;
+    SmImage image;
+
+    if (SmImageBuildFromClass(sm_class, NULL, 0, NULL, &blob) != SM_RET_OK)
+    {
+        printf("  image         : build failed (%s)\n", blob.error);
+        return -1;
+    }
+
+    /* 1. 加载耗时 */
+    uint64_t load_ns = 0;
+    bool loaded = true;
+    for (uint32_t i = 0; i < BENCH_IMAGE_LOADS && loaded; i++)
+    {
+        uint64_t start = BenchNowNs();
+        loaded = (SmImageLoad(&image, blob.data, blob.size, NULL, 0, 0) == SM_RET_OK);
+        load_ns += BenchNowNs() - start;
+        if (loaded && i + 1 < BENCH_IMAGE_LOADS)
+        {
+            SmImageClose(&image);
+        }
+    }
+    if (!loaded)
+    {
+        printf("  image         : load failed (%s)\n", image.error);
+        SmImageBlobFree(&blob);
+        return -1;
+    }
+    const SmImageHeader *h = image.header;
+    uint32_t elements = (uint32_t)h->state_count + h->trans_count + h->any_count;
+    double load_us = (double)load_ns / BENCH_IMAGE_LOADS / 1e3;
+    printf("  image load    : %zu bytes, %.1f us/load (%.2f ns per state+transition, %u elements)\n", blob.size,
+           load_us, load_us * 1e3 / elements, elements);
+
+    /* 2. 往返: 加载的类与原类分发结果一致 */
+    SmStateId image_state;
+    double image_ns = BenchDispatch(&image.sm_class, events, count, &image_state);
+    printf("  image dispatch: %7.2f ns/event\n", image_ns);
+    SmImageClose(&image);
+    SmImageBlobFree(&blob);
+
+    /* 3. 篡改检查(不校验校验和, 由逐元素检查拒绝) */
+    static const SmImageSymbol symbols[] = { SM_IMAGE_FN(BenchInterestHandle) };
+    static const char *const cases[] = { "control", "list", "target", "slot" };
+    int rejected = 0;
+    bool control_ok = false;
+    if (SmImageBuildFromClass(&bench_interest_class, symbols, 1, NULL, &blob) != SM_RET_OK)
+    {
+        printf("  image         : build failed (%s)\n", blob.error);
+        return -1;
+    }
+    for (int mode = 0; mode < 4; mode++)
+    {
+        char error[96];
+        SmRetCode ret = BenchImageTamper(&blob, symbols, 1, mode, error, sizeof(error));
+        if (mode == 0)
+        {
+            control_ok = (ret == SM_RET_OK);
+            continue;
+        }
+        rejected += (ret != SM_RET_OK);
+        printf("  image tamper  : %-7s -> %s\n", cases[mode], (ret != SM_RET_OK) ? error : "accepted");
+    }
+    SmImageBlobFree(&blob);
+
+    bool ok = (image_state == expect && control_ok && rejected == 3);
+    printf("  image check   : round trip %s, %d of 3 tampered images rejected -> %s\n",
+           (image_state == expect) ? "matches" : "MISMATCH", rejected, ok ? "OK" : "FAIL");
+    return ok ? 0 : -1;
+}
+
+/* ============================================================================
+ * 基准主函数
+ * ============================================================================ */
+
+int bench(void)
+{
+    SmClass *sm_class = BenchGenClass(0x12345678);
+    SmEventId *events = malloc(sizeof(SmEventId) * BENCH_EVENTS);
+    uint32_t seed = 0x9E3779B9;
+
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++)
+    {
+        events[i] = (SmEventId)(BenchRand(&seed) % BENCH_EVENT_COUNT);
+    }
+
+    printf("SmMgr bench: %d states, %d events, %d dispatches\n",
+           BENCH_STATE_COUNT, BENCH_EVENT_COUNT, BENCH_EVENTS);
+
+    /* 1. 线性查找 */
+    SmStateId linear_state;
+    double linear_ns = BenchDispatch(sm_class, events, BENCH_EVENTS, &linear_state);
+    printf("  linear search : %7.2f ns/event\n", linear_ns);
+
+    /* 2. 压缩转换表 */
+    SmTable table;
+    size_t buf_size = SmTableCalcSize(sm_class);
+    void *buf = malloc(buf_size);
+    uint64_t build_start = BenchNowNs();
+    if (SmTableBuild(&table, sm_class, buf, buf_size) != SM_RET_OK)
+    {
+        printf("  table build failed\n");
+        return -1;
+    }
+    uint64_t build_ns = BenchNowNs() - build_start;
+    sm_class->table = &table;
+
+    SmStateId table_state;
+    double table_ns = BenchDispatch(sm_class, events, BENCH_EVENTS, &table_state);
+    printf("  compressed    : %7.2f ns/event (build %.1f ms)\n", table_ns, build_ns / 1e6);
+
+    /* 3. 内存占用 */
+    size_t bytes = SmTableGetBytes(&table);
+    size_t dense = sizeof(uint16_t) * BENCH_STATE_COUNT * BENCH_EVENT_COUNT;
+    printf("  transitions   : %u, slots %u (fill %.1f%%)\n",
+           table.trans_count, table.slot_count, 100.0 * table.trans_count / table.slot_count);
+    size_t bitmap = sizeof(uint32_t) * table.interest_words * table.state_count;
+    printf("  table bytes   : %zu (%.2f bytes/transition), dense matrix %zu (%.2f bytes/transition)\n",
+           bytes - bitmap, (double)(bytes - bitmap) / table.trans_count, dense, (double)dense / table.trans_count);
+    printf("  interest bits : %zu bytes\n", bitmap);
+    printf("  result check  : %s\n", (linear_state == table_state) ? "OK" : "MISMATCH");
+    int interest_ok = BenchInterest();
+
+    /* 4. 广播: 大部分实例对事件不感兴趣 */
+    SmMachine *pool = malloc(sizeof(SmMachine) * BENCH_FLEET);
+    SmFleet fleet = { .machines = malloc(sizeof(SmMachine *) * BENCH_FLEET), .count = BENCH_FLEET };
+    uint32_t delivered;
+    double bcast_ns = BenchBroadcast(sm_class, pool, &fleet, 7, &delivered);
+    printf("  broadcast     : %7.2f ns/instance, %u of %u delivered (bitmap)\n", bcast_ns, delivered, BENCH_FLEET);
+    sm_class->table = NULL;
+    bcast_ns = BenchBroadcast(sm_class, pool, &fleet, 7, &delivered);
+    printf("  broadcast     : %7.2f ns/instance, %u of %u delivered (no table)\n", bcast_ns, delivered, BENCH_FLEET);
+    free(fleet.machines);
+    free(pool);
+
+    /* 5. 记录与回放 */
+    sm_class->table = &table;
+    int replay_ok = BenchRecordReplay(sm_class, events, BENCH_EVENTS);
+
+    /* 6. 合成负载 */
+    BenchWorkload(sm_class);
+
+    /* 7. 虚拟时间仿真 */
+    int sim_ok = BenchSimulate();
+
+    /* 8. 停留时间监视 */
+    int wd_ok = BenchWatchdog();
+
+    /* 9. 状态成员索引 */
+    int pop_ok = BenchPopIndex(sm_class, events, BENCH_EVENTS);
+
+    /* 10. 准入控制 */
+    int storm_ok = BenchStorm();
+
+    /* 11. 转换种类 */
+    int kind_ok = BenchKinds();
+
+    /* 12. 热备复制 */
+    int repl_ok = BenchRepl(sm_class, events, BENCH_EVENTS);
+
+    /* 13. 克隆与推演 */
+    int spec_ok = BenchSpeculate(sm_class, events, BENCH_EVENTS);
+    int spec_adm_ok = BenchSpecAdmission();
+
+    /* 14. 名称索引 */
+    int names_ok = BenchNames(sm_class);
+
+    /* 15. 可达性分析 */
+    int explore_ok = BenchExplore(sm_class, events, BENCH_EVENTS);
+
+    /* 16. CAN 帧接入 */
+    int can_ok = BenchCan();
+
+    /* 17. 共享内存观察 */
+    int obs_ok = BenchObserver();
+
+    /* 18. 类热更新 */
+    int reload_ok = BenchReload();
+
+    /* 19. 阻塞式分发循环 */
+    int loop_ok = BenchLoop();
+
+    /* 20. 预编译镜像 */
+    int image_ok = BenchImage(sm_class, events, BENCH_EVENTS, linear_state);
+
+    free(buf);
+    free(events);
+    return (linear_state == table_state && interest_ok == 0 && replay_ok == 0 && sim_ok == 0 && wd_ok == 0 && pop_ok == 0 &&
+            storm_ok == 0 && kind_ok == 0 &&
+            repl_ok == 0 && spec_ok == 0 && spec_adm_ok == 0 && names_ok == 0 && explore_ok == 0 &&
+            can_ok == 0 && obs_ok == 0 && reload_ok == 0 && loop_ok == 0 &&
+            image_ok == 0) ? 0 : -1;
+}
@@ -4,7 +4,15 @@
  */
 
 #include "SmMgr.h"
+#include "SmOutbox.h"
+#include "SmImage.h"
+#include "SmNames.h"
+#include "SmExplore.h"
+#include "SmAdmission.h"
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "alog/alog.h"
 
 /* ============================================================================
@@ -19,6 +27,8 @@ enum
     STATE_AUTHENTICATED,    /* 已认证 */
     STATE_RECONNECTING,     /* 重连中 */
     STATE_ERROR,            /* 错误状态 */
+    STATE_SESSION,          /* 会话(组合状态: 已连接/认证中/已认证) */
+    STATE_SESSION_HISTORY,  /* 会话历史伪状态 */
     STATE_MAX
 };
 
@@ -41,6 +51,21 @@ enum
     EVT_MAX
 };
 
+/* 事件名称(转换日志及控制面按名称下发命令) */
+static const char *const tcp_event_names[EVT_MAX] = {
+    [EVT_CONNECT] = "CONNECT",
+    [EVT_CONNECT_OK] = "CONNECT_OK",
+    [EVT_CONNECT_FAIL] = "CONNECT_FAIL",
+    [EVT_DISCONNECT] = "DISCONNECT",
+    [EVT_REMOTE_CLOSE] = "REMOTE_CLOSE",
+    [EVT_SEND_AUTH] = "SEND_AUTH",
+    [EVT_AUTH_OK] = "AUTH_OK",
+    [EVT_AUTH_FAIL] = "AUTH_FAIL",
+    [EVT_TIMEOUT] = "TIMEOUT",
+    [EVT_NETWORK_ERROR] = "NETWORK_ERROR",
+    [EVT_RECONNECT] = "RECONNECT",
+};
+
 /* ============================================================================
  * 用户数据结构体
  * ============================================================================ */
@@ -70,25 +95,6 @@ typedef struct
  * 日志相关函数
  * ============================================================================ */
 
-/**
- * @brief 获取事件名称
- */
-static const char *GetEventName(SmEventId event_id)
-{
-    static const char *event_names[] = {
-        "CONNECT", "CONNECT_OK", "CONNECT_FAIL", "DISCONNECT",
-        "REMOTE_CLOSE", "SEND_AUTH", "AUTH_OK", "AUTH_FAIL",
-        "TIMEOUT", "NETWORK_ERROR", "RECONNECT"
-    };
-
-    if (event_id >= 0 && event_id < (SmEventId)(sizeof(event_names) / sizeof(event_names[0])))
-    {
-        return event_names[event_id];
-    }
-
-    return "UNKNOWN";
-}
-
 /**
  * @brief 状态转换日志回调
  */
@@ -143,9 +149,36 @@ static bool ShouldReconnect(SmHandle handle, void *user_data)
  * 转换动作函数
  * ============================================================================ */
 
+/* Fleet-wide pacing of (re)connects, shared by every session of the class */
+static SmAdmission tcp_connect_admission;
+
+/* Monotonic microsecond clock for the admission controller */
+static uint64_t DemoNowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* Paced-out attempts are not started; EVT_TIMEOUT is re-sent after a jittered backoff */
+static bool PaceConnect(TcpSessionSm *tcp_sm)
+{
+    if (SmAdmitMachine(&tcp_connect_admission, &tcp_sm->sm))
+    {
+        return true;
+    }
+    ALOG_E("[Action] Connect paced out by admission control, retry later");
+    return false;
+}
+
 static SmRetCode OnConnectAction(SmHandle handle, void *user_data)
 {
-    TcpSessionData *data = (TcpSessionData *)user_data;
+    TcpSessionSm   *tcp_sm = (TcpSessionSm *)handle;
+    TcpSessionData *data = &tcp_sm->session_data;
+    if (!PaceConnect(tcp_sm))
+    {
+        return SM_RET_OK;
+    }
     ALOG_E("[Action] OnConnectAction: Initiate TCP connect %s:%d", data->server_ip, data->server_port);
     data->connect_retry_count++;
     return SM_RET_OK;
@@ -156,6 +189,11 @@ static SmRetCode OnDisconnectAction(SmHandle handle, void *user_data)
     TcpSessionSm   *tcp_sm = (TcpSessionSm *)handle;
     TcpSessionData *data = &tcp_sm->session_data;
     ALOG_E("[Action] OnDisconnectAction: Close socket fd=%d", data->socket_fd);
+    SmOutbox *outbox = SmGetOutbox(&tcp_sm->sm);
+    if (outbox != NULL && SmOutboxClose(outbox, data->socket_fd) != SM_RET_OK)
+    {
+        return SM_RET_ERROR;
+    }
     data->socket_fd = -1;
     data->connect_retry_count = 0;
     data->auth_retry_count = 0;
@@ -167,6 +205,15 @@ static SmRetCode OnSendAuthAction(SmHandle handle, void *user_data)
     TcpSessionSm   *tcp_sm = (TcpSessionSm *)handle;
     TcpSessionData *data = &tcp_sm->session_data;
     ALOG_E("[Action] OnSendAuthAction: Send auth data socket=%d", data->socket_fd);
+    SmOutbox *outbox = SmGetOutbox(&tcp_sm->sm);
+    if (outbox != NULL)
+    {
+        static const char auth_req[] = "AUTH demo\n";
+        if (SmOutboxSend(outbox, data->socket_fd, auth_req, sizeof(auth_req) - 1) != SM_RET_OK)
+        {
+            return SM_RET_ERROR; /* Outbox full: transition does not happen */
+        }
+    }
     data->auth_retry_count++;
     return SM_RET_OK;
 }
@@ -179,6 +226,7 @@ static SmRetCode OnReconnectStartAction(SmHandle handle, void *user_data)
     data->reconnect_count++;
     data->connect_retry_count = 0;
     data->auth_retry_count = 0;
+    PaceConnect(tcp_sm);
     return SM_RET_OK;
 }
 
@@ -387,7 +435,7 @@ static SmRetCode Error_OnHandle(SmHandle handle, SmEventId event)
  * ============================================================================ */
 
 /* DISCONNECTED state transitions */
-static SmTransition disconnected_transitions[] = {
+static const SmTransition disconnected_transitions[] = {
     /* Initiate connection */
     SM_TRANS_ACTION(EVT_CONNECT, STATE_CONNECTING, OnConnectAction, NULL),
 
@@ -396,61 +444,52 @@ static SmTransition disconnected_transitions[] = {
 };
 
 /* CONNECTING state transitions */
-static SmTransition connecting_transitions[] = {
+static const SmTransition connecting_transitions[] = {
     /* Connect success -> Connected */
     SM_TRANS(EVT_CONNECT_OK, STATE_CONNECTED),
 
-    /* Connect failed, retry if condition met */
-    SM_TRANS_FULL(EVT_CONNECT_FAIL, STATE_CONNECTING, CanRetryConnect, OnConnectAction, NULL),
+    /* Connect failed, retry in place if condition met (no exit/enter) */
+    SM_TRANS_INTERNAL(EVT_CONNECT_FAIL, CanRetryConnect, OnConnectAction, NULL),
 
     /* Timeout, retry if condition met */
-    SM_TRANS_FULL(EVT_TIMEOUT, STATE_CONNECTING, CanRetryConnect, OnConnectAction, NULL),
-
-    /* Condition not met or network error -> Error state */
-    SM_TRANS(EVT_NETWORK_ERROR, STATE_ERROR),
-    SM_TRANS(EVT_DISCONNECT, STATE_DISCONNECTED),
+    SM_TRANS_INTERNAL(EVT_TIMEOUT, CanRetryConnect, OnConnectAction, NULL),
 
     /* End marker */
     SM_TRANS_END()
 };
 
 /* CONNECTED state transitions */
-static SmTransition connected_transitions[] = {
+static const SmTransition connected_transitions[] = {
     /* Send auth */
     SM_TRANS_ACTION(EVT_SEND_AUTH, STATE_AUTHENTICATING, OnSendAuthAction, NULL),
 
     /* Active disconnect */
     SM_TRANS_ACTION(EVT_DISCONNECT, STATE_DISCONNECTED, OnDisconnectAction, NULL),
 
-    /* Remote close or network error */
+    /* Remote close (network error uses the class-wide rule) */
     SM_TRANS(EVT_REMOTE_CLOSE, STATE_ERROR),
-    SM_TRANS(EVT_NETWORK_ERROR, STATE_ERROR),
 
     /* End marker */
     SM_TRANS_END()
 };
 
 /* AUTHENTICATING state transitions */
-static SmTransition authenticating_transitions[] = {
+static const SmTransition authenticating_transitions[] = {
     /* Auth success -> Authenticated */
     SM_TRANS(EVT_AUTH_OK, STATE_AUTHENTICATED),
 
-    /* Auth failed, retry if condition met */
-    SM_TRANS_FULL(EVT_AUTH_FAIL, STATE_AUTHENTICATING, CanRetryAuth, OnSendAuthAction, NULL),
+    /* Auth failed, retry in place if condition met (no exit/enter) */
+    SM_TRANS_INTERNAL(EVT_AUTH_FAIL, CanRetryAuth, OnSendAuthAction, NULL),
 
     /* Timeout, retry if condition met */
-    SM_TRANS_FULL(EVT_TIMEOUT, STATE_AUTHENTICATING, CanRetryAuth, OnSendAuthAction, NULL),
-
-    /* Condition not met -> Error state */
-    SM_TRANS(EVT_NETWORK_ERROR, STATE_ERROR),
-    SM_TRANS(EVT_DISCONNECT, STATE_DISCONNECTED),
+    SM_TRANS_INTERNAL(EVT_TIMEOUT, CanRetryAuth, OnSendAuthAction, NULL),
 
     /* 结束标记 */
     SM_TRANS_END()
 };
 
 /* AUTHENTICATED state transitions */
-static SmTransition authenticated_transitions[] = {
+static const SmTransition authenticated_transitions[] = {
     /* Remote close, reconnect if condition met */
     SM_TRANS_FULL(EVT_REMOTE_CLOSE, STATE_RECONNECTING, ShouldReconnect, OnReconnectStartAction, NULL),
 
@@ -465,26 +504,22 @@ static SmTransition authenticated_transitions[] = {
 };
 
 /* RECONNECTING state transitions */
-static SmTransition reconnecting_transitions[] = {
-    /* Reconnect success -> Connected */
-    SM_TRANS(EVT_CONNECT_OK, STATE_CONNECTED),
+static const SmTransition reconnecting_transitions[] = {
+    /* Reconnect success -> resume where the session left off */
+    SM_TRANS(EVT_CONNECT_OK, STATE_SESSION_HISTORY),
 
-    /* Reconnect failed, retry if condition met */
-    SM_TRANS_FULL(EVT_CONNECT_FAIL, STATE_RECONNECTING, CanRetryConnect, OnConnectAction, NULL),
+    /* Reconnect failed, retry in place if condition met (no exit/enter) */
+    SM_TRANS_INTERNAL(EVT_CONNECT_FAIL, CanRetryConnect, OnConnectAction, NULL),
 
     /* Timeout, retry if condition met */
-    SM_TRANS_FULL(EVT_TIMEOUT, STATE_RECONNECTING, CanRetryConnect, OnConnectAction, NULL),
-
-    /* Condition not met or network error -> Error state */
-    SM_TRANS(EVT_NETWORK_ERROR, STATE_ERROR),
-    SM_TRANS(EVT_DISCONNECT, STATE_DISCONNECTED),
+    SM_TRANS_INTERNAL(EVT_TIMEOUT, CanRetryConnect, OnConnectAction, NULL),
 
     /* End marker */
     SM_TRANS_END()
 };
 
 /* ERROR state transitions */
-static SmTransition error_transitions[] = {
+static const SmTransition error_transitions[] = {
     /* Can reconnect from error state */
     SM_TRANS_ACTION(EVT_CONNECT, STATE_CONNECTING, OnConnectAction, NULL),
 
@@ -492,17 +527,43 @@ static SmTransition error_transitions[] = {
     SM_TRANS_END()
 };
 
+/* Class-wide transitions, used when a state has no matching row.
+ * AUTHENTICATED and CONNECTED override them with their own rows,
+ * DISCONNECTED and ERROR opt out. */
+static const SmTransition tcp_any_transitions[] = {
+    /* Network error -> Error state */
+    SM_TRANS(EVT_NETWORK_ERROR, STATE_ERROR),
+
+    /* Active disconnect */
+    SM_TRANS(EVT_DISCONNECT, STATE_DISCONNECTED),
+
+    /* End marker */
+    SM_TRANS_END()
+};
+
+/* Events each on_handle cares about (others skip on_handle entirely) */
+static const SmEventId disconnected_handles[] = { EVT_CONNECT_OK, SM_EVENT_INVALID };
+static const SmEventId connecting_handles[] = { EVT_CONNECT_OK, EVT_CONNECT_FAIL, EVT_TIMEOUT, SM_EVENT_INVALID };
+static const SmEventId authenticating_handles[] = { EVT_AUTH_OK, EVT_AUTH_FAIL, EVT_TIMEOUT, SM_EVENT_INVALID };
+static const SmEventId authenticated_handles[] = { EVT_REMOTE_CLOSE, EVT_NETWORK_ERROR, EVT_TIMEOUT, SM_EVENT_INVALID };
+static const SmEventId reconnecting_handles[] = { EVT_CONNECT_OK, EVT_CONNECT_FAIL, EVT_TIMEOUT, SM_EVENT_INVALID };
+
+/* Events held while the link is not up yet (re-sent once connected) */
+static const SmEventId link_down_defers[] = { EVT_SEND_AUTH, SM_EVENT_INVALID };
+
 /* ============================================================================
  * State Table Definition
  * ============================================================================ */
-static SmState tcp_states[] = {
-    SM_STATE(STATE_DISCONNECTED, "DISCONNECTED", Disconnected_OnEnter, Disconnected_OnExit, Disconnected_OnHandle, disconnected_transitions),
-    SM_STATE(STATE_CONNECTING, "CONNECTING", Connecting_OnEnter, Connecting_OnExit, Connecting_OnHandle, connecting_transitions),
-    SM_STATE(STATE_CONNECTED, "CONNECTED", Connected_OnEnter, Connected_OnExit, Connected_OnHandle, connected_transitions),
-    SM_STATE(STATE_AUTHENTICATING, "AUTHENTICATING", Authenticating_OnEnter, Authenticating_OnExit, Authenticating_OnHandle, authenticating_transitions),
-    SM_STATE(STATE_AUTHENTICATED, "AUTHENTICATED", Authenticated_OnEnter, Authenticated_OnExit, Authenticated_OnHandle, authenticated_transitions),
-    SM_STATE(STATE_RECONNECTING, "RECONNECTING", Reconnecting_OnEnter, Reconnecting_OnExit, Reconnecting_OnHandle, reconnecting_transitions),
-    SM_STATE(STATE_ERROR, "ERROR", Error_OnEnter, Error_OnExit, Error_OnHandle, error_transitions),
+static const SmState tcp_states[] = {
+    SM_STATE(STATE_DISCONNECTED, "DISCONNECTED", Disconnected_OnEnter, Disconnected_OnExit, Disconnected_OnHandle, disconnected_transitions, SM_STATE_NO_ANY(), SM_STATE_HANDLES(disconnected_handles)),
+    SM_STATE(STATE_CONNECTING, "CONNECTING", Connecting_OnEnter, Connecting_OnExit, Connecting_OnHandle, connecting_transitions, SM_STATE_HANDLES(connecting_handles), SM_STATE_DEFER(link_down_defers)),
+    SM_STATE(STATE_CONNECTED, "CONNECTED", Connected_OnEnter, Connected_OnExit, Connected_OnHandle, connected_transitions, SM_STATE_PARENT(STATE_SESSION)),
+    SM_STATE(STATE_AUTHENTICATING, "AUTHENTICATING", Authenticating_OnEnter, Authenticating_OnExit, Authenticating_OnHandle, authenticating_transitions, SM_STATE_HANDLES(authenticating_handles), SM_STATE_PARENT(STATE_SESSION)),
+    SM_STATE(STATE_AUTHENTICATED, "AUTHENTICATED", Authenticated_OnEnter, Authenticated_OnExit, Authenticated_OnHandle, authenticated_transitions, SM_STATE_HANDLES(authenticated_handles), SM_STATE_PARENT(STATE_SESSION)),
+    SM_STATE(STATE_RECONNECTING, "RECONNECTING", Reconnecting_OnEnter, Reconnecting_OnExit, Reconnecting_OnHandle, reconnecting_transitions, SM_STATE_HANDLES(reconnecting_handles), SM_STATE_DEFER(link_down_defers)),
+    SM_STATE(STATE_ERROR, "ERROR", Error_OnEnter, Error_OnExit, Error_OnHandle, error_transitions, SM_STATE_NO_ANY()),
+    SM_COMPOSITE(STATE_SESSION, "SESSION", NULL, NULL, STATE_CONNECTED),
+    SM_HISTORY(STATE_SESSION_HISTORY, "SESSION_H", STATE_SESSION, STATE_CONNECTED),
 };
 
 /* ============================================================================
@@ -536,7 +597,39 @@ static SmRetCode Tcp_OnDeinit(SmHandle handle)
     return SM_RET_OK;
 }
 
-static const SmClass tcp_sm_class = SM_CLASS_DEF("TcpSessionSm", tcp_states, Tcp_OnInit, Tcp_OnDeinit);
+/* Event priority lanes: control events must not wait behind timeout ticks */
+static const uint8_t tcp_event_lanes[EVT_MAX] = {
+    [EVT_CONNECT] = SM_LANE_NORMAL,
+    [EVT_CONNECT_OK] = SM_LANE_NORMAL,
+    [EVT_CONNECT_FAIL] = SM_LANE_NORMAL,
+    [EVT_DISCONNECT] = SM_LANE_CTRL,
+    [EVT_REMOTE_CLOSE] = SM_LANE_HIGH,
+    [EVT_SEND_AUTH] = SM_LANE_NORMAL,
+    [EVT_AUTH_OK] = SM_LANE_NORMAL,
+    [EVT_AUTH_FAIL] = SM_LANE_NORMAL,
+    [EVT_TIMEOUT] = SM_LANE_LOW,
+    [EVT_NETWORK_ERROR] = SM_LANE_HIGH,
+    [EVT_RECONNECT] = SM_LANE_NORMAL,
+};
+
+static const SmClass tcp_sm_class = SM_CLASS_DEF("TcpSessionSm", tcp_states, Tcp_OnInit, Tcp_OnDeinit,
+                                                 SM_CLASS_LANES(tcp_event_lanes), SM_CLASS_ANY(tcp_any_transitions),
+                                                 SM_CLASS_EVENT_NAMES(tcp_event_names));
+
+/* Symbols a class image may reference (callbacks are resolved by name at load time) */
+static const SmImageSymbol tcp_symbols[] = {
+    SM_IMAGE_FN(Tcp_OnInit), SM_IMAGE_FN(Tcp_OnDeinit),
+    SM_IMAGE_FN(CanRetryConnect), SM_IMAGE_FN(CanRetryAuth), SM_IMAGE_FN(ShouldReconnect),
+    SM_IMAGE_FN(OnConnectAction), SM_IMAGE_FN(OnDisconnectAction), SM_IMAGE_FN(OnSendAuthAction),
+    SM_IMAGE_FN(OnReconnectStartAction),
+    SM_IMAGE_FN(Disconnected_OnEnter), SM_IMAGE_FN(Disconnected_OnExit), SM_IMAGE_FN(Disconnected_OnHandle),
+    SM_IMAGE_FN(Connecting_OnEnter), SM_IMAGE_FN(Connecting_OnExit), SM_IMAGE_FN(Connecting_OnHandle),
+    SM_IMAGE_FN(Connected_OnEnter), SM_IMAGE_FN(Connected_OnExit), SM_IMAGE_FN(Connected_OnHandle),
+    SM_IMAGE_FN(Authenticating_OnEnter), SM_IMAGE_FN(Authenticating_OnExit), SM_IMAGE_FN(Authenticating_OnHandle),
+    SM_IMAGE_FN(Authenticated_OnEnter), SM_IMAGE_FN(Authenticated_OnExit), SM_IMAGE_FN(Authenticated_OnHandle),
+    SM_IMAGE_FN(Reconnecting_OnEnter), SM_IMAGE_FN(Reconnecting_OnExit), SM_IMAGE_FN(Reconnecting_OnHandle),
+    SM_IMAGE_FN(Error_OnEnter), SM_IMAGE_FN(Error_OnExit), SM_IMAGE_FN(Error_OnHandle),
+};
 
 /* ============================================================================
  * Demo主函数
@@ -544,12 +637,24 @@ static const SmClass tcp_sm_class = SM_CLASS_DEF("TcpSessionSm", tcp_states, Tcp
 
 int demo(void)
 {
-    TcpSessionSm tcp_sm = { 0 };
+    TcpSessionSm  tcp_sm = { 0 };
+    SmEventQueue  tcp_queue;
+    SmQueuedEvent tcp_queue_buf[SM_LANE_COUNT * 8];
+    SmStateId     tcp_history[STATE_MAX];
+    SmEventId     tcp_deferred[4];
 
     ALOG_E("========================================");
     ALOG_E("       TCP Connection Platform SM Demo");
     ALOG_E("========================================");
 
+    /* 1 connect per ms with bursts of 32 (microsecond clock), 5 ms retry jitter */
+    SmSetTimeFn(DemoNowUs);
+    if (SmAdmissionInit(&tcp_connect_admission, 1000, 32, 5000, EVT_TIMEOUT, NULL) != SM_RET_OK)
+    {
+        ALOG_E("Init admission control failed!");
+        return -1;
+    }
+
     /* 1. Create state machine instance */
     ALOG_E("[Step 1] Create TCP session state machine");
     if (SmCreate(&tcp_sm.sm, &tcp_sm_class, &tcp_sm.session_data) != SM_RET_OK)
@@ -561,7 +666,8 @@ int demo(void)
     /* 1.1 Set transition log callback */
     ALOG_E("[Step 1.1] Set state transition log");
     SmSetTransLogFn(&tcp_sm.sm, TransLogCallback);
-    SmSetGetEventNameFn(&tcp_sm.sm, GetEventName);
+    SmSetHistoryStorage(&tcp_sm.sm, tcp_history, STATE_MAX);
+    SmSetDeferStorage(&tcp_sm.sm, tcp_deferred, 4);
 
     /* 2. Start state machine */
     ALOG_E("[Step 2] Start state machine (initial state: DISCONNECTED)");
@@ -586,6 +692,20 @@ int demo(void)
     SmSendEvent(&tcp_sm.sm, EVT_AUTH_OK);
     ALOG_E("  Current state: %s", SmGetCurrentStateName(&tcp_sm.sm));
 
+    /* 3.1 Deferred event: auth requested before the link is up */
+    ALOG_E("[Step 3.1] Send auth while still connecting (deferred)");
+    SmStart(&tcp_sm.sm, STATE_DISCONNECTED);
+    SmSendEvent(&tcp_sm.sm, EVT_CONNECT);
+
+    ALOG_E("  -> Send auth early");
+    SmRetCode defer_ret = SmSendEvent(&tcp_sm.sm, EVT_SEND_AUTH);
+    ALOG_E("  Result: %s, current state: %s", (defer_ret == SM_RET_DEFERRED) ? "DEFERRED" : "not deferred",
+           SmGetCurrentStateName(&tcp_sm.sm));
+
+    ALOG_E("  -> Connection success");
+    SmSendEvent(&tcp_sm.sm, EVT_CONNECT_OK);
+    ALOG_E("  Current state: %s (deferred auth re-sent after connect)", SmGetCurrentStateName(&tcp_sm.sm));
+
     /* 4. Simulate reconnection scenario */
     ALOG_E("[Step 4] Simulate reconnection scenario");
     ALOG_E("  -> Reset state machine");
@@ -609,7 +729,7 @@ int demo(void)
 
     ALOG_E("  -> Reconnect success");
     SmSendEvent(&tcp_sm.sm, EVT_CONNECT_OK);
-    ALOG_E("  Current state: %s", SmGetCurrentStateName(&tcp_sm.sm));
+    ALOG_E("  Current state: %s (resumed via SESSION history)", SmGetCurrentStateName(&tcp_sm.sm));
 
     /* 5. Simulate connection retry scenario */
     ALOG_E("[Step 5] Simulate connection retry scenario");
@@ -689,6 +809,138 @@ int demo(void)
     SmSendEvent(&tcp_sm.sm, EVT_DISCONNECT);
     ALOG_E("  Current state: %s", SmGetCurrentStateName(&tcp_sm.sm));
 
+    /* 9.1 Priority lanes: disconnect overtakes queued keepalive ticks */
+    ALOG_E("[Step 9.1] Queue events with priority lanes");
+    SmQueueInit(&tcp_queue, tcp_queue_buf, 8, 4);
+    SmSetEventQueue(&tcp_sm.sm, &tcp_queue);
+    SmStart(&tcp_sm.sm, STATE_DISCONNECTED);
+    SmSendEvent(&tcp_sm.sm, EVT_CONNECT);
+    SmSendEvent(&tcp_sm.sm, EVT_CONNECT_OK);
+    SmSendEvent(&tcp_sm.sm, EVT_SEND_AUTH);
+    SmSendEvent(&tcp_sm.sm, EVT_AUTH_OK);
+
+    for (int i = 0; i < 6; i++)
+    {
+        SmPostEvent(&tcp_sm.sm, EVT_TIMEOUT);
+    }
+    SmPostEvent(&tcp_sm.sm, EVT_DISCONNECT);
+
+    ALOG_E("  -> Dispatch one event (should be DISCONNECT)");
+    SmDispatch(&tcp_sm.sm, 1);
+    ALOG_E("  Current state: %s", SmGetCurrentStateName(&tcp_sm.sm));
+    SmDispatch(&tcp_sm.sm, 0);
+    ALOG_E("  CTRL lane dispatched=%u, LOW lane dispatched=%u",
+           SmGetLaneStats(&tcp_queue, SM_LANE_CTRL)->dispatched,
+           SmGetLaneStats(&tcp_queue, SM_LANE_LOW)->dispatched);
+    SmSetEventQueue(&tcp_sm.sm, NULL);
+
+    /* 9.2 Outbox: actions emit output records, flushed once per dispatch cycle */
+    ALOG_E("[Step 9.2] Batch side effects through an outbox");
+    int peer[2];
+    if (pipe(peer) == 0)
+    {
+        SmOutbox    outbox;
+        SmOutRecord out_records[16];
+        uint8_t     out_arena[256];
+        char        received[64];
+
+        SmOutboxInit(&outbox, out_records, 16, out_arena, sizeof(out_arena), NULL);
+        SmSetOutbox(&tcp_sm.sm, &outbox);
+        SmStart(&tcp_sm.sm, STATE_DISCONNECTED);
+        SmSendEvent(&tcp_sm.sm, EVT_CONNECT);
+        SmSendEvent(&tcp_sm.sm, EVT_CONNECT_OK);
+        tcp_sm.session_data.socket_fd = peer[1]; /* Use the pipe as the session socket */
+        SmSendEvent(&tcp_sm.sm, EVT_SEND_AUTH);
+        SmSendEvent(&tcp_sm.sm, EVT_AUTH_FAIL);
+        SmSendEvent(&tcp_sm.sm, EVT_AUTH_OK);
+        SmSendEvent(&tcp_sm.sm, EVT_DISCONNECT);
+        ALOG_E("  Pending records: %u (nothing written yet)", outbox.record_count);
+
+        SmOutboxFlush(&outbox);
+        ssize_t n = read(peer[0], received, sizeof(received) - 1);
+        received[(n > 0) ? n : 0] = '\0';
+        ALOG_E("  Flushed %llu records with %llu syscalls, peer received %zd bytes:",
+               (unsigned long long)outbox.stats.flushed, (unsigned long long)outbox.stats.syscalls, n);
+        for (char *line = strtok(received, "\n"); line != NULL; line = strtok(NULL, "\n"))
+        {
+            ALOG_E("    %s", line);
+        }
+        SmSetOutbox(&tcp_sm.sm, NULL);
+        close(peer[0]);
+    }
+
+    /* 9.3 Class image: compile the class once, load it without rebuilding tables */
+    ALOG_E("[Step 9.3] Run a session from a precompiled class image");
+    SmImageBlob blob;
+    SmImage     image;
+    uint32_t    symbol_count = sizeof(tcp_symbols) / sizeof(tcp_symbols[0]);
+    if (SmImageBuildFromClass(&tcp_sm_class, tcp_symbols, symbol_count, NULL, &blob) == SM_RET_OK &&
+        SmImageLoad(&image, blob.data, blob.size, tcp_symbols, symbol_count, SM_IMAGE_VERIFY) == SM_RET_OK)
+    {
+        TcpSessionSm image_sm = { 0 };
+
+        ALOG_E("  Image: %zu bytes, %u states, %u symbols, table %s",
+               blob.size, image.header->state_count, image.header->symbol_count,
+               (image.sm_class.table != NULL) ? "in place" : "none");
+        SmCreate(&image_sm.sm, &image.sm_class, &image_sm.session_data);
+        SmStart(&image_sm.sm, STATE_DISCONNECTED);
+        SmSendEvent(&image_sm.sm, EVT_CONNECT);
+        SmSendEvent(&image_sm.sm, EVT_CONNECT_OK);
+        SmSendEvent(&image_sm.sm, EVT_NETWORK_ERROR);
+        ALOG_E("  %s -> state %s", SmImageEventName(&image, EVT_NETWORK_ERROR), SmGetCurrentStateName(&image_sm.sm));
+        SmDestroy(&image_sm.sm);
+        SmImageClose(&image);
+    }
+    else
+    {
+        ALOG_E("  Image failed: %s", (blob.error[0] != '\0') ? blob.error : image.error);
+    }
+    SmImageBlobFree(&blob);
+
+    /* 9.4 Name index: parse control-plane commands ("REMOTE_CLOSE") in O(1) */
+    ALOG_E("[Step 9.4] Resolve event and state names from the control plane");
+    static uint64_t names_buf[64];
+    SmNames  names;
+    SmClass  named_class = tcp_sm_class;
+    if (SmNamesCalcSize(&tcp_sm_class) <= sizeof(names_buf) &&
+        SmNamesBuild(&names, &tcp_sm_class, names_buf, sizeof(names_buf)) == SM_RET_OK)
+    {
+        const char *command = "{\"event\":\"REMOTE_CLOSE\"}";
+        named_class.names = &names;
+        ALOG_E("  Index: %zu bytes for %u events and %u states",
+               SmNamesGetBytes(&names), names.events.count, names.states.count);
+        ALOG_E("  %s -> event %d, \"AUTHENTICATED\" -> state %d, \"BOGUS\" -> %d", command,
+               SmFindEventId(&named_class, command + 10, 12), SmFindStateId(&named_class, "AUTHENTICATED", 13),
+               SmFindEventId(&named_class, "BOGUS", 5));
+    }
+
+    /* 9.5 Reachability: dead rules and retry loops, found before deployment */
+    ALOG_E("[Step 9.5] Explore reachable configurations of the class");
+    static const SmEventId tcp_auto_events[] = { EVT_CONNECT_FAIL, EVT_TIMEOUT };
+    SmExploreConfig explore_config = {
+        .sm_class      = &tcp_sm_class,
+        .initial_state = STATE_DISCONNECTED,
+        .auto_events   = tcp_auto_events,
+        .auto_count    = sizeof(tcp_auto_events) / sizeof(SmEventId),
+        .thread_count  = 2,
+        .max_configs   = 4096,
+    };
+    SmExploreResult explore;
+    if (SmExploreRun(&explore_config, &explore) == SM_RET_OK)
+    {
+        ALOG_E("  %llu configs, %u/%u states, %u/%u rules fired, %u guards, %u loops",
+               (unsigned long long)explore.configs, explore.states_reached, tcp_sm_class.state_count,
+               explore.rules_fired, explore.rules_total, explore.guard_count, explore.loops_total);
+        for (uint16_t i = 0; i < explore.loop_count; i++)
+        {
+            const SmExploreLoop *loop = &explore.loops[i];
+            ALOG_E("  Loop through %s (%u states) exits only via guard on %s%s",
+                   tcp_sm_class.states[loop->state].state_name, loop->state_count,
+                   tcp_sm_class.states[loop->guard_state].state_name, loop->held ? " (livelock)" : "");
+        }
+        SmExploreFree(&explore);
+    }
+
     /* 10. Stop state machine */
     ALOG_E("[Step 10] Stop state machine");
     SmStop(&tcp_sm.sm);
@@ -697,6 +949,7 @@ int demo(void)
     /* 11. Destroy state machine */
     ALOG_E("[Step 11] Destroy state machine instance");
     SmDestroy(&tcp_sm.sm);
+    SmSetTimeFn(NULL);
 
     ALOG_E("========================================");
     ALOG_E("       TCP Session Demo Complete");
@@ -719,6 +972,9 @@ int demo(void)
  *   - AUTHENTICATED:  Authenticated, authentication complete, normal business communication
  *   - RECONNECTING:   Reconnecting, attempting to reconnect after disconnection
  *   - ERROR:          Error state, retry count exceeded or other serious errors
+ *   - SESSION:        Composite of CONNECTED/AUTHENTICATING/AUTHENTICATED
+ *   - SESSION_H:      Shallow history of SESSION, a successful reconnect
+ *                     resumes the last session substate in one transition
  *
  * Event Definitions:
  *   - EVT_CONNECT:      Initiate connection request
@@ -733,6 +989,10 @@ int demo(void)
  *   - EVT_NETWORK_ERROR: Network error
  *   - EVT_RECONNECT:    Start reconnect
  *
+ * Priority Lanes:
+ *   - EVT_DISCONNECT uses the CTRL lane, REMOTE_CLOSE/NETWORK_ERROR the HIGH lane
+ *   - EVT_TIMEOUT ticks use the LOW lane and are protected from starvation
+ *
  * Retry Mechanism:
  *   - Connection retry: Max 5 times
  *   - Auth retry: Max 3 times
@@ -744,12 +1004,136 @@ int demo(void)
  *   3. Implement condition check functions - optional
  *   4. Implement transition action functions - optional
  *   5. Implement state enter/exit/handle callback functions
- *   6. Define state transition table (use SM_TRANS related macros)
- *   7. Define state table (use SM_STATE macro)
+ *   6. Define state transition table (use SM_TRANS related macros),
+ *      rows shared by most states go to the class-wide table (SM_CLASS_ANY)
+ *   7. Define state table (use SM_STATE macro), keep all tables static const
+ *      so they live in Flash/.rodata and are shared after fork()
  *   8. Define state machine class (use SM_CLASS_DEF macro)
+ *      - large classes: build a compressed table with SmTableBuild (or
+ *        generate one offline) and attach it with SM_CLASS_TABLE
  *   9. Create SmMachine instance (static allocation)
  *  10. Call SmCreate to initialize
  *  11. Call SmStart to start
  *  12. Call SmSendEvent to send events
+ *      (or SmPostEvent + SmDispatch when a priority queue is bound)
  *  13. Call SmDestroy to cleanup
+ *
+ * Live Observation:
+ *   - SmObserverCreate("/tcp_sessions", n, &tcp_sm_class) + SmSetMachineId +
+ *     SmObserverAttach export every state change to shared memory
+ *   - other processes map it with SmObserverOpen and read snapshots with
+ *     SmObserverRead / SmObserverCountStates without stalling the dispatcher
+ *
+ * Record / Replay:
+ *   - SmRecorderCreate + SmRecorderAttach append every event sent to the
+ *     machine (SmSendEvent or SmSendEventEx with payload) to a mapped log
+ *   - SmRecLogOpen + SmReplay feed the log to fresh instances, full speed or
+ *     at original pacing, and report any state/result mismatch
+ *
+ * Hot Reload:
+ *   - SmReloadInit(&domain, &tcp_sm_class, ...) and one SmReloadRegister per
+ *     dispatch thread; SmReloadPublish(new_class, state_map) from the control
+ *     thread, SmReloadQuiescent(fleet) between dispatch batches migrates the
+ *     sessions, SmReloadReclaim frees versions no dispatcher still uses
+ *
+ * Timers / Simulation:
+ *   - SmTimerStart(&heap, machine, EVT_TIMEOUT, SmGetTime() + delay) arms a
+ *     timeout, SmTimerExpire(&heap, now) delivers the expired ones
+ *   - SmSimInit installs a virtual clock over the same heap; SmSimRun jumps
+ *     straight to the next deadline, so days of retry/reconnect churn run in
+ *     seconds and repeat exactly for the same seed (see SmMgr_bench.c)
+ *
+ * Outbox:
+ *   - SmSetOutbox binds one SmOutbox per dispatch thread; actions emit
+ *     SmOutboxSend/Close/Timer records instead of doing I/O inline
+ *   - SmOutboxFlush after each dispatch cycle issues one writev per fd, then
+ *     the closes and timer inserts; records of a failed event are dropped
+ *
+ * Admission Control (SmAdmission.h):
+ *   - OnConnectAction/OnReconnectStartAction consult tcp_connect_admission,
+ *     one lock-free token bucket for the whole class; after an upstream
+ *     restart the reconnect herd is paced and the rejected sessions get
+ *     EVT_TIMEOUT again after a jittered backoff. Guards stay pure
+ *   - SmSetTimeFn(DemoNowUs) is installed first: without a time source
+ *     SmAdmissionInit refuses a nonzero rate
+ *
+ * Transition Kinds:
+ *   - The retry rows use SM_TRANS_INTERNAL: the guard and action run, but
+ *     no on_exit/on_enter and no transition log for a counter bump
+ *   - SM_TRANS_LOCAL keeps the enclosing states entered; SM_TRANS_COMPLETION
+ *     rows fire right after their state is entered, and SmTableBuild fuses
+ *     chains of callback-free pass-through states into one step
+ *
+ * Deferred Events:
+ *   - SM_STATE_DEFER(link_down_defers) on CONNECTING/RECONNECTING plus
+ *     SmSetDeferStorage per session: an early EVT_SEND_AUTH returns
+ *     SM_RET_DEFERRED and is re-sent once, in order, after the session
+ *     enters a state that handles it; no caller-side re-post loop
+ *
+ * Dwell Watchdog (SmWatchdog.h):
+ *   - SM_STATE_DWELL(budget) on AUTHENTICATING/RECONNECTING, SmWatchdogAttach
+ *     per session; SmWatchdogCheck(&wd, SmGetTime()) from the dispatch loop
+ *     reports sessions stuck past the budget (or sends them EVT_TIMEOUT)
+ *     without scanning the fleet
+ *
+ * Population Index (SmPopIndex.h):
+ *   - SmPopIndexInit + SmPopIndexAttach per session (after SmSetMachineId);
+ *     SmPopCount(&index, STATE_AUTHENTICATED) is O(1), and
+ *     SmPopForEach(&index, STATE_ERROR, fn, ctx) visits only the members,
+ *     e.g. to send EVT_DISCONNECT to every session in ERROR
+ *
+ * Hot Standby (SmRepl.h):
+ *   - Primary: SmReplSenderInit on a connected AF_UNIX socket with a delta
+ *     callback (e.g. socket_fd + retry counters), SmReplAttach per session;
+ *     each committed change is a ring write, a sender thread batches writev
+ *   - Standby: SmCreate the mirror pool (no SmStart), SmReplReceiverInit and
+ *     SmReplReceive in its loop; after failover the mirrors dispatch as-is
+ *
+ * Speculation (SmSpec.h):
+ *   - SmSpecArenaInit(&arena, buf, sizeof(buf), &scratch_outbox) once, then per
+ *     candidate plan: SmSpecArenaReset, SmClone(&arena, &session->sm,
+ *     sizeof(*session), 0), SmSpeculate(clone, plan, n, SM_SPEC_STUB_ALL, &trace)
+ *   - trace.final_state and the recorded steps answer "where would this session
+ *     end up"; the live instance is never touched
+ *
+ * Reachability (SmExplore.h):
+ *   - SmExploreRun(&config, &result) before deployment enumerates every
+ *     reachable (state, guard outcome) configuration of a class on several
+ *     threads; SmExplorePrint lists unreachable states, dead rules (shadowed
+ *     or guard never true) and loops that only a guard can leave
+ *   - auto_events names the timer/driver events (EVT_TIMEOUT, EVT_CONNECT_FAIL)
+ *     so a CanRetryConnect that never turns false shows up as a livelock
+ *   - SmExplorePrune drops never-selected rules before SmTableBuild
+ *
+ * CAN Ingest (SmCan.h, Linux):
+ *   - Describe frames once: SM_CAN_RULE(0x180, 0x7C0, EVT_MOTOR_STATUS, fields,
+ *     MotorStatus, SM_CAN_ROUTE(0, 0, 0x3F)) maps every node's status frame to
+ *     its own machine and decodes the DBC signals into a MotorStatus payload
+ *   - SmCanInit(&can, rules, n, machines, count), fd = SmCanOpen(&can, "can0")
+ *     (kernel filters from the rules), then loop SmCanReceive(&can, fd, false):
+ *     one recvmmsg per burst, no per-frame parsing or allocation
+ *   - Test without hardware: ip link add dev vcan0 type vcan && ip link set
+ *     up vcan0, then cangen/canplayer vcan0
+ *
+ * Name Index (SmNames.h):
+ *   - SM_CLASS_EVENT_NAMES(tcp_event_names) gives the class its event names;
+ *     transition logs use them without SmSetGetEventNameFn
+ *   - SmNamesBuild once at startup and set SmClass.names; SmFindEventId /
+ *     SmFindStateId then resolve "REMOTE_CLOSE" straight from the JSON/MQTT
+ *     buffer (pointer + length) in O(1), no copy and no strcmp chain
+ *
+ * Class Image (SmImage.h):
+ *   - SmImageBuildFromClass(&tcp_sm_class, tcp_symbols, ...) or the
+ *     image_tool "build" command (description text) compile a class into a
+ *     position-independent image with its lookup table and names
+ *   - SmImageOpen maps the file read-only (shared by every process loading
+ *     it) and resolves callbacks by name through the symbol table; no table
+ *     is rebuilt at startup
+ *
+ * Blocking Dispatch (SmOs.h / SmLoop.h):
+ *   - SmLoopInit(&loop, items, n, &timers, &outbox) + SmOsThreadCreate(SmLoopRun)
+ *     replaces busy polling: other threads call SmLoopPost, the loop sleeps on
+ *     an SmOsSem until the next post or timer deadline
+ *   - SmOs_posix.c is the Linux port; RTOS ports define SM_OS_PORT_TYPES and
+ *     implement the same SmOsXxx functions (tickless idle on MCUs)
  */
@@ -0,0 +1,278 @@
+#include "SmNames.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_NAMES_ALIGN(x)      (((x) + 7u) & ~(size_t)7u)
+#define SM_NAMES_BUCKETS(n)    (((uint32_t)(n) + 2u) / 3u) /* 平均每桶 3 个名称 */
+#define SM_NAMES_TAKEN         1                           /* 槽位已被先前的桶占用 */
+#define SM_NAMES_TRIAL         2                           /* 槽位被当前桶试探占用 */
+
+/**
+ * @brief 构建期间的临时空间
+ */
+typedef struct
+{
+    uint64_t *hash;   /* 名称哈希 [count] */
+    uint16_t *key;    /* 名称对应的事件ID/状态下标 [count] */
+    uint32_t *start;  /* 桶内名称起始位置 [bucket_count + 1] */
+    uint16_t *order;  /* 按桶排列的名称序号 [count] */
+    uint8_t *taken;   /* 槽位占用标记 [count] */
+    uint32_t *slot;   /* 排列时为各桶填充游标, 放置时为当前桶试探的槽位 [count] */
+    uint32_t free;    /* 单名称桶查找空槽位的游标 */
+} SmNamesScratch;
+
+/**
+ * @brief 获取第 i 个事件名/状态名
+ */
+static const char *SmNamesKey(const SmClass *sm_class, bool states, uint16_t i)
+{
+    if (states)
+    {
+        return sm_class->states[i].state_name;
+    }
+    return (sm_class->event_names != NULL) ? sm_class->event_names[i] : NULL;
+}
+
+/**
+ * @brief 统计非NULL名称数量
+ */
+static uint16_t SmNamesCount(const SmClass *sm_class, bool states)
+{
+    uint16_t total = states ? sm_class->state_count : sm_class->event_name_count;
+    uint16_t count = 0;
+
+    for (uint16_t i = 0; i < total; i++)
+    {
+        count += (SmNamesKey(sm_class, states, i) != NULL);
+    }
+    return count;
+}
+
+/**
+ * @brief 一组名称的永久数据字节数
+ */
+static size_t SmNamesHashBytes(uint16_t count)
+{
+    return SM_NAMES_ALIGN(sizeof(uint32_t) * SM_NAMES_BUCKETS(count)) + SM_NAMES_ALIGN(sizeof(uint16_t) * count);
+}
+
+/**
+ * @brief 临时空间字节数
+ */
+static size_t SmNamesScratchBytes(uint16_t count)
+{
+    return SM_NAMES_ALIGN(sizeof(uint64_t) * count) + SM_NAMES_ALIGN(sizeof(uint16_t) * count) +
+           SM_NAMES_ALIGN(sizeof(uint32_t) * (SM_NAMES_BUCKETS(count) + 1)) +
+           SM_NAMES_ALIGN(sizeof(uint16_t) * count) + SM_NAMES_ALIGN(count) +
+           SM_NAMES_ALIGN(sizeof(uint32_t) * count);
+}
+
+/**
+ * @brief 为当前桶寻找位移, 使桶内名称落到互不相同的空槽位
+ * @return true 找到(slots 已填写), false 种子用尽
+ */
+static bool SmNamesPlaceBucket(SmNameHash *hash, uint32_t *disp, uint16_t *slots, SmNamesScratch *s,
+                               uint32_t bucket)
+{
+    uint32_t first = s->start[bucket];
+    uint32_t size = s->start[bucket + 1] - first;
+
+    /* 单名称桶: 偏移直接指向下一个空槽位(此时只剩单名称桶, 游标单调前进) */
+    if (size == 1)
+    {
+        while (s->taken[s->free] != 0)
+        {
+            s->free++;
+        }
+        uint32_t base = SmNamesSlot(hash, s->hash[s->order[first]], 0);
+        disp[bucket] = (s->free >= base) ? s->free - base : s->free + hash->count - base;
+        s->taken[s->free] = SM_NAMES_TAKEN;
+        slots[s->free] = s->key[s->order[first]];
+        return true;
+    }
+
+    for (uint32_t seed = 0; seed <= SM_NAMES_SEED_MAX; seed++)
+    {
+        uint32_t placed = 0;
+        while (placed < size)
+        {
+            uint32_t slot = SmNamesSlot(hash, s->hash[s->order[first + placed]], seed << 16);
+            if (s->taken[slot] != 0)
+            {
+                break;
+            }
+            s->taken[slot] = SM_NAMES_TRIAL;
+            s->slot[placed++] = slot;
+        }
+
+        if (placed == size)
+        {
+            disp[bucket] = seed << 16;
+            for (uint32_t i = 0; i < size; i++)
+            {
+                s->taken[s->slot[i]] = SM_NAMES_TAKEN;
+                slots[s->slot[i]] = s->key[s->order[first + i]];
+            }
+            return true;
+        }
+
+        /* 撤销试探 */
+        for (uint32_t i = 0; i < placed; i++)
+        {
+            s->taken[s->slot[i]] = 0;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 构建一组名称的完美哈希
+ * @param data 永久数据存放位置(SmNamesHashBytes 字节)
+ */
+static SmRetCode SmNamesBuildHash(SmNameHash *hash, const SmClass *sm_class, bool states, uint8_t *data,
+                                  SmNamesScratch *s)
+{
+    uint16_t total = states ? sm_class->state_count : sm_class->event_name_count;
+    uint16_t count = SmNamesCount(sm_class, states);
+    uint32_t bucket_count = SM_NAMES_BUCKETS(count);
+    uint32_t *disp = (uint32_t *)data;
+    uint16_t *slots = (uint16_t *)(data + SM_NAMES_ALIGN(sizeof(uint32_t) * bucket_count));
+
+    hash->count = count;
+    hash->bucket_count = (uint16_t)bucket_count;
+    hash->disp = disp;
+    hash->slots = slots;
+    if (count == 0)
+    {
+        return SM_RET_OK;
+    }
+
+    /* 1. 计算哈希, 按桶计数 */
+    uint16_t n = 0;
+    memset(s->start, 0, sizeof(uint32_t) * (bucket_count + 1));
+    for (uint16_t i = 0; i < total; i++)
+    {
+        const char *name = SmNamesKey(sm_class, states, i);
+        if (name != NULL)
+        {
+            s->hash[n] = SmNamesHash(name, strlen(name));
+            s->key[n] = i;
+            s->start[(uint32_t)(s->hash[n] >> 32) % bucket_count + 1]++;
+            n++;
+        }
+    }
+
+    /* 2. 按桶排列(计数排序), 同名必然落在同一个桶中, 在此检出 */
+    uint32_t max_size = 0;
+    for (uint32_t b = 0; b < bucket_count; b++)
+    {
+        max_size = (s->start[b + 1] > max_size) ? s->start[b + 1] : max_size;
+        s->start[b + 1] += s->start[b];
+    }
+    memcpy(s->slot, s->start, sizeof(uint32_t) * bucket_count); /* 填充游标 */
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint32_t b = (uint32_t)(s->hash[i] >> 32) % bucket_count;
+        for (uint32_t j = s->start[b]; j < s->slot[b]; j++)
+        {
+            if (s->hash[s->order[j]] == s->hash[i] &&
+                strcmp(SmNamesKey(sm_class, states, s->key[s->order[j]]), SmNamesKey(sm_class, states, s->key[i])) == 0)
+            {
+                return SM_RET_ERROR;
+            }
+        }
+        s->order[s->slot[b]++] = i;
+    }
+
+    /* 3. 大桶先放置: 剩余空槽位越少, 小桶越容易找到种子 */
+    memset(s->taken, 0, count);
+    memset(disp, 0, sizeof(uint32_t) * bucket_count);
+    s->free = 0;
+    for (uint32_t size = max_size; size > 0; size--)
+    {
+        for (uint32_t b = 0; b < bucket_count; b++)
+        {
+            if (s->start[b + 1] - s->start[b] == size && !SmNamesPlaceBucket(hash, disp, slots, s, b))
+            {
+                return SM_RET_ERROR;
+            }
+        }
+    }
+
+    return SM_RET_OK;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+size_t SmNamesCalcSize(const SmClass *sm_class)
+{
+    if (sm_class == NULL || (sm_class->states == NULL && sm_class->state_count > 0))
+    {
+        return 0;
+    }
+
+    uint16_t events = SmNamesCount(sm_class, false);
+    uint16_t states = SmNamesCount(sm_class, true);
+    return SmNamesHashBytes(events) + SmNamesHashBytes(states) +
+           SmNamesScratchBytes((events > states) ? events : states);
+}
+
+SmRetCode SmNamesBuild(SmNames *names, const SmClass *sm_class, void *buf, size_t buf_size)
+{
+    if (names == NULL || buf == NULL || ((uintptr_t)buf & 7u) != 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    size_t size = SmNamesCalcSize(sm_class);
+    if (size == 0 || buf_size < size)
+    {
+        return SM_RET_ERROR;
+    }
+
+    uint16_t events = SmNamesCount(sm_class, false);
+    uint16_t states = SmNamesCount(sm_class, true);
+    uint16_t max = (events > states) ? events : states;
+    uint8_t *p = (uint8_t *)buf;
+    uint8_t *event_data = p;
+    uint8_t *state_data = event_data + SmNamesHashBytes(events);
+    SmNamesScratch s;
+
+    /* 临时空间紧跟在永久数据之后 */
+    p = state_data + SmNamesHashBytes(states);
+    s.hash = (uint64_t *)p;
+    p += SM_NAMES_ALIGN(sizeof(uint64_t) * max);
+    s.key = (uint16_t *)p;
+    p += SM_NAMES_ALIGN(sizeof(uint16_t) * max);
+    s.start = (uint32_t *)p;
+    p += SM_NAMES_ALIGN(sizeof(uint32_t) * (SM_NAMES_BUCKETS(max) + 1));
+    s.order = (uint16_t *)p;
+    p += SM_NAMES_ALIGN(sizeof(uint16_t) * max);
+    s.taken = p;
+    p += SM_NAMES_ALIGN(max);
+    s.slot = (uint32_t *)p;
+
+    if (SmNamesBuildHash(&names->events, sm_class, false, event_data, &s) != SM_RET_OK ||
+        SmNamesBuildHash(&names->states, sm_class, true, state_data, &s) != SM_RET_OK)
+    {
+        return SM_RET_ERROR;
+    }
+
+    return SM_RET_OK;
+}
+
+size_t SmNamesGetBytes(const SmNames *names)
+{
+    if (names == NULL)
+    {
+        return 0;
+    }
+
+    return sizeof(SmNames) + SmNamesHashBytes(names->events.count) + SmNamesHashBytes(names->states.count);
+}
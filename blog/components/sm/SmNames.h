@@ -0,0 +1,138 @@
+#ifndef __SMNAMES_H__
+#define __SMNAMES_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 名称索引(最小完美哈希)
+ * ============================================================================ */
+
+/*
+ * 为类的事件名(SmClass.event_names)和状态名(SmState.state_name)生成
+ * 名称 -> ID 的最小完美哈希(hash and displace):
+ *   桶 = H(名称) 高32位 % bucket_count
+ *   槽位 = (Mix(H(名称), 种子) + 偏移) % count, slots[槽位] 即事件ID/状态下标
+ * 每个桶的位移 disp[桶] = 种子 << 16 | 偏移: 大桶先放置, 搜索种子(偏移为 0);
+ * 最后剩下的单名称桶直接用偏移指向一个空槽位, 满载时也不会搜索失败.
+ * n 个名称恰好占用 n 个槽位, 查找为一次哈希 + 一次字符串比较(拒绝未知名称),
+ * 不分配内存. 构建在启动时进行一次, 数据存放于调用者提供的缓冲区.
+ *
+ * 约束: 同一个类中事件名互不相同, 状态名互不相同; NULL 名称不参与索引.
+ */
+
+#define SM_NAMES_SEED_MAX  0xFFFF          /* 单个桶的种子搜索上限 */
+#define SM_NAMES_SEED(d)   ((d) >> 16)      /* 位移中的种子 */
+#define SM_NAMES_OFFSET(d) ((d) & 0xFFFFu)  /* 位移中的偏移 */
+
+/**
+ * @brief 一组名称的完美哈希
+ */
+typedef struct
+{
+    uint16_t count;        /* 名称数量(槽位数) */
+    uint16_t bucket_count; /* 桶数量 */
+    const uint32_t *disp;  /* 桶位移(种子 << 16 | 偏移) [bucket_count] */
+    const uint16_t *slots; /* 槽位 -> 事件ID/状态下标 [count] */
+} SmNameHash;
+
+/**
+ * @brief 类的名称索引
+ */
+struct SmNamesTag
+{
+    SmNameHash events; /* 事件名 */
+    SmNameHash states; /* 状态名 */
+};
+
+/**
+ * @brief 计算名称哈希(64位 FNV-1a + 混合)
+ * @param name 名称
+ * @param len 名称长度
+ * @return 哈希值
+ */
+static inline uint64_t SmNamesHash(const char *name, size_t len)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (uint8_t)name[i];
+        h *= 1099511628211ULL;
+    }
+
+    /* 相近的短名称(EVT_001/EVT_002)高位几乎相同, 混合后再取桶 */
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief 按桶位移计算槽位
+ * @param hash 完美哈希
+ * @param h 名称哈希
+ * @param disp 桶位移
+ * @return 槽位
+ */
+static inline uint32_t SmNamesSlot(const SmNameHash *hash, uint64_t h, uint32_t disp)
+{
+    uint64_t x = h ^ ((uint64_t)SM_NAMES_SEED(disp) * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+
+    uint32_t slot = (uint32_t)(x % hash->count) + SM_NAMES_OFFSET(disp);
+    return (slot >= hash->count) ? slot - hash->count : slot;
+}
+
+/**
+ * @brief 查找候选
+ * @param hash 完美哈希
+ * @param h 名称哈希
+ * @return 事件ID/状态下标, -1 表示为空; 调用者需比较名称以拒绝未知名称
+ */
+static inline int32_t SmNamesProbe(const SmNameHash *hash, uint64_t h)
+{
+    if (hash->count == 0)
+    {
+        return -1;
+    }
+
+    uint32_t disp = hash->disp[(uint32_t)(h >> 32) % hash->bucket_count];
+    return hash->slots[SmNamesSlot(hash, h, disp)];
+}
+
+/**
+ * @brief 计算构建名称索引建议的缓冲区大小
+ * @param sm_class 状态机类
+ * @return 字节数(含构建期间的临时空间)
+ */
+size_t SmNamesCalcSize(const SmClass *sm_class);
+
+/**
+ * @brief 构建名称索引
+ * @param names 名称索引(输出)
+ * @param sm_class 状态机类
+ * @param buf 缓冲区, 索引数据直接存放于此, 生命周期需不短于 names
+ * @param buf_size 缓冲区大小
+ * @return SM_RET_OK 成功, SM_RET_ERROR 名称重复或缓冲区不足
+ * @note 构建完成后将 names 赋给 SmClass.names 即可启用 O(1) 查找
+ */
+SmRetCode SmNamesBuild(SmNames *names, const SmClass *sm_class, void *buf, size_t buf_size);
+
+/**
+ * @brief 获取名称索引实际占用的字节数
+ * @param names 名称索引
+ * @return 字节数
+ */
+size_t SmNamesGetBytes(const SmNames *names);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMNAMES_H__ */
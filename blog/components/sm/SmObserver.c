@@ -0,0 +1,257 @@
+#define _POSIX_C_SOURCE 200809L /* ftruncate */
+
+#include "SmObserver.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 计算共享内存段大小
+ */
+static size_t SmObserverMapSize(uint32_t slot_count)
+{
+    return sizeof(SmObsHeader) + sizeof(SmObsSlot) * (size_t)slot_count;
+}
+
+/**
+ * @brief 复制名称(截断并保证结束符)
+ */
+static void SmObserverCopyName(char *dst, const char *src)
+{
+    if (src == NULL)
+    {
+        dst[0] = '\0';
+        return;
+    }
+
+    strncpy(dst, src, SM_OBS_NAME_LEN - 1);
+    dst[SM_OBS_NAME_LEN - 1] = '\0';
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmObsSlotRead(const SmObsSlot *slot, SmObsSnapshot *snapshot)
+{
+    if (slot == NULL || snapshot == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 槽位为只读映射时也需要原子读取, 去掉 const 仅用于 atomic_load */
+    SmObsSlot *s = (SmObsSlot *)slot;
+    for (uint32_t retry = 0; retry < SM_OBS_READ_RETRY; retry++)
+    {
+        uint32_t seq1 = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq1 & 1u)
+        {
+            continue; /* 写者正在写入 */
+        }
+
+        snapshot->state = atomic_load_explicit(&s->state, memory_order_relaxed);
+        snapshot->previous_state = atomic_load_explicit(&s->previous_state, memory_order_relaxed);
+        snapshot->trans_count = atomic_load_explicit(&s->trans_count, memory_order_relaxed);
+        snapshot->change_time = atomic_load_explicit(&s->change_time, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t seq2 = atomic_load_explicit(&s->seq, memory_order_relaxed);
+        if (seq1 == seq2)
+        {
+            return SM_RET_OK;
+        }
+    }
+
+    return SM_RET_ERROR;
+}
+
+SmRetCode SmObserverCreate(SmObserver *obs, const char *shm_name, uint32_t slot_count, const SmClass *sm_class)
+{
+    if (obs == NULL || shm_name == NULL || slot_count == 0 || sm_class == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(obs, 0, sizeof(SmObserver));
+
+    int fd = shm_open(shm_name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    size_t map_size = SmObserverMapSize(slot_count);
+    if (ftruncate(fd, (off_t)map_size) != 0)
+    {
+        close(fd);
+        return SM_RET_ERROR;
+    }
+
+    void *addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return SM_RET_ERROR;
+    }
+
+    obs->header = (SmObsHeader *)addr;
+    obs->slots = (SmObsSlot *)((uint8_t *)addr + sizeof(SmObsHeader));
+    obs->map_size = map_size;
+    obs->writable = true;
+
+    /* 初始化段头和槽位(未绑定的槽位状态无效) */
+    memset(obs->header, 0, sizeof(SmObsHeader));
+    obs->header->slot_count = slot_count;
+    obs->header->slot_size = sizeof(SmObsSlot);
+    obs->header->state_count = sm_class->state_count;
+    SmObserverCopyName(obs->header->class_name, sm_class->class_name);
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        SmStateId id = sm_class->states[i].state_id;
+        if (id >= 0 && id < SM_OBS_MAX_STATES)
+        {
+            SmObserverCopyName(obs->header->state_names[id], sm_class->states[i].state_name);
+        }
+    }
+
+    for (uint32_t i = 0; i < slot_count; i++)
+    {
+        atomic_init(&obs->slots[i].seq, 0);
+        atomic_init(&obs->slots[i].state, SM_STATE_INVALID);
+        atomic_init(&obs->slots[i].previous_state, SM_STATE_INVALID);
+        atomic_init(&obs->slots[i].trans_count, 0);
+        atomic_init(&obs->slots[i].change_time, 0);
+    }
+
+    /* 最后写入魔数和版本, 读端据此判断段已就绪 */
+    obs->header->version = SM_OBS_VERSION;
+    atomic_thread_fence(memory_order_release);
+    obs->header->magic = SM_OBS_MAGIC;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmObserverOpen(SmObserver *obs, const char *shm_name)
+{
+    if (obs == NULL || shm_name == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(obs, 0, sizeof(SmObserver));
+
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SmObsHeader))
+    {
+        close(fd);
+        return SM_RET_ERROR;
+    }
+
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const SmObsHeader *header = (const SmObsHeader *)addr;
+    if (header->magic != SM_OBS_MAGIC || header->version != SM_OBS_VERSION ||
+        header->slot_size != sizeof(SmObsSlot) ||
+        SmObserverMapSize(header->slot_count) > (size_t)st.st_size)
+    {
+        munmap(addr, (size_t)st.st_size);
+        return SM_RET_ERROR;
+    }
+
+    obs->header = (SmObsHeader *)addr;
+    obs->slots = (SmObsSlot *)((uint8_t *)addr + sizeof(SmObsHeader));
+    obs->map_size = (size_t)st.st_size;
+    obs->writable = false;
+
+    return SM_RET_OK;
+}
+
+void SmObserverClose(SmObserver *obs)
+{
+    if (obs != NULL && obs->header != NULL)
+    {
+        munmap(obs->header, obs->map_size);
+        memset(obs, 0, sizeof(SmObserver));
+    }
+}
+
+void SmObserverUnlink(const char *shm_name)
+{
+    if (shm_name != NULL)
+    {
+        shm_unlink(shm_name);
+    }
+}
+
+SmRetCode SmObserverAttach(SmObserver *obs, SmMachine *machine)
+{
+    if (obs == NULL || obs->header == NULL || !obs->writable || machine == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (machine->machine_id >= obs->header->slot_count)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 只发布当前状态, 变更次数保持不变(绑定不是一次转换) */
+    SmObsSlot *slot = &obs->slots[machine->machine_id];
+    SmObsSlotStore(slot, machine->current_state, machine->previous_state,
+                   atomic_load_explicit(&slot->trans_count, memory_order_relaxed), SmGetTime());
+    SmSetObsSlot(machine, slot);
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmObserverRead(const SmObserver *obs, uint32_t machine_id, SmObsSnapshot *snapshot)
+{
+    if (obs == NULL || obs->header == NULL || machine_id >= obs->header->slot_count)
+    {
+        return SM_RET_ERROR;
+    }
+
+    return SmObsSlotRead(&obs->slots[machine_id], snapshot);
+}
+
+uint32_t SmObserverCountStates(const SmObserver *obs, uint32_t *counts, uint32_t state_count)
+{
+    uint32_t invalid = 0;
+
+    if (obs == NULL || obs->header == NULL || counts == NULL)
+    {
+        return 0;
+    }
+
+    memset(counts, 0, sizeof(uint32_t) * state_count);
+    for (uint32_t i = 0; i < obs->header->slot_count; i++)
+    {
+        SmObsSnapshot snapshot;
+        if (SmObsSlotRead(&obs->slots[i], &snapshot) != SM_RET_OK ||
+            snapshot.state < 0 || (uint32_t)snapshot.state >= state_count)
+        {
+            invalid++;
+            continue;
+        }
+        counts[snapshot.state]++;
+    }
+
+    return invalid;
+}
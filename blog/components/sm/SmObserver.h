@@ -0,0 +1,182 @@
+#ifndef __SMOBSERVER_H__
+#define __SMOBSERVER_H__
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 状态观察(共享内存 + seqlock)
+ * ============================================================================ */
+
+/*
+ * 每个状态机实例对应共享内存中的一个槽位, 状态提交时由分发线程写入:
+ *   seq 置为奇数 -> 写入数据 -> seq 置为偶数
+ * 读者(监控线程或其他进程)读到相同的偶数 seq 前后两次即得到一致快照,
+ * 写者不加锁也不等待读者, 每次转换的开销为几次普通存储.
+ */
+
+#define SM_OBS_MAGIC      0x534D4F42 /* "SMOB" */
+#define SM_OBS_VERSION    1          /* 段格式版本 */
+#define SM_OBS_NAME_LEN   32         /* 类名/状态名最大长度(含结束符) */
+#define SM_OBS_MAX_STATES 64         /* 段头中记录名称的最大状态数 */
+#define SM_OBS_READ_RETRY 64         /* 读快照的最大重试次数 */
+
+/**
+ * @brief 共享内存槽位(单写者多读者)
+ */
+struct SmObsSlotTag
+{
+    _Atomic uint32_t seq;           /* 序列号, 奇数表示正在写入 */
+    _Atomic int32_t state;          /* 当前状态ID */
+    _Atomic int32_t previous_state; /* 上一个状态ID */
+    _Atomic uint32_t trans_count;   /* 状态变更次数 */
+    _Atomic uint64_t change_time;   /* 最近一次变更时间(SmGetTime) */
+};
+
+/**
+ * @brief 槽位快照
+ */
+typedef struct
+{
+    SmStateId state;          /* 当前状态ID */
+    SmStateId previous_state; /* 上一个状态ID */
+    uint32_t trans_count;     /* 状态变更次数 */
+    uint64_t change_time;     /* 最近一次变更时间 */
+} SmObsSnapshot;
+
+/**
+ * @brief 共享内存段头
+ */
+typedef struct
+{
+    uint32_t magic;                                       /* SM_OBS_MAGIC */
+    uint32_t version;                                     /* SM_OBS_VERSION */
+    uint32_t slot_count;                                  /* 槽位数量 */
+    uint32_t slot_size;                                   /* 槽位大小 */
+    uint32_t state_count;                                 /* 类的状态数量 */
+    uint32_t reserved;                                    /* 保留 */
+    char class_name[SM_OBS_NAME_LEN];                     /* 类名 */
+    char state_names[SM_OBS_MAX_STATES][SM_OBS_NAME_LEN]; /* 状态名(按状态ID) */
+} SmObsHeader;
+
+/**
+ * @brief 观察器(共享内存段的映射)
+ */
+typedef struct
+{
+    SmObsHeader *header; /* 段头 */
+    SmObsSlot *slots;    /* 槽位数组 */
+    size_t map_size;     /* 映射大小 */
+    bool writable;       /* 是否为写端 */
+} SmObserver;
+
+/**
+ * @brief 按 seqlock 协议写入槽位全部字段
+ * @param slot 槽位
+ * @param state 当前状态ID
+ * @param previous_state 上一个状态ID
+ * @param trans_count 状态变更次数
+ * @param now 当前时间
+ */
+static inline void SmObsSlotStore(SmObsSlot *slot, SmStateId state, SmStateId previous_state, uint32_t trans_count,
+                                  uint64_t now)
+{
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->state, state, memory_order_relaxed);
+    atomic_store_explicit(&slot->previous_state, previous_state, memory_order_relaxed);
+    atomic_store_explicit(&slot->trans_count, trans_count, memory_order_relaxed);
+    atomic_store_explicit(&slot->change_time, now, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief 写入一次状态变更(分发线程调用)
+ * @param slot 槽位
+ * @param state 当前状态ID
+ * @param previous_state 上一个状态ID
+ * @param now 当前时间
+ */
+static inline void SmObsSlotWrite(SmObsSlot *slot, SmStateId state, SmStateId previous_state, uint64_t now)
+{
+    uint32_t count = atomic_load_explicit(&slot->trans_count, memory_order_relaxed);
+    SmObsSlotStore(slot, state, previous_state, count + 1, now);
+}
+
+/**
+ * @brief 读取槽位一致快照
+ * @param slot 槽位
+ * @param snapshot 快照(输出)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 重试次数耗尽(写者过于频繁)
+ */
+SmRetCode SmObsSlotRead(const SmObsSlot *slot, SmObsSnapshot *snapshot);
+
+/**
+ * @brief 创建共享内存段(写端)
+ * @param obs 观察器
+ * @param shm_name 共享内存名称(如 "/tcp_sessions")
+ * @param slot_count 槽位数量, 按 machine_id 索引
+ * @param sm_class 状态机类(用于记录类名和状态名)
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmObserverCreate(SmObserver *obs, const char *shm_name, uint32_t slot_count, const SmClass *sm_class);
+
+/**
+ * @brief 只读打开共享内存段(读端, 可在其他进程中调用)
+ * @param obs 观察器
+ * @param shm_name 共享内存名称
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmObserverOpen(SmObserver *obs, const char *shm_name);
+
+/**
+ * @brief 关闭映射
+ * @param obs 观察器
+ */
+void SmObserverClose(SmObserver *obs);
+
+/**
+ * @brief 删除共享内存段
+ * @param shm_name 共享内存名称
+ */
+void SmObserverUnlink(const char *shm_name);
+
+/**
+ * @brief 将状态机实例绑定到其 machine_id 对应的槽位
+ * @param obs 观察器(写端)
+ * @param machine 状态机实例
+ * @return SM_RET_OK 成功, 其他 失败
+ * @note 绑定时写入当前状态, 不计入状态变更次数
+ */
+SmRetCode SmObserverAttach(SmObserver *obs, SmMachine *machine);
+
+/**
+ * @brief 读取指定实例的快照
+ * @param obs 观察器
+ * @param machine_id 实例ID
+ * @param snapshot 快照(输出)
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmObserverRead(const SmObserver *obs, uint32_t machine_id, SmObsSnapshot *snapshot);
+
+/**
+ * @brief 统计各状态的实例数量
+ * @param obs 观察器
+ * @param counts 计数数组(输出), 按状态ID索引
+ * @param state_count 计数数组长度
+ * @return 已停止/未绑定(状态无效)的实例数量
+ */
+uint32_t SmObserverCountStates(const SmObserver *obs, uint32_t *counts, uint32_t state_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMOBSERVER_H__ */
@@ -0,0 +1,134 @@
+#ifndef __SMOS_H__
+#define __SMOS_H__
+
+#include "SmMgr.h"
+
+/*
+ * 操作系统抽象层: 互斥锁, 计数信号量(带超时等待), 单调时钟, 线程.
+ * 默认使用 POSIX 实现(SmOs_posix.c). 移植到 FreeRTOS/RT-Thread 等平台时,
+ * 定义 SM_OS_PORT_TYPES 为该平台的类型头文件(提供 SmOsMutex/SmOsSem/SmOsThread),
+ * 并以 SmOs_<port>.c 实现下面的函数, 例如:
+ *   FreeRTOS:  SemaphoreHandle_t + xSemaphoreTake(ticks), 开启 configUSE_TICKLESS_IDLE
+ *              后分发线程阻塞期间可以进入低功耗
+ *   RT-Thread: struct rt_mutex / struct rt_semaphore + rt_sem_take(ticks)
+ */
+#ifdef SM_OS_PORT_TYPES
+#include SM_OS_PORT_TYPES
+#else
+#include <pthread.h>
+
+typedef pthread_mutex_t SmOsMutex; /* 互斥锁 */
+
+/**
+ * @brief 计数信号量(互斥锁 + 单调时钟条件变量)
+ */
+typedef struct
+{
+    pthread_mutex_t lock; /* 保护计数 */
+    pthread_cond_t cond;  /* 等待条件(CLOCK_MONOTONIC) */
+    uint32_t count;       /* 计数 */
+} SmOsSem;
+
+typedef pthread_t SmOsThread; /* 线程 */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 操作系统抽象
+ * ============================================================================ */
+
+#define SM_OS_WAIT_FOREVER UINT64_MAX /* 无限等待 */
+
+/**
+ * @brief 线程入口函数
+ * @param arg 线程参数
+ */
+typedef void (*SmOsThreadFn)(void *arg);
+
+/**
+ * @brief 初始化互斥锁
+ * @param mutex 互斥锁
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmOsMutexInit(SmOsMutex *mutex);
+
+/**
+ * @brief 销毁互斥锁
+ * @param mutex 互斥锁
+ */
+void SmOsMutexDeinit(SmOsMutex *mutex);
+
+/**
+ * @brief 加锁
+ * @param mutex 互斥锁
+ */
+void SmOsMutexLock(SmOsMutex *mutex);
+
+/**
+ * @brief 解锁
+ * @param mutex 互斥锁
+ */
+void SmOsMutexUnlock(SmOsMutex *mutex);
+
+/**
+ * @brief 初始化信号量
+ * @param sem 信号量
+ * @param initial 初始计数
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmOsSemInit(SmOsSem *sem, uint32_t initial);
+
+/**
+ * @brief 销毁信号量
+ * @param sem 信号量
+ */
+void SmOsSemDeinit(SmOsSem *sem);
+
+/**
+ * @brief 释放信号量(计数加一, 唤醒一个等待者)
+ * @param sem 信号量
+ */
+void SmOsSemPost(SmOsSem *sem);
+
+/**
+ * @brief 等待信号量
+ * @param sem 信号量
+ * @param timeout_us 超时(微秒), 0表示不等待, SM_OS_WAIT_FOREVER 表示无限等待
+ * @return SM_RET_OK 获得信号量, SM_RET_ERROR 超时
+ */
+SmRetCode SmOsSemWait(SmOsSem *sem, uint64_t timeout_us);
+
+/**
+ * @brief 获取单调时钟(微秒)
+ * @return 单调递增的时间, 可直接作为 SmSetTimeFn 的时间源
+ */
+uint64_t SmOsTimeUs(void);
+
+/**
+ * @brief 创建线程
+ * @param thread 线程(输出)
+ * @param fn 入口函数
+ * @param arg 线程参数
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmOsThreadCreate(SmOsThread *thread, SmOsThreadFn fn, void *arg);
+
+/**
+ * @brief 等待线程结束
+ * @param thread 线程
+ */
+void SmOsThreadJoin(SmOsThread *thread);
+
+/**
+ * @brief 让出处理器(忙等待的线程在没有工作时调用)
+ */
+void SmOsYield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMOS_H__ */
@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime/pthread_condattr_setclock */
+
+#include "SmOs.h"
+
+#ifndef SM_OS_PORT_TYPES
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 线程启动参数
+ */
+typedef struct
+{
+    SmOsThreadFn fn; /* 入口函数 */
+    void *arg;       /* 线程参数 */
+} SmOsThreadStart;
+
+static void *SmOsThreadEntry(void *arg)
+{
+    SmOsThreadStart start = *(SmOsThreadStart *)arg;
+    free(arg);
+    start.fn(start.arg);
+    return NULL;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmOsMutexInit(SmOsMutex *mutex)
+{
+    if (mutex == NULL || pthread_mutex_init(mutex, NULL) != 0)
+    {
+        return SM_RET_ERROR;
+    }
+    return SM_RET_OK;
+}
+
+void SmOsMutexDeinit(SmOsMutex *mutex)
+{
+    if (mutex != NULL)
+    {
+        pthread_mutex_destroy(mutex);
+    }
+}
+
+void SmOsMutexLock(SmOsMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void SmOsMutexUnlock(SmOsMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+SmRetCode SmOsSemInit(SmOsSem *sem, uint32_t initial)
+{
+    pthread_condattr_t attr;
+
+    if (sem == NULL || pthread_mutex_init(&sem->lock, NULL) != 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 超时基于单调时钟, 不受系统时间调整影响 */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    int rc = pthread_cond_init(&sem->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (rc != 0)
+    {
+        pthread_mutex_destroy(&sem->lock);
+        return SM_RET_ERROR;
+    }
+
+    sem->count = initial;
+    return SM_RET_OK;
+}
+
+void SmOsSemDeinit(SmOsSem *sem)
+{
+    if (sem != NULL)
+    {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->lock);
+    }
+}
+
+void SmOsSemPost(SmOsSem *sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->count++;
+    pthread_mutex_unlock(&sem->lock);
+    pthread_cond_signal(&sem->cond);
+}
+
+SmRetCode SmOsSemWait(SmOsSem *sem, uint64_t timeout_us)
+{
+    struct timespec deadline;
+
+    if (timeout_us != SM_OS_WAIT_FOREVER)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t)(timeout_us / 1000000);
+        deadline.tv_nsec += (long)(timeout_us % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0)
+    {
+        if (timeout_us == SM_OS_WAIT_FOREVER)
+        {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        }
+        else if (timeout_us == 0 || pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    SmRetCode ret = SM_RET_ERROR;
+    if (sem->count > 0)
+    {
+        sem->count--;
+        ret = SM_RET_OK;
+    }
+    pthread_mutex_unlock(&sem->lock);
+
+    return ret;
+}
+
+uint64_t SmOsTimeUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+SmRetCode SmOsThreadCreate(SmOsThread *thread, SmOsThreadFn fn, void *arg)
+{
+    if (thread == NULL || fn == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmOsThreadStart *start = malloc(sizeof(SmOsThreadStart));
+    if (start == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+    start->fn = fn;
+    start->arg = arg;
+
+    if (pthread_create(thread, NULL, SmOsThreadEntry, start) != 0)
+    {
+        free(start);
+        return SM_RET_ERROR;
+    }
+    return SM_RET_OK;
+}
+
+void SmOsThreadJoin(SmOsThread *thread)
+{
+    if (thread != NULL)
+    {
+        pthread_join(*thread, NULL);
+    }
+}
+
+void SmOsYield(void)
+{
+    sched_yield();
+}
+
+#endif /* SM_OS_PORT_TYPES */
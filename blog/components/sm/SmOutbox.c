@@ -0,0 +1,312 @@
+#include "SmOutbox.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 分配一条记录
+ */
+static SmOutRecord *SmOutboxAlloc(SmOutbox *outbox, uint8_t kind)
+{
+    if (outbox->record_count >= outbox->record_capacity)
+    {
+        outbox->stats.overflow++;
+        return NULL;
+    }
+
+    SmOutRecord *record = &outbox->records[outbox->record_count];
+    memset(record, 0, sizeof(SmOutRecord));
+    record->kind = kind;
+    record->fd = -1;
+    record->seq = outbox->record_count++;
+    outbox->stats.emitted++;
+    return record;
+}
+
+/**
+ * @brief 刷新顺序: 发送(按 fd 分组) -> 关闭 -> 定时器/回调, 组内保持产生顺序
+ */
+static int SmOutboxCompare(const void *a, const void *b)
+{
+    const SmOutRecord *ra = (const SmOutRecord *)a;
+    const SmOutRecord *rb = (const SmOutRecord *)b;
+    int pa = (ra->kind <= SM_OUT_CLOSE) ? ra->kind : SM_OUT_TIMER;
+    int pb = (rb->kind <= SM_OUT_CLOSE) ? rb->kind : SM_OUT_TIMER;
+
+    if (pa != pb)
+    {
+        return pa - pb;
+    }
+    if (pa != SM_OUT_TIMER && ra->fd != rb->fd)
+    {
+        return (ra->fd < rb->fd) ? -1 : 1;
+    }
+    return (ra->seq < rb->seq) ? -1 : (ra->seq > rb->seq);
+}
+
+/**
+ * @brief 报告执行失败
+ */
+static void SmOutboxFail(SmOutbox *outbox, const SmOutRecord *record, int err)
+{
+    outbox->stats.errors++;
+    if (outbox->error_fn != NULL)
+    {
+        outbox->error_fn(outbox->error_ctx, record, err);
+    }
+}
+
+/**
+ * @brief 用一次(或少数几次) writev 发送同一 fd 上连续的发送记录
+ */
+static void SmOutboxWrite(SmOutbox *outbox, const SmOutRecord *records, uint32_t count)
+{
+    struct iovec iov[SM_OUT_IOV_MAX];
+    uint32_t first = 0;
+
+    while (first < count)
+    {
+        uint32_t n = (count - first > SM_OUT_IOV_MAX) ? SM_OUT_IOV_MAX : count - first;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            iov[i].iov_base = outbox->arena + records[first + i].offset;
+            iov[i].iov_len = records[first + i].len;
+        }
+
+        /* 部分写入时从中断处继续 */
+        uint32_t done = 0;
+        while (done < n)
+        {
+            ssize_t written = writev(records[0].fd, &iov[done], (int)(n - done));
+            outbox->stats.syscalls++;
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                int err = errno;
+                for (uint32_t i = done; i < n; i++)
+                {
+                    SmOutboxFail(outbox, &records[first + i], err);
+                }
+                break;
+            }
+
+            size_t left = (size_t)written;
+            while (done < n && left >= iov[done].iov_len)
+            {
+                left -= iov[done].iov_len;
+                done++;
+            }
+            if (done < n)
+            {
+                iov[done].iov_base = (uint8_t *)iov[done].iov_base + left;
+                iov[done].iov_len -= left;
+            }
+        }
+
+        first += n;
+    }
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmOutboxInit(SmOutbox *outbox, SmOutRecord *records, uint32_t record_capacity,
+                       uint8_t *arena, uint32_t arena_size, SmTimerHeap *timers)
+{
+    if (outbox == NULL || records == NULL || record_capacity == 0 || (arena == NULL && arena_size != 0))
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(outbox, 0, sizeof(SmOutbox));
+    outbox->records = records;
+    outbox->record_capacity = record_capacity;
+    outbox->arena = arena;
+    outbox->arena_size = arena_size;
+    outbox->timers = timers;
+
+    return SM_RET_OK;
+}
+
+void SmOutboxSetErrorFn(SmOutbox *outbox, SmOutErrorFn error_fn, void *ctx)
+{
+    if (outbox != NULL)
+    {
+        outbox->error_fn = error_fn;
+        outbox->error_ctx = ctx;
+    }
+}
+
+SmRetCode SmOutboxSend(SmOutbox *outbox, int fd, const void *data, uint32_t len)
+{
+    if (outbox == NULL || fd < 0 || (data == NULL && len != 0))
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (len > outbox->arena_size - outbox->arena_used)
+    {
+        outbox->stats.overflow++;
+        return SM_RET_ERROR;
+    }
+
+    SmOutRecord *record = SmOutboxAlloc(outbox, SM_OUT_SEND);
+    if (record == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    record->fd = fd;
+    record->offset = outbox->arena_used;
+    record->len = len;
+    if (len != 0)
+    {
+        memcpy(outbox->arena + outbox->arena_used, data, len);
+    }
+    outbox->arena_used += len;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmOutboxClose(SmOutbox *outbox, int fd)
+{
+    if (outbox == NULL || fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmOutRecord *record = SmOutboxAlloc(outbox, SM_OUT_CLOSE);
+    if (record == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    record->fd = fd;
+    return SM_RET_OK;
+}
+
+SmRetCode SmOutboxTimer(SmOutbox *outbox, SmMachine *machine, SmEventId event, uint64_t delay)
+{
+    if (outbox == NULL || outbox->timers == NULL || machine == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmOutRecord *record = SmOutboxAlloc(outbox, SM_OUT_TIMER);
+    if (record == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    record->machine = machine;
+    record->event = event;
+    record->deadline = SmGetTime() + delay;
+    return SM_RET_OK;
+}
+
+SmRetCode SmOutboxCall(SmOutbox *outbox, SmOutCallFn fn, void *arg)
+{
+    if (outbox == NULL || fn == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmOutRecord *record = SmOutboxAlloc(outbox, SM_OUT_CALL);
+    if (record == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    record->fn = fn;
+    record->arg = arg;
+    return SM_RET_OK;
+}
+
+SmOutMark SmOutboxMark(const SmOutbox *outbox)
+{
+    SmOutMark mark = { 0, 0 };
+
+    if (outbox != NULL)
+    {
+        mark.records = outbox->record_count;
+        mark.bytes = outbox->arena_used;
+    }
+    return mark;
+}
+
+void SmOutboxRollback(SmOutbox *outbox, SmOutMark mark)
+{
+    if (outbox == NULL || mark.records > outbox->record_count)
+    {
+        return;
+    }
+
+    outbox->stats.rolled_back += outbox->record_count - mark.records;
+    outbox->record_count = mark.records;
+    outbox->arena_used = mark.bytes;
+}
+
+uint32_t SmOutboxFlush(SmOutbox *outbox)
+{
+    if (outbox == NULL || outbox->record_count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t count = outbox->record_count;
+    qsort(outbox->records, count, sizeof(SmOutRecord), SmOutboxCompare);
+
+    uint32_t i = 0;
+    while (i < count)
+    {
+        SmOutRecord *record = &outbox->records[i];
+
+        if (record->kind == SM_OUT_SEND)
+        {
+            uint32_t end = i + 1;
+            while (end < count && outbox->records[end].kind == SM_OUT_SEND && outbox->records[end].fd == record->fd)
+            {
+                end++;
+            }
+            SmOutboxWrite(outbox, record, end - i);
+            i = end;
+            continue;
+        }
+
+        if (record->kind == SM_OUT_CLOSE)
+        {
+            outbox->stats.syscalls++;
+            if (close(record->fd) != 0 && errno != EINTR)
+            {
+                SmOutboxFail(outbox, record, errno);
+            }
+        }
+        else if (record->kind == SM_OUT_TIMER)
+        {
+            if (SmTimerStart(outbox->timers, record->machine, record->event, record->deadline) == SM_TIMER_NONE)
+            {
+                SmOutboxFail(outbox, record, ENOSPC);
+            }
+        }
+        else
+        {
+            record->fn(record->arg);
+        }
+        i++;
+    }
+
+    outbox->stats.flushed += count;
+    outbox->record_count = 0;
+    outbox->arena_used = 0;
+    return count;
+}
@@ -0,0 +1,191 @@
+#ifndef __SMOUTBOX_H__
+#define __SMOUTBOX_H__
+
+#include "SmMgr.h"
+#include "SmTimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 副作用批量输出
+ * ============================================================================ */
+
+/*
+ * 动作/进入/退出函数不直接做 I/O, 而是把输出记录写入所在分发线程的 outbox:
+ *   SmOutboxSend(SmGetOutbox(handle), fd, buf, len)   -- 数据拷贝到 outbox 缓冲区
+ *   SmOutboxClose / SmOutboxTimer / SmOutboxCall
+ * 分发循环在一批事件处理完后调用 SmOutboxFlush:
+ *   - 同一 fd 的全部发送合并为 writev(保持产生顺序)
+ *   - 发送完成后统一关闭 fd
+ *   - 定时器插入和回调按产生顺序执行
+ * SmSendEvent 返回错误(动作失败/进入失败/输出缓冲区满等)时, 本次事件产生的
+ * 记录全部丢弃, 因此副作用只在状态提交成功后才对外可见.
+ *
+ * 约束: 一个 outbox 只由一个分发线程使用; 刷新前缓冲区中的数据不会发送.
+ */
+
+#define SM_OUT_SEND  0 /* 发送数据 */
+#define SM_OUT_CLOSE 1 /* 关闭 fd */
+#define SM_OUT_TIMER 2 /* 启动定时器 */
+#define SM_OUT_CALL  3 /* 调用回调 */
+
+#define SM_OUT_IOV_MAX 64 /* 单次 writev 最多合并的记录数 */
+
+/**
+ * @brief 延迟执行的回调
+ * @param arg 回调参数
+ */
+typedef void (*SmOutCallFn)(void *arg);
+
+/**
+ * @brief 输出记录
+ */
+typedef struct
+{
+    uint8_t kind;       /* 记录类型 SM_OUT_xxx */
+    int fd;             /* 目标 fd(SEND/CLOSE) */
+    uint32_t seq;       /* 产生顺序 */
+    uint32_t offset;    /* 数据在缓冲区中的偏移(SEND) */
+    uint32_t len;       /* 数据长度(SEND) */
+    SmMachine *machine; /* 定时器目标实例(TIMER) */
+    SmEventId event;    /* 定时器到期事件(TIMER) */
+    uint64_t deadline;  /* 定时器截止时间(TIMER) */
+    SmOutCallFn fn;     /* 回调(CALL) */
+    void *arg;          /* 回调参数(CALL) */
+} SmOutRecord;
+
+/**
+ * @brief 刷新失败回调
+ * @param ctx 回调上下文
+ * @param record 失败的记录
+ * @param err errno
+ */
+typedef void (*SmOutErrorFn)(void *ctx, const SmOutRecord *record, int err);
+
+/**
+ * @brief 回滚点
+ */
+typedef struct
+{
+    uint32_t records; /* 记录数量 */
+    uint32_t bytes;   /* 缓冲区已用字节数 */
+} SmOutMark;
+
+/**
+ * @brief 输出缓冲区统计
+ */
+typedef struct
+{
+    uint64_t emitted;     /* 产生的记录数量 */
+    uint64_t rolled_back; /* 因事件处理失败丢弃的记录数量 */
+    uint64_t overflow;    /* 缓冲区满被拒绝的记录数量 */
+    uint64_t flushed;     /* 已执行的记录数量 */
+    uint64_t syscalls;    /* 刷新产生的系统调用次数 */
+    uint64_t errors;      /* 执行失败的记录数量 */
+} SmOutStats;
+
+/**
+ * @brief 输出缓冲区(每个分发线程一个)
+ */
+struct SmOutboxTag
+{
+    SmOutRecord *records;     /* 记录存储 [record_capacity] */
+    uint32_t record_capacity; /* 记录容量 */
+    uint32_t record_count;    /* 记录数量 */
+    uint8_t *arena;           /* 发送数据缓冲区 */
+    uint32_t arena_size;      /* 缓冲区大小 */
+    uint32_t arena_used;      /* 缓冲区已用字节数 */
+    SmTimerHeap *timers;      /* 定时器记录的目标堆(可选) */
+    SmOutErrorFn error_fn;    /* 刷新失败回调(可选) */
+    void *error_ctx;          /* 刷新失败回调上下文 */
+    SmOutStats stats;         /* 统计 */
+};
+
+/**
+ * @brief 初始化输出缓冲区
+ * @param outbox 输出缓冲区
+ * @param records 记录存储 [record_capacity]
+ * @param record_capacity 记录容量
+ * @param arena 发送数据缓冲区
+ * @param arena_size 缓冲区大小
+ * @param timers 定时器记录的目标堆(可选)
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmOutboxInit(SmOutbox *outbox, SmOutRecord *records, uint32_t record_capacity,
+                       uint8_t *arena, uint32_t arena_size, SmTimerHeap *timers);
+
+/**
+ * @brief 设置刷新失败回调
+ * @param outbox 输出缓冲区
+ * @param error_fn 回调, NULL表示只计数
+ * @param ctx 回调上下文
+ */
+void SmOutboxSetErrorFn(SmOutbox *outbox, SmOutErrorFn error_fn, void *ctx);
+
+/**
+ * @brief 产生发送记录(数据拷贝到缓冲区)
+ * @param outbox 输出缓冲区
+ * @param fd 目标 fd
+ * @param data 数据
+ * @param len 数据长度
+ * @return SM_RET_OK 成功, SM_RET_ERROR 缓冲区满或参数错误
+ */
+SmRetCode SmOutboxSend(SmOutbox *outbox, int fd, const void *data, uint32_t len);
+
+/**
+ * @brief 产生关闭记录
+ * @param outbox 输出缓冲区
+ * @param fd 目标 fd
+ * @return SM_RET_OK 成功, SM_RET_ERROR 缓冲区满或参数错误
+ * @note 该 fd 在同一批次中的发送先于关闭执行
+ */
+SmRetCode SmOutboxClose(SmOutbox *outbox, int fd);
+
+/**
+ * @brief 产生定时器记录
+ * @param outbox 输出缓冲区
+ * @param machine 目标实例
+ * @param event 到期事件
+ * @param delay 延迟(从产生时的 SmGetTime 开始计算)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 缓冲区满或未设置定时器堆
+ */
+SmRetCode SmOutboxTimer(SmOutbox *outbox, SmMachine *machine, SmEventId event, uint64_t delay);
+
+/**
+ * @brief 产生回调记录
+ * @param outbox 输出缓冲区
+ * @param fn 回调
+ * @param arg 回调参数
+ * @return SM_RET_OK 成功, SM_RET_ERROR 缓冲区满或参数错误
+ */
+SmRetCode SmOutboxCall(SmOutbox *outbox, SmOutCallFn fn, void *arg);
+
+/**
+ * @brief 获取回滚点
+ * @param outbox 输出缓冲区(可为NULL)
+ * @return 回滚点
+ */
+SmOutMark SmOutboxMark(const SmOutbox *outbox);
+
+/**
+ * @brief 丢弃回滚点之后产生的记录
+ * @param outbox 输出缓冲区(可为NULL)
+ * @param mark 回滚点
+ */
+void SmOutboxRollback(SmOutbox *outbox, SmOutMark mark);
+
+/**
+ * @brief 执行并清空全部记录
+ * @param outbox 输出缓冲区
+ * @return 执行的记录数量
+ * @note 不可在动作/进入/退出函数中调用
+ */
+uint32_t SmOutboxFlush(SmOutbox *outbox);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMOUTBOX_H__ */
@@ -0,0 +1,258 @@
+#include "SmPopIndex.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_POP_ALIGN8(n) (((n) + 7u) & ~(size_t)7u)
+
+static bool SmPopValid(const SmPopIndex *index, SmStateId state_id)
+{
+    return state_id >= 0 && state_id < index->state_count;
+}
+
+/*
+ * 多写者时摘要位与位图字之间是"先写后读"的配对(store buffering):
+ *   加入方: 置位图字 -> 字原为空时置摘要位
+ *   枚举方: 清摘要位 -> 复查位图字, 非空时重新置位
+ * 两边的写和随后的读都用 seq_cst, 保证至少一方看到另一方的写: 要么加入方的
+ * 摘要置位排在清除之后, 要么枚举方复查时看到新置的位, 摘要位不会在字非空时丢失.
+ */
+static void SmPopAdd(SmPopIndex *index, SmStateId state_id, uint32_t id)
+{
+    atomic_uint *count = &index->counts[state_id];
+    atomic_ullong *word = &index->bits[(size_t)state_id * index->words + (id >> 6)];
+    atomic_ullong *summary = &index->summary[(size_t)state_id * index->summary_words + (id >> 12)];
+    unsigned long long bit = 1ULL << (id & 63);
+    unsigned long long summary_bit = 1ULL << ((id >> 6) & 63);
+
+    if (index->single_writer)
+    {
+        unsigned long long old = atomic_load_explicit(word, memory_order_relaxed);
+        atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_store_explicit(word, old | bit, memory_order_release);
+        if (old == 0)
+        {
+            atomic_store_explicit(summary, atomic_load_explicit(summary, memory_order_relaxed) | summary_bit,
+                                  memory_order_release);
+        }
+        return;
+    }
+
+    atomic_fetch_add_explicit(count, 1, memory_order_relaxed);
+    if (atomic_fetch_or_explicit(word, bit, memory_order_seq_cst) == 0)
+    {
+        atomic_fetch_or_explicit(summary, summary_bit, memory_order_seq_cst);
+    }
+}
+
+static void SmPopRemove(SmPopIndex *index, SmStateId state_id, uint32_t id)
+{
+    atomic_uint *count = &index->counts[state_id];
+    atomic_ullong *word = &index->bits[(size_t)state_id * index->words + (id >> 6)];
+    unsigned long long bit = 1ULL << (id & 63);
+
+    if (index->single_writer)
+    {
+        /* 单写者: 字变空时直接清摘要位, 枚举方不修改摘要 */
+        unsigned long long now = atomic_load_explicit(word, memory_order_relaxed) & ~bit;
+        atomic_store_explicit(word, now, memory_order_release);
+        atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) - 1, memory_order_relaxed);
+        if (now == 0)
+        {
+            atomic_ullong *summary = &index->summary[(size_t)state_id * index->summary_words + (id >> 12)];
+            atomic_store_explicit(summary,
+                                  atomic_load_explicit(summary, memory_order_relaxed) & ~(1ULL << ((id >> 6) & 63)),
+                                  memory_order_relaxed);
+        }
+        return;
+    }
+
+    /* 多写者: 字变空时不清摘要位, 由枚举方清理, 避免与并发置位竞争 */
+    atomic_fetch_and_explicit(word, ~bit, memory_order_release);
+    atomic_fetch_sub_explicit(count, 1, memory_order_relaxed);
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+size_t SmPopIndexCalcSize(uint16_t state_count, uint32_t capacity)
+{
+    size_t words = ((size_t)capacity + 63) / 64;
+    size_t summary_words = (words + 63) / 64;
+
+    return SM_POP_ALIGN8(sizeof(atomic_uint) * state_count) +
+           sizeof(atomic_ullong) * state_count * (words + summary_words) +
+           sizeof(SmMachine *) * capacity;
+}
+
+SmRetCode SmPopIndexInit(SmPopIndex *index, uint16_t state_count, uint32_t capacity, void *buf, size_t buf_size,
+                         uint32_t flags)
+{
+    if (index == NULL || buf == NULL || state_count == 0 || capacity == 0 ||
+        ((uintptr_t)buf & 7u) != 0 || buf_size < SmPopIndexCalcSize(state_count, capacity))
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(index, 0, sizeof(SmPopIndex));
+    index->state_count = state_count;
+    index->capacity = capacity;
+    index->words = (capacity + 63) / 64;
+    index->summary_words = (index->words + 63) / 64;
+    index->single_writer = (flags & SM_POP_SINGLE_WRITER) != 0;
+
+    uint8_t *p = (uint8_t *)buf;
+    index->counts = (atomic_uint *)p;
+    p += SM_POP_ALIGN8(sizeof(atomic_uint) * state_count);
+    index->bits = (atomic_ullong *)p;
+    p += sizeof(atomic_ullong) * state_count * index->words;
+    index->summary = (atomic_ullong *)p;
+    p += sizeof(atomic_ullong) * state_count * index->summary_words;
+    index->machines = (SmMachine *_Atomic *)p;
+
+    for (uint16_t i = 0; i < state_count; i++)
+    {
+        atomic_init(&index->counts[i], 0);
+    }
+    for (size_t i = 0; i < (size_t)state_count * (index->words + index->summary_words); i++)
+    {
+        atomic_init(&index->bits[i], 0);
+    }
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&index->machines[i], NULL);
+    }
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmPopIndexAttach(SmPopIndex *index, SmMachine *machine)
+{
+    if (index == NULL || machine == NULL || !machine->is_initialized || machine->pop_index != NULL ||
+        machine->machine_id >= index->capacity)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmMachine *expected = NULL;
+    if (!atomic_compare_exchange_strong(&index->machines[machine->machine_id], &expected, machine))
+    {
+        return SM_RET_ERROR;
+    }
+
+    machine->pop_index = index;
+    if (SmPopValid(index, machine->current_state))
+    {
+        SmPopAdd(index, machine->current_state, machine->machine_id);
+    }
+
+    return SM_RET_OK;
+}
+
+void SmPopIndexDetach(SmMachine *machine)
+{
+    if (machine == NULL || machine->pop_index == NULL)
+    {
+        return;
+    }
+
+    SmPopIndex *index = machine->pop_index;
+    if (SmPopValid(index, machine->current_state))
+    {
+        SmPopRemove(index, machine->current_state, machine->machine_id);
+    }
+    atomic_store_explicit(&index->machines[machine->machine_id], NULL, memory_order_release);
+    machine->pop_index = NULL;
+}
+
+void SmPopIndexMove(SmMachine *machine, SmStateId old_state, SmStateId new_state)
+{
+    SmPopIndex *index = machine->pop_index;
+
+    if (old_state == new_state)
+    {
+        return;
+    }
+
+    /* 先加入新状态再离开旧状态: 并发枚举不会漏掉实例 */
+    if (SmPopValid(index, new_state))
+    {
+        SmPopAdd(index, new_state, machine->machine_id);
+    }
+    if (SmPopValid(index, old_state))
+    {
+        SmPopRemove(index, old_state, machine->machine_id);
+    }
+}
+
+uint32_t SmPopCount(const SmPopIndex *index, SmStateId state_id)
+{
+    if (index == NULL || !SmPopValid(index, state_id))
+    {
+        return 0;
+    }
+
+    return atomic_load_explicit(&index->counts[state_id], memory_order_relaxed);
+}
+
+uint32_t SmPopForEach(SmPopIndex *index, SmStateId state_id, SmPopVisitFn fn, void *ctx)
+{
+    uint32_t visited = 0;
+
+    if (index == NULL || fn == NULL || !SmPopValid(index, state_id))
+    {
+        return 0;
+    }
+
+    atomic_ullong *bits = &index->bits[(size_t)state_id * index->words];
+    atomic_ullong *summary = &index->summary[(size_t)state_id * index->summary_words];
+
+    for (uint32_t s = 0; s < index->summary_words; s++)
+    {
+        unsigned long long group = atomic_load_explicit(&summary[s], memory_order_acquire);
+        while (group != 0)
+        {
+            uint32_t w = s * 64 + (uint32_t)__builtin_ctzll(group);
+            unsigned long long group_bit = group & (~group + 1);
+            group &= group - 1;
+
+            /* 字已空: 先清摘要位再复查(与 SmPopAdd 配对, 见上), 与并发置位交错时重新置位 */
+            unsigned long long word = atomic_load_explicit(&bits[w], memory_order_acquire);
+            if (word == 0)
+            {
+                if (!index->single_writer)
+                {
+                    atomic_fetch_and_explicit(&summary[s], ~group_bit, memory_order_seq_cst);
+                    if (atomic_load_explicit(&bits[w], memory_order_seq_cst) != 0)
+                    {
+                        atomic_fetch_or_explicit(&summary[s], group_bit, memory_order_seq_cst);
+                    }
+                }
+                continue;
+            }
+
+            /* 按快照访问, 回调中发生的转换不影响本次枚举 */
+            while (word != 0)
+            {
+                uint32_t id = w * 64 + (uint32_t)__builtin_ctzll(word);
+                word &= word - 1;
+
+                SmMachine *machine = atomic_load_explicit(&index->machines[id], memory_order_acquire);
+                if (machine == NULL)
+                {
+                    continue;
+                }
+                visited++;
+                if (!fn(ctx, machine))
+                {
+                    return visited;
+                }
+            }
+        }
+    }
+
+    return visited;
+}
@@ -0,0 +1,127 @@
+#ifndef __SMPOPINDEX_H__
+#define __SMPOPINDEX_H__
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 状态成员索引
+ * ============================================================================ */
+
+/*
+ * 按状态维护实例计数和成员位图, 回答"多少会话处于 AUTHENTICATED"(O(1))和
+ * "断开所有 ERROR 会话"(O(成员数))这类问题, 不需要遍历全部实例:
+ *   - 每个状态一个计数器和一张按 machine_id 索引的位图
+ *   - 每 64 个位图字对应一个摘要位, 枚举时跳过空白区域; 摘要位只在位图字
+ *     由空变为非空时置位, 字变空后由枚举方(或单写者的移出操作)清除
+ *   - 状态变化时在 SmCommitState 中更新: 两次计数加减 + 两次位操作
+ * 默认所有更新都是原子读-改-写, 多个分发线程中的实例可以共用一个索引(每次状态
+ * 变化约 4 次带锁操作); 全部实例在同一个分发线程中时用 SM_POP_SINGLE_WRITER,
+ * 更新退化为普通的原子读写, 其他线程仍可随时计数/枚举. 并发转换期间计数/枚举
+ * 是近似快照(实例可能短暂同时出现在新旧两个状态中).
+ *
+ * 内存: 位图按 状态数 x 容量 分配, 约 state_count * capacity / 8 字节
+ *       (另加 1/64 的摘要和每实例 8 字节指针), 例如 4000 状态 x 100 万实例约 500 MB.
+ *       只统计ID小于 state_count 的状态, 状态很多时可只为ID较小的关键状态建索引.
+ *
+ * 约束: 按状态ID索引, 只统计 0 <= 状态ID < state_count 的状态;
+ *       实例需先用 SmSetMachineId 设置小于 capacity 的ID.
+ */
+
+#define SM_POP_SINGLE_WRITER 0x01 /* 所有转换/加入/退出都在同一个线程中 */
+
+/**
+ * @brief 枚举回调
+ * @param ctx 用户上下文
+ * @param machine 状态成员
+ * @return true 继续, false 停止枚举
+ */
+typedef bool (*SmPopVisitFn)(void *ctx, SmMachine *machine);
+
+/**
+ * @brief 状态成员索引
+ */
+struct SmPopIndexTag
+{
+    uint16_t state_count;         /* 状态数量 */
+    uint32_t capacity;            /* 实例ID容量 */
+    uint32_t words;               /* 每个状态的位图字数 */
+    uint32_t summary_words;       /* 每个状态的摘要字数 */
+    bool single_writer;           /* SM_POP_SINGLE_WRITER: 更新不使用读-改-写 */
+    atomic_uint *counts;          /* 各状态实例数量 [state_count] */
+    atomic_ullong *bits;          /* 成员位图 [state_count][words] */
+    atomic_ullong *summary;       /* 摘要位图 [state_count][summary_words], 置位表示对应字可能非空 */
+    SmMachine *_Atomic *machines; /* 实例ID -> 实例 [capacity] */
+};
+
+/**
+ * @brief 计算索引所需内存大小
+ * @param state_count 状态数量
+ * @param capacity 实例ID容量
+ * @return 所需字节数, 约 state_count * capacity / 8 + capacity * 8
+ */
+size_t SmPopIndexCalcSize(uint16_t state_count, uint32_t capacity);
+
+/**
+ * @brief 初始化索引
+ * @param index 索引
+ * @param state_count 状态数量
+ * @param capacity 实例ID容量
+ * @param buf 存储(8字节对齐, 至少 SmPopIndexCalcSize 字节)
+ * @param buf_size 存储大小
+ * @param flags SM_POP_SINGLE_WRITER 等
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmPopIndexInit(SmPopIndex *index, uint16_t state_count, uint32_t capacity, void *buf, size_t buf_size,
+                         uint32_t flags);
+
+/**
+ * @brief 加入索引
+ * @param index 索引
+ * @param machine 状态机实例(已运行时按当前状态计入)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效/ID越界/ID已被占用
+ */
+SmRetCode SmPopIndexAttach(SmPopIndex *index, SmMachine *machine);
+
+/**
+ * @brief 退出索引(SmDestroy 自动调用)
+ * @param machine 状态机实例
+ */
+void SmPopIndexDetach(SmMachine *machine);
+
+/**
+ * @brief 更新成员关系(由 SmMgr 在提交状态时调用)
+ * @param machine 状态机实例
+ * @param old_state 原状态ID
+ * @param new_state 新状态ID
+ */
+void SmPopIndexMove(SmMachine *machine, SmStateId old_state, SmStateId new_state);
+
+/**
+ * @brief 获取状态的实例数量
+ * @param index 索引
+ * @param state_id 状态ID
+ * @return 实例数量
+ */
+uint32_t SmPopCount(const SmPopIndex *index, SmStateId state_id);
+
+/**
+ * @brief 枚举状态的成员
+ * @param index 索引
+ * @param state_id 状态ID
+ * @param fn 回调(可以在回调中向实例发送事件)
+ * @param ctx 用户上下文
+ * @return 访问的实例数量
+ */
+uint32_t SmPopForEach(SmPopIndex *index, SmStateId state_id, SmPopVisitFn fn, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMPOPINDEX_H__ */
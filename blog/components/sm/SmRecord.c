@@ -0,0 +1,361 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime/clock_nanosleep/ftruncate */
+
+#include "SmRecord.h"
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 单调时钟(纳秒), 用于回放计时和节奏控制
+ */
+static uint64_t SmRecNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 映射日志文件
+ */
+static SmRetCode SmRecorderMap(SmRecorder *rec, size_t map_size)
+{
+    if (ftruncate(rec->fd, (off_t)map_size) != 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    void *addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, rec->fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        return SM_RET_ERROR;
+    }
+
+    rec->base = (uint8_t *)addr;
+    rec->map_size = map_size;
+    return SM_RET_OK;
+}
+
+/**
+ * @brief 扩展日志文件, 保证记录区还能写入 need 字节
+ */
+static SmRetCode SmRecorderReserve(SmRecorder *rec, uint64_t data_size, size_t need)
+{
+    size_t used = sizeof(SmRecHeader) + (size_t)data_size;
+    if (used + need <= rec->map_size)
+    {
+        return SM_RET_OK;
+    }
+
+    size_t grow = (need > SM_REC_GROW_SIZE) ? need : SM_REC_GROW_SIZE;
+    size_t old_size = rec->map_size;
+    uint8_t *old_base = rec->base;
+
+    if (SmRecorderMap(rec, old_size + grow) != SM_RET_OK)
+    {
+        rec->base = old_base;
+        rec->map_size = old_size;
+        return SM_RET_ERROR;
+    }
+
+    munmap(old_base, old_size);
+    return SM_RET_OK;
+}
+
+/**
+ * @brief 分发完成钩子: 追加记录
+ */
+static void SmRecorderOnEvent(void *ctx, SmMachine *machine, SmEventId event,
+                              const void *data, uint16_t len, SmRetCode ret)
+{
+    SmRecorderAppend((SmRecorder *)ctx, machine->machine_id, event, machine->current_state, ret, data, len);
+}
+
+/* ============================================================================
+ * 记录器
+ * ============================================================================ */
+
+SmRetCode SmRecorderCreate(SmRecorder *rec, const char *path, const SmClass *sm_class, uint32_t tick_ns)
+{
+    if (rec == NULL || path == NULL || sm_class == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(rec, 0, sizeof(SmRecorder));
+
+    rec->fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (rec->fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (SmRecorderMap(rec, SM_REC_GROW_SIZE) != SM_RET_OK)
+    {
+        close(rec->fd);
+        return SM_RET_ERROR;
+    }
+
+    SmRecHeader *header = (SmRecHeader *)rec->base;
+    memset(header, 0, sizeof(SmRecHeader));
+    header->magic = SM_REC_MAGIC;
+    header->version = SM_REC_VERSION;
+    header->tick_ns = (tick_ns != 0) ? tick_ns : 1000;
+    if (sm_class->class_name != NULL)
+    {
+        strncpy(header->class_name, sm_class->class_name, SM_REC_NAME_LEN - 1);
+    }
+    atomic_init(&header->data_size, 0);
+    atomic_init(&header->record_count, 0);
+
+    rec->hooks.on_event = SmRecorderOnEvent;
+    rec->hooks.ctx = rec;
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmRecorderAttach(SmRecorder *rec, SmMachine *machine)
+{
+    if (rec == NULL || rec->base == NULL || machine == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmSetHooks(machine, &rec->hooks);
+    return SM_RET_OK;
+}
+
+SmRetCode SmRecorderAppend(SmRecorder *rec, uint32_t machine_id, SmEventId event, SmStateId state,
+                           SmRetCode result, const void *data, uint16_t len)
+{
+    if (rec == NULL || rec->base == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmRecHeader *header = (SmRecHeader *)rec->base;
+    uint64_t data_size = atomic_load_explicit(&header->data_size, memory_order_relaxed);
+    size_t entry_size = SM_REC_ALIGN(sizeof(SmRecEntry) + (data != NULL ? len : 0));
+
+    if (SmRecorderReserve(rec, data_size, entry_size) != SM_RET_OK)
+    {
+        rec->dropped++;
+        return SM_RET_ERROR;
+    }
+    header = (SmRecHeader *)rec->base; /* 扩展后映射地址可能变化 */
+
+    /* 时间增量(首条记录为0) */
+    uint64_t now = SmGetTime();
+    uint64_t count = atomic_load_explicit(&header->record_count, memory_order_relaxed);
+    uint64_t delta = 0;
+    if (count == 0)
+    {
+        header->start_time = now;
+    }
+    else if (now > rec->last_time)
+    {
+        delta = now - rec->last_time;
+    }
+    rec->last_time = now;
+
+    SmRecEntry *entry = (SmRecEntry *)(rec->base + sizeof(SmRecHeader) + data_size);
+    entry->time_delta = (delta > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta;
+    entry->machine_id = machine_id;
+    entry->event_id = (int32_t)event;
+    entry->state = (int32_t)state;
+    entry->result = (int32_t)result;
+    entry->data_len = (data != NULL) ? len : 0;
+    entry->reserved = 0;
+    if (entry->data_len > 0)
+    {
+        memcpy((uint8_t *)entry + sizeof(SmRecEntry), data, len);
+    }
+
+    /* 先写记录再提交大小, 同时映射该文件的读者只会看到完整记录 */
+    atomic_store_explicit(&header->data_size, data_size + entry_size, memory_order_release);
+    atomic_store_explicit(&header->record_count, count + 1, memory_order_relaxed);
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmRecorderClose(SmRecorder *rec)
+{
+    if (rec == NULL || rec->base == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmRecHeader *header = (SmRecHeader *)rec->base;
+    size_t used = sizeof(SmRecHeader) + (size_t)atomic_load(&header->data_size);
+
+    munmap(rec->base, rec->map_size);
+    SmRetCode ret = (ftruncate(rec->fd, (off_t)used) == 0) ? SM_RET_OK : SM_RET_ERROR;
+    close(rec->fd);
+
+    memset(rec, 0, sizeof(SmRecorder));
+    rec->fd = -1;
+    return ret;
+}
+
+/* ============================================================================
+ * 日志读取
+ * ============================================================================ */
+
+SmRetCode SmRecLogOpen(SmRecLog *log, const char *path)
+{
+    if (log == NULL || path == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(log, 0, sizeof(SmRecLog));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SmRecHeader))
+    {
+        close(fd);
+        return SM_RET_ERROR;
+    }
+
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const SmRecHeader *header = (const SmRecHeader *)addr;
+    if (header->magic != SM_REC_MAGIC || header->version != SM_REC_VERSION)
+    {
+        munmap(addr, (size_t)st.st_size);
+        return SM_RET_ERROR;
+    }
+
+    /* 录制中的文件只读取已提交部分 */
+    uint64_t data_size = atomic_load_explicit(&((SmRecHeader *)addr)->data_size, memory_order_acquire);
+    if (data_size > (uint64_t)st.st_size - sizeof(SmRecHeader))
+    {
+        data_size = (uint64_t)st.st_size - sizeof(SmRecHeader);
+    }
+
+    log->header = header;
+    log->data = (const uint8_t *)addr + sizeof(SmRecHeader);
+    log->data_size = data_size;
+    log->map_size = (size_t)st.st_size;
+
+    return SM_RET_OK;
+}
+
+void SmRecLogClose(SmRecLog *log)
+{
+    if (log != NULL && log->header != NULL)
+    {
+        munmap((void *)log->header, log->map_size);
+        memset(log, 0, sizeof(SmRecLog));
+    }
+}
+
+const SmRecEntry *SmRecLogNext(const SmRecLog *log, uint64_t *offset)
+{
+    if (log == NULL || log->data == NULL || offset == NULL)
+    {
+        return NULL;
+    }
+
+    if (*offset + sizeof(SmRecEntry) > log->data_size)
+    {
+        return NULL;
+    }
+
+    const SmRecEntry *entry = (const SmRecEntry *)(log->data + *offset);
+    size_t entry_size = SM_REC_ALIGN(sizeof(SmRecEntry) + entry->data_len);
+    if (*offset + entry_size > log->data_size)
+    {
+        return NULL; /* 记录被截断 */
+    }
+
+    *offset += entry_size;
+    return entry;
+}
+
+/* ============================================================================
+ * 回放
+ * ============================================================================ */
+
+SmRetCode SmReplay(const SmRecLog *log, SmMachine *pool, uint32_t pool_size, uint32_t pace_percent,
+                   SmReplayResult *result)
+{
+    if (log == NULL || log->header == NULL || pool == NULL || pool_size == 0 || result == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    const char *class_name = pool[0].sm_class ? pool[0].sm_class->class_name : NULL;
+    if (class_name == NULL || strncmp(class_name, log->header->class_name, SM_REC_NAME_LEN - 1) != 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(result, 0, sizeof(SmReplayResult));
+    result->first_mismatch = UINT64_MAX;
+
+    uint64_t start = SmRecNowNs();
+    uint64_t ticks = 0;
+    uint64_t offset = 0;
+    const SmRecEntry *entry;
+
+    while ((entry = SmRecLogNext(log, &offset)) != NULL)
+    {
+        uint64_t index = result->events + result->skipped;
+
+        /* 按原始节奏: 等待到 (累计时间 * 100 / pace_percent) */
+        ticks += entry->time_delta;
+        if (pace_percent > 0)
+        {
+            uint64_t due = start + ticks * log->header->tick_ns * 100 / pace_percent;
+            if (due > SmRecNowNs())
+            {
+                struct timespec ts = { .tv_sec = (time_t)(due / 1000000000ULL),
+                                       .tv_nsec = (long)(due % 1000000000ULL) };
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+            }
+        }
+
+        if (entry->machine_id >= pool_size)
+        {
+            result->skipped++;
+            continue;
+        }
+
+        SmMachine *machine = &pool[entry->machine_id];
+        SmRetCode ret = SmSendEventEx(machine, entry->event_id,
+                                      entry->data_len ? SmRecEntryData(entry) : NULL, entry->data_len);
+        result->events++;
+
+        /* 核对分发结果和分发后的状态 */
+        if (ret != entry->result || machine->current_state != entry->state)
+        {
+            if (result->mismatches == 0)
+            {
+                result->first_mismatch = index;
+            }
+            result->mismatches++;
+        }
+    }
+
+    result->elapsed_ns = SmRecNowNs() - start;
+    return SM_RET_OK;
+}
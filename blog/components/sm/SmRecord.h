@@ -0,0 +1,183 @@
+#ifndef __SMRECORD_H__
+#define __SMRECORD_H__
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 事件记录与回放
+ * ============================================================================ */
+
+/*
+ * 记录器通过 SmHooks 接入分发路径, 把每个外部发送的事件追加到内存映射的
+ * 日志文件中: [段头][记录][记录]...
+ * 每条记录为 24 字节定长头 + 负载(按4字节对齐), 时间以增量方式保存.
+ * 回放器把日志重新发送给同一个类的新实例, 并逐条核对分发后的状态和结果,
+ * 可以全速回放(吞吐基准)或按原始节奏回放(复现现场).
+ */
+
+#define SM_REC_MAGIC     0x534D5243   /* "SMRC" */
+#define SM_REC_VERSION   2            /* 文件格式版本(2: 事件/状态/结果扩展为32位) */
+#define SM_REC_NAME_LEN  32           /* 类名最大长度(含结束符) */
+#define SM_REC_GROW_SIZE (4u << 20)   /* 日志文件每次扩展的字节数 */
+#define SM_REC_ALIGN(x)  (((x) + 3u) & ~(size_t)3u)
+
+/**
+ * @brief 日志文件头
+ */
+typedef struct
+{
+    uint32_t magic;                   /* SM_REC_MAGIC */
+    uint32_t version;                 /* SM_REC_VERSION */
+    uint32_t tick_ns;                 /* 时间单位(每个 SmGetTime 计数的纳秒数) */
+    uint32_t reserved;                /* 保留 */
+    uint64_t start_time;              /* 第一条记录的时间 */
+    _Atomic uint64_t data_size;       /* 记录区已提交字节数 */
+    _Atomic uint64_t record_count;    /* 已提交记录数 */
+    char class_name[SM_REC_NAME_LEN]; /* 类名 */
+} SmRecHeader;
+
+/**
+ * @brief 单条记录(后跟 data_len 字节负载)
+ */
+typedef struct
+{
+    uint32_t time_delta; /* 与上一条记录的时间差(超出范围时饱和) */
+    uint32_t machine_id; /* 实例ID */
+    int32_t event_id;    /* 事件ID */
+    int32_t state;       /* 分发后的状态ID */
+    int32_t result;      /* 分发结果 */
+    uint16_t data_len;   /* 负载长度 */
+    uint16_t reserved;   /* 保留(填充为0) */
+} SmRecEntry;
+
+/**
+ * @brief 记录器(写端, 单线程使用)
+ */
+typedef struct
+{
+    int fd;              /* 日志文件描述符 */
+    uint8_t *base;       /* 映射基址 */
+    size_t map_size;     /* 映射大小 */
+    uint64_t last_time;  /* 上一条记录的时间 */
+    uint32_t dropped;    /* 扩展文件失败而丢弃的记录数 */
+    SmHooks hooks;       /* 绑定到实例的钩子 */
+} SmRecorder;
+
+/**
+ * @brief 日志(读端)
+ */
+typedef struct
+{
+    const SmRecHeader *header; /* 文件头 */
+    const uint8_t *data;       /* 记录区 */
+    uint64_t data_size;        /* 记录区大小 */
+    size_t map_size;           /* 映射大小 */
+} SmRecLog;
+
+/**
+ * @brief 回放结果
+ */
+typedef struct
+{
+    uint64_t events;         /* 回放的事件数量 */
+    uint64_t mismatches;     /* 状态或结果与记录不一致的数量 */
+    uint64_t first_mismatch; /* 第一条不一致记录的序号, UINT64_MAX 表示无 */
+    uint64_t skipped;        /* 实例ID超出实例池而跳过的数量 */
+    uint64_t elapsed_ns;     /* 回放耗时 */
+} SmReplayResult;
+
+/**
+ * @brief 获取记录的负载
+ * @param entry 记录
+ * @return 负载指针
+ */
+static inline const void *SmRecEntryData(const SmRecEntry *entry)
+{
+    return (const uint8_t *)entry + sizeof(SmRecEntry);
+}
+
+/**
+ * @brief 创建日志文件
+ * @param rec 记录器
+ * @param path 文件路径(已存在时覆盖)
+ * @param sm_class 状态机类(记录类名, 回放时校验)
+ * @param tick_ns 时间源单位, 0表示微秒
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmRecorderCreate(SmRecorder *rec, const char *path, const SmClass *sm_class, uint32_t tick_ns);
+
+/**
+ * @brief 将状态机实例的事件记录到日志
+ * @param rec 记录器
+ * @param machine 状态机实例(按 machine_id 区分)
+ * @return SM_RET_OK 成功, 其他 失败
+ * @note 会替换实例已有的扩展钩子
+ */
+SmRetCode SmRecorderAttach(SmRecorder *rec, SmMachine *machine);
+
+/**
+ * @brief 追加一条记录
+ * @param rec 记录器
+ * @param machine_id 实例ID
+ * @param event 事件ID
+ * @param state 分发后的状态ID
+ * @param result 分发结果
+ * @param data 负载(可为NULL)
+ * @param len 负载长度
+ * @return SM_RET_OK 成功, SM_RET_ERROR 扩展文件失败(计入 dropped)
+ */
+SmRetCode SmRecorderAppend(SmRecorder *rec, uint32_t machine_id, SmEventId event, SmStateId state,
+                           SmRetCode result, const void *data, uint16_t len);
+
+/**
+ * @brief 关闭日志文件(截断到实际大小)
+ * @param rec 记录器
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmRecorderClose(SmRecorder *rec);
+
+/**
+ * @brief 只读打开日志文件
+ * @param log 日志
+ * @param path 文件路径
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmRecLogOpen(SmRecLog *log, const char *path);
+
+/**
+ * @brief 关闭日志文件
+ * @param log 日志
+ */
+void SmRecLogClose(SmRecLog *log);
+
+/**
+ * @brief 遍历日志记录
+ * @param log 日志
+ * @param offset 记录区偏移(输入输出, 从0开始)
+ * @return 记录指针, NULL表示已到末尾或记录损坏
+ */
+const SmRecEntry *SmRecLogNext(const SmRecLog *log, uint64_t *offset);
+
+/**
+ * @brief 回放日志
+ * @param log 日志
+ * @param pool 实例池, 按 machine_id 索引, 调用者需已创建并启动到录制开始时的状态
+ * @param pool_size 实例池大小
+ * @param pace_percent 回放速度, 0表示全速, 100表示原始节奏, 1000表示10倍速
+ * @param result 回放结果(输出)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数错误或类名不一致
+ */
+SmRetCode SmReplay(const SmRecLog *log, SmMachine *pool, uint32_t pool_size, uint32_t pace_percent,
+                   SmReplayResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMRECORD_H__ */
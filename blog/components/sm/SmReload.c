@@ -0,0 +1,293 @@
+#include "SmReload.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 查找状态下标
+ */
+static int32_t SmReloadStateIndex(const SmClass *sm_class, SmStateId state_id)
+{
+    if (state_id >= 0 && state_id < sm_class->state_count && sm_class->states[state_id].state_id == state_id)
+    {
+        return state_id;
+    }
+
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        if (sm_class->states[i].state_id == state_id)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 把上一版本中的状态映射到下一版本
+ */
+static SmStateId SmReloadMapState(const SmClassVersion *prev, const SmClassVersion *next, SmStateId state)
+{
+    if (state == SM_STATE_INVALID)
+    {
+        return SM_STATE_INVALID;
+    }
+
+    int32_t index = SmReloadStateIndex(prev->sm_class, state);
+    SmStateId mapped = state;
+    if (next->state_map != NULL)
+    {
+        mapped = (index >= 0 && index < next->map_count) ? next->state_map[index] : SM_STATE_INVALID;
+    }
+
+    if (mapped == SM_STATE_INVALID || SmReloadStateIndex(next->sm_class, mapped) < 0)
+    {
+        mapped = next->fallback_state;
+    }
+
+    return mapped;
+}
+
+/**
+ * @brief 分配版本节点
+ */
+static SmClassVersion *SmReloadNewVersion(const SmClass *sm_class, const SmStateId *state_map,
+                                          uint16_t map_count, SmStateId fallback_state, uint32_t number)
+{
+    SmClassVersion *version = malloc(sizeof(SmClassVersion));
+    if (version == NULL)
+    {
+        return NULL;
+    }
+
+    version->sm_class = sm_class;
+    version->state_map = state_map;
+    version->map_count = map_count;
+    version->fallback_state = fallback_state;
+    version->number = number;
+    atomic_init(&version->next, NULL);
+    return version;
+}
+
+/**
+ * @brief 释放版本节点
+ */
+static void SmReloadFreeVersion(SmReloadDomain *domain, SmClassVersion *version)
+{
+    if (domain->free_fn != NULL)
+    {
+        domain->free_fn(domain->free_ctx, version->sm_class, version->state_map);
+    }
+    free(version);
+    domain->reclaimed++;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmReloadInit(SmReloadDomain *domain, const SmClass *initial_class, SmReloadFreeFn free_fn, void *free_ctx)
+{
+    if (domain == NULL || initial_class == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(domain, 0, sizeof(SmReloadDomain));
+
+    SmClassVersion *version = SmReloadNewVersion(initial_class, NULL, 0, SM_STATE_INVALID, 1);
+    if (version == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    domain->oldest = version;
+    domain->free_fn = free_fn;
+    domain->free_ctx = free_ctx;
+    for (uint32_t i = 0; i < SM_RELOAD_MAX_READERS; i++)
+    {
+        atomic_init(&domain->readers[i], NULL);
+    }
+    atomic_init(&domain->reader_count, 0);
+    atomic_store_explicit(&domain->current, version, memory_order_release);
+
+    return SM_RET_OK;
+}
+
+SmRetCode SmReloadRegister(SmReloadDomain *domain, SmReloadReader *reader)
+{
+    if (domain == NULL || reader == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 1. 原子占用槽位, 并发注册的读者不会写入同一个槽位 */
+    uint32_t slot = atomic_fetch_add_explicit(&domain->reader_count, 1, memory_order_seq_cst);
+    if (slot >= SM_RELOAD_MAX_READERS)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 2. 先以版本号 0 公布读者(暂时阻止任何回收), 再读取 current.
+     *    与 SmReloadReclaim 配对(全部 seq_cst): 回收先读 current 再读读者槽位;
+     *    如果回收没有看到本读者, 本读者随后读到的 current 不早于回收读到的版本,
+     *    而回收不会释放它读到的 current, 因此取到的版本不会在公布前被释放 */
+    reader->version = NULL;
+    atomic_init(&reader->seen, 0);
+    atomic_store_explicit(&domain->readers[slot], reader, memory_order_seq_cst);
+
+    reader->version = atomic_load_explicit(&domain->current, memory_order_seq_cst);
+    atomic_store_explicit(&reader->seen, reader->version->number, memory_order_release);
+
+    return SM_RET_OK;
+}
+
+uint32_t SmReloadPublish(SmReloadDomain *domain, const SmClass *new_class, const SmStateId *state_map,
+                         uint16_t map_count, SmStateId fallback_state)
+{
+    if (domain == NULL || new_class == NULL)
+    {
+        return 0;
+    }
+
+    SmClassVersion *current = atomic_load_explicit(&domain->current, memory_order_relaxed);
+    SmClassVersion *version = SmReloadNewVersion(new_class, state_map, map_count, fallback_state,
+                                                 current->number + 1);
+    if (version == NULL)
+    {
+        return 0;
+    }
+
+    /* 先链接再发布, 读者看到新版本时一定能沿链走到它(seq_cst 见 SmReloadRegister) */
+    atomic_store_explicit(&current->next, version, memory_order_release);
+    atomic_store_explicit(&domain->current, version, memory_order_seq_cst);
+
+    return version->number;
+}
+
+uint32_t SmReloadQuiescent(SmReloadDomain *domain, SmReloadReader *reader, const SmFleet *fleet)
+{
+    uint32_t migrated = 0;
+
+    if (domain == NULL || reader == NULL)
+    {
+        return 0;
+    }
+
+    /* 快速路径: 没有新版本 */
+    SmClassVersion *latest = atomic_load_explicit(&domain->current, memory_order_acquire);
+    if (latest == reader->version)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 0; fleet != NULL && fleet->machines != NULL && i < fleet->count; i++)
+    {
+        SmMachine *machine = fleet->machines[i];
+        if (machine == NULL || !machine->is_initialized)
+        {
+            continue;
+        }
+
+        /* 找到实例当前所在的版本(其他类或已是最新版本的实例会走到 latest) */
+        SmClassVersion *version = reader->version;
+        while (version != latest && version->sm_class != machine->sm_class)
+        {
+            version = atomic_load_explicit(&version->next, memory_order_acquire);
+        }
+        if (version == latest)
+        {
+            continue;
+        }
+
+        /* 逐版映射状态ID */
+        SmStateId state = machine->current_state;
+        while (version != latest)
+        {
+            SmClassVersion *next = atomic_load_explicit(&version->next, memory_order_acquire);
+            state = SmReloadMapState(version, next, state);
+            version = next;
+        }
+
+        if (SmMigrate(machine, latest->sm_class, state) == SM_RET_OK ||
+            SmMigrate(machine, latest->sm_class, latest->fallback_state) == SM_RET_OK)
+        {
+            migrated++;
+        }
+    }
+
+    /* 公布进度, 此后本读者不再引用更早的版本 */
+    reader->version = latest;
+    atomic_store_explicit(&reader->seen, latest->number, memory_order_release);
+
+    return migrated;
+}
+
+uint32_t SmReloadReclaim(SmReloadDomain *domain)
+{
+    uint32_t reclaimed = 0;
+
+    if (domain == NULL)
+    {
+        return 0;
+    }
+
+    /* 先读 current 再读读者槽位(seq_cst, 与 SmReloadRegister 配对); 槽位为 NULL 的
+     * 读者尚未读取 current, 之后只会取到不早于这里的版本, 可以跳过 */
+    SmClassVersion *current = atomic_load_explicit(&domain->current, memory_order_seq_cst);
+    uint32_t min_seen = current->number;
+    uint32_t count = atomic_load_explicit(&domain->reader_count, memory_order_seq_cst);
+    if (count > SM_RELOAD_MAX_READERS)
+    {
+        count = SM_RELOAD_MAX_READERS;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SmReloadReader *reader = atomic_load_explicit(&domain->readers[i], memory_order_seq_cst);
+        if (reader == NULL)
+        {
+            continue;
+        }
+        uint32_t seen = atomic_load_explicit(&reader->seen, memory_order_acquire);
+        if (seen < min_seen)
+        {
+            min_seen = seen;
+        }
+    }
+
+    while (domain->oldest != current && domain->oldest->number < min_seen)
+    {
+        SmClassVersion *version = domain->oldest;
+        domain->oldest = atomic_load_explicit(&version->next, memory_order_relaxed);
+        SmReloadFreeVersion(domain, version);
+        reclaimed++;
+    }
+
+    return reclaimed;
+}
+
+void SmReloadDestroy(SmReloadDomain *domain)
+{
+    if (domain == NULL)
+    {
+        return;
+    }
+
+    while (domain->oldest != NULL)
+    {
+        SmClassVersion *version = domain->oldest;
+        domain->oldest = atomic_load_explicit(&version->next, memory_order_relaxed);
+        SmReloadFreeVersion(domain, version);
+    }
+
+    atomic_store_explicit(&domain->current, NULL, memory_order_relaxed);
+    for (uint32_t i = 0; i < SM_RELOAD_MAX_READERS; i++)
+    {
+        atomic_store_explicit(&domain->readers[i], NULL, memory_order_relaxed);
+    }
+    atomic_store_explicit(&domain->reader_count, 0, memory_order_relaxed);
+}
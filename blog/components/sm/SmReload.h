@@ -0,0 +1,135 @@
+#ifndef __SMRELOAD_H__
+#define __SMRELOAD_H__
+
+#include <stdatomic.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 类热更新(RCU 风格)
+ * ============================================================================ */
+
+/*
+ * 控制线程发布新版本的类, 各分发线程(读者)在自己的静止点把所负责的实例迁移过去:
+ *   发布:  version[n+1] = { new_class, state_map }; current = version[n+1] (release)
+ *   读者:  每批分发之间调用 SmReloadQuiescent, 只做一次 current 的 acquire 读取;
+ *          版本变化时沿版本链把实例的状态ID逐版映射并切换 sm_class, 然后公布已看到的版本号
+ *   回收:  所有读者看到的版本号都超过某个旧版本后, 该版本的类和映射表交给回收回调释放
+ * 分发路径(SmSendEvent)本身不增加任何开销, 实例在两个静止点之间始终使用同一个类.
+ *
+ * 约束: 发布和回收由同一个控制线程调用; 每个读者只由其所属的分发线程调用
+ *       (注册可以与其他线程的注册/发布/回收并发); 长时间空闲的分发线程也需要
+ *       定期调用 SmReloadQuiescent, 否则旧版本无法回收.
+ */
+
+#define SM_RELOAD_MAX_READERS 64 /* 读者(分发线程)最大数量 */
+
+/**
+ * @brief 旧版本回收回调
+ * @param ctx 回调上下文
+ * @param sm_class 旧版本的类
+ * @param state_map 发布该版本时使用的状态映射表(可能为NULL)
+ */
+typedef void (*SmReloadFreeFn)(void *ctx, const SmClass *sm_class, const SmStateId *state_map);
+
+typedef struct SmClassVersionTag SmClassVersion;
+
+/**
+ * @brief 类的一个版本
+ */
+struct SmClassVersionTag
+{
+    const SmClass *sm_class;        /* 该版本的类 */
+    const SmStateId *state_map;     /* 上一版本状态下标 -> 本版本状态ID, NULL表示ID不变 */
+    uint16_t map_count;             /* 映射表长度(上一版本的状态数量) */
+    SmStateId fallback_state;       /* 映射为 SM_STATE_INVALID 或越界时使用的状态 */
+    uint32_t number;                /* 版本号(从1开始递增) */
+    _Atomic(SmClassVersion *) next; /* 下一个版本 */
+};
+
+/**
+ * @brief 读者(一个分发线程及其负责的实例)
+ */
+typedef struct
+{
+    _Atomic uint32_t seen;   /* 已迁移到的版本号(回收依据) */
+    SmClassVersion *version; /* 已迁移到的版本 */
+} SmReloadReader;
+
+/**
+ * @brief 热更新域(一个类的全部版本)
+ */
+typedef struct
+{
+    _Atomic(SmClassVersion *) current;              /* 最新版本 */
+    SmClassVersion *oldest;                         /* 最旧的未回收版本 */
+    _Atomic(SmReloadReader *) readers[SM_RELOAD_MAX_READERS]; /* 已注册读者(NULL 表示正在注册) */
+    _Atomic uint32_t reader_count;                             /* 已占用的读者槽位数量 */
+    SmReloadFreeFn free_fn;                         /* 回收回调(可选) */
+    void *free_ctx;                                 /* 回收回调上下文 */
+    uint32_t reclaimed;                             /* 已回收版本数量 */
+} SmReloadDomain;
+
+/**
+ * @brief 初始化热更新域
+ * @param domain 热更新域
+ * @param initial_class 初始版本的类
+ * @param free_fn 回收回调(可选, 初始版本同样会经过它)
+ * @param free_ctx 回收回调上下文
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmReloadInit(SmReloadDomain *domain, const SmClass *initial_class, SmReloadFreeFn free_fn, void *free_ctx);
+
+/**
+ * @brief 注册读者
+ * @param domain 热更新域
+ * @param reader 读者, 从当前最新版本开始
+ * @return SM_RET_OK 成功, SM_RET_ERROR 读者数量已满
+ * @note 读者负责的实例应已使用注册后 reader->version 对应的类创建; 可由各分发线程并发调用
+ */
+SmRetCode SmReloadRegister(SmReloadDomain *domain, SmReloadReader *reader);
+
+/**
+ * @brief 发布新版本
+ * @param domain 热更新域
+ * @param new_class 新版本的类
+ * @param state_map 状态映射表, 按上一版本的状态下标索引, NULL表示状态ID不变
+ * @param map_count 映射表长度
+ * @param fallback_state 被删除状态的实例迁移到的状态
+ * @return 新版本号, 0表示失败
+ */
+uint32_t SmReloadPublish(SmReloadDomain *domain, const SmClass *new_class, const SmStateId *state_map,
+                         uint16_t map_count, SmStateId fallback_state);
+
+/**
+ * @brief 读者静止点: 把实例迁移到最新版本并公布进度
+ * @param domain 热更新域
+ * @param reader 读者
+ * @param fleet 读者负责的实例(只迁移使用本域旧版本类的实例)
+ * @return 迁移的实例数量
+ * @note 无新版本时只有一次原子读取
+ */
+uint32_t SmReloadQuiescent(SmReloadDomain *domain, SmReloadReader *reader, const SmFleet *fleet);
+
+/**
+ * @brief 回收所有读者都已离开的旧版本
+ * @param domain 热更新域
+ * @return 本次回收的版本数量
+ */
+uint32_t SmReloadReclaim(SmReloadDomain *domain);
+
+/**
+ * @brief 销毁热更新域(回收全部版本)
+ * @param domain 热更新域
+ * @note 调用前所有分发线程应已停止
+ */
+void SmReloadDestroy(SmReloadDomain *domain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMRELOAD_H__ */
@@ -0,0 +1,470 @@
+#include "SmRepl.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * 内部辅助函数 - 发送端
+ * ============================================================================ */
+
+/**
+ * @brief 单写者计数器加 n(普通读写, 不使用带锁的读-改-写)
+ */
+static inline void SmReplCount(atomic_ullong *counter, uint64_t n)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+/**
+ * @brief 完整发送 iov 中的数据(处理部分写入)
+ * @return true 成功, false 连接断开
+ */
+static bool SmReplWriteAll(int fd, struct iovec *iov, uint32_t count)
+{
+    struct msghdr msg;
+    uint32_t done = 0;
+
+    while (done < count)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov[done];
+        msg.msg_iovlen = count - done;
+
+        /* 备用进程退出时返回 EPIPE 而不是触发 SIGPIPE */
+        ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        size_t left = (size_t)written;
+        while (done < count && left >= iov[done].iov_len)
+        {
+            left -= iov[done].iov_len;
+            done++;
+        }
+        if (done < count)
+        {
+            iov[done].iov_base = (uint8_t *)iov[done].iov_base + left;
+            iov[done].iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 发送格式头
+ */
+static bool SmReplSendHello(int fd)
+{
+    SmReplHello hello = { .magic = SM_REPL_MAGIC, .version = SM_REPL_VERSION, .delta_max = SM_REPL_DELTA_MAX };
+    struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+    return SmReplWriteAll(fd, &iov, 1);
+}
+
+/**
+ * @brief 发送环中已发布的全部记录
+ */
+static void SmReplDrain(SmReplSender *sender)
+{
+    struct iovec iov[SM_REPL_BATCH];
+    uint32_t mask = sender->capacity - 1;
+    uint32_t tail = atomic_load_explicit(&sender->tail, memory_order_relaxed);
+
+    for (;;)
+    {
+        uint32_t head = atomic_load_explicit(&sender->head, memory_order_acquire);
+        uint32_t n = head - tail;
+        if (n == 0)
+        {
+            return;
+        }
+        if (n > SM_REPL_BATCH)
+        {
+            n = SM_REPL_BATCH;
+        }
+
+        size_t bytes = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            SmReplRecord *record = &sender->ring[(tail + i) & mask];
+            iov[i].iov_base = record;
+            iov[i].iov_len = sizeof(SmReplHeader) + record->header.delta_len;
+            bytes += iov[i].iov_len;
+        }
+
+        if (!atomic_load_explicit(&sender->broken, memory_order_relaxed) && SmReplWriteAll(sender->fd, iov, n))
+        {
+            SmReplCount(&sender->stats.sent, n);
+            SmReplCount(&sender->stats.batches, 1);
+            SmReplCount(&sender->stats.bytes, bytes);
+        }
+        else
+        {
+            atomic_store_explicit(&sender->broken, true, memory_order_relaxed);
+            SmReplCount(&sender->stats.lost, n);
+        }
+
+        tail += n;
+        atomic_store_explicit(&sender->tail, tail, memory_order_release);
+    }
+}
+
+/**
+ * @brief 发送线程: 环过半时被唤醒, 否则每 flush_us 发送一次
+ */
+static void SmReplThread(void *arg)
+{
+    SmReplSender *sender = (SmReplSender *)arg;
+
+    while (!atomic_load_explicit(&sender->stop, memory_order_acquire))
+    {
+        SmOsSemWait(&sender->wake, sender->flush_us);
+        SmReplDrain(sender);
+    }
+
+    SmReplDrain(sender);
+}
+
+/* ============================================================================
+ * 内部辅助函数 - 接收端
+ * ============================================================================ */
+
+/**
+ * @brief 应用一条记录
+ */
+static void SmReplApplyRecord(SmReplReceiver *receiver, const SmReplHeader *header, const uint8_t *delta)
+{
+    /* 序号只增不减; 空洞说明发送端丢弃了记录. 第一条记录只确定起点(连上的可能是重连后的发送端) */
+    if (!receiver->seq_valid)
+    {
+        receiver->next_seq = header->seq;
+        receiver->seq_valid = true;
+    }
+    if (header->seq > receiver->next_seq)
+    {
+        receiver->stats.gaps += header->seq - receiver->next_seq;
+    }
+    receiver->next_seq = header->seq + 1;
+
+    SmMachine *mirror = (header->machine_id < receiver->mirror_count) ? receiver->mirrors[header->machine_id] : NULL;
+    if (mirror == NULL)
+    {
+        receiver->stats.unknown++;
+        return;
+    }
+
+    if (receiver->apply_fn != NULL && header->delta_len > 0)
+    {
+        receiver->apply_fn(receiver->apply_ctx, mirror, delta, header->delta_len);
+    }
+
+    if (SmRestoreState(mirror, header->state, header->previous_state) != SM_RET_OK)
+    {
+        receiver->stats.invalid++;
+        return;
+    }
+    receiver->stats.applied++;
+}
+
+/**
+ * @brief 解析缓冲区中的完整记录, 剩余的半条记录移到缓冲区开头
+ * @return 应用的记录数, -1 格式错误
+ */
+static int32_t SmReplParse(SmReplReceiver *receiver)
+{
+    uint32_t pos = 0;
+    int32_t applied = 0;
+
+    if (!receiver->hello)
+    {
+        if (receiver->fill < sizeof(SmReplHello))
+        {
+            return 0;
+        }
+
+        SmReplHello hello;
+        memcpy(&hello, receiver->buf, sizeof(hello));
+        if (hello.magic != SM_REPL_MAGIC || hello.version != SM_REPL_VERSION || hello.delta_max > SM_REPL_DELTA_MAX)
+        {
+            return -1;
+        }
+        receiver->hello = true;
+        pos = sizeof(SmReplHello);
+    }
+
+    while (receiver->fill - pos >= sizeof(SmReplHeader))
+    {
+        SmReplHeader header;
+        memcpy(&header, receiver->buf + pos, sizeof(header));
+        if (header.delta_len > SM_REPL_DELTA_MAX)
+        {
+            return -1;
+        }
+        if (receiver->fill - pos < sizeof(SmReplHeader) + header.delta_len)
+        {
+            break;
+        }
+
+        uint64_t before = receiver->stats.applied;
+        SmReplApplyRecord(receiver, &header, receiver->buf + pos + sizeof(SmReplHeader));
+        applied += (int32_t)(receiver->stats.applied - before);
+        pos += (uint32_t)sizeof(SmReplHeader) + header.delta_len;
+    }
+
+    memmove(receiver->buf, receiver->buf + pos, receiver->fill - pos);
+    receiver->fill -= pos;
+    return applied;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmReplSenderInit(SmReplSender *sender, SmReplRecord *ring, uint32_t capacity, int fd,
+                           uint64_t flush_us, SmReplDeltaFn delta_fn, void *ctx)
+{
+    if (sender == NULL || ring == NULL || capacity < 2 || (capacity & (capacity - 1)) != 0 || fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(sender, 0, sizeof(SmReplSender));
+    sender->ring = ring;
+    sender->capacity = capacity;
+    sender->fd = fd;
+    sender->flush_us = flush_us;
+    sender->delta_fn = delta_fn;
+    sender->delta_ctx = ctx;
+    atomic_init(&sender->head, 0);
+    atomic_init(&sender->tail, 0);
+    atomic_init(&sender->broken, false);
+    atomic_init(&sender->stop, false);
+    atomic_init(&sender->stats.published, 0);
+    atomic_init(&sender->stats.dropped, 0);
+    atomic_init(&sender->stats.sent, 0);
+    atomic_init(&sender->stats.lost, 0);
+    atomic_init(&sender->stats.batches, 0);
+    atomic_init(&sender->stats.bytes, 0);
+
+    /* 格式头随第一批记录之前发送 */
+    if (!SmReplSendHello(fd))
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (SmOsSemInit(&sender->wake, 0) != SM_RET_OK)
+    {
+        return SM_RET_ERROR;
+    }
+    if (SmOsThreadCreate(&sender->thread, SmReplThread, sender) != SM_RET_OK)
+    {
+        SmOsSemDeinit(&sender->wake);
+        return SM_RET_ERROR;
+    }
+    sender->running = true;
+
+    return SM_RET_OK;
+}
+
+void SmReplSenderDeinit(SmReplSender *sender)
+{
+    if (sender == NULL || !sender->running)
+    {
+        return;
+    }
+
+    atomic_store_explicit(&sender->stop, true, memory_order_release);
+    SmOsSemPost(&sender->wake);
+    SmOsThreadJoin(&sender->thread);
+    SmOsSemDeinit(&sender->wake);
+    sender->running = false;
+}
+
+SmRetCode SmReplReconnect(SmReplSender *sender, int fd)
+{
+    if (sender == NULL || !sender->running || fd < 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    /* 停止发送线程: 环中剩余的记录发往旧连接(已断开时丢弃), 环随之清空 */
+    atomic_store_explicit(&sender->stop, true, memory_order_release);
+    SmOsSemPost(&sender->wake);
+    SmOsThreadJoin(&sender->thread);
+
+    /* 分发线程是唯一的生产者, 此时没有并发发布, 直接换用新连接 */
+    sender->fd = fd;
+    bool connected = SmReplSendHello(fd);
+    atomic_store_explicit(&sender->broken, !connected, memory_order_relaxed);
+    atomic_store_explicit(&sender->stop, false, memory_order_relaxed);
+    if (SmOsThreadCreate(&sender->thread, SmReplThread, sender) != SM_RET_OK)
+    {
+        SmOsSemDeinit(&sender->wake);
+        sender->running = false;
+        return SM_RET_ERROR;
+    }
+
+    return connected ? SM_RET_OK : SM_RET_ERROR;
+}
+
+SmRetCode SmReplAttach(SmReplSender *sender, SmMachine *machine)
+{
+    if (sender == NULL || machine == NULL || !machine->is_initialized)
+    {
+        return SM_RET_ERROR;
+    }
+
+    machine->repl = sender;
+    machine->repl_pending = false;
+    if (machine->current_state != SM_STATE_INVALID)
+    {
+        SmReplPublish(machine);
+    }
+
+    return SM_RET_OK;
+}
+
+void SmReplDetach(SmMachine *machine)
+{
+    if (machine == NULL)
+    {
+        return;
+    }
+
+    machine->repl = NULL;
+    machine->repl_pending = false;
+}
+
+void SmReplPublish(SmMachine *machine)
+{
+    SmReplSender *sender = machine->repl;
+    uint32_t head = atomic_load_explicit(&sender->head, memory_order_relaxed);
+    uint64_t seq = sender->seq++;
+
+    /* 读取位置由发送线程修改, 缓存后只在环看起来已满时重新读取, 减少缓存行往返 */
+    if (head - sender->tail_cache >= sender->capacity)
+    {
+        sender->tail_cache = atomic_load_explicit(&sender->tail, memory_order_acquire);
+    }
+    uint32_t tail = sender->tail_cache;
+
+    if (head - tail >= sender->capacity || atomic_load_explicit(&sender->broken, memory_order_relaxed))
+    {
+        SmReplCount(&sender->stats.dropped, 1);
+        return;
+    }
+
+    SmReplRecord *record = &sender->ring[head & (sender->capacity - 1)];
+    record->header.machine_id = machine->machine_id;
+    record->header.state = machine->current_state;
+    record->header.previous_state = machine->previous_state;
+    record->header.reserved = 0;
+    record->header.seq = seq;
+    record->header.delta_len = 0;
+    if (sender->delta_fn != NULL)
+    {
+        uint16_t len = sender->delta_fn(sender->delta_ctx, machine, record->delta, SM_REPL_DELTA_MAX);
+        record->header.delta_len = (len > SM_REPL_DELTA_MAX) ? SM_REPL_DELTA_MAX : len;
+    }
+
+    atomic_store_explicit(&sender->head, head + 1, memory_order_release);
+    SmReplCount(&sender->stats.published, 1);
+
+    /* 只在越过半满时唤醒一次, 其余由发送线程的攒批超时处理 */
+    if (head + 1 - tail == sender->capacity / 2)
+    {
+        SmOsSemPost(&sender->wake);
+    }
+}
+
+SmRetCode SmReplSync(SmMachine *machine)
+{
+    if (machine == NULL || machine->repl == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    machine->repl_pending = false;
+    SmReplPublish(machine);
+    return SM_RET_OK;
+}
+
+SmRetCode SmReplReceiverInit(SmReplReceiver *receiver, SmMachine **mirrors, uint32_t mirror_count,
+                             SmReplApplyFn apply_fn, void *ctx)
+{
+    if (receiver == NULL || mirrors == NULL || mirror_count == 0)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(receiver, 0, offsetof(SmReplReceiver, buf));
+    receiver->mirrors = mirrors;
+    receiver->mirror_count = mirror_count;
+    receiver->apply_fn = apply_fn;
+    receiver->apply_ctx = ctx;
+
+    return SM_RET_OK;
+}
+
+int32_t SmReplFeed(SmReplReceiver *receiver, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    int32_t applied = 0;
+
+    if (receiver == NULL || (data == NULL && len > 0))
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        size_t n = sizeof(receiver->buf) - receiver->fill;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(receiver->buf + receiver->fill, p, n);
+        receiver->fill += (uint32_t)n;
+        p += n;
+        len -= n;
+
+        int32_t ret = SmReplParse(receiver);
+        if (ret < 0)
+        {
+            return -1;
+        }
+        applied += ret;
+    }
+
+    return applied;
+}
+
+int32_t SmReplReceive(SmReplReceiver *receiver, int fd)
+{
+    if (receiver == NULL)
+    {
+        return -1;
+    }
+
+    ssize_t n;
+    do
+    {
+        n = read(fd, receiver->buf + receiver->fill, sizeof(receiver->buf) - receiver->fill);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0)
+    {
+        return -1;
+    }
+
+    receiver->fill += (uint32_t)n;
+    return SmReplParse(receiver);
+}
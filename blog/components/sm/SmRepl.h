@@ -0,0 +1,249 @@
+#ifndef __SMREPL_H__
+#define __SMREPL_H__
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "SmMgr.h"
+#include "SmOs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 热备复制
+ * ============================================================================ */
+
+/*
+ * 主进程把实例的状态变更以紧凑记录发送给本机的备用进程, 备用进程应用到
+ * 镜像实例池, 主进程退出后直接接管, 会话无需重连/重新认证:
+ *   - 状态提交时只做标记, 最外层调用(事件/启动/停止/强制切换)结束时发布一条
+ *     记录: 实例ID + 新状态 + 用户回调生成的用户数据增量(进入函数的修改也包含在内)
+ *   - 发布只写入单生产者单消费者环, 不做系统调用; 发送线程按批 writev 到
+ *     流式 Unix 套接字, 环过半或等待超过 flush_us 时发送
+ *   - 环满时丢弃并计数, 序号出现空洞, 备用端据此统计; 主进程用 SmReplSync
+ *     重新发布实例的完整状态即可收敛
+ *   - 写入失败(备用进程退出)后发送端进入断开状态, 之后的记录直接丢弃; 新的备用
+ *     进程连上后由分发线程调用 SmReplReconnect 换用新套接字, 再对全部挂接实例
+ *     调用 SmReplSync 重新播种, 断开期间的变更不会补发
+ *   - 统计计数器各只有一个写者(分发线程或发送线程), 用普通读写更新, 不加锁;
+ *     其他线程读到的是近似值
+ * 备用端的镜像实例只 SmCreate 不 SmStart, 由 SmRestoreState 直接设置状态,
+ * 不调用进入/退出函数; 接管后照常分发事件.
+ *
+ * 约束: 挂接到同一发送端的实例只在一个分发线程中分发(单生产者);
+ *       记录按本机字节序编码, 只用于同一台机器上的进程.
+ */
+
+#define SM_REPL_MAGIC     0x534D5250U /* "SMRP" */
+#define SM_REPL_VERSION   1           /* 线上格式版本 */
+#define SM_REPL_DELTA_MAX 40          /* 单条记录用户数据增量最大字节数 */
+#define SM_REPL_BATCH     64          /* 发送线程单次 writev 最多合并的记录数 */
+#define SM_REPL_RX_BUF    65536       /* 接收端缓冲区大小 */
+
+/**
+ * @brief 连接建立后发送的格式头
+ */
+typedef struct
+{
+    uint32_t magic;     /* SM_REPL_MAGIC */
+    uint16_t version;   /* SM_REPL_VERSION */
+    uint16_t delta_max; /* 增量最大字节数 */
+} SmReplHello;
+
+/**
+ * @brief 记录头(线上格式), 后跟 delta_len 字节增量
+ */
+typedef struct
+{
+    uint32_t machine_id;    /* 实例ID */
+    int32_t state;          /* 新状态ID, SM_STATE_INVALID 表示已停止 */
+    int32_t previous_state; /* 上一个状态ID */
+    uint16_t delta_len;     /* 增量字节数 */
+    uint16_t reserved;      /* 保留 */
+    uint64_t seq;           /* 发送端序号(连续递增, 丢弃的记录同样占用序号) */
+} SmReplHeader;
+
+/**
+ * @brief 环中的记录
+ */
+typedef struct
+{
+    SmReplHeader header;              /* 记录头 */
+    uint8_t delta[SM_REPL_DELTA_MAX]; /* 用户数据增量 */
+} SmReplRecord;
+
+/**
+ * @brief 生成用户数据增量(在分发线程中调用)
+ * @param ctx 用户上下文
+ * @param machine 状态机实例
+ * @param buf 输出缓冲区
+ * @param cap 缓冲区大小(SM_REPL_DELTA_MAX)
+ * @return 增量字节数, 0 表示无增量
+ */
+typedef uint16_t (*SmReplDeltaFn)(void *ctx, SmMachine *machine, void *buf, uint16_t cap);
+
+/**
+ * @brief 应用用户数据增量(在备用端应用状态前调用)
+ * @param ctx 用户上下文
+ * @param mirror 镜像实例
+ * @param delta 增量
+ * @param len 增量字节数
+ */
+typedef void (*SmReplApplyFn)(void *ctx, SmMachine *mirror, const void *delta, uint16_t len);
+
+/**
+ * @brief 发送端统计(每个计数器只有一个写者)
+ */
+typedef struct
+{
+    atomic_ullong published; /* 写入环的记录数(分发线程) */
+    atomic_ullong dropped;   /* 环满或连接已断开时丢弃的记录数(分发线程) */
+    atomic_ullong sent;      /* 已发送的记录数(发送线程) */
+    atomic_ullong lost;      /* 写入失败而丢弃的记录数(发送线程) */
+    atomic_ullong batches;   /* writev 次数(发送线程) */
+    atomic_ullong bytes;     /* 已发送字节数(发送线程) */
+} SmReplStats;
+
+/**
+ * @brief 复制发送端
+ */
+struct SmReplSenderTag
+{
+    SmReplRecord *ring;     /* 记录环 [capacity] */
+    uint32_t capacity;      /* 环容量(2 的幂) */
+    atomic_uint head;       /* 写入位置(分发线程) */
+    atomic_uint tail;       /* 读取位置(发送线程) */
+    uint32_t tail_cache;    /* 分发线程缓存的读取位置(环看起来满时才重新读取) */
+    uint64_t seq;           /* 下一条记录的序号(分发线程) */
+    int fd;                 /* 流式 Unix 套接字 */
+    atomic_bool broken;     /* 连接已断开, 之后的记录直接丢弃 */
+    uint64_t flush_us;      /* 最长攒批时间(微秒) */
+    SmReplDeltaFn delta_fn; /* 用户数据增量回调(可选) */
+    void *delta_ctx;        /* 增量回调上下文 */
+    SmOsSem wake;           /* 环过半/停止时唤醒发送线程 */
+    SmOsThread thread;      /* 发送线程 */
+    atomic_bool stop;       /* 停止请求 */
+    bool running;           /* 发送线程已启动 */
+    SmReplStats stats;      /* 统计 */
+};
+
+/**
+ * @brief 复制接收端统计
+ */
+typedef struct
+{
+    uint64_t applied; /* 已应用的记录数 */
+    uint64_t gaps;    /* 序号空洞中缺失的记录数 */
+    uint64_t unknown; /* 实例ID没有对应镜像的记录数 */
+    uint64_t invalid; /* 镜像拒绝的状态(类不一致等) */
+} SmReplRxStats;
+
+/**
+ * @brief 复制接收端
+ */
+typedef struct
+{
+    SmMachine **mirrors;         /* 镜像实例(按实例ID索引, 可含NULL) */
+    uint32_t mirror_count;       /* 镜像数组大小 */
+    SmReplApplyFn apply_fn;      /* 增量应用回调(可选) */
+    void *apply_ctx;             /* 应用回调上下文 */
+    bool hello;                  /* 已收到格式头 */
+    bool seq_valid;              /* 已收到第一条记录(重连后序号从发送端当前值开始) */
+    uint64_t next_seq;           /* 期望的下一条记录序号 */
+    uint32_t fill;               /* 缓冲区中未处理的字节数 */
+    SmReplRxStats stats;         /* 统计 */
+    uint8_t buf[SM_REPL_RX_BUF]; /* 接收缓冲区(保存跨读取边界的记录) */
+} SmReplReceiver;
+
+/**
+ * @brief 初始化发送端并启动发送线程
+ * @param sender 发送端
+ * @param ring 记录环存储 [capacity]
+ * @param capacity 环容量(2 的幂)
+ * @param fd 已连接的流式 Unix 套接字(所有权不转移)
+ * @param flush_us 最长攒批时间(微秒)
+ * @param delta_fn 用户数据增量回调(可选)
+ * @param ctx 增量回调上下文
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmReplSenderInit(SmReplSender *sender, SmReplRecord *ring, uint32_t capacity, int fd,
+                           uint64_t flush_us, SmReplDeltaFn delta_fn, void *ctx);
+
+/**
+ * @brief 停止发送线程(先发送完环中的记录)
+ * @param sender 发送端
+ */
+void SmReplSenderDeinit(SmReplSender *sender);
+
+/**
+ * @brief 换用新连接(备用进程重启后), 断开状态随之清除
+ * @param sender 发送端
+ * @param fd 已连接的流式 Unix 套接字(所有权不转移)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效/格式头发送失败(仍处于断开状态)
+ * @note 在分发线程中调用; 返回后对全部挂接实例调用 SmReplSync 重新播种备用端
+ */
+SmRetCode SmReplReconnect(SmReplSender *sender, int fd);
+
+/**
+ * @brief 挂接实例, 运行中的实例立即发布当前状态
+ * @param sender 发送端
+ * @param machine 状态机实例(需先用 SmSetMachineId 设置ID)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效
+ */
+SmRetCode SmReplAttach(SmReplSender *sender, SmMachine *machine);
+
+/**
+ * @brief 解除挂接(SmDestroy 自动调用)
+ * @param machine 状态机实例
+ */
+void SmReplDetach(SmMachine *machine);
+
+/**
+ * @brief 发布实例的当前状态和用户数据增量(由 SmMgr 在最外层调用结束时调用)
+ * @param machine 状态机实例
+ */
+void SmReplPublish(SmMachine *machine);
+
+/**
+ * @brief 重新发布实例的完整状态(丢弃记录或备用端重连后收敛用)
+ * @param machine 状态机实例
+ * @return SM_RET_OK 成功, SM_RET_ERROR 未挂接
+ */
+SmRetCode SmReplSync(SmMachine *machine);
+
+/**
+ * @brief 初始化接收端
+ * @param receiver 接收端
+ * @param mirrors 镜像实例数组(按实例ID索引)
+ * @param mirror_count 镜像数组大小
+ * @param apply_fn 增量应用回调(可选)
+ * @param ctx 应用回调上下文
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmReplReceiverInit(SmReplReceiver *receiver, SmMachine **mirrors, uint32_t mirror_count,
+                             SmReplApplyFn apply_fn, void *ctx);
+
+/**
+ * @brief 处理收到的字节流
+ * @param receiver 接收端
+ * @param data 数据
+ * @param len 数据长度
+ * @return 应用的记录数, -1 格式错误
+ * @note 记录可以跨多次调用拆分
+ */
+int32_t SmReplFeed(SmReplReceiver *receiver, const void *data, size_t len);
+
+/**
+ * @brief 从套接字读取一次并应用其中的记录
+ * @param receiver 接收端
+ * @param fd 套接字
+ * @return 应用的记录数, -1 连接关闭/读取错误/格式错误
+ */
+int32_t SmReplReceive(SmReplReceiver *receiver, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMREPL_H__ */
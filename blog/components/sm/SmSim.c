@@ -0,0 +1,205 @@
+#include "SmSim.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+static SmSim *s_active_sim = NULL; /* 当前安装了虚拟时钟的仿真器 */
+
+/**
+ * @brief 虚拟时钟(作为全局时间源)
+ */
+static uint64_t SmSimTime(void)
+{
+    return (s_active_sim != NULL) ? s_active_sim->now : 0;
+}
+
+/**
+ * @brief 追加到 FIFO 尾部
+ */
+static SmRetCode SmSimEnqueue(SmSim *sim, SmMachine *machine, SmEventId event)
+{
+    if (sim->item_count >= sim->item_capacity)
+    {
+        sim->dropped++;
+        return SM_RET_ERROR;
+    }
+
+    uint32_t tail = sim->item_head + sim->item_count;
+    if (tail >= sim->item_capacity)
+    {
+        tail -= sim->item_capacity;
+    }
+
+    sim->items[tail].machine = machine;
+    sim->items[tail].event = event;
+    sim->item_count++;
+
+    return SM_RET_OK;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmSimInit(SmSim *sim, SmTimerHeap *timers, SmSimItem *items, uint32_t item_capacity,
+                    uint64_t start_time, uint64_t seed)
+{
+    if (sim == NULL || timers == NULL || items == NULL || item_capacity == 0 || s_active_sim != NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(sim, 0, sizeof(SmSim));
+    sim->timers = timers;
+    sim->items = items;
+    sim->item_capacity = item_capacity;
+    sim->now = start_time;
+    sim->rng = (seed != 0) ? seed : 0x9E3779B97F4A7C15ULL;
+
+    sim->saved_time_fn = SmGetTimeFn();
+    s_active_sim = sim;
+    SmSetTimeFn(SmSimTime);
+
+    return SM_RET_OK;
+}
+
+void SmSimDeinit(SmSim *sim)
+{
+    if (sim == NULL || s_active_sim != sim)
+    {
+        return;
+    }
+
+    SmSetTimeFn(sim->saved_time_fn);
+    s_active_sim = NULL;
+}
+
+SmRetCode SmSimPost(SmSim *sim, SmMachine *machine, SmEventId event)
+{
+    if (sim == NULL || machine == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    if (machine->queue == NULL)
+    {
+        return SmSimEnqueue(sim, machine, event);
+    }
+
+    /* 先占用 FIFO 位置, 保证投递到实例队列的事件一定会被分发 */
+    if (sim->item_count >= sim->item_capacity)
+    {
+        sim->dropped++;
+        return SM_RET_ERROR;
+    }
+    if (SmPostEvent(machine, event) != SM_RET_OK)
+    {
+        sim->dropped++;
+        return SM_RET_ERROR;
+    }
+
+    return SmSimEnqueue(sim, machine, SM_EVENT_INVALID);
+}
+
+SmTimerId SmSimAfter(SmSim *sim, SmMachine *machine, SmEventId event, uint64_t delay)
+{
+    if (sim == NULL)
+    {
+        return SM_TIMER_NONE;
+    }
+
+    return SmTimerStart(sim->timers, machine, event, sim->now + delay);
+}
+
+bool SmSimStep(SmSim *sim, uint64_t until)
+{
+    if (sim == NULL)
+    {
+        return false;
+    }
+
+    if (sim->item_count > 0)
+    {
+        SmSimItem item = sim->items[sim->item_head];
+        sim->item_head = (sim->item_head + 1 == sim->item_capacity) ? 0 : sim->item_head + 1;
+        sim->item_count--;
+
+        if (item.event == SM_EVENT_INVALID)
+        {
+            SmDispatch(item.machine, 1);
+        }
+        else
+        {
+            SmSendEvent(item.machine, item.event);
+        }
+        sim->dispatched++;
+        return true;
+    }
+
+    /* FIFO 为空: 虚拟时间直接跳到最近的截止时间 */
+    uint64_t deadline;
+    if (!SmTimerPeek(sim->timers, &deadline) || deadline > until)
+    {
+        return false;
+    }
+    if (deadline > sim->now)
+    {
+        sim->now = deadline;
+    }
+
+    /* 同一时刻到期的定时器按启动顺序进入 FIFO, FIFO 满时留到下一步 */
+    SmMachine *machine;
+    SmEventId event;
+    while (sim->item_count < sim->item_capacity && SmTimerPop(sim->timers, sim->now, &machine, &event))
+    {
+        SmSimPost(sim, machine, event);
+        sim->fired++;
+    }
+
+    return true;
+}
+
+uint64_t SmSimRun(SmSim *sim, uint64_t until)
+{
+    if (sim == NULL)
+    {
+        return 0;
+    }
+
+    uint64_t start = sim->dispatched;
+    while (SmSimStep(sim, until))
+    {
+    }
+
+    if (sim->now < until)
+    {
+        sim->now = until;
+    }
+
+    return sim->dispatched - start;
+}
+
+uint64_t SmSimNow(const SmSim *sim)
+{
+    return (sim != NULL) ? sim->now : 0;
+}
+
+uint64_t SmSimRandom(SmSim *sim)
+{
+    if (sim == NULL)
+    {
+        return 0;
+    }
+
+    sim->rng ^= sim->rng >> 12;
+    sim->rng ^= sim->rng << 25;
+    sim->rng ^= sim->rng >> 27;
+    return sim->rng * 0x2545F4914F6CDD1DULL;
+}
+
+uint64_t SmSimRandomRange(SmSim *sim, uint64_t bound)
+{
+    return (bound != 0) ? SmSimRandom(sim) % bound : 0;
+}
@@ -0,0 +1,137 @@
+#ifndef __SMSIM_H__
+#define __SMSIM_H__
+
+#include "SmMgr.h"
+#include "SmTimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 虚拟时间仿真
+ * ============================================================================ */
+
+/*
+ * 单线程、确定性的仿真执行器:
+ *   - 事件进入一个全局 FIFO, 按投递顺序逐个分发
+ *   - FIFO 为空时虚拟时钟直接跳到最近的定时器截止时间, 到期定时器按
+ *     (截止时间, 启动顺序) 依次进入 FIFO
+ *   - 运行期间全局时间源替换为虚拟时钟, 状态机代码中的 SmGetTime 和
+ *     基于 SmGetTime 的 SmTimerStart 不需要任何修改
+ *   - 环境模型需要的随机数来自 SmSimRandom, 相同种子得到完全相同的执行序列
+ * 因为不存在真实等待, 仿真耗时只与事件数量有关, 与仿真的时间跨度无关.
+ *
+ * 约束: 同一时刻只能有一个仿真器处于初始化状态(时间源是全局的).
+ */
+
+/**
+ * @brief 待分发的事件
+ */
+typedef struct
+{
+    SmMachine *machine; /* 目标实例 */
+    SmEventId event;    /* 事件ID, 已投递到实例队列时为 SM_EVENT_INVALID */
+} SmSimItem;
+
+/**
+ * @brief 仿真器
+ */
+typedef struct
+{
+    SmTimerHeap *timers;     /* 定时器堆 */
+    SmSimItem *items;        /* 事件 FIFO [item_capacity] */
+    uint32_t item_capacity;  /* FIFO 容量 */
+    uint32_t item_head;      /* FIFO 头 */
+    uint32_t item_count;     /* FIFO 中的事件数量 */
+    uint64_t now;            /* 虚拟时间(SmGetTime 单位) */
+    uint64_t rng;            /* 随机数状态 */
+    uint64_t dispatched;     /* 已分发的事件数量 */
+    uint64_t fired;          /* 已触发的定时器数量 */
+    uint64_t dropped;        /* FIFO 或实例队列满丢弃的事件数量 */
+    SmTimeFn saved_time_fn;  /* 初始化前的时间源 */
+} SmSim;
+
+/**
+ * @brief 初始化仿真器并安装虚拟时钟
+ * @param sim 仿真器
+ * @param timers 定时器堆(已初始化, 状态机代码和环境模型共用)
+ * @param items 事件 FIFO 存储 [item_capacity]
+ * @param item_capacity FIFO 容量
+ * @param start_time 起始虚拟时间
+ * @param seed 随机种子
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数错误或已有仿真器在运行
+ */
+SmRetCode SmSimInit(SmSim *sim, SmTimerHeap *timers, SmSimItem *items, uint32_t item_capacity,
+                    uint64_t start_time, uint64_t seed);
+
+/**
+ * @brief 结束仿真并恢复原时间源
+ * @param sim 仿真器
+ */
+void SmSimDeinit(SmSim *sim);
+
+/**
+ * @brief 投递事件
+ * @param sim 仿真器
+ * @param machine 目标实例
+ * @param event 事件ID
+ * @return SM_RET_OK 成功, SM_RET_ERROR FIFO 或实例队列已满
+ * @note 实例绑定了事件队列时先投递到队列, 轮到它时分发一个事件(遵循通道优先级)
+ */
+SmRetCode SmSimPost(SmSim *sim, SmMachine *machine, SmEventId event);
+
+/**
+ * @brief 启动相对当前虚拟时间的定时器
+ * @param sim 仿真器
+ * @param machine 目标实例
+ * @param event 到期事件
+ * @param delay 延迟
+ * @return 定时器ID, SM_TIMER_NONE 表示定时器堆已满
+ */
+SmTimerId SmSimAfter(SmSim *sim, SmMachine *machine, SmEventId event, uint64_t delay);
+
+/**
+ * @brief 执行一步: 分发一个事件, 或把虚拟时间推进到下一个截止时间
+ * @param sim 仿真器
+ * @param until 时间上限, 截止时间超过它的定时器不触发
+ * @return true 有进展, false 已空闲(FIFO 为空且上限内没有定时器)
+ */
+bool SmSimStep(SmSim *sim, uint64_t until);
+
+/**
+ * @brief 运行到指定虚拟时间
+ * @param sim 仿真器
+ * @param until 时间上限
+ * @return 本次分发的事件数量
+ * @note 返回时虚拟时间等于 until(若原本未超过)
+ */
+uint64_t SmSimRun(SmSim *sim, uint64_t until);
+
+/**
+ * @brief 获取当前虚拟时间
+ * @param sim 仿真器
+ * @return 虚拟时间
+ */
+uint64_t SmSimNow(const SmSim *sim);
+
+/**
+ * @brief 生成随机数(xorshift64*)
+ * @param sim 仿真器
+ * @return 64位随机数
+ */
+uint64_t SmSimRandom(SmSim *sim);
+
+/**
+ * @brief 生成 [0, bound) 范围内的随机数
+ * @param sim 仿真器
+ * @param bound 上界, 0 时返回0
+ * @return 随机数
+ */
+uint64_t SmSimRandomRange(SmSim *sim, uint64_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMSIM_H__ */
@@ -0,0 +1,190 @@
+#include "SmSpec.h"
+#include "SmOutbox.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_SPEC_ALIGN(n) (((n) + 7u) & ~(size_t)7u)
+
+static void *SmSpecAlloc(SmSpecArena *arena, size_t size)
+{
+    size_t need = SM_SPEC_ALIGN(size);
+    if (need > arena->size - arena->used)
+    {
+        return NULL;
+    }
+
+    void *p = arena->buf + arena->used;
+    arena->used += need;
+    return p;
+}
+
+/**
+ * @brief 重定位克隆中的指针
+ * @note 指向源对象内部的指针按偏移重定位, 外部数据拷贝到临时区(size 为 0 时保持共享)
+ */
+static bool SmSpecRebase(SmSpecArena *arena, const void *src_base, size_t instance_size, void *dst_base,
+                         void **ptr, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)*ptr;
+    const uint8_t *base = (const uint8_t *)src_base;
+
+    if (p == NULL)
+    {
+        return true;
+    }
+    if (p >= base && p < base + instance_size)
+    {
+        *ptr = (uint8_t *)dst_base + (p - base);
+        return true;
+    }
+    if (size == 0)
+    {
+        return true;
+    }
+
+    void *copy = SmSpecAlloc(arena, size);
+    if (copy == NULL)
+    {
+        return false;
+    }
+    memcpy(copy, p, size);
+    *ptr = copy;
+    return true;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmSpecArenaInit(SmSpecArena *arena, void *buf, size_t size, SmOutbox *outbox)
+{
+    /* 克隆必须有自己的输出缓冲区, 否则定时器等输出会落到实例外的共享设施上 */
+    if (arena == NULL || buf == NULL || ((uintptr_t)buf & 7u) != 0 || outbox == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    arena->buf = (uint8_t *)buf;
+    arena->size = size;
+    arena->used = 0;
+    arena->outbox = outbox;
+    return SM_RET_OK;
+}
+
+void SmSpecArenaReset(SmSpecArena *arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    arena->used = 0;
+    SmOutboxRollback(arena->outbox, (SmOutMark){ .records = 0, .bytes = 0 });
+}
+
+SmMachine *SmClone(SmSpecArena *arena, const SmMachine *src, size_t instance_size, size_t user_size)
+{
+    if (arena == NULL || src == NULL || !src->is_initialized || src->dispatch_depth != 0 ||
+        instance_size < sizeof(SmMachine))
+    {
+        return NULL;
+    }
+
+    size_t used = arena->used;
+    SmMachine *clone = (SmMachine *)SmSpecAlloc(arena, instance_size);
+    if (clone == NULL)
+    {
+        return NULL;
+    }
+
+    /* 实例连同所在的用户结构体一次拷贝 */
+    memcpy(clone, src, instance_size);
+
+    bool ok = SmSpecRebase(arena, src, instance_size, clone, &clone->user_data, user_size);
+    ok = ok && SmSpecRebase(arena, src, instance_size, clone, (void **)&clone->history,
+                            sizeof(SmStateId) * clone->history_count);
+    ok = ok && SmSpecRebase(arena, src, instance_size, clone, (void **)&clone->defer.buf,
+                            sizeof(SmEventId) * clone->defer.size);
+    if (!ok)
+    {
+        arena->used = used;
+        return NULL;
+    }
+
+    /* 与外界断开: 推演不能投递事件, 导出状态或产生真实输出 */
+    clone->trans_log_fn = NULL;
+    clone->queue = NULL;
+    clone->obs_slot = NULL;
+    clone->hooks = NULL;
+    clone->outbox = arena->outbox;
+    memset(&clone->dwell, 0, sizeof(clone->dwell));
+    clone->dwell.list = SM_DWELL_UNLINKED;
+    clone->pop_index = NULL;
+    clone->repl = NULL;
+    clone->repl_pending = false;
+    clone->spec = NULL;
+
+    return clone;
+}
+
+SmRetCode SmSpeculate(SmMachine *clone, const SmEventId *events, uint16_t count, uint32_t flags, SmSpecTrace *trace)
+{
+    SmRetCode result = SM_RET_OK;
+
+    if (clone == NULL || (events == NULL && count > 0) || trace == NULL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    trace->count = 0;
+    trace->truncated = false;
+    trace->flags = flags;
+    clone->spec = trace;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        trace->event = events[i];
+        SmRetCode ret = SmSendEvent(clone, events[i]);
+        SmSpecRecord(trace, SM_SPEC_STEP_EVENT, SmGetCurrentState(clone), NULL);
+        if (trace->count > 0 && !trace->truncated)
+        {
+            trace->steps[trace->count - 1].ret = ret;
+        }
+
+        if (ret != SM_RET_OK && ret != SM_RET_IGNORE && ret != SM_RET_DEFERRED && result == SM_RET_OK)
+        {
+            result = ret;
+        }
+    }
+
+    clone->spec = NULL;
+    trace->final_state = SmGetCurrentState(clone);
+    return result;
+}
+
+bool SmSpecRecord(SmSpecTrace *trace, uint8_t kind, SmStateId state, const SmTransition *trans)
+{
+    bool stubbed = ((kind == SM_SPEC_STEP_ACTION) && (trace->flags & SM_SPEC_STUB_ACTIONS)) ||
+                   ((kind == SM_SPEC_STEP_ENTER || kind == SM_SPEC_STEP_EXIT) && (trace->flags & SM_SPEC_STUB_STATES));
+
+    if (trace->count < trace->capacity)
+    {
+        trace->steps[trace->count++] = (SmSpecStep){
+            .kind = kind,
+            .stubbed = stubbed,
+            .event = trace->event,
+            .state = state,
+            .ret = SM_RET_OK,
+            .trans = trans,
+        };
+    }
+    else
+    {
+        trace->truncated = true;
+    }
+
+    return !stubbed;
+}
@@ -0,0 +1,130 @@
+#ifndef __SMSPEC_H__
+#define __SMSPEC_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 克隆与推演
+ * ============================================================================ */
+
+/*
+ * 回答"如果依次发送 EVT_DISCONNECT, EVT_CONNECT, 会话最终处于哪个状态、
+ * 触发哪些动作"而不影响运行中的实例:
+ *   - SmClone 把实例(连同所在的用户结构体)拷贝到临时区, 基本就是一次 memcpy;
+ *     指向实例内部的用户数据随之重定位, 外部用户数据/历史记录/延迟队列另行拷贝
+ *   - 克隆与外界断开: 事件队列/观察槽位/扩展钩子/停留监视/成员索引/复制流/
+ *     转换日志全部摘除, outbox 换成临时区的输出缓冲区(只记录, 从不刷新)
+ *   - SmSpeculate 在克隆上依次分发事件, 记录每次回调和状态提交; 按 flags
+ *     把动作和进入/退出函数替换为只记录的桩函数
+ * 临时区是调用者提供的缓冲区, SmSpecArenaReset 后重复使用, 推演过程不分配内存.
+ *
+ * 约束: 转换条件照常执行, 需要无副作用(准入控制在克隆上只判断不消耗令牌,
+ *       见 SmAdmitMachine); 未替换的回调运行在克隆上, 其副作用应通过 outbox 输出.
+ */
+
+#define SM_SPEC_STUB_ACTIONS 0x01 /* 转换动作只记录不执行 */
+#define SM_SPEC_STUB_STATES  0x02 /* 进入/退出函数只记录不执行 */
+#define SM_SPEC_STUB_ALL     (SM_SPEC_STUB_ACTIONS | SM_SPEC_STUB_STATES)
+
+#define SM_SPEC_STEP_EVENT  0 /* 事件分发完成 */
+#define SM_SPEC_STEP_EXIT   1 /* 退出函数 */
+#define SM_SPEC_STEP_ACTION 2 /* 转换动作 */
+#define SM_SPEC_STEP_ENTER  3 /* 进入函数 */
+#define SM_SPEC_STEP_STATE  4 /* 状态提交 */
+
+/**
+ * @brief 推演轨迹中的一步
+ */
+typedef struct
+{
+    uint8_t kind;              /* SM_SPEC_STEP_* */
+    bool stubbed;              /* 回调被桩函数替换(未执行) */
+    SmEventId event;           /* 所属的推演事件 */
+    SmStateId state;           /* 退出/进入: 所属状态; 动作: 源状态; 状态提交: 新状态; 事件: 分发后的状态 */
+    SmRetCode ret;             /* 事件: 分发结果 */
+    const SmTransition *trans; /* 动作: 转换规则(动作函数及动作数据) */
+} SmSpecStep;
+
+/**
+ * @brief 推演轨迹
+ */
+struct SmSpecTraceTag
+{
+    SmSpecStep *steps;     /* 步骤存储 [capacity] */
+    uint16_t capacity;     /* 步骤容量 */
+    uint16_t count;        /* 已记录步骤数 */
+    bool truncated;        /* 步骤超出容量(之后的步骤未记录) */
+    uint32_t flags;        /* SM_SPEC_STUB_* */
+    SmEventId event;       /* 当前推演事件 */
+    SmStateId final_state; /* 推演结束后的状态 */
+};
+
+/**
+ * @brief 推演临时区
+ */
+typedef struct
+{
+    uint8_t *buf;     /* 缓冲区 */
+    size_t size;      /* 缓冲区大小 */
+    size_t used;      /* 已用字节数 */
+    SmOutbox *outbox; /* 克隆使用的输出缓冲区(只记录不刷新) */
+} SmSpecArena;
+
+/**
+ * @brief 初始化临时区
+ * @param arena 临时区
+ * @param buf 缓冲区(8字节对齐)
+ * @param size 缓冲区大小
+ * @param outbox 克隆使用的输出缓冲区(必须提供, 克隆的发送/定时器只记录到这里)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效/缓冲区未对齐/outbox 为NULL
+ */
+SmRetCode SmSpecArenaInit(SmSpecArena *arena, void *buf, size_t size, SmOutbox *outbox);
+
+/**
+ * @brief 清空临时区(之前的克隆全部失效, outbox 中的记录一并丢弃)
+ * @param arena 临时区
+ */
+void SmSpecArenaReset(SmSpecArena *arena);
+
+/**
+ * @brief 克隆实例
+ * @param arena 临时区
+ * @param src 源实例
+ * @param instance_size 源实例所在对象的大小(实例嵌在用户结构体开头时为结构体大小, 至少 sizeof(SmMachine))
+ * @param user_size 外部用户数据大小(用户数据不在对象内时拷贝, 0 表示共享同一份)
+ * @return 克隆实例, NULL 表示参数无效或临时区不足
+ * @note 源实例不能处于事件分发中
+ */
+SmMachine *SmClone(SmSpecArena *arena, const SmMachine *src, size_t instance_size, size_t user_size);
+
+/**
+ * @brief 在克隆上推演事件序列
+ * @param clone 克隆实例(SmClone 的返回值)
+ * @param events 事件序列
+ * @param count 事件数量
+ * @param flags SM_SPEC_STUB_*
+ * @param trace 推演轨迹(steps/capacity 由调用者设置, 其余字段输出)
+ * @return SM_RET_OK 全部事件分发完成(可能被忽略), 其他 第一个失败事件的结果
+ */
+SmRetCode SmSpeculate(SmMachine *clone, const SmEventId *events, uint16_t count, uint32_t flags, SmSpecTrace *trace);
+
+/**
+ * @brief 记录一步(由 SmMgr 在推演中调用)
+ * @param trace 推演轨迹
+ * @param kind SM_SPEC_STEP_*
+ * @param state 状态ID
+ * @param trans 转换规则(动作)
+ * @return true 调用实际的回调, false 回调被桩函数替换
+ */
+bool SmSpecRecord(SmSpecTrace *trace, uint8_t kind, SmStateId state, const SmTransition *trans);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMSPEC_H__ */
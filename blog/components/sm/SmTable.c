@@ -0,0 +1,513 @@
+#include "SmTable.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_TABLE_ALIGN(x)  (((x) + 7u) & ~(size_t)7u)
+#define SM_TABLE_UNPLACED  0x80000000u /* 构建过程中标记尚未放置的行 */
+#define SM_TABLE_WINDOW    8192u       /* 首次适配的搜索窗口(槽位数) */
+#define SM_TABLE_WORDS(n)  (((uint32_t)(n) + 31u) / 32u)
+
+/**
+ * @brief 计算转换表的事件域
+ * @note 取转换表、通配转换、on_handle 过滤表和延迟事件中最大事件ID + 1, 与类声明的
+ *       event_count 取较大者; event_count 只是通道表长度, 不能截断事件域, 否则超出
+ *       通道表的转换在查表时被丢弃, 与线性查找不一致
+ */
+static uint16_t SmTableEventCount(const SmClass *sm_class)
+{
+    SmEventId max_event = (SmEventId)sm_class->event_count - 1;
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        const SmState *state = &sm_class->states[s];
+        for (uint16_t i = 0; i < state->trans_count; i++)
+        {
+            if (state->transitions[i].event_id > max_event)
+            {
+                max_event = state->transitions[i].event_id;
+            }
+        }
+        for (const SmEventId *evt = state->handle_events; evt != NULL && *evt != SM_EVENT_INVALID; evt++)
+        {
+            if (*evt > max_event)
+            {
+                max_event = *evt;
+            }
+        }
+        for (const SmEventId *evt = state->deferred_events; evt != NULL && *evt != SM_EVENT_INVALID; evt++)
+        {
+            if (*evt > max_event)
+            {
+                max_event = *evt;
+            }
+        }
+    }
+    for (uint16_t i = 0; i < sm_class->any_trans_count; i++)
+    {
+        if (sm_class->any_transitions[i].event_id > max_event)
+        {
+            max_event = sm_class->any_transitions[i].event_id;
+        }
+    }
+
+    return (max_event >= UINT16_MAX) ? UINT16_MAX : (uint16_t)(max_event + 1);
+}
+
+/**
+ * @brief 获取状态行中的第 i 个候选条目
+ * @param i 候选下标, [0, trans_count) 为状态自身规则, 之后为通配规则
+ * @param event 输出事件ID
+ * @param value 输出槽位转换值
+ * @return true 有效条目, false 无效(结束标记/越界/被前面的规则覆盖)
+ * @note 与线性查找语义一致: 同一事件取第一条自身规则, 其次取第一条通配规则
+ */
+static bool SmTableRowEntry(const SmClass *sm_class, const SmState *state, uint16_t event_count,
+                            uint32_t i, SmEventId *event, uint16_t *value)
+{
+    const SmTransition *trans;
+    bool is_any = (i >= state->trans_count);
+
+    if (!is_any)
+    {
+        trans = &state->transitions[i];
+    }
+    else
+    {
+        if (state->any_opt_out || i - state->trans_count >= sm_class->any_trans_count)
+        {
+            return false;
+        }
+        trans = &sm_class->any_transitions[i - state->trans_count];
+    }
+
+    SmEventId evt = trans->event_id;
+    if (evt < 0 || evt >= event_count)
+    {
+        return false;
+    }
+
+    /* 被前面的条目覆盖 */
+    for (uint32_t j = 0; j < i; j++)
+    {
+        const SmTransition *prev = (j < state->trans_count)
+                                       ? &state->transitions[j]
+                                       : &sm_class->any_transitions[j - state->trans_count];
+        if (prev->event_id == evt)
+        {
+            return false;
+        }
+    }
+
+    *event = evt;
+    *value = is_any ? (uint16_t)((i - state->trans_count) | SM_TABLE_ANY_BIT) : (uint16_t)i;
+    return true;
+}
+
+/**
+ * @brief 统计状态行的有效条目数
+ */
+static uint32_t SmTableRowSize(const SmClass *sm_class, const SmState *state, uint16_t event_count)
+{
+    uint32_t total = (uint32_t)state->trans_count + sm_class->any_trans_count;
+    uint32_t count = 0;
+    SmEventId event;
+    uint16_t value;
+
+    for (uint32_t i = 0; i < total; i++)
+    {
+        if (SmTableRowEntry(sm_class, state, event_count, i, &event, &value))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief 标记 on_handle 关心的事件
+ * @note 未声明 handle_events 的处理函数视为关心全部事件
+ */
+static void SmTableMarkHandled(const SmState *state, uint16_t event_count, uint32_t *bits)
+{
+    if (state->on_handle == NULL)
+    {
+        return;
+    }
+
+    /* 不过滤事件时连同越界位(下标 event_count)一起置位, 越界事件也送到 on_handle */
+    if (state->handle_events == NULL)
+    {
+        for (uint32_t e = 0; e <= event_count; e++)
+        {
+            bits[e >> 5] |= 1u << (e & 31u);
+        }
+        return;
+    }
+
+    for (const SmEventId *evt = state->handle_events; *evt != SM_EVENT_INVALID; evt++)
+    {
+        if (*evt >= 0 && *evt < event_count)
+        {
+            bits[(uint32_t)*evt >> 5] |= 1u << ((uint32_t)*evt & 31u);
+        }
+    }
+}
+
+/**
+ * @brief 标记延迟的事件(包括所属组合状态延迟的事件), 使其不被快速拒绝
+ * @note 压缩表要求状态ID即下标
+ */
+static void SmTableMarkDeferred(const SmClass *sm_class, const SmState *state, uint16_t event_count, uint32_t *bits)
+{
+    for (uint16_t depth = 0; state != NULL && depth < SM_STATE_MAX_DEPTH; depth++)
+    {
+        for (const SmEventId *evt = state->deferred_events; evt != NULL && *evt != SM_EVENT_INVALID; evt++)
+        {
+            if (*evt >= 0 && *evt < event_count)
+            {
+                bits[(uint32_t)*evt >> 5] |= 1u << ((uint32_t)*evt & 31u);
+            }
+        }
+        state = (state->has_parent && state->parent >= 0 && state->parent < sm_class->state_count)
+                    ? &sm_class->states[state->parent]
+                    : NULL;
+    }
+}
+
+/**
+ * @brief 查找状态的完成转换
+ */
+static const SmTransition *SmTableCompletion(const SmState *state)
+{
+    for (uint16_t i = 0; state->transitions != NULL && i < state->trans_count; i++)
+    {
+        if (state->transitions[i].event_id == SM_EVENT_COMPLETION)
+        {
+            return &state->transitions[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 判断状态能否作为直通状态被融合
+ * @note 完成转换无条件/无动作/外部转换, 状态(及所属组合状态)没有进入/退出回调,
+ *       也没有延迟事件和停留预算, 跳过它不改变可观察的行为
+ */
+static bool SmTablePassThrough(const SmClass *sm_class, const SmState *state)
+{
+    const SmTransition *trans = SmTableCompletion(state);
+    if (trans == NULL || trans->condition != NULL || trans->action != NULL || trans->kind != SM_TRANS_KIND_EXTERNAL ||
+        state->kind != SM_STATE_LEAF || state->on_enter != NULL || state->on_exit != NULL ||
+        state->deferred_events != NULL || state->dwell_budget != 0)
+    {
+        return false;
+    }
+
+    for (uint16_t depth = 0; state->has_parent; depth++)
+    {
+        if (depth >= SM_STATE_MAX_DEPTH || state->parent < 0 || state->parent >= sm_class->state_count)
+        {
+            return false;
+        }
+        state = &sm_class->states[state->parent];
+        if (state->on_enter != NULL || state->on_exit != NULL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 静态解析转换目标(组合状态沿 initial 下降)
+ * @return 叶子状态下标, -1 表示无法静态确定(历史伪状态等)
+ */
+static int32_t SmTableStaticTarget(const SmClass *sm_class, SmStateId target)
+{
+    for (uint16_t n = 0; n <= sm_class->state_count; n++)
+    {
+        if (target < 0 || target >= sm_class->state_count)
+        {
+            return -1;
+        }
+        const SmState *state = &sm_class->states[target];
+        if (state->kind == SM_STATE_LEAF)
+        {
+            return target;
+        }
+        if (state->kind != SM_STATE_COMPOSITE)
+        {
+            return -1;
+        }
+        target = state->initial;
+    }
+    return -1;
+}
+
+/**
+ * @brief 生成完成转换链
+ * @note 直通状态沿完成转换走到第一个非直通状态; 成环或目标无法静态确定时
+ *       退回运行时逐步执行
+ */
+static void SmTableBuildChain(const SmClass *sm_class, uint16_t *chain)
+{
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        const SmState *state = &sm_class->states[s];
+        if (SmTableCompletion(state) == NULL)
+        {
+            chain[s] = SM_TABLE_EMPTY;
+            continue;
+        }
+
+        chain[s] = SM_TABLE_DYNAMIC;
+        int32_t cur = s;
+        for (uint16_t n = 0; n < sm_class->state_count && SmTablePassThrough(sm_class, &sm_class->states[cur]); n++)
+        {
+            int32_t next = SmTableStaticTarget(sm_class, SmTableCompletion(&sm_class->states[cur])->next_state);
+            if (next < 0 || next == s)
+            {
+                break;
+            }
+            cur = next;
+            if (!SmTablePassThrough(sm_class, &sm_class->states[cur]))
+            {
+                chain[s] = (uint16_t)cur;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 检查类是否满足压缩表约束
+ */
+static bool SmTableCheckClass(const SmClass *sm_class)
+{
+    if (sm_class == NULL || sm_class->states == NULL || sm_class->state_count >= SM_TABLE_EMPTY)
+    {
+        return false;
+    }
+
+    if (sm_class->any_trans_count >= SM_TABLE_ANY_BIT)
+    {
+        return false;
+    }
+
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        if (sm_class->states[s].state_id != (SmStateId)s || sm_class->states[s].trans_count >= SM_TABLE_ANY_BIT)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+size_t SmTableCalcSize(const SmClass *sm_class)
+{
+    if (!SmTableCheckClass(sm_class))
+    {
+        return 0;
+    }
+
+    uint16_t event_count = SmTableEventCount(sm_class);
+    size_t trans_total = 0;
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        trans_total += SmTableRowSize(sm_class, &sm_class->states[s], event_count);
+    }
+
+    /* 窗口内首次适配的填充率通常在 60%~80%, 按 50% 预留; 另需一行构建暂存 */
+    size_t slots = 2u * trans_total + 2u * event_count;
+    size_t interest_size = sizeof(uint32_t) * SM_TABLE_WORDS(event_count + 1u) * sm_class->state_count;
+    return SM_TABLE_ALIGN(sizeof(uint32_t) * sm_class->state_count) + SM_TABLE_ALIGN(interest_size) +
+           SM_TABLE_ALIGN(sizeof(uint16_t) * sm_class->state_count) + sizeof(SmTableSlot) * slots;
+}
+
+SmRetCode SmTableBuild(SmTable *table, const SmClass *sm_class, void *buf, size_t buf_size)
+{
+    if (table == NULL || buf == NULL || !SmTableCheckClass(sm_class))
+    {
+        return SM_RET_ERROR;
+    }
+
+    uint16_t state_count = sm_class->state_count;
+    uint16_t event_count = SmTableEventCount(sm_class);
+
+    /* 布局: [base][interest][chain][slots], 槽位放在最后, 未使用的尾部可由调用者回收 */
+    uint16_t interest_words = (uint16_t)SM_TABLE_WORDS(event_count + 1u);
+    size_t base_size = SM_TABLE_ALIGN(sizeof(uint32_t) * state_count);
+    size_t interest_size = SM_TABLE_ALIGN(sizeof(uint32_t) * interest_words * state_count);
+    size_t chain_size = SM_TABLE_ALIGN(sizeof(uint16_t) * state_count);
+    if (buf_size < base_size + interest_size + chain_size + sizeof(SmTableSlot))
+    {
+        return SM_RET_ERROR;
+    }
+
+    uint32_t *base = (uint32_t *)buf;
+    uint32_t *interest = (uint32_t *)((uint8_t *)buf + base_size);
+    uint16_t *chain = (uint16_t *)((uint8_t *)buf + base_size + interest_size);
+    SmTableSlot *slots = (SmTableSlot *)((uint8_t *)buf + base_size + interest_size + chain_size);
+    size_t capacity = (buf_size - base_size - interest_size - chain_size) / sizeof(SmTableSlot);
+
+    SmTableBuildChain(sm_class, chain);
+
+    /* 事件兴趣位图: on_handle 关心的事件 + 延迟的事件 + 有转换的事件(放置行时补充),
+     * 每行多一位(下标 event_count)表示是否关心越界事件 */
+    memset(interest, 0, interest_size);
+    for (uint16_t s = 0; s < state_count; s++)
+    {
+        SmTableMarkHandled(&sm_class->states[s], event_count, &interest[(uint32_t)s * interest_words]);
+        SmTableMarkDeferred(sm_class, &sm_class->states[s], event_count, &interest[(uint32_t)s * interest_words]);
+    }
+
+    /* 统计最大行密度, 未放置的行以 SM_TABLE_UNPLACED 标记行大小 */
+    uint32_t max_row = 0;
+    uint32_t trans_count = 0;
+    for (uint16_t s = 0; s < state_count; s++)
+    {
+        uint32_t row_size = SmTableRowSize(sm_class, &sm_class->states[s], event_count);
+        trans_count += row_size;
+        if (row_size > max_row)
+        {
+            max_row = row_size;
+        }
+        base[s] = SM_TABLE_UNPLACED | row_size;
+    }
+
+    /* 缓冲区尾部暂存当前行(check 存事件ID, trans 存转换值) */
+    if (capacity <= max_row)
+    {
+        return SM_RET_ERROR;
+    }
+    capacity -= max_row;
+    if (capacity > UINT32_MAX)
+    {
+        capacity = UINT32_MAX;
+    }
+    SmTableSlot *row = slots + capacity;
+    memset(slots, 0xFF, capacity * sizeof(SmTableSlot));
+
+    /* 按行密度从高到低放置, 每行取第一个不冲突的偏移 */
+    uint32_t used = 0;
+    uint32_t first_free = 0;
+    for (uint32_t density = max_row; density > 0; density--)
+    {
+        for (uint16_t s = 0; s < state_count; s++)
+        {
+            if (base[s] != (SM_TABLE_UNPLACED | density))
+            {
+                continue;
+            }
+
+            /* 收集行条目, 行中最小事件ID决定起始偏移下限 */
+            const SmState *state = &sm_class->states[s];
+            uint32_t total = (uint32_t)state->trans_count + sm_class->any_trans_count;
+            uint32_t row_size = 0;
+            uint32_t min_event = event_count;
+            for (uint32_t i = 0; i < total; i++)
+            {
+                SmEventId event;
+                uint16_t value;
+                if (SmTableRowEntry(sm_class, state, event_count, i, &event, &value))
+                {
+                    row[row_size].check = (uint16_t)event;
+                    row[row_size].trans = value;
+                    row_size++;
+                    if ((uint32_t)event < min_event)
+                    {
+                        min_event = (uint32_t)event;
+                    }
+                }
+            }
+
+            /* 只在已用区域末尾 SM_TABLE_WINDOW 个槽位内首次适配, 更早的空洞基本无法再填充 */
+            uint32_t start = (used > SM_TABLE_WINDOW) ? used - SM_TABLE_WINDOW : 0;
+            if (start < first_free)
+            {
+                start = first_free;
+            }
+            uint32_t offset = (start > min_event) ? start - min_event : 0;
+            for (;; offset++)
+            {
+
+                bool fit = true;
+                for (uint32_t i = 0; i < row_size && fit; i++)
+                {
+                    size_t idx = (size_t)offset + row[i].check;
+                    if (idx >= capacity)
+                    {
+                        return SM_RET_ERROR; /* 缓冲区不足 */
+                    }
+                    fit = (slots[idx].check == SM_TABLE_EMPTY);
+                }
+                if (fit)
+                {
+                    break;
+                }
+            }
+
+            for (uint32_t i = 0; i < row_size; i++)
+            {
+                uint32_t idx = offset + row[i].check;
+                slots[idx].check = s;
+                slots[idx].trans = row[i].trans;
+                interest[(uint32_t)s * interest_words + (row[i].check >> 5)] |= 1u << (row[i].check & 31u);
+                if (idx + 1 > used)
+                {
+                    used = idx + 1;
+                }
+            }
+            base[s] = offset;
+
+            while (first_free < capacity && slots[first_free].check != SM_TABLE_EMPTY)
+            {
+                first_free++;
+            }
+        }
+    }
+
+    /* 空行状态不占用槽位, 任意偏移查找都不会命中 */
+    for (uint16_t s = 0; s < state_count; s++)
+    {
+        if (base[s] == SM_TABLE_UNPLACED)
+        {
+            base[s] = 0;
+        }
+    }
+
+    table->state_count = state_count;
+    table->event_count = event_count;
+    table->slot_count = used;
+    table->trans_count = trans_count;
+    table->interest_words = interest_words;
+    table->base = base;
+    table->interest = interest;
+    table->slots = slots;
+    table->chain = chain;
+
+    return SM_RET_OK;
+}
+
+size_t SmTableGetBytes(const SmTable *table)
+{
+    if (table == NULL)
+    {
+        return 0;
+    }
+
+    return sizeof(SmTable) + sizeof(uint32_t) * table->state_count +
+           sizeof(uint32_t) * table->interest_words * table->state_count +
+           ((table->chain != NULL) ? sizeof(uint16_t) * table->state_count : 0) +
+           sizeof(SmTableSlot) * table->slot_count;
+}
@@ -0,0 +1,139 @@
+#ifndef __SMTABLE_H__
+#define __SMTABLE_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 压缩转换表(行位移 / row displacement)
+ * ============================================================================ */
+
+/*
+ * 将 SmClass 的 [状态][事件] 稀疏矩阵压缩为一维槽位数组:
+ *   槽位下标 = base[状态下标] + 事件ID
+ *   slots[下标].check == 状态下标 时命中, 否则该 (状态, 事件) 无转换
+ * 查找为 O(1), 内存约为 (实际转换数 + 少量空洞) * 4 字节 + 状态数 * 4 字节.
+ * 类级通配转换在构建时展开到各状态的行中, 运行时不再二次查找.
+ * 同时为每个状态生成事件兴趣位图(有转换或 on_handle 关心), 用于快速拒绝.
+ * 完成转换(SM_EVENT_COMPLETION)不进入槽位, 按状态记录在 chain 中: 无条件、
+ * 无动作且进入/退出没有回调的直通状态在构建时融合, 转换直接到达链路终点.
+ *
+ * 约束: 状态ID必须与其在状态数组中的下标一致(0..state_count-1).
+ * 事件域 event_count 由类中出现的最大事件ID决定(不小于类声明的 event_count),
+ * 所有转换都落在域内; 域外事件只可能送到不过滤事件的 on_handle.
+ */
+
+#define SM_TABLE_EMPTY   0xFFFF /* 空槽位 */
+#define SM_TABLE_ANY_BIT 0x8000 /* 槽位引用通配转换 */
+#define SM_TABLE_DYNAMIC 0xFFFE /* chain: 有完成转换, 运行时逐步执行 */
+
+/**
+ * @brief 转换表槽位
+ */
+typedef struct
+{
+    uint16_t check; /* 所属状态下标, SM_TABLE_EMPTY 表示空槽位 */
+    uint16_t trans; /* 转换下标, 置位 SM_TABLE_ANY_BIT 时为通配转换下标 */
+} SmTableSlot;
+
+/**
+ * @brief 压缩转换表
+ */
+struct SmTableTag
+{
+    uint16_t state_count;     /* 状态数量 */
+    uint16_t event_count;     /* 事件域(最大事件ID + 1) */
+    uint32_t slot_count;      /* 槽位数量 */
+    uint32_t trans_count;     /* 有效 (状态, 事件) 转换数量 */
+    uint16_t interest_words;  /* 每个状态的兴趣位图字数(event_count + 1 位) */
+    const uint32_t *base;     /* 行偏移数组 [state_count] */
+    const uint32_t *interest; /* 事件兴趣位图 [state_count][interest_words], 第 event_count 位表示越界事件 */
+    const SmTableSlot *slots; /* 槽位数组 [slot_count] */
+    const uint16_t *chain;    /* 完成转换 [state_count]: 融合后终点状态下标 / SM_TABLE_DYNAMIC / SM_TABLE_EMPTY(无), 可为NULL */
+};
+
+/**
+ * @brief 判断状态是否关心事件
+ * @param table 转换表
+ * @param state_index 状态下标
+ * @param event 事件ID
+ * @return true 有转换或 on_handle 关心该事件, false 可直接忽略
+ */
+static inline bool SmTableIsInterested(const SmTable *table, uint16_t state_index, SmEventId event)
+{
+    if (state_index >= table->state_count)
+    {
+        return false;
+    }
+
+    /* 越界事件(含负ID)查每行末尾的越界位: 不过滤事件的 on_handle 仍然关心 */
+    uint32_t bit = ((uint32_t)event < table->event_count) ? (uint32_t)event : table->event_count;
+    const uint32_t *bits = &table->interest[(uint32_t)state_index * table->interest_words];
+    return (bits[bit >> 5] >> (bit & 31u)) & 1u;
+}
+
+/**
+ * @brief 查找转换规则
+ * @param table 转换表
+ * @param sm_class 状态机类
+ * @param state_index 状态下标
+ * @param event 事件ID
+ * @return 转换规则, NULL表示无转换
+ */
+static inline const SmTransition *SmTableLookup(const SmTable *table, const SmClass *sm_class,
+                                                uint16_t state_index, SmEventId event)
+{
+    if ((uint32_t)event >= table->event_count || state_index >= table->state_count)
+    {
+        return NULL;
+    }
+
+    uint32_t idx = table->base[state_index] + (uint32_t)event;
+    if (idx >= table->slot_count || table->slots[idx].check != state_index)
+    {
+        return NULL;
+    }
+
+    uint16_t trans = table->slots[idx].trans;
+    if (trans & SM_TABLE_ANY_BIT)
+    {
+        return &sm_class->any_transitions[trans & (uint16_t)~SM_TABLE_ANY_BIT];
+    }
+
+    return &sm_class->states[state_index].transitions[trans];
+}
+
+/**
+ * @brief 计算构建转换表建议的缓冲区大小
+ * @param sm_class 状态机类
+ * @return 字节数, 0表示类不满足约束
+ */
+size_t SmTableCalcSize(const SmClass *sm_class);
+
+/**
+ * @brief 构建压缩转换表
+ * @param table 转换表(输出)
+ * @param sm_class 状态机类
+ * @param buf 缓冲区, 表数据直接存放于此, 生命周期需不短于 table
+ * @param buf_size 缓冲区大小
+ * @return SM_RET_OK 成功, SM_RET_ERROR 类不满足约束或缓冲区不足
+ * @note 构建完成后将 table 赋给 SmClass.table 即可启用 O(1) 查找
+ */
+SmRetCode SmTableBuild(SmTable *table, const SmClass *sm_class, void *buf, size_t buf_size);
+
+/**
+ * @brief 获取转换表实际占用的字节数
+ * @param table 转换表
+ * @return 字节数
+ */
+size_t SmTableGetBytes(const SmTable *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMTABLE_H__ */
@@ -0,0 +1,225 @@
+#include "SmTimer.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+#define SM_TIMER_NIL 0xFFFFFFFFu /* 空闲链表结束标记 */
+
+/**
+ * @brief 比较两个定时器的触发顺序
+ */
+static bool SmTimerBefore(const SmTimerHeap *heap, uint32_t a, uint32_t b)
+{
+    const SmTimer *ta = &heap->timers[a];
+    const SmTimer *tb = &heap->timers[b];
+
+    return (ta->deadline < tb->deadline) || (ta->deadline == tb->deadline && ta->seq < tb->seq);
+}
+
+/**
+ * @brief 放置槽位到堆下标并更新反向索引
+ */
+static void SmTimerPlace(SmTimerHeap *heap, uint32_t pos, uint32_t slot)
+{
+    heap->heap[pos] = slot;
+    heap->timers[slot].link = pos;
+}
+
+static void SmTimerSiftUp(SmTimerHeap *heap, uint32_t pos)
+{
+    uint32_t slot = heap->heap[pos];
+
+    while (pos > 0)
+    {
+        uint32_t parent = (pos - 1) / 2;
+        if (!SmTimerBefore(heap, slot, heap->heap[parent]))
+        {
+            break;
+        }
+        SmTimerPlace(heap, pos, heap->heap[parent]);
+        pos = parent;
+    }
+    SmTimerPlace(heap, pos, slot);
+}
+
+static void SmTimerSiftDown(SmTimerHeap *heap, uint32_t pos)
+{
+    uint32_t slot = heap->heap[pos];
+
+    for (;;)
+    {
+        uint32_t child = pos * 2 + 1;
+        if (child >= heap->count)
+        {
+            break;
+        }
+        if (child + 1 < heap->count && SmTimerBefore(heap, heap->heap[child + 1], heap->heap[child]))
+        {
+            child++;
+        }
+        if (!SmTimerBefore(heap, heap->heap[child], slot))
+        {
+            break;
+        }
+        SmTimerPlace(heap, pos, heap->heap[child]);
+        pos = child;
+    }
+    SmTimerPlace(heap, pos, slot);
+}
+
+/**
+ * @brief 从堆中删除指定下标并释放槽位
+ */
+static void SmTimerRemoveAt(SmTimerHeap *heap, uint32_t pos)
+{
+    uint32_t slot = heap->heap[pos];
+
+    heap->count--;
+    if (pos < heap->count)
+    {
+        SmTimerPlace(heap, pos, heap->heap[heap->count]);
+        if (pos > 0 && SmTimerBefore(heap, heap->heap[pos], heap->heap[(pos - 1) / 2]))
+        {
+            SmTimerSiftUp(heap, pos);
+        }
+        else
+        {
+            SmTimerSiftDown(heap, pos);
+        }
+    }
+
+    SmTimer *timer = &heap->timers[slot];
+    timer->active = false;
+    timer->generation++;
+    timer->link = heap->free_head;
+    heap->free_head = slot;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmTimerHeapInit(SmTimerHeap *heap, SmTimer *timers, uint32_t *heap_buf, uint32_t capacity)
+{
+    if (heap == NULL || timers == NULL || heap_buf == NULL || capacity == 0 || capacity == SM_TIMER_NIL)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(heap, 0, sizeof(SmTimerHeap));
+    memset(timers, 0, sizeof(SmTimer) * capacity);
+
+    heap->timers = timers;
+    heap->heap = heap_buf;
+    heap->capacity = capacity;
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        timers[i].link = (i + 1 < capacity) ? i + 1 : SM_TIMER_NIL;
+    }
+    heap->free_head = 0;
+
+    return SM_RET_OK;
+}
+
+SmTimerId SmTimerStart(SmTimerHeap *heap, SmMachine *machine, SmEventId event, uint64_t deadline)
+{
+    if (heap == NULL || machine == NULL || heap->free_head == SM_TIMER_NIL)
+    {
+        return SM_TIMER_NONE;
+    }
+
+    uint32_t slot = heap->free_head;
+    SmTimer *timer = &heap->timers[slot];
+    heap->free_head = timer->link;
+
+    timer->deadline = deadline;
+    timer->seq = heap->seq++;
+    timer->machine = machine;
+    timer->event = event;
+    timer->active = true;
+
+    SmTimerPlace(heap, heap->count++, slot);
+    SmTimerSiftUp(heap, heap->count - 1);
+
+    return ((uint64_t)timer->generation << 32) | (uint64_t)(slot + 1);
+}
+
+SmRetCode SmTimerCancel(SmTimerHeap *heap, SmTimerId id)
+{
+    if (heap == NULL || id == SM_TIMER_NONE)
+    {
+        return SM_RET_ERROR;
+    }
+
+    uint32_t slot = (uint32_t)(id & 0xFFFFFFFFu) - 1;
+    if (slot >= heap->capacity)
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmTimer *timer = &heap->timers[slot];
+    if (!timer->active || timer->generation != (uint32_t)(id >> 32))
+    {
+        return SM_RET_ERROR;
+    }
+
+    SmTimerRemoveAt(heap, timer->link);
+    return SM_RET_OK;
+}
+
+bool SmTimerPeek(const SmTimerHeap *heap, uint64_t *deadline)
+{
+    if (heap == NULL || heap->count == 0)
+    {
+        return false;
+    }
+
+    if (deadline != NULL)
+    {
+        *deadline = heap->timers[heap->heap[0]].deadline;
+    }
+    return true;
+}
+
+bool SmTimerPop(SmTimerHeap *heap, uint64_t now, SmMachine **machine, SmEventId *event)
+{
+    if (heap == NULL || heap->count == 0)
+    {
+        return false;
+    }
+
+    const SmTimer *timer = &heap->timers[heap->heap[0]];
+    if (timer->deadline > now)
+    {
+        return false;
+    }
+
+    *machine = timer->machine;
+    *event = timer->event;
+    SmTimerRemoveAt(heap, 0);
+    return true;
+}
+
+uint32_t SmTimerExpire(SmTimerHeap *heap, uint64_t now)
+{
+    uint32_t fired = 0;
+    SmMachine *machine;
+    SmEventId event;
+
+    while (SmTimerPop(heap, now, &machine, &event))
+    {
+        if (machine->queue != NULL)
+        {
+            SmPostEvent(machine, event);
+        }
+        else
+        {
+            SmSendEvent(machine, event);
+        }
+        fired++;
+    }
+
+    return fired;
+}
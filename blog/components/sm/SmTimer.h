@@ -0,0 +1,112 @@
+#ifndef __SMTIMER_H__
+#define __SMTIMER_H__
+
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 定时器堆
+ * ============================================================================ */
+
+/*
+ * 到期时向状态机发送事件的定时器, 按 (截止时间, 启动顺序) 组织为二叉最小堆:
+ * 启动/取消 O(log n), 查询最近截止时间 O(1). 截止时间与 SmGetTime 同一单位,
+ * 因此同一套定时器既可以由实时分发循环驱动, 也可以由虚拟时间仿真器驱动.
+ * 存储由调用者提供(静态分配), 不在内部申请内存.
+ */
+
+#define SM_TIMER_NONE 0 /* 无效定时器ID */
+
+typedef uint64_t SmTimerId; /* 定时器ID(槽位 + 代数, 槽位复用后旧ID自动失效) */
+
+/**
+ * @brief 定时器槽位
+ */
+typedef struct
+{
+    uint64_t deadline;   /* 截止时间 */
+    uint64_t seq;        /* 启动顺序(截止时间相同时先启动先触发) */
+    SmMachine *machine;  /* 目标实例 */
+    SmEventId event;     /* 到期事件 */
+    uint32_t link;       /* 使用中为堆下标, 空闲时为下一个空闲槽位 */
+    uint32_t generation; /* 槽位代数 */
+    bool active;         /* 是否使用中 */
+} SmTimer;
+
+/**
+ * @brief 定时器堆
+ */
+typedef struct
+{
+    SmTimer *timers;    /* 槽位数组 [capacity] */
+    uint32_t *heap;     /* 堆数组(槽位下标) [capacity] */
+    uint32_t capacity;  /* 容量 */
+    uint32_t count;     /* 使用中的定时器数量 */
+    uint32_t free_head; /* 空闲槽位链表头 */
+    uint64_t seq;       /* 启动计数 */
+} SmTimerHeap;
+
+/**
+ * @brief 初始化定时器堆
+ * @param heap 定时器堆
+ * @param timers 槽位存储 [capacity]
+ * @param heap_buf 堆存储 [capacity]
+ * @param capacity 容量
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmTimerHeapInit(SmTimerHeap *heap, SmTimer *timers, uint32_t *heap_buf, uint32_t capacity);
+
+/**
+ * @brief 启动定时器
+ * @param heap 定时器堆
+ * @param machine 目标实例
+ * @param event 到期事件
+ * @param deadline 截止时间(SmGetTime 单位)
+ * @return 定时器ID, SM_TIMER_NONE 表示堆已满
+ */
+SmTimerId SmTimerStart(SmTimerHeap *heap, SmMachine *machine, SmEventId event, uint64_t deadline);
+
+/**
+ * @brief 取消定时器
+ * @param heap 定时器堆
+ * @param id 定时器ID
+ * @return SM_RET_OK 成功, SM_RET_ERROR 已触发/已取消/ID无效
+ */
+SmRetCode SmTimerCancel(SmTimerHeap *heap, SmTimerId id);
+
+/**
+ * @brief 获取最近的截止时间
+ * @param heap 定时器堆
+ * @param deadline 截止时间(输出)
+ * @return true 有定时器, false 堆为空
+ */
+bool SmTimerPeek(const SmTimerHeap *heap, uint64_t *deadline);
+
+/**
+ * @brief 取出一个已到期的定时器
+ * @param heap 定时器堆
+ * @param now 当前时间
+ * @param machine 目标实例(输出)
+ * @param event 到期事件(输出)
+ * @return true 取出成功, false 没有到期的定时器
+ */
+bool SmTimerPop(SmTimerHeap *heap, uint64_t now, SmMachine **machine, SmEventId *event);
+
+/**
+ * @brief 触发所有已到期的定时器
+ * @param heap 定时器堆
+ * @param now 当前时间
+ * @return 触发的定时器数量
+ * @note 实例绑定了事件队列时投递到队列(由分发循环处理), 否则直接发送;
+ *       回调函数中可以继续启动/取消定时器
+ */
+uint32_t SmTimerExpire(SmTimerHeap *heap, uint64_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMTIMER_H__ */
@@ -0,0 +1,264 @@
+#include "SmWatchdog.h"
+#include <string.h>
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+/**
+ * @brief 查找状态下标
+ */
+static uint16_t SmWdStateIndex(const SmClass *sm_class, const SmState *state)
+{
+    if (state == NULL || state < sm_class->states || state >= sm_class->states + sm_class->state_count)
+    {
+        return SM_DWELL_UNLINKED;
+    }
+    return (uint16_t)(state - sm_class->states);
+}
+
+static const SmState *SmWdFindState(const SmClass *sm_class, SmStateId state_id)
+{
+    if (state_id >= 0 && state_id < sm_class->state_count && sm_class->states[state_id].state_id == state_id)
+    {
+        return &sm_class->states[state_id];
+    }
+
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        if (sm_class->states[i].state_id == state_id)
+        {
+            return &sm_class->states[i];
+        }
+    }
+    return NULL;
+}
+
+static void SmWdUnlink(SmWatchdog *watchdog, SmMachine *machine)
+{
+    SmDwellLink *link = &machine->dwell;
+    if (link->list == SM_DWELL_UNLINKED)
+    {
+        return;
+    }
+
+    SmDwellList *list = &watchdog->lists[link->list];
+    if (link->prev != NULL)
+    {
+        link->prev->dwell.next = link->next;
+    }
+    else
+    {
+        list->head = link->next;
+    }
+    if (link->next != NULL)
+    {
+        link->next->dwell.prev = link->prev;
+    }
+    else
+    {
+        list->tail = link->prev;
+    }
+
+    link->prev = NULL;
+    link->next = NULL;
+    link->list = SM_DWELL_UNLINKED;
+    watchdog->pending--;
+}
+
+/**
+ * @brief 按到期时间插入链表(通常直接挂在尾部)
+ */
+static void SmWdLink(SmWatchdog *watchdog, SmMachine *machine, uint16_t index, uint64_t deadline)
+{
+    SmDwellList *list = &watchdog->lists[index];
+    SmMachine *after = list->tail;
+
+    /* 换类等情况下的到期时间可能早于尾部, 向前找到插入位置 */
+    while (after != NULL && after->dwell.deadline > deadline)
+    {
+        after = after->dwell.prev;
+    }
+
+    SmDwellLink *link = &machine->dwell;
+    link->deadline = deadline;
+    link->list = index;
+    link->prev = after;
+    link->next = (after != NULL) ? after->dwell.next : list->head;
+    if (link->next != NULL)
+    {
+        link->next->dwell.prev = machine;
+    }
+    else
+    {
+        list->tail = machine;
+    }
+    if (after != NULL)
+    {
+        after->dwell.next = machine;
+    }
+    else
+    {
+        list->head = machine;
+    }
+    watchdog->pending++;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmWatchdogInit(SmWatchdog *watchdog, SmDwellList *lists, uint16_t list_count)
+{
+    if (watchdog == NULL || lists == NULL || list_count == 0 || list_count == SM_DWELL_UNLINKED)
+    {
+        return SM_RET_ERROR;
+    }
+
+    memset(watchdog, 0, sizeof(SmWatchdog));
+    memset(lists, 0, sizeof(SmDwellList) * list_count);
+    watchdog->lists = lists;
+    watchdog->list_count = list_count;
+    watchdog->expire_event = SM_EVENT_INVALID;
+
+    return SM_RET_OK;
+}
+
+void SmWatchdogSetAction(SmWatchdog *watchdog, SmEventId expire_event, SmWatchdogReportFn report_fn, void *ctx)
+{
+    if (watchdog == NULL)
+    {
+        return;
+    }
+
+    watchdog->expire_event = expire_event;
+    watchdog->report_fn = report_fn;
+    watchdog->report_ctx = ctx;
+}
+
+SmRetCode SmWatchdogAttach(SmWatchdog *watchdog, SmMachine *machine)
+{
+    if (watchdog == NULL || machine == NULL || !machine->is_initialized)
+    {
+        return SM_RET_ERROR;
+    }
+    if (machine->dwell.watchdog != NULL)
+    {
+        return (machine->dwell.watchdog == watchdog) ? SM_RET_OK : SM_RET_ERROR;
+    }
+
+    machine->dwell.watchdog = watchdog;
+    machine->dwell.prev = NULL;
+    machine->dwell.next = NULL;
+    machine->dwell.list = SM_DWELL_UNLINKED;
+    watchdog->watched++;
+
+    /* 已运行的实例从进入当前状态的时间开始计算 */
+    if (machine->current_state != SM_STATE_INVALID)
+    {
+        SmWatchdogTrack(machine, SmWdFindState(machine->sm_class, machine->current_state), true);
+    }
+
+    return SM_RET_OK;
+}
+
+void SmWatchdogDetach(SmMachine *machine)
+{
+    if (machine == NULL || machine->dwell.watchdog == NULL)
+    {
+        return;
+    }
+
+    SmWatchdog *watchdog = machine->dwell.watchdog;
+    SmWdUnlink(watchdog, machine);
+    watchdog->watched--;
+    machine->dwell.watchdog = NULL;
+}
+
+void SmWatchdogTrack(SmMachine *machine, const SmState *state, bool entered)
+{
+    SmWatchdog *watchdog = machine->dwell.watchdog;
+    uint16_t index = SmWdStateIndex(machine->sm_class, state);
+
+    if (index != SM_DWELL_UNLINKED && (index >= watchdog->list_count || state->dwell_budget == 0))
+    {
+        index = SM_DWELL_UNLINKED;
+    }
+
+    /* 自转换保持原位置; 已报告过的实例在离开该状态前不再登记 */
+    if (!entered && (machine->dwell.list == SM_DWELL_UNLINKED || machine->dwell.list == index))
+    {
+        return;
+    }
+
+    SmWdUnlink(watchdog, machine);
+    if (index != SM_DWELL_UNLINKED)
+    {
+        SmWdLink(watchdog, machine, index, machine->enter_time + state->dwell_budget);
+    }
+}
+
+uint32_t SmWatchdogCheck(SmWatchdog *watchdog, uint64_t now)
+{
+    uint32_t fired = 0;
+
+    if (watchdog == NULL)
+    {
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < watchdog->list_count && watchdog->pending > 0; i++)
+    {
+        SmDwellList *list = &watchdog->lists[i];
+
+        /* 发送到期事件可能使实例进入其他状态的链表, 每次重新读取链表头 */
+        while (list->head != NULL && list->head->dwell.deadline <= now)
+        {
+            SmMachine *machine = list->head;
+            SmWdUnlink(watchdog, machine);
+            watchdog->expired++;
+            fired++;
+
+            if (watchdog->report_fn != NULL)
+            {
+                watchdog->report_fn(watchdog->report_ctx, machine, machine->current_state, now - machine->enter_time);
+            }
+
+            if (watchdog->expire_event != SM_EVENT_INVALID)
+            {
+                if (machine->queue != NULL)
+                {
+                    SmPostEvent(machine, watchdog->expire_event);
+                }
+                else
+                {
+                    SmSendEvent(machine, watchdog->expire_event);
+                }
+            }
+        }
+    }
+
+    return fired;
+}
+
+bool SmWatchdogPeek(const SmWatchdog *watchdog, uint64_t *deadline)
+{
+    bool found = false;
+
+    if (watchdog == NULL || deadline == NULL)
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < watchdog->list_count && watchdog->pending > 0; i++)
+    {
+        const SmMachine *head = watchdog->lists[i].head;
+        if (head != NULL && (!found || head->dwell.deadline < *deadline))
+        {
+            *deadline = head->dwell.deadline;
+            found = true;
+        }
+    }
+
+    return found;
+}
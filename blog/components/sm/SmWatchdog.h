@@ -0,0 +1,119 @@
+#ifndef __SMWATCHDOG_H__
+#define __SMWATCHDOG_H__
+
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 停留时间监视
+ * ============================================================================ */
+
+/*
+ * 找出在某个状态停留超过预算(SmState.dwell_budget)的实例, 而不扫描全部实例:
+ *   - 每个状态一条双向链表, 实例进入有预算的状态时挂到链表尾部
+ *   - 同一状态的预算相同, 链表按到期时间自然有序, 到期的实例总在链表头部
+ *   - SmWatchdogCheck 只查看各链表头部并摘下到期实例, 开销 O(状态数 + 到期数)
+ * 登记/摘除在 SmMgr 提交状态时完成(O(1)), 自转换不重新计时.
+ * 到期的实例先交给报告回调, 再按配置发送到期事件(绑定了队列时投递到队列);
+ * 每次进入状态最多报告一次.
+ *
+ * 约束: 与实例在同一线程中使用.
+ */
+
+/**
+ * @brief 一个状态的停留链表
+ */
+typedef struct
+{
+    SmMachine *head; /* 最早到期 */
+    SmMachine *tail; /* 最晚到期 */
+} SmDwellList;
+
+/**
+ * @brief 到期报告回调
+ * @param ctx 用户上下文
+ * @param machine 到期实例
+ * @param state 停留的状态ID
+ * @param dwell 已停留时间
+ */
+typedef void (*SmWatchdogReportFn)(void *ctx, SmMachine *machine, SmStateId state, uint64_t dwell);
+
+/**
+ * @brief 停留时间监视器
+ */
+struct SmWatchdogTag
+{
+    SmDwellList *lists;           /* 各状态的停留链表 [list_count](按状态下标) */
+    uint16_t list_count;          /* 链表数量 */
+    SmEventId expire_event;       /* 到期事件, SM_EVENT_INVALID 表示只报告 */
+    SmWatchdogReportFn report_fn; /* 到期报告回调(可选) */
+    void *report_ctx;             /* 报告回调上下文 */
+    uint32_t watched;             /* 监视中的实例数量 */
+    uint32_t pending;             /* 链表中等待到期的实例数量 */
+    uint64_t expired;             /* 累计到期次数 */
+};
+
+/**
+ * @brief 初始化监视器
+ * @param watchdog 监视器
+ * @param lists 链表存储 [list_count], 不少于类的状态数量
+ * @param list_count 链表数量
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+SmRetCode SmWatchdogInit(SmWatchdog *watchdog, SmDwellList *lists, uint16_t list_count);
+
+/**
+ * @brief 设置到期处理
+ * @param watchdog 监视器
+ * @param expire_event 到期时发送给实例的事件, SM_EVENT_INVALID 表示不发送
+ * @param report_fn 到期报告回调(可选)
+ * @param ctx 报告回调上下文
+ */
+void SmWatchdogSetAction(SmWatchdog *watchdog, SmEventId expire_event, SmWatchdogReportFn report_fn, void *ctx);
+
+/**
+ * @brief 开始监视实例
+ * @param watchdog 监视器
+ * @param machine 状态机实例(已运行时按当前状态的进入时间登记)
+ * @return SM_RET_OK 成功, SM_RET_ERROR 参数无效或已被其他监视器监视
+ */
+SmRetCode SmWatchdogAttach(SmWatchdog *watchdog, SmMachine *machine);
+
+/**
+ * @brief 停止监视实例(SmDestroy 自动调用)
+ * @param machine 状态机实例
+ */
+void SmWatchdogDetach(SmMachine *machine);
+
+/**
+ * @brief 按当前状态重新登记(由 SmMgr 在提交状态时调用)
+ * @param machine 状态机实例
+ * @param state 当前状态, NULL表示已停止
+ * @param entered 是否进入了新状态(false 为自转换/换类)
+ */
+void SmWatchdogTrack(SmMachine *machine, const SmState *state, bool entered);
+
+/**
+ * @brief 处理到期实例
+ * @param watchdog 监视器
+ * @param now 当前时间(SmGetTime 单位)
+ * @return 本次到期的实例数量
+ */
+uint32_t SmWatchdogCheck(SmWatchdog *watchdog, uint64_t now);
+
+/**
+ * @brief 查询最近的到期时间
+ * @param watchdog 监视器
+ * @param deadline 最近到期时间(输出)
+ * @return true 有等待到期的实例, false 没有
+ */
+bool SmWatchdogPeek(const SmWatchdog *watchdog, uint64_t *deadline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMWATCHDOG_H__ */
@@ -0,0 +1,734 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime/nanosleep */
+
+#include "SmWorkload.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/* ============================================================================
+ * 内部数据结构
+ * ============================================================================ */
+
+/**
+ * @brief 单个状态的事件抽样表
+ */
+typedef struct
+{
+    SmEventId *events; /* 候选事件 */
+    uint32_t *cum;     /* 累计权重 */
+    uint32_t count;    /* 候选数量 */
+} SmWlChoice;
+
+/**
+ * @brief 启动闸门(全部线程创建成功后同时开始, 失败时通知已创建的线程退出)
+ */
+typedef struct
+{
+    pthread_mutex_t lock; /* 互斥锁 */
+    pthread_cond_t cond;  /* 条件变量 */
+    int state;            /* 0 等待, 1 开始, -1 放弃 */
+} SmWlGate;
+
+/**
+ * @brief 线程上下文
+ */
+typedef struct
+{
+    const SmWorkloadConfig *config;    /* 负载配置 */
+    const SmWlChoice *choices;         /* 事件抽样表(按状态下标) */
+    uint8_t *instances;                /* 本线程实例内存 */
+    size_t stride;                     /* 实例大小 */
+    uint32_t count;                    /* 本线程实例数量 */
+    double *zipf_cdf;                  /* Zipf 累计分布(可选) */
+    SmMachine **fleet_buf;             /* 广播用实例指针 */
+    uint8_t *pending;                  /* 队列模式下实例是否待分发 */
+    SmMachine **pending_list;          /* 待分发实例列表 */
+    uint32_t pending_count;            /* 待分发实例数量 */
+    uint64_t rng;                      /* 随机数状态 */
+    SmWlGate *gate;                    /* 启动闸门 */
+    uint64_t start_ns;                 /* 开始时间 */
+    uint64_t end_ns;                   /* 结束时间 */
+    uint64_t events;                   /* 发送事件数 */
+    uint64_t state_changes;            /* 状态变更数 */
+    uint64_t storm_max_ns;             /* 最长风暴耗时 */
+    uint64_t latency_max;              /* 最大延迟 */
+    uint64_t hist[SM_WL_HIST_BUCKETS]; /* 延迟直方图 */
+} SmWlThread;
+
+/* ============================================================================
+ * 内部辅助函数
+ * ============================================================================ */
+
+static uint64_t SmWlNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 休眠指定微秒(被信号中断时继续睡完剩余时间)
+ */
+static void SmWlSleepUs(uint64_t us)
+{
+    struct timespec ts = { .tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+/**
+ * @brief xorshift64* 随机数
+ */
+static uint64_t SmWlRand(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief 读取常驻内存(字节)
+ */
+static size_t SmWlRss(void)
+{
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+    {
+        resident = 0;
+    }
+    fclose(fp);
+
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief 延迟直方图桶号(log2 分段, 每段8个子桶, 相对误差 < 12.5%)
+ */
+static uint32_t SmWlBucket(uint64_t value)
+{
+    if (value < 8)
+    {
+        return (uint32_t)value;
+    }
+
+    uint32_t msb = 63u - (uint32_t)__builtin_clzll(value);
+    return ((msb - 2u) << 3) | (uint32_t)((value >> (msb - 3u)) & 7u);
+}
+
+/**
+ * @brief 桶的上界
+ */
+static uint64_t SmWlBucketUpper(uint32_t bucket)
+{
+    if (bucket < 8)
+    {
+        return bucket;
+    }
+
+    uint32_t msb = (bucket >> 3) + 2u;
+    uint64_t low = (8u | (bucket & 7u));
+    return (low << (msb - 3u)) + (1ULL << (msb - 3u)) - 1u;
+}
+
+/**
+ * @brief 按直方图计算分位数
+ */
+static uint64_t SmWlPercentile(const uint64_t *hist, uint64_t total, uint16_t permille, uint64_t max)
+{
+    uint64_t target = (total * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < SM_WL_HIST_BUCKETS; i++)
+    {
+        seen += hist[i];
+        if (seen >= target && seen > 0)
+        {
+            uint64_t upper = SmWlBucketUpper(i);
+            return (upper < max) ? upper : max;
+        }
+    }
+
+    return max;
+}
+
+/**
+ * @brief 查找状态下标
+ */
+static int32_t SmWlStateIndex(const SmClass *sm_class, SmStateId state_id)
+{
+    if (state_id >= 0 && state_id < sm_class->state_count && sm_class->states[state_id].state_id == state_id)
+    {
+        return state_id;
+    }
+
+    for (uint16_t i = 0; i < sm_class->state_count; i++)
+    {
+        if (sm_class->states[i].state_id == state_id)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 类的事件数量(未声明时取转换表中最大事件ID + 1)
+ */
+static uint32_t SmWlEventCount(const SmClass *sm_class)
+{
+    SmEventId max_event = (SmEventId)sm_class->event_count - 1;
+
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        for (uint16_t i = 0; i < sm_class->states[s].trans_count; i++)
+        {
+            if (sm_class->states[s].transitions[i].event_id > max_event)
+            {
+                max_event = sm_class->states[s].transitions[i].event_id;
+            }
+        }
+    }
+
+    return (max_event >= 0) ? (uint32_t)max_event + 1 : 0;
+}
+
+/**
+ * @brief 追加候选事件
+ */
+static void SmWlAddChoice(SmWlChoice *choice, SmEventId event, uint32_t weight)
+{
+    if (weight == 0)
+    {
+        return;
+    }
+
+    uint32_t prev = (choice->count > 0) ? choice->cum[choice->count - 1] : 0;
+    choice->events[choice->count] = event;
+    choice->cum[choice->count] = prev + weight;
+    choice->count++;
+}
+
+/**
+ * @brief 构建各状态的事件抽样表
+ * @note 未提供权重表时在状态自身规则和通配规则中均匀抽样, 两者都没有时在全部事件中抽样
+ */
+static SmWlChoice *SmWlBuildChoices(const SmWorkloadConfig *config)
+{
+    const SmClass *sm_class = config->sm_class;
+    uint32_t event_count = SmWlEventCount(sm_class);
+    SmWlChoice *choices = calloc(sm_class->state_count, sizeof(SmWlChoice));
+
+    if (choices == NULL || event_count == 0)
+    {
+        free(choices);
+        return NULL;
+    }
+
+    for (uint16_t s = 0; s < sm_class->state_count; s++)
+    {
+        const SmState *state = &sm_class->states[s];
+        uint32_t cap = event_count + state->trans_count + sm_class->any_trans_count;
+        SmWlChoice *choice = &choices[s];
+
+        choice->events = malloc(sizeof(SmEventId) * cap);
+        choice->cum = malloc(sizeof(uint32_t) * cap);
+        if (choice->events == NULL || choice->cum == NULL)
+        {
+            continue;
+        }
+
+        if (config->event_weights != NULL)
+        {
+            for (uint32_t e = 0; e < event_count; e++)
+            {
+                SmWlAddChoice(choice, (SmEventId)e, config->event_weights[(size_t)s * event_count + e]);
+            }
+            continue;
+        }
+
+        for (uint16_t i = 0; i < state->trans_count; i++)
+        {
+            if (state->transitions[i].event_id >= 0)
+            {
+                SmWlAddChoice(choice, state->transitions[i].event_id, 1);
+            }
+        }
+        for (uint16_t i = 0; !state->any_opt_out && i < sm_class->any_trans_count; i++)
+        {
+            if (sm_class->any_transitions[i].event_id >= 0)
+            {
+                SmWlAddChoice(choice, sm_class->any_transitions[i].event_id, 1);
+            }
+        }
+        for (uint32_t e = 0; choice->count == 0 && e < event_count; e++)
+        {
+            SmWlAddChoice(choice, (SmEventId)e, 1);
+        }
+    }
+
+    return choices;
+}
+
+static void SmWlFreeChoices(SmWlChoice *choices, uint16_t state_count)
+{
+    for (uint16_t s = 0; choices != NULL && s < state_count; s++)
+    {
+        free(choices[s].events);
+        free(choices[s].cum);
+    }
+    free(choices);
+}
+
+/**
+ * @brief 按当前状态抽样事件
+ */
+static SmEventId SmWlPickEvent(SmWlThread *thread, const SmMachine *machine)
+{
+    int32_t index = SmWlStateIndex(machine->sm_class, machine->current_state);
+    if (index < 0 || thread->choices[index].count == 0)
+    {
+        return SM_EVENT_INVALID;
+    }
+
+    const SmWlChoice *choice = &thread->choices[index];
+    uint32_t r = (uint32_t)(SmWlRand(&thread->rng) % choice->cum[choice->count - 1]);
+    uint32_t lo = 0;
+    uint32_t hi = choice->count - 1;
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (choice->cum[mid] > r)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    return choice->events[lo];
+}
+
+/**
+ * @brief 选择实例(均匀或 Zipf)
+ */
+static SmMachine *SmWlPickMachine(SmWlThread *thread)
+{
+    uint32_t index;
+
+    if (thread->zipf_cdf == NULL)
+    {
+        index = (uint32_t)(SmWlRand(&thread->rng) % thread->count);
+    }
+    else
+    {
+        double u = (double)(SmWlRand(&thread->rng) >> 11) * (1.0 / 9007199254740992.0);
+        uint32_t lo = 0;
+        uint32_t hi = thread->count - 1;
+        while (lo < hi)
+        {
+            uint32_t mid = (lo + hi) / 2;
+            if (thread->zipf_cdf[mid] > u)
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        index = lo;
+    }
+
+    return (SmMachine *)(thread->instances + (size_t)index * thread->stride);
+}
+
+/**
+ * @brief 队列模式: 分发所有待处理实例
+ */
+static void SmWlFlush(SmWlThread *thread)
+{
+    for (uint32_t i = 0; i < thread->pending_count; i++)
+    {
+        SmMachine *machine = thread->pending_list[i];
+        SmStateId before = machine->current_state;
+        SmDispatch(machine, 0);
+        thread->state_changes += (machine->current_state != before);
+        thread->pending[((uint8_t *)machine - thread->instances) / thread->stride] = 0;
+    }
+    thread->pending_count = 0;
+}
+
+/**
+ * @brief 风暴: 向本线程全部实例广播
+ */
+static void SmWlStorm(SmWlThread *thread)
+{
+    SmFleet fleet = { .machines = thread->fleet_buf, .count = thread->count };
+
+    uint64_t start = SmWlNowNs();
+    uint32_t delivered = SmBroadcast(&fleet, thread->config->storm_event);
+    uint64_t elapsed = SmWlNowNs() - start;
+
+    thread->events += delivered;
+    if (elapsed > thread->storm_max_ns)
+    {
+        thread->storm_max_ns = elapsed;
+    }
+}
+
+/**
+ * @brief 负载线程
+ */
+static void *SmWlThreadMain(void *arg)
+{
+    SmWlThread *thread = (SmWlThread *)arg;
+    const SmWorkloadConfig *config = thread->config;
+    bool queued = (config->queue_depth > 0);
+    uint16_t batch = (config->dispatch_batch > 0) ? config->dispatch_batch : 64;
+
+    pthread_mutex_lock(&thread->gate->lock);
+    while (thread->gate->state == 0)
+    {
+        pthread_cond_wait(&thread->gate->cond, &thread->gate->lock);
+    }
+    int state = thread->gate->state;
+    pthread_mutex_unlock(&thread->gate->lock);
+    if (state < 0)
+    {
+        return NULL;
+    }
+
+    thread->start_ns = SmWlNowNs();
+
+    for (uint64_t i = 0; i < config->events_per_thread; i++)
+    {
+        if (config->storm_every > 0 && i > 0 && i % config->storm_every == 0)
+        {
+            if (queued)
+            {
+                SmWlFlush(thread);
+            }
+            SmWlStorm(thread);
+        }
+
+        SmMachine *machine = SmWlPickMachine(thread);
+        SmEventId event = SmWlPickEvent(thread, machine);
+        if (event == SM_EVENT_INVALID)
+        {
+            continue;
+        }
+        thread->events++;
+
+        if (queued)
+        {
+            uint32_t index = (uint32_t)(((uint8_t *)machine - thread->instances) / thread->stride);
+            if (SmPostEvent(machine, event) == SM_RET_OK && !thread->pending[index])
+            {
+                thread->pending[index] = 1;
+                thread->pending_list[thread->pending_count++] = machine;
+            }
+            if ((i + 1) % batch == 0)
+            {
+                SmWlFlush(thread);
+            }
+        }
+        else if ((i & ((1u << SM_WL_SAMPLE_SHIFT) - 1)) == 0)
+        {
+            SmStateId before = machine->current_state;
+            uint64_t start = SmWlNowNs();
+            SmSendEvent(machine, event);
+            uint64_t latency = SmWlNowNs() - start;
+            thread->hist[SmWlBucket(latency)]++;
+            if (latency > thread->latency_max)
+            {
+                thread->latency_max = latency;
+            }
+            thread->state_changes += (machine->current_state != before);
+        }
+        else
+        {
+            SmStateId before = machine->current_state;
+            SmSendEvent(machine, event);
+            thread->state_changes += (machine->current_state != before);
+        }
+
+        if (config->burst_len > 0 && (i + 1) % config->burst_len == 0)
+        {
+            if (queued)
+            {
+                SmWlFlush(thread);
+            }
+            if (config->idle_us > 0)
+            {
+                SmWlSleepUs(config->idle_us);
+            }
+        }
+    }
+
+    if (queued)
+    {
+        SmWlFlush(thread);
+    }
+
+    thread->end_ns = SmWlNowNs();
+    return NULL;
+}
+
+/**
+ * @brief 默认实例初始化
+ */
+static SmRetCode SmWlDefaultInit(const SmWorkloadConfig *config, SmMachine *machine, uint32_t machine_id)
+{
+    if (config->init_fn != NULL)
+    {
+        return config->init_fn(config->init_ctx, machine, machine_id);
+    }
+
+    SmRetCode ret = SmCreate(machine, config->sm_class, NULL);
+    if (ret != SM_RET_OK)
+    {
+        return ret;
+    }
+    SmSetMachineId(machine, machine_id);
+    return SmStart(machine, config->initial_state);
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================ */
+
+SmRetCode SmWorkloadRun(const SmWorkloadConfig *config, SmWorkloadResult *result)
+{
+    if (config == NULL || result == NULL || config->sm_class == NULL || config->thread_count == 0 ||
+        config->machine_count < config->thread_count)
+    {
+        return SM_RET_ERROR;
+    }
+
+    size_t stride = (config->instance_size > sizeof(SmMachine)) ? config->instance_size : sizeof(SmMachine);
+    stride = (stride + 63u) & ~(size_t)63u; /* 实例按缓存行对齐, 避免线程间伪共享 */
+    uint32_t threads = config->thread_count;
+    bool queued = (config->queue_depth > 0);
+    SmRetCode ret = SM_RET_ERROR;
+
+    memset(result, 0, sizeof(SmWorkloadResult));
+    result->rss_before = SmWlRss();
+
+    SmWlChoice *choices = SmWlBuildChoices(config);
+    uint8_t *instances = aligned_alloc(64, stride * config->machine_count);
+    SmWlThread *ctx = calloc(threads, sizeof(SmWlThread));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    SmEventQueue *queues = queued ? calloc(config->machine_count, sizeof(SmEventQueue)) : NULL;
+    SmQueuedEvent *queue_buf = queued ? calloc((size_t)config->machine_count * SM_LANE_COUNT * config->queue_depth,
+                                               sizeof(SmQueuedEvent))
+                                      : NULL;
+    if (choices == NULL || instances == NULL || ctx == NULL || tids == NULL || (queued && (queues == NULL || queue_buf == NULL)))
+    {
+        goto cleanup;
+    }
+    memset(instances, 0, stride * config->machine_count);
+
+    /* 1. 创建实例 */
+    for (uint32_t i = 0; i < config->machine_count; i++)
+    {
+        SmMachine *machine = (SmMachine *)(instances + (size_t)i * stride);
+        if (SmWlDefaultInit(config, machine, i) != SM_RET_OK)
+        {
+            goto cleanup;
+        }
+        SmSetTransLogFn(machine, config->trans_log_fn);
+        if (queued)
+        {
+            SmQueueInit(&queues[i], &queue_buf[(size_t)i * SM_LANE_COUNT * config->queue_depth],
+                        config->queue_depth, 4);
+            SmSetEventQueue(machine, &queues[i]);
+        }
+    }
+
+    /* 2. 切分到各线程 */
+    uint32_t base = 0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        SmWlThread *thread = &ctx[t];
+        uint32_t count = config->machine_count / threads + (t < config->machine_count % threads ? 1 : 0);
+
+        thread->config = config;
+        thread->choices = choices;
+        thread->instances = instances + (size_t)base * stride;
+        thread->stride = stride;
+        thread->count = count;
+        thread->rng = ((uint64_t)config->seed << 32) ^ (0x9E3779B97F4A7C15ULL * (t + 1));
+        thread->fleet_buf = malloc(sizeof(SmMachine *) * count);
+        thread->pending = calloc(count, 1);
+        thread->pending_list = malloc(sizeof(SmMachine *) * count);
+        if (thread->fleet_buf == NULL || thread->pending == NULL || thread->pending_list == NULL)
+        {
+            goto cleanup;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            thread->fleet_buf[i] = (SmMachine *)(thread->instances + (size_t)i * stride);
+        }
+
+        if (config->zipf_s > 0)
+        {
+            thread->zipf_cdf = malloc(sizeof(double) * count);
+            if (thread->zipf_cdf == NULL)
+            {
+                goto cleanup;
+            }
+            double sum = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                sum += 1.0 / pow((double)(i + 1), config->zipf_s);
+                thread->zipf_cdf[i] = sum;
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                thread->zipf_cdf[i] /= sum;
+            }
+        }
+
+        base += count;
+    }
+
+    /* 3. 运行(队列模式使用纳秒时间源统计排队延迟) */
+    SmTimeFn saved_time_fn = SmGetTimeFn();
+    if (queued)
+    {
+        SmSetTimeFn(SmWlNowNs);
+    }
+
+    SmWlGate gate = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .state = 0 };
+    uint32_t started = 0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        ctx[t].gate = &gate;
+        if (pthread_create(&tids[t], NULL, SmWlThreadMain, &ctx[t]) != 0)
+        {
+            break;
+        }
+        started++;
+    }
+
+    pthread_mutex_lock(&gate.lock);
+    gate.state = (started == threads) ? 1 : -1;
+    pthread_cond_broadcast(&gate.cond);
+    pthread_mutex_unlock(&gate.lock);
+    for (uint32_t t = 0; t < started; t++)
+    {
+        pthread_join(tids[t], NULL);
+    }
+    SmSetTimeFn(saved_time_fn);
+    if (started < threads)
+    {
+        goto cleanup;
+    }
+
+    /* 4. 汇总 */
+    uint64_t start_ns = UINT64_MAX;
+    uint64_t end_ns = 0;
+    uint64_t *hist = calloc(SM_WL_HIST_BUCKETS, sizeof(uint64_t));
+    uint64_t samples = 0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        SmWlThread *thread = &ctx[t];
+        start_ns = (thread->start_ns < start_ns) ? thread->start_ns : start_ns;
+        end_ns = (thread->end_ns > end_ns) ? thread->end_ns : end_ns;
+        result->events += thread->events;
+        result->state_changes += thread->state_changes;
+        if (thread->storm_max_ns > result->storm_max_ns)
+        {
+            result->storm_max_ns = thread->storm_max_ns;
+        }
+        if (thread->latency_max > result->latency_max)
+        {
+            result->latency_max = thread->latency_max;
+        }
+        for (uint32_t i = 0; hist != NULL && i < SM_WL_HIST_BUCKETS; i++)
+        {
+            hist[i] += thread->hist[i];
+            samples += thread->hist[i];
+        }
+    }
+
+    /* 队列模式: 合并各实例的排队延迟直方图 */
+    for (uint32_t i = 0; queued && hist != NULL && i < config->machine_count; i++)
+    {
+        for (uint8_t lane = 0; lane < SM_LANE_COUNT; lane++)
+        {
+            const SmLaneStats *stats = SmGetLaneStats(&queues[i], lane);
+            result->dropped += stats->dropped;
+            if (stats->delay_max > result->latency_max)
+            {
+                result->latency_max = stats->delay_max;
+            }
+            for (uint32_t b = 0; b < SM_LANE_DELAY_BUCKETS; b++)
+            {
+                /* 第b桶为 [2^(b-1), 2^b), 按下界折算到细分直方图 */
+                uint64_t low = (b == 0) ? 0 : (1ULL << (b - 1));
+                hist[SmWlBucket(low)] += stats->delay_hist[b];
+                samples += stats->delay_hist[b];
+            }
+        }
+    }
+
+    if (hist != NULL)
+    {
+        result->latency_p50 = SmWlPercentile(hist, samples, 500, result->latency_max);
+        result->latency_p99 = SmWlPercentile(hist, samples, 990, result->latency_max);
+        result->latency_p999 = SmWlPercentile(hist, samples, 999, result->latency_max);
+        free(hist);
+    }
+
+    result->elapsed_ns = (end_ns > start_ns) ? end_ns - start_ns : 0;
+    result->events_per_sec = result->elapsed_ns ? (double)result->events * 1e9 / result->elapsed_ns : 0;
+    result->rss_after = SmWlRss();
+    result->bytes_per_instance = stride;
+    if (queued)
+    {
+        result->bytes_per_instance += sizeof(SmEventQueue) + sizeof(SmQueuedEvent) * SM_LANE_COUNT * config->queue_depth;
+    }
+    ret = SM_RET_OK;
+
+cleanup:
+    for (uint32_t i = 0; instances != NULL && ctx != NULL && i < config->machine_count; i++)
+    {
+        SmMachine *machine = (SmMachine *)(instances + (size_t)i * stride);
+        if (machine->is_initialized)
+        {
+            SmDestroy(machine);
+        }
+    }
+    for (uint32_t t = 0; ctx != NULL && t < threads; t++)
+    {
+        free(ctx[t].fleet_buf);
+        free(ctx[t].pending);
+        free(ctx[t].pending_list);
+        free(ctx[t].zipf_cdf);
+    }
+    SmWlFreeChoices(choices, config->sm_class->state_count);
+    free(queue_buf);
+    free(queues);
+    free(tids);
+    free(ctx);
+    free(instances);
+    return ret;
+}
@@ -0,0 +1,96 @@
+#ifndef __SMWORKLOAD_H__
+#define __SMWORKLOAD_H__
+
+#include <stddef.h>
+#include "SmMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 合成负载生成器
+ * ============================================================================ */
+
+/*
+ * 对任意 SmClass 生成集群规模的负载: N 个实例平均分配到 M 个线程,
+ * 每个线程只操作自己的实例(与生产中按连接分片的分发线程一致).
+ * 负载由几个可组合的维度描述:
+ *   - 事件选择: 按当前状态的事件权重表抽样, 未提供时在该状态的转换规则中均匀抽样
+ *   - 实例选择: 均匀, 或按 Zipf 分布集中到少数热点实例
+ *   - 时间分布: 连续发送, 或突发(发送 burst_len 个事件后空闲 idle_us)
+ *   - 风暴注入: 每 storm_every 个事件向线程内全部实例广播 storm_event
+ * 可选经过优先级队列分发和转换日志回调, 以便分别定位分发/排队/日志的扩展瓶颈.
+ */
+
+#define SM_WL_HIST_BUCKETS 512 /* 延迟直方图桶数(log2 分段, 每段8个子桶) */
+#define SM_WL_SAMPLE_SHIFT 4   /* 直接分发模式下每 2^n 个事件采样一次延迟 */
+
+/**
+ * @brief 实例初始化回调(负责 SmCreate + SmStart, 可设置用户数据)
+ * @param ctx 回调上下文
+ * @param machine 实例(位于 instance_size 大小内存的起始处)
+ * @param machine_id 实例ID
+ * @return SM_RET_OK 成功, 其他 失败
+ */
+typedef SmRetCode (*SmWorkloadInitFn)(void *ctx, SmMachine *machine, uint32_t machine_id);
+
+/**
+ * @brief 负载配置
+ */
+typedef struct
+{
+    const SmClass *sm_class;       /* 状态机类 */
+    uint32_t machine_count;        /* 实例数量 */
+    uint32_t thread_count;         /* 线程数量 */
+    uint64_t events_per_thread;    /* 每个线程发送的事件数量 */
+    size_t instance_size;          /* 实例大小(SmMachine 位于起始处), 0表示 sizeof(SmMachine) */
+    SmWorkloadInitFn init_fn;      /* 实例初始化(可选, 默认 SmCreate + SmStart(initial_state)) */
+    void *init_ctx;                /* 初始化回调上下文 */
+    SmStateId initial_state;       /* 默认初始状态 */
+    const uint16_t *event_weights; /* 事件权重 [state_count][event_count](可选) */
+    double zipf_s;                 /* Zipf 指数, 0表示均匀选择实例 */
+    uint32_t burst_len;            /* 突发长度, 0表示连续发送 */
+    uint32_t idle_us;              /* 突发之间的空闲时间(微秒) */
+    uint32_t storm_every;          /* 风暴间隔(事件数), 0表示不注入 */
+    SmEventId storm_event;         /* 风暴事件 */
+    uint16_t queue_depth;          /* 每通道队列深度, 0表示直接分发 */
+    uint16_t dispatch_batch;       /* 队列模式下投递多少个事件后分发一次 */
+    SmTransLogFn trans_log_fn;     /* 转换日志回调(可选) */
+    uint32_t seed;                 /* 随机种子 */
+} SmWorkloadConfig;
+
+/**
+ * @brief 负载结果
+ */
+typedef struct
+{
+    uint64_t events;           /* 发送的事件数量(含风暴) */
+    uint64_t state_changes;    /* 分发后当前状态发生变化的次数 */
+    uint64_t dropped;          /* 队列满丢弃的事件数量 */
+    uint64_t elapsed_ns;       /* 墙钟耗时 */
+    double events_per_sec;     /* 吞吐量 */
+    uint64_t latency_p50;      /* 延迟 P50(ns), 直接分发为分发耗时, 队列模式为排队延迟 */
+    uint64_t latency_p99;      /* 延迟 P99(ns) */
+    uint64_t latency_p999;     /* 延迟 P99.9(ns) */
+    uint64_t latency_max;      /* 最大延迟(ns) */
+    uint64_t storm_max_ns;     /* 单次风暴广播的最长耗时 */
+    size_t rss_before;         /* 创建实例前的常驻内存 */
+    size_t rss_after;          /* 运行结束时的常驻内存(同一进程多次运行时受堆复用影响) */
+    size_t bytes_per_instance; /* 每个实例占用的内存(实例 + 队列) */
+} SmWorkloadResult;
+
+/**
+ * @brief 运行负载
+ * @param config 负载配置
+ * @param result 负载结果(输出)
+ * @return SM_RET_OK 成功, 其他 失败
+ * @note 队列模式运行期间安装纳秒时间源, 结束后恢复原时间源
+ */
+SmRetCode SmWorkloadRun(const SmWorkloadConfig *config, SmWorkloadResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SMWORKLOAD_H__ */